@@ -1,6 +1,7 @@
 #include "engine-precompiled-header.h"
 #include "EnginePerformanceMonitor.h"
 #include "../BaseEngineWidgetManager.h"
+#include "engine/core/allocator/MemoryStats.h"
 
 #include <imgui/addons/implot/implot.h>
 
@@ -97,7 +98,110 @@ void longmarch::EnginePerformanceMonitor::Render()
 	}
 	ImGui::Columns(1); // resetting the number of columns to 1
 
+	RenderMemoryStats();
+
 	manager->CaptureMouseAndKeyboardOnHover(true);
 	manager->PopWidgetStyle();
 	ImGui::End();
 }
+
+
+void longmarch::EnginePerformanceMonitor::RenderMemoryStats()
+{
+	if (!ImGui::CollapsingHeader("Memory"))
+	{
+		return;
+	}
+	constexpr double toKB = 1.0 / 1024.0;
+	constexpr double toMB = toKB * toKB;
+
+	const auto snapshot = MemoryStats::TakeSnapshot();
+	if (m_memoryBaseline.m_sizeClasses.empty())
+	{
+		m_memoryBaseline = snapshot;
+	}
+	// Growth is index aligned with the snapshot
+	const auto growth = MemoryStats::Diff(m_memoryBaseline, snapshot);
+
+	ImGui::Text("LIVE: %.2f MB (peak %.2f MB, %+.2f MB since baseline)", snapshot.m_liveBytes * toMB, snapshot.m_peakLiveBytes * toMB, growth.m_liveBytes * toMB);
+	ImGui::Text("RESERVED: %.2f MB (%+.2f MB since baseline)", snapshot.m_reservedBytes * toMB, growth.m_reservedBytes * toMB);
+	ImGui::Text("LARGE: %.2f MB in %lld allocations", snapshot.m_largeBytes * toMB, static_cast<long long>(snapshot.m_largeAllocations));
+	if (ImGui::Button("Set baseline"))
+	{
+		m_memoryBaseline = snapshot;
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Dump json"))
+	{
+		MemoryStats::DumpJson("$root:memory-stats.json", snapshot, m_memoryBaseline);
+	}
+	ImGui::SameLine();
+	static bool showUnused = false;
+	ImGui::Checkbox("Show unused", &showUnused);
+
+	constexpr auto tableFlags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingStretchProp;
+	auto renderPools = [&](const char* label, const std::vector<MemorySnapshot::Pool_T>& pools, const std::vector<MemorySnapshot::Pool_T>& poolGrowth)
+	{
+		if (ImGui::BeginTable(label, 7, tableFlags, ImVec2(0, 200)))
+		{
+			ImGui::TableSetupScrollFreeze(0, 1);
+			ImGui::TableSetupColumn("Pool");
+			ImGui::TableSetupColumn("Live KB");
+			ImGui::TableSetupColumn("Live blocks");
+			ImGui::TableSetupColumn("Peak blocks");
+			ImGui::TableSetupColumn("Pages");
+			ImGui::TableSetupColumn("Frag %");
+			ImGui::TableSetupColumn("Growth KB");
+			ImGui::TableHeadersRow();
+			for (size_t i = 0; i < pools.size(); ++i)
+			{
+				const auto& pool = pools[i];
+				if (!showUnused && pool.m_pages == 0)
+				{
+					continue;
+				}
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn(); ImGui::TextUnformatted(pool.m_name.c_str());
+				ImGui::TableNextColumn(); ImGui::Text("%.1f", pool.m_liveBytes * toKB);
+				ImGui::TableNextColumn(); ImGui::Text("%lld", static_cast<long long>(pool.m_liveBlocks));
+				ImGui::TableNextColumn(); ImGui::Text("%lld", static_cast<long long>(pool.m_peakUsedBlocks));
+				ImGui::TableNextColumn(); ImGui::Text("%lld", static_cast<long long>(pool.m_pages));
+				ImGui::TableNextColumn(); ImGui::Text("%.1f", pool.Fragmentation() * 1e2);
+				ImGui::TableNextColumn(); ImGui::Text("%+.1f", poolGrowth[i].m_liveBytes * toKB);
+			}
+			ImGui::EndTable();
+		}
+	};
+	if (ImGui::TreeNode("Size classes"))
+	{
+		renderPools("##SizeClasses", snapshot.m_sizeClasses, growth.m_sizeClasses);
+		ImGui::TreePop();
+	}
+	if (ImGui::TreeNode("Types"))
+	{
+		renderPools("##Types", snapshot.m_types, growth.m_types);
+		ImGui::TreePop();
+	}
+	if (ImGui::TreeNode("Tags"))
+	{
+		if (ImGui::BeginTable("##Tags", 4, tableFlags))
+		{
+			ImGui::TableSetupColumn("Tag");
+			ImGui::TableSetupColumn("Live KB");
+			ImGui::TableSetupColumn("Peak KB");
+			ImGui::TableSetupColumn("Growth KB");
+			ImGui::TableHeadersRow();
+			for (size_t i = 0; i < snapshot.m_tags.size(); ++i)
+			{
+				const auto& tag = snapshot.m_tags[i];
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn(); ImGui::TextUnformatted(tag.m_name.c_str());
+				ImGui::TableNextColumn(); ImGui::Text("%.1f", tag.m_liveBytes * toKB);
+				ImGui::TableNextColumn(); ImGui::Text("%.1f", tag.m_peakBytes * toKB);
+				ImGui::TableNextColumn(); ImGui::Text("%+.1f", growth.m_tags[i].m_liveBytes * toKB);
+			}
+			ImGui::EndTable();
+		}
+		ImGui::TreePop();
+	}
+}
\ No newline at end of file
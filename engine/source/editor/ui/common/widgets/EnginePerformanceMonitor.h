@@ -1,5 +1,6 @@
 #pragma once
 #include "engine/ui/BaseWidget.h"
+#include "engine/core/allocator/MemoryStats.h"
 
 namespace longmarch {
 	/**
@@ -13,8 +14,13 @@ namespace longmarch {
 		EnginePerformanceMonitor();
 		virtual void Render() override;
 
+	private:
+		//! Memory accounting by size class, type and tag, and its growth since a baseline snapshot
+		void RenderMemoryStats();
+
 	private:
 		ImVec2 m_Size;
+		MemorySnapshot m_memoryBaseline;
 	};
 
 	// utility structure for realtime plot
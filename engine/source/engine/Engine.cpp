@@ -5,6 +5,7 @@
 #include "engine/renderer/material/Material.h"
 #include "engine/core/utility/Random.h"
 #include "engine/core/thread/StealThreadPool.h"
+#include "engine/core/thread/Scheduler.h"
 #include "engine/delegate/EngineDelegates/EngineDelegates.h"
 
 namespace longmarch
@@ -16,6 +17,16 @@ namespace longmarch
 
 	Engine::~Engine()
 	{
+		if (!m_memoryStatsDumpPath.empty())
+		{
+			MemoryStats::DumpJson(m_memoryStatsDumpPath, MemoryStats::TakeSnapshot(), m_memoryBaseline);
+		}
+		if (FrameProfiler::IsRecording())
+		{
+			FrameProfiler::Stop();
+			FrameProfiler::DumpChromeTrace(m_traceDumpPath);
+		}
+		Scheduler::ShutDown();
 		ImGuiDriver::ShutDown();
 		Logger::ShutDown();
 		s_instance = nullptr;
@@ -25,6 +36,7 @@ namespace longmarch
 	{
 		// Logger
 		{
+			FrameProfiler::SetThreadName("Main");
 			Logger::Init();
 			ENGINE_INFO("Initialized Engine Log!");
 			APP_INFO("Initialized Application Log!");
@@ -52,6 +64,12 @@ namespace longmarch
 		// Engine config
 		{
 			m_enable_pause_on_unfocused = engineConfiguration["engine"]["Pause-on-unfocused"].asBool();
+			m_memoryStatsDumpPath = engineConfiguration["engine"]["Memory-stats-dump"].asString();
+			m_traceDumpPath = engineConfiguration["engine"]["Trace-dump"].asString();
+			if (const auto& seconds = engineConfiguration["engine"]["Trace-seconds"]; !seconds.isNull())
+			{
+				m_traceSeconds = seconds.asDouble();
+			}
 			switch (engineConfiguration["engine"]["Startup-mode"].asInt())
 			{
 			case 0:
@@ -109,6 +127,16 @@ namespace longmarch
 				StealThreadPool::ResetStats();
 			});
 			PostRenderUpdate().Connect(EngineException::Update);
+			PostRenderUpdate().Connect([this]()
+			{
+				// Stop a headless trace capture after its duration
+				if (FrameProfiler::IsRecording() && !m_traceDumpPath.empty() && Engine::GetTotalTime() >= m_traceCaptureEnd)
+				{
+					FrameProfiler::Stop();
+					FrameProfiler::DumpChromeTrace(m_traceDumpPath);
+					m_traceDumpPath.clear();
+				}
+			});
 			PostRenderUpdate().Connect([this]() 
 			{
 				// Check should exit
@@ -151,6 +179,12 @@ namespace longmarch
 			delegates::WorkerThreadReportWait.BindGlobal(StealThreadPool::ThreadReportWait);
 			delegates::WorkerThreadReportExec.BindGlobal(StealThreadPool::ThreadReportExec);
 		}
+		m_memoryBaseline = MemoryStats::TakeSnapshot();
+		if (!m_traceDumpPath.empty())
+		{
+			m_traceCaptureEnd = Engine::GetTotalTime() + m_traceSeconds;
+			FrameProfiler::Start();
+		}
 	}
 
 	void Engine::_ON_ENG_WINDOW_QUIT(EventQueue<EngineEventType>::EventPtr e)
@@ -190,34 +224,57 @@ namespace longmarch
 		{
 			rateController->FrameStart();
 			{
+				PROFILE_SCOPE("Frame");
 				// Pre update
-				PreUpdate().Update();
+				{
+					PROFILE_SCOPE("PreUpdate");
+					MemoryTagScope _tag(MemoryTag::ASSET);
+					PreUpdate().Update();
+				}
 
 				double dt = rateController->GetFrameTime();
 				// Event queue update
-				EventQueueUpdate().Update(dt);
+				{
+					PROFILE_SCOPE("EventQueueUpdate");
+					MemoryTagScope _tag(MemoryTag::EVENT);
+					EventQueueUpdate().Update(dt);
+				}
 
 				if (!Engine::GetPaused())
 				{
 					// Updating for the current layer
-					for (auto& layer : *m_LayerStack.GetCurrentLayer())
 					{
-						layer->OnUpdate(dt);
+						PROFILE_SCOPE("LayerUpdate");
+						for (auto& layer : *m_LayerStack.GetCurrentLayer())
+						{
+							layer->OnUpdate(dt);
+						}
 					}
 
 					// Render the imgui UI of the cureent layer
-					ImGuiDriver::BeginFrame();
-					for (auto& layer : *m_LayerStack.GetCurrentLayer())
 					{
-						layer->OnImGuiRender();
+						PROFILE_SCOPE("ImGui");
+						MemoryTagScope _tag(MemoryTag::UI);
+						ImGuiDriver::BeginFrame();
+						for (auto& layer : *m_LayerStack.GetCurrentLayer())
+						{
+							layer->OnImGuiRender();
+						}
+						ImGuiDriver::EndFrame();
 					}
-					ImGuiDriver::EndFrame();
 
 					// Engine post game layer update
-					LateUpdate().Update(dt);
+					{
+						PROFILE_SCOPE("LateUpdate");
+						LateUpdate().Update(dt);
+					}
 
 					// Window swap buffer
-					Render().Update();
+					{
+						PROFILE_SCOPE("Render");
+						MemoryTagScope _tag(MemoryTag::RENDERER);
+						Render().Update();
+					}
 				}
 				else
 				{
@@ -225,7 +282,10 @@ namespace longmarch
 				}
 
 				// Post update
-				PostRenderUpdate().Update();
+				{
+					PROFILE_SCOPE("PostRenderUpdate");
+					PostRenderUpdate().Update();
+				}
 			}
 			rateController->FrameEnd();
 		}
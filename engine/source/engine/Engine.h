@@ -1,5 +1,6 @@
 #pragma once
 #include "engine/EngineEssential.h"
+#include "engine/core/allocator/MemoryStats.h"
 #include "engine/layer/LayerStack.h"
 #include "engine/ui/ImGuiDriver.h"
 #include "engine/window/Window.h"
@@ -91,6 +92,13 @@ namespace longmarch
 		bool m_isPaused{ false }; 
 		bool m_isWindowFocused{ true };
 		bool m_enable_pause_on_unfocused{ false };
+		//! Dump memory statistics and their growth since Init() on exit if the path is not empty
+		std::string m_memoryStatsDumpPath;
+		MemorySnapshot m_memoryBaseline;
+		//! Capture a Chrome trace of the first m_traceSeconds seconds after Init() if the path is not empty
+		std::string m_traceDumpPath;
+		double m_traceSeconds{ 10.0 };
+		double m_traceCaptureEnd{ 0.0 };
 
 	public:
 		inline static GraphicsContext* GetGraphicsContext() { return s_instance->m_engineWindow->GetWindowProperties().m_context; }
@@ -8,12 +8,13 @@
 #define ALIGN(x, a)         (((x) + ((a) - 1)) & ~((a) - 1))
 #endif
 
-void longmarch::Allocator::Reset(size_t data_size, size_t page_size, size_t alignment) noexcept
+void longmarch::Allocator::Reset(size_t data_size, size_t page_size, size_t alignment, bool lock_free) noexcept
 {
     FreeAll();
 
     m_szDataSize = data_size;
     m_szPageSize = page_size;
+    m_bLockFree = lock_free;
 
     size_t minimal_size = (sizeof(BlockHeader) > m_szDataSize) ? sizeof(BlockHeader) : m_szDataSize;
     // this magic only works when alignment is 2^n, which should general be the case
@@ -29,11 +30,11 @@ void longmarch::Allocator::Reset(size_t data_size, size_t page_size, size_t alig
     m_nBlocksPerPage = (m_szPageSize) / (m_szBlockSize + sizeof(BlockHeader));
 }
 
-void longmarch::Allocator::AllocateNewPage() noexcept
+longmarch::BlockHeader* longmarch::Allocator::AllocateNewPage(BlockHeader*& tail)
 {
-    // allocate a new page
+    // allocate a new page, with room for the link to the next page
     auto alloc = this;
-    if (PageHeader* pNewPage = reinterpret_cast<PageHeader*>(std::calloc(1, alloc->m_szPageSize));
+    if (PageHeader* pNewPage = reinterpret_cast<PageHeader*>(std::calloc(1, alloc->m_szPageSize + sizeof(PageHeader*)));
         !pNewPage)
     [[unlikely]]
     {
@@ -42,13 +43,14 @@ void longmarch::Allocator::AllocateNewPage() noexcept
     else
     [[likely]]
     {
+        alloc->m_nPages.fetch_add(1, std::memory_order_relaxed);
 #if defined(_DEBUG)
-		++alloc->m_nPages;
-		alloc->m_nBlocks += alloc->m_nBlocksPerPage;
-		alloc->m_nFreeBlocks += alloc->m_nBlocksPerPage;
 		alloc->FillFreePage(pNewPage);
 #endif
-        alloc->m_pPageList.push_back(pNewPage);
+        // publish the page, pages are only pushed so there is no ABA problem
+        auto& next = pNewPage->NextPage(alloc->m_szPageSize);
+        next = alloc->m_pPageList.load(std::memory_order_relaxed);
+        while (!alloc->m_pPageList.compare_exchange_weak(next, pNewPage, std::memory_order_release, std::memory_order_relaxed));
 
         BlockHeader* pBlock = pNewPage->GetBlockHeader();
         // link each block in the page
@@ -62,27 +64,79 @@ void longmarch::Allocator::AllocateNewPage() noexcept
         pBlock->pNext.free = true;
         pBlock->pNext = nullptr;
 
-        alloc->m_pFreeList = pNewPage->GetBlockHeader();
+        tail = pBlock;
+        return pNewPage->GetBlockHeader();
     }
 }
 
+longmarch::BlockHeader* longmarch::Allocator::PopLockFree()
+{
+    auto head = m_freeListHead.load(std::memory_order_acquire);
+    while (true)
+    {
+        if (BlockHeader* freeBlock = Unpack(head); freeBlock)
+        [[likely]]
+        {
+            // the block might be popped and reused by another thread in the meantime, in which case the tag has changed and the CAS fails
+            // the free bit is above the 48 bits of the pointer and is masked off by Unpack()
+            BlockHeader* next = Unpack(BlockHeader::LoadHeaderWord(freeBlock));
+            if (m_freeListHead.compare_exchange_weak(head, Pack(next, (head >> kPointerBits) + 1), std::memory_order_acquire, std::memory_order_acquire))
+            {
+                return freeBlock;
+            }
+        }
+        else
+        [[unlikely]]
+        {
+            // grow the free list by a new page, keep its first block and push the rest
+            BlockHeader* tail;
+            BlockHeader* freeBlock = AllocateNewPage(tail);
+            if (freeBlock != tail)
+            {
+                PushLockFree(freeBlock->pNext, tail);
+            }
+            return freeBlock;
+        }
+    }
+}
+
+void longmarch::Allocator::PushLockFree(BlockHeader* head, BlockHeader* tail) noexcept
+{
+    auto oldHead = m_freeListHead.load(std::memory_order_relaxed);
+    do
+    {
+        BlockHeader::StoreHeaderWord(tail, Unpack(oldHead), true);
+    }
+    while (!m_freeListHead.compare_exchange_weak(oldHead, Pack(head, (oldHead >> kPointerBits) + 1), std::memory_order_release, std::memory_order_relaxed));
+}
+
 void* longmarch::Allocator::Allocate() noexcept
 {
     BlockHeader* freeBlock;
+    if (m_bLockFree)
+    {
+        freeBlock = PopLockFree();
+        BlockHeader::StoreHeaderWord(freeBlock, nullptr, false);
+#if defined(_DEBUG)
+        FillAllocatedBlock(freeBlock);
+#endif
+    }
+    else
     {
         LOCK_GUARD_NC();
-        while (!m_pFreeList)
+        if (!m_pFreeList)
         {
-            AllocateNewPage();
+            BlockHeader* tail;
+            m_pFreeList = AllocateNewPage(tail);
         }
         freeBlock = m_pFreeList;
         m_pFreeList = freeBlock->pNext;
+        freeBlock->pNext.free = false;
 #if defined(_DEBUG)
-        --m_nFreeBlocks;
         FillAllocatedBlock(freeBlock);
 #endif
     }
-    freeBlock->pNext.free = false;
+    AddUsedBlocks(1);
     return BlockHeader::GetPtr(freeBlock);
 }
 
@@ -97,34 +151,101 @@ void longmarch::Allocator::Free(void* p)
     else
     [[likely]]
     {
-        block->pNext.free = true;
+        RemoveUsedBlocks(1);
+#if defined(_DEBUG)
+        FillFreeBlock(block);
+#endif
+        if (m_bLockFree)
+        {
+            // the push marks the block as free
+            PushLockFree(block, block);
+        }
+        else
         {
+            block->pNext.free = true;
             LOCK_GUARD_NC();
             block->pNext = m_pFreeList;
             m_pFreeList = block;
-#if defined(_DEBUG)
-            ++m_nFreeBlocks;
-            FillFreeBlock(block);
-#endif
         }
     }
 }
 
+longmarch::BlockHeader* longmarch::Allocator::AllocateBatch(size_t num) noexcept
+{
+    BlockHeader* head = nullptr;
+    // Blocks stay marked as free, they are only handed out by the thread cache
+    if (m_bLockFree)
+    {
+        for (auto i(0u); i < num; ++i)
+        {
+            BlockHeader* freeBlock = PopLockFree();
+            BlockHeader::StoreHeaderWord(freeBlock, head, true);
+            head = freeBlock;
+        }
+    }
+    else
+    {
+        LOCK_GUARD_NC();
+        for (auto i(0u); i < num; ++i)
+        {
+            if (!m_pFreeList)
+            {
+                BlockHeader* tail;
+                m_pFreeList = AllocateNewPage(tail);
+            }
+            BlockHeader* freeBlock = m_pFreeList;
+            m_pFreeList = freeBlock->pNext;
+            freeBlock->pNext = head;
+            head = freeBlock;
+        }
+    }
+    AddUsedBlocks(num);
+    return head;
+}
+
+void longmarch::Allocator::FreeBatch(BlockHeader* head, BlockHeader* tail, size_t num) noexcept
+{
+    RemoveUsedBlocks(num);
+    if (m_bLockFree)
+    {
+        PushLockFree(head, tail);
+    }
+    else
+    {
+        LOCK_GUARD_NC();
+        tail->pNext = m_pFreeList;
+        m_pFreeList = head;
+    }
+}
+
 void longmarch::Allocator::FreeAll() noexcept
 {
     LOCK_GUARD_NC();
-    while (!m_pPageList.empty())
+    auto page = m_pPageList.exchange(nullptr, std::memory_order_acq_rel);
+    while (page)
     {
-        std::free(m_pPageList.back());
-        m_pPageList.pop_back();
+        auto next = page->NextPage(m_szPageSize);
+        std::free(page);
+        page = next;
     }
-    m_pPageList.clear();
     m_pFreeList = nullptr;
-#if defined(_DEBUG)
-	m_nPages = 0;
-	m_nBlocks = 0;
-	m_nFreeBlocks = 0;
-#endif
+    m_freeListHead.store(0, std::memory_order_release);
+    m_nPages.store(0, std::memory_order_relaxed);
+    m_nUsedBlocks.store(0, std::memory_order_relaxed);
+    m_nPeakUsedBlocks.store(0, std::memory_order_relaxed);
+}
+
+longmarch::Allocator::Stats_T longmarch::Allocator::GetStats() const noexcept
+{
+    Stats_T stats;
+    stats.m_dataSize = m_szDataSize;
+    stats.m_blockSize = m_szBlockSize;
+    stats.m_pageSize = m_szPageSize;
+    stats.m_blocksPerPage = m_nBlocksPerPage;
+    stats.m_pages = m_nPages.load(std::memory_order_relaxed);
+    stats.m_usedBlocks = m_nUsedBlocks.load(std::memory_order_relaxed);
+    stats.m_peakUsedBlocks = m_nPeakUsedBlocks.load(std::memory_order_relaxed);
+    return stats;
 }
 
 #if defined(_DEBUG)
@@ -1,6 +1,6 @@
 #pragma once
 #include <stdint.h>
-#include <vector>
+#include <atomic>
 #include "../thread/Lock.h"
 
 namespace longmarch
@@ -39,6 +39,9 @@ namespace longmarch
         NONINSTANTIABLE(BlockHeader);
         LongMarch_64Ptr<BlockHeader> pNext;
 
+        //! Bits of the header word that hold the pointer to the next free block
+        constexpr inline static uint64_t kNextMask = {(1ull << 48) - 1};
+
         inline static bool GetFree(void* ptr) noexcept
         {
             return GetBlock(ptr)->pNext.free;
@@ -58,6 +61,36 @@ namespace longmarch
         {
             return reinterpret_cast<BlockHeader*>(reinterpret_cast<uint8_t*>(block + 1) + blockSize);
         }
+
+        /*
+            Blocks of a lock free allocator could still be read by a pop that lost its race after they have been popped by another thread,
+            so the header of a block that has ever been in a lock free list is only written as a whole word by the methods below,
+            including by thread caches that hold blocks taken from a lock free allocator and by the tag of allocated blocks.
+        */
+        //! Load the header word of a block at once, LongMarch_64Ptr is not trivially copyable so it can not be loaded through std::atomic_ref itself
+        inline static uint64_t LoadHeaderWord(BlockHeader* block) noexcept
+        {
+            static_assert(sizeof(LongMarch_64Ptr<BlockHeader>) == sizeof(uint64_t));
+            return std::atomic_ref<uint64_t>(*reinterpret_cast<uint64_t*>(&block->pNext)).load(std::memory_order_relaxed);
+        }
+
+        //! Store the next pointer and the free bit (the top bit) of a block at once
+        inline static void StoreHeaderWord(BlockHeader* block, BlockHeader* next, bool free) noexcept
+        {
+            const uint64_t word = (reinterpret_cast<uint64_t>(next) & kNextMask) | (static_cast<uint64_t>(free) << 63);
+            std::atomic_ref<uint64_t>(*reinterpret_cast<uint64_t*>(&block->pNext)).store(word, std::memory_order_relaxed);
+        }
+
+        //! An allocated block does not use its next pointer, so it could carry a small user tag until it is freed (the free bit stays cleared)
+        inline static void SetTag(void* ptr, uint64_t tag) noexcept
+        {
+            std::atomic_ref<uint64_t>(*reinterpret_cast<uint64_t*>(&GetBlock(ptr)->pNext)).store(tag & ~(1ull << 63), std::memory_order_relaxed);
+        }
+
+        inline static uint64_t GetTag(void* ptr) noexcept
+        {
+            return LoadHeaderWord(GetBlock(ptr)) & ~(1ull << 63);
+        }
     };
 
     // Stack page
@@ -69,30 +102,104 @@ namespace longmarch
         {
             return reinterpret_cast<BlockHeader*>(this);
         }
+
+        //! Pages are linked by a pointer stored right after the last byte of the page
+        inline PageHeader*& NextPage(size_t pageSize)
+        {
+            return *reinterpret_cast<PageHeader**>(reinterpret_cast<uint8_t*>(this) + pageSize);
+        }
     };
 
+    /**
+     *  @brief Fixed size block allocator
+     *
+     *  @details By default, the free list is guarded by a spin lock. A lock free allocator instead pushes and pops blocks with a single CAS
+     *           on a 64 bits head that packs a 16 bits ABA tag with the 48 bits pointer to the first free block, the tag is incremented on every
+     *           update so that a pop that raced with a pop/push of the same block fails. New pages are published with a CAS as well.
+     *           Pages are never released before FreeAll(), so reading the next pointer of a block that has just been popped by another thread is safe.
+     *           Page and block statistics are always on, they are relaxed atomics that are updated per page, per block or per batch.
+     */
     class Allocator : private BaseAtomicClassNC
     {
+    public:
+        struct Stats_T
+        {
+            size_t m_dataSize;
+            size_t m_blockSize;
+            size_t m_pageSize;
+            size_t m_blocksPerPage;
+            size_t m_pages;
+            //! Blocks taken out of the free list, it includes blocks that are cached by thread caches
+            size_t m_usedBlocks;
+            //! High-water mark of m_usedBlocks
+            size_t m_peakUsedBlocks;
+        };
+
     public:
         NONCOPYABLE(Allocator);
         Allocator() = default;
         ~Allocator() { FreeAll(); }
 
         // resets the allocator to a new configuration
-        void Reset(size_t data_size, size_t page_size, size_t alignment) noexcept;
+        void Reset(size_t data_size, size_t page_size, size_t alignment, bool lock_free = false) noexcept;
+        inline bool IsLockFree() const noexcept { return m_bLockFree; }
         // alloc and free blocks
         void* Allocate() noexcept;
         void Free(void* p);
         void FreeAll() noexcept;
+        // alloc and free a list of num free blocks linked by pNext, used by thread caches to refill/return under a single lock
+        [[nodiscard]] BlockHeader* AllocateBatch(size_t num) noexcept;
+        void FreeBatch(BlockHeader* head, BlockHeader* tail, size_t num) noexcept;
+        // statistics, safe to call from any thread
+        [[nodiscard]] Stats_T GetStats() const noexcept;
     private:
-        void AllocateNewPage() noexcept;
+        // allocate a new page and link its blocks, return the first and the last block
+        BlockHeader* AllocateNewPage(BlockHeader*& tail);
+
+        // lock free free list
+        inline static uint64_t Pack(BlockHeader* block, uint64_t tag) noexcept
+        {
+            return (tag << kPointerBits) | (reinterpret_cast<uint64_t>(block) & kPointerMask);
+        }
+        inline static BlockHeader* Unpack(uint64_t head) noexcept
+        {
+            return reinterpret_cast<BlockHeader*>(head & kPointerMask);
+        }
+        BlockHeader* PopLockFree();
+        void PushLockFree(BlockHeader* head, BlockHeader* tail) noexcept;
+
+        inline void AddUsedBlocks(size_t num) noexcept
+        {
+            const auto used = m_nUsedBlocks.fetch_add(num, std::memory_order_relaxed) + num;
+            auto peak = m_nPeakUsedBlocks.load(std::memory_order_relaxed);
+            while (used > peak && !m_nPeakUsedBlocks.compare_exchange_weak(peak, used, std::memory_order_relaxed));
+        }
+
+        inline void RemoveUsedBlocks(size_t num) noexcept
+        {
+            m_nUsedBlocks.fetch_sub(num, std::memory_order_relaxed);
+        }
+
     private:
+        constexpr inline static uint64_t kPointerBits = {48};
+        constexpr inline static uint64_t kPointerMask = {(1ull << kPointerBits) - 1};
+
         // the page list
-        std::vector<PageHeader*> m_pPageList;
+        std::atomic<PageHeader*> m_pPageList = {nullptr};
 
         // the free block list
         CACHE_ALIGN BlockHeader * m_pFreeList = {nullptr};
 
+        // the free block list of a lock free allocator : 16 bits ABA tag | 48 bits pointer to the first free block
+        CACHE_ALIGN std::atomic_uint64_t m_freeListHead = {0};
+
+        // statistics, the used block counter shares the cache line of the free list head that is written anyway
+        std::atomic_size_t m_nUsedBlocks = {0};
+        std::atomic_size_t m_nPeakUsedBlocks = {0};
+        std::atomic_size_t m_nPages = {0};
+
+        bool m_bLockFree = {false};
+
         size_t m_szDataSize = {0};
         size_t m_szPageSize = {0};
         size_t m_szAlignmentSize = {0};
@@ -100,11 +207,6 @@ namespace longmarch
         size_t m_nBlocksPerPage = {0};
 
 #if defined(_DEBUG)
-        // statistics
-        size_t m_nPages = {0};
-        size_t m_nBlocks = {0};
-        size_t m_nFreeBlocks = {0};
-
         // debug patterns
         constexpr static const uint8_t PATTERN_ALIGN = 0xFC;
         constexpr static const uint8_t PATTERN_ALLOC = 0xFD;
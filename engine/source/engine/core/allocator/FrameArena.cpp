@@ -0,0 +1,220 @@
+#include "engine-precompiled-header.h"
+#include "FrameArena.h"
+#include "engine/core/thread/Lock.h"
+
+#ifndef ALIGN
+#define ALIGN(x, a)         (((x) + ((a) - 1)) & ~((a) - 1))
+#endif
+
+namespace longmarch
+{
+    namespace
+    {
+        //! Blocks that are returned by sub-arenas
+        std::vector<std::byte*>* s_pool = {new std::vector<std::byte*>()};
+
+        struct Retired_T
+        {
+            void* m_ptr;
+            uint64_t m_frame;
+            bool m_pooled;
+        };
+
+        //! Blocks of exited threads or late allocations that are released once their frame is over
+        std::vector<Retired_T>* s_retired = {new std::vector<Retired_T>()};
+
+        std::atomic_flag s_poolFlag;
+
+        std::byte* AcquireBlock()
+        {
+            {
+                atomic_flag_guard _lock(s_poolFlag);
+                if (!s_pool->empty())
+                {
+                    const auto block = s_pool->back();
+                    s_pool->pop_back();
+                    return block;
+                }
+            }
+            if (auto block = static_cast<std::byte*>(std::malloc(FrameArena::kBlockSize)); block)
+            [[likely]]
+            {
+                return block;
+            }
+            throw std::bad_alloc();
+        }
+
+        void* AllocateLarge(size_t size, size_t alignment, void*& raw)
+        {
+            if (raw = std::malloc(size + alignment); !raw)
+            [[unlikely]]
+            {
+                throw std::bad_alloc();
+            }
+            return reinterpret_cast<void*>(ALIGN(reinterpret_cast<uintptr_t>(raw), alignment));
+        }
+
+        class FrameResource_T final : public std::pmr::memory_resource
+        {
+        private:
+            void* do_allocate(size_t bytes, size_t alignment) override
+            {
+                return FrameArena::Allocate(bytes, alignment);
+            }
+
+            void do_deallocate(void* p, size_t bytes, size_t alignment) override
+            {
+                // Frame memory is released all at once
+            }
+
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+            {
+                return this == &other;
+            }
+        };
+    }
+
+    /**
+     *  @brief Frame memory of a single thread, one chain of blocks per buffer
+     */
+    struct FrameArena::SubArena_T
+    {
+        struct Buffer_T
+        {
+            std::vector<std::byte*> m_blocks;
+            std::vector<void*> m_largeBlocks;
+            uintptr_t m_cursor = {0};
+            uintptr_t m_end = {0};
+            //! Frame that the buffer is used for
+            uint64_t m_frame = {~0ull};
+
+            //! Keep the first block and release everything else
+            void Reset(uint64_t frame) noexcept
+            {
+                if (m_blocks.size() > 1)
+                {
+                    atomic_flag_guard _lock(s_poolFlag);
+                    s_pool->insert(s_pool->end(), m_blocks.begin() + 1, m_blocks.end());
+                    m_blocks.resize(1);
+                }
+                for (auto p : m_largeBlocks)
+                {
+                    std::free(p);
+                }
+                m_largeBlocks.clear();
+                if (!m_blocks.empty())
+                {
+                    m_cursor = reinterpret_cast<uintptr_t>(m_blocks.front());
+                    m_end = m_cursor + kBlockSize;
+                }
+                m_frame = frame;
+            }
+
+            [[nodiscard]] void* Allocate(size_t size, size_t alignment)
+            {
+                if (const auto p = ALIGN(m_cursor, alignment); m_cursor != 0 && p + size <= m_end)
+                [[likely]]
+                {
+                    m_cursor = p + size;
+                    return reinterpret_cast<void*>(p);
+                }
+                if (size + alignment > kMaxBumpSize)
+                {
+                    void* raw;
+                    auto ret = AllocateLarge(size, alignment, raw);
+                    m_largeBlocks.push_back(raw);
+                    return ret;
+                }
+                m_blocks.push_back(AcquireBlock());
+                m_cursor = reinterpret_cast<uintptr_t>(m_blocks.back());
+                m_end = m_cursor + kBlockSize;
+                const auto p = ALIGN(m_cursor, alignment);
+                m_cursor = p + size;
+                return reinterpret_cast<void*>(p);
+            }
+        };
+
+        Buffer_T m_buffers[kNumBuffers];
+
+        //! Return nullptr once the sub-arena of the calling thread is destroyed
+        inline static SubArena_T* Get() noexcept
+        {
+            if (s_subArenaDestroyed)
+            [[unlikely]]
+            {
+                return nullptr;
+            }
+            thread_local SubArena_T t_subArena;
+            return &t_subArena;
+        }
+
+        SubArena_T() = default;
+        ~SubArena_T()
+        {
+            s_subArenaDestroyed = true;
+            // Other threads might still read memory of this thread, so blocks are only released once their frames are over
+            atomic_flag_guard _lock(s_poolFlag);
+            for (const auto& buffer : m_buffers)
+            {
+                for (auto block : buffer.m_blocks)
+                {
+                    s_retired->emplace_back(Retired_T{block, buffer.m_frame, true});
+                }
+                for (auto p : buffer.m_largeBlocks)
+                {
+                    s_retired->emplace_back(Retired_T{p, buffer.m_frame, false});
+                }
+            }
+        }
+
+        inline static thread_local bool s_subArenaDestroyed = {false};
+    };
+}
+
+void longmarch::FrameArena::FrameStart() noexcept
+{
+    const auto frame = s_frameIndex.fetch_add(1, std::memory_order_acq_rel) + 1;
+    atomic_flag_guard _lock(s_poolFlag);
+    if (!s_retired->empty())
+    [[unlikely]]
+    {
+        std::erase_if(*s_retired, [frame](const Retired_T& retired)
+        {
+            if (retired.m_frame + kNumBuffers <= frame)
+            {
+                retired.m_pooled ? s_pool->push_back(static_cast<std::byte*>(retired.m_ptr)) : std::free(retired.m_ptr);
+                return true;
+            }
+            return false;
+        });
+    }
+}
+
+std::pmr::memory_resource* longmarch::FrameArena::GetMemoryResource() noexcept
+{
+    static FrameResource_T resource;
+    return &resource;
+}
+
+void* longmarch::FrameArena::Allocate(size_t size, size_t alignment)
+{
+    ASSERT(alignment > 0 && ((alignment & (alignment - 1))) == 0, "Alignment must be a power of 2!");
+    const auto frame = GetFrameIndex();
+    if (auto subArena = SubArena_T::Get(); subArena)
+    [[likely]]
+    {
+        auto& buffer = subArena->m_buffers[frame % kNumBuffers];
+        if (buffer.m_frame != frame)
+        [[unlikely]]
+        {
+            buffer.Reset(frame);
+        }
+        return buffer.Allocate(size, alignment);
+    }
+    // Late allocation on thread exit
+    void* raw;
+    auto ret = AllocateLarge(size, alignment, raw);
+    atomic_flag_guard _lock(s_poolFlag);
+    s_retired->emplace_back(Retired_T{raw, frame, false});
+    return ret;
+}
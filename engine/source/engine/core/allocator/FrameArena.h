@@ -0,0 +1,106 @@
+#pragma once
+#include "engine/core/EngineCore.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+namespace longmarch
+{
+    /**
+     *  @brief Double buffered linear (bump) allocator for temporaries that only live within a frame
+     *
+     *  Use it like : FrameVector<RigidBody*> rbs; rbs.reserve(n);
+     *				 auto p = static_cast<Foo*>(FrameArena::Allocate(sizeof(Foo), alignof(Foo)));
+     *
+     *  @details Each thread bumps a pointer in its own sub-arena, so allocation never locks unless the sub-arena needs a new 64KB block.
+     *           There is no free, memory allocated in frame N stays valid through frame N + 1 and is released all at once when frame N + 2 starts,
+     *           so frame memory could be handed to the next frame (e.g. to the render thread) but never be stored longer than that.
+     *           Sub-arenas are reset lazily on their first allocation of a frame, so FrameStart() is O(1).
+     *
+     *  @attention No destructor is called on frame memory, only store trivially destructible objects or objects whose destructor could be skipped
+     *
+     *  @author Hang Yu (yohan680919@gmail.com)
+     */
+    class ENGINE_API FrameArena
+    {
+    public:
+        NONINSTANTIABLE(FrameArena);
+
+        //! Begin a new frame, called by FramerateController::FrameStart
+        static void FrameStart() noexcept;
+
+        inline static uint64_t GetFrameIndex() noexcept
+        {
+            return s_frameIndex.load(std::memory_order_acquire);
+        }
+
+        //! Allocate frame memory, alignment must be a power of 2
+        [[nodiscard]] static void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+        //! Memory resource for std::pmr containers, deallocation is a no-op
+        [[nodiscard]] static std::pmr::memory_resource* GetMemoryResource() noexcept;
+
+    public:
+        // 64KB per block
+        constexpr inline static size_t kBlockSize = {1u << 16};
+
+        // Allocations larger than this get their own block
+        constexpr inline static size_t kMaxBumpSize = {kBlockSize >> 2};
+
+        // Number of frames a frame memory lives
+        constexpr inline static uint64_t kNumBuffers = {2};
+
+    private:
+        struct SubArena_T;
+
+        inline static std::atomic_uint64_t s_frameIndex = {0u};
+    };
+
+    /*
+        Reference https://en.cppreference.com/w/cpp/named_req/Allocator
+    */
+    template <class T>
+    struct FrameAllocator
+    {
+        using value_type = T;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+
+        using propagate_on_container_move_assignment = std::true_type;
+        using is_always_equal = std::true_type;
+
+        FrameAllocator() noexcept = default;
+        FrameAllocator(const FrameAllocator&) noexcept = default;
+
+        template <class U>
+        FrameAllocator(const FrameAllocator<U>&) noexcept
+        {
+        }
+
+        [[nodiscard]] T* allocate(std::size_t n)
+        {
+            return static_cast<T*>(FrameArena::Allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept
+        {
+            // Frame memory is released all at once
+        }
+    };
+
+    template <class W, class U>
+    inline bool operator==(const longmarch::FrameAllocator<W>&, const longmarch::FrameAllocator<U>&) { return true; }
+
+    template <class W, class U>
+    inline bool operator!=(const longmarch::FrameAllocator<W>&, const longmarch::FrameAllocator<U>&) { return false; }
+
+    //! Vector in frame memory, do not keep it beyond the next frame
+    template <class T>
+    using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+    //! String in frame memory, do not keep it beyond the next frame
+    using FrameString = std::basic_string<char, std::char_traits<char>, FrameAllocator<char>>;
+}
@@ -1,10 +1,249 @@
 #include "engine-precompiled-header.h"
 #include "MemoryManager.h"
+#include "MemoryStats.h"
 
 #ifndef ALIGN
 #define ALIGN(x, a)         (((x) + ((a) - 1)) & ~((a) - 1))
 #endif
 
+namespace longmarch
+{
+    namespace
+    {
+        // One slot per block size, the last slot counts allocations larger than kMaxBlockSize
+        constexpr size_t kNumStatSlots = {MemoryManager::kNumBlockSizes + 1};
+        constexpr size_t kLargeSlot = {MemoryManager::kNumBlockSizes};
+
+        /**
+         *  @brief Allocation counters of a thread, a thread that frees memory of another thread simply counts negative
+         */
+        struct Counters_T
+        {
+            std::atomic_int64_t m_blocks[kNumStatSlots] = {};
+            std::atomic_int64_t m_bytes[kNumStatSlots] = {};
+            std::atomic_int64_t m_tagBytes[kNumMemoryTags] = {};
+
+            //! Only called by the owning thread, so that counting does not need a locked instruction
+            inline void Add(size_t slot, int64_t num, int64_t bytes, size_t tag) noexcept
+            {
+                Bump(m_blocks[slot], num);
+                Bump(m_bytes[slot], bytes);
+                Bump(m_tagBytes[tag], bytes);
+            }
+
+            //! Could be called by any thread
+            inline void AddShared(size_t slot, int64_t num, int64_t bytes, size_t tag) noexcept
+            {
+                m_blocks[slot].fetch_add(num, std::memory_order_relaxed);
+                m_bytes[slot].fetch_add(bytes, std::memory_order_relaxed);
+                m_tagBytes[tag].fetch_add(bytes, std::memory_order_relaxed);
+            }
+
+            void AddTo(Counters_T& other) const noexcept
+            {
+                for (size_t i = 0; i < kNumStatSlots; ++i)
+                {
+                    other.m_blocks[i].fetch_add(m_blocks[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+                    other.m_bytes[i].fetch_add(m_bytes[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+                }
+                for (size_t i = 0; i < kNumMemoryTags; ++i)
+                {
+                    other.m_tagBytes[i].fetch_add(m_tagBytes[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+                }
+            }
+
+            inline static void Bump(std::atomic_int64_t& counter, int64_t value) noexcept
+            {
+                counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+            }
+        };
+
+        std::atomic_flag s_countersFlag;
+
+        //! Counters of living threads, function local so that allocations during static initialization are safe
+        std::vector<Counters_T*>& ThreadCounters()
+        {
+            static auto counters = new std::vector<Counters_T*>();
+            return *counters;
+        }
+
+        //! Counters of exited threads and of late calls on thread exit
+        Counters_T s_retiredCounters;
+
+        inline size_t ClampTag(uint64_t tag) noexcept
+        {
+            return static_cast<size_t>(std::min<uint64_t>(tag, kNumMemoryTags - 1));
+        }
+
+        class PoolResource_T final : public std::pmr::memory_resource
+        {
+        private:
+            void* do_allocate(size_t bytes, size_t alignment) override
+            {
+                if (alignment > MemoryManager::kAlignment)
+                [[unlikely]]
+                {
+                    return ::operator new(bytes, std::align_val_t{alignment});
+                }
+                if (auto p = MemoryManager::Allocate(bytes); p)
+                [[likely]]
+                {
+                    return p;
+                }
+                throw std::bad_alloc();
+            }
+
+            void do_deallocate(void* p, size_t bytes, size_t alignment) override
+            {
+                if (alignment > MemoryManager::kAlignment)
+                [[unlikely]]
+                {
+                    ::operator delete(p, bytes, std::align_val_t{alignment});
+                    return;
+                }
+                MemoryManager::Free(p, bytes);
+            }
+
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+            {
+                return this == &other;
+            }
+        };
+    }
+
+    /**
+     *  @brief Per thread magazines of free blocks, one per block size
+     *
+     *  @details Blocks of the same size are interchangeable, so a block freed by any thread simply goes to the cache of the freeing thread.
+     *           A magazine is refilled with a batch of blocks when it is empty, and returns a batch once it holds more than two batches.
+     *           Cached blocks remain marked as free so that double frees are still detected.
+     */
+    struct MemoryManager::ThreadCache_T
+    {
+        struct Magazine_T
+        {
+            BlockHeader* m_head = {nullptr};
+            uint32_t m_count = {0};
+        };
+
+        Magazine_T m_magazines[kNumBlockSizes];
+        Counters_T m_counters;
+
+        //! Return nullptr once the cache of the calling thread is destroyed
+        inline static ThreadCache_T* Get() noexcept
+        {
+            if (s_threadCacheDestroyed)
+            [[unlikely]]
+            {
+                return nullptr;
+            }
+            thread_local ThreadCache_T t_cache;
+            return &t_cache;
+        }
+
+        ThreadCache_T()
+        {
+            atomic_flag_guard _lock(s_countersFlag);
+            ThreadCounters().push_back(&m_counters);
+        }
+        ~ThreadCache_T()
+        {
+            s_threadCacheDestroyed = true;
+            for (size_t i = 0; i < kNumBlockSizes; ++i)
+            {
+                if (auto& magazine = m_magazines[i]; magazine.m_count > 0)
+                {
+                    _Return(i, magazine.m_count);
+                }
+            }
+            atomic_flag_guard _lock(s_countersFlag);
+            m_counters.AddTo(s_retiredCounters);
+            std::erase(ThreadCounters(), &m_counters);
+        }
+
+        //! Count an allocation (num = 1) or a free (num = -1) of the calling thread
+        inline static void Count(ThreadCache_T* cache, size_t slot, int64_t num, size_t size, size_t tag) noexcept
+        {
+            if (cache)
+            [[likely]]
+            {
+                cache->m_counters.Add(slot, num, num * static_cast<int64_t>(size), tag);
+            }
+            else
+            [[unlikely]]
+            {
+                s_retiredCounters.AddShared(slot, num, num * static_cast<int64_t>(size), tag);
+            }
+        }
+
+        inline static uint32_t BatchSize(size_t index) noexcept
+        {
+            return std::clamp(kBatchBytes / kBlockSizes[index], 4u, kMaxBatchSize);
+        }
+
+        inline void* Allocate(size_t index) noexcept
+        {
+            auto& magazine = m_magazines[index];
+            if (!magazine.m_head)
+            [[unlikely]]
+            {
+                magazine.m_count = BatchSize(index);
+                magazine.m_head = s_pAllocators[index].AllocateBatch(magazine.m_count);
+            }
+            BlockHeader* block = magazine.m_head;
+            magazine.m_head = block->pNext;
+            --magazine.m_count;
+            // Cached blocks came from the shared free list, a pop that lost its race there might still be reading this header
+            BlockHeader::StoreHeaderWord(block, nullptr, false);
+            return BlockHeader::GetPtr(block);
+        }
+
+        inline void Free(void* p, size_t index)
+        {
+            if (BlockHeader* block = BlockHeader::GetBlock(p);
+                block->pNext.free)
+            [[unlikely]]
+            {
+                throw std::runtime_error(std::string("Double free!"));
+            }
+            else
+            [[likely]]
+            {
+                auto& magazine = m_magazines[index];
+                BlockHeader::StoreHeaderWord(block, magazine.m_head, true);
+                magazine.m_head = block;
+                if (++magazine.m_count > 2 * BatchSize(index))
+                [[unlikely]]
+                {
+                    _Return(index, BatchSize(index));
+                }
+            }
+        }
+
+        //! Return the first num blocks of the magazine to the shared allocator
+        void _Return(size_t index, uint32_t num) noexcept
+        {
+            auto& magazine = m_magazines[index];
+            BlockHeader* head = magazine.m_head;
+            BlockHeader* tail = head;
+            for (auto i(1u); i < num; ++i)
+            {
+                tail = tail->pNext;
+            }
+            magazine.m_head = tail->pNext;
+            magazine.m_count -= num;
+            s_pAllocators[index].FreeBatch(head, tail, num);
+        }
+
+        // yuhang : thread_local objects are destroyed on thread exit while other thread_local destructors could still free memory,
+        // so this trivially destructible flag redirects those late calls to the shared allocators
+        inline static thread_local bool s_threadCacheDestroyed = {false};
+
+        //! Memory tag of the thread, it outlives the cache
+        inline static thread_local MemoryTag s_threadTag = {MemoryTag::GENERAL};
+    };
+}
+
 void longmarch::MemoryManager::Init()
 {
     // initialize block size lookup table
@@ -22,7 +261,7 @@ void longmarch::MemoryManager::Init()
     // initialize the allocators
     for (size_t i = 0; i < kNumBlockSizes; i++)
     {
-        s_pAllocators[i].Reset(kBlockSizes[i], kPageSize, kAlignment);
+        s_pAllocators[i].Reset(kBlockSizes[i], kPageSize, kAlignment, kLockFreeBlockSizes[i]);
     }
 }
 
@@ -45,15 +284,28 @@ void* longmarch::MemoryManager::Allocate(const size_t size) noexcept
     std::call_once(s_flag_init, MemoryManager::Init);
 
 #if CUSTOM_ALLOCATOR
+    const auto tag = static_cast<size_t>(ThreadCache_T::s_threadTag);
+    const auto cache = ThreadCache_T::Get();
     if (size <= kMaxBlockSize)
     [[likely]]
     {
-        return (s_pAllocators + s_pBlockSizeLookup[size])->Allocate();
+        const auto index = s_pBlockSizeLookup[size];
+        void* p = (cache) ? cache->Allocate(index) : (s_pAllocators + index)->Allocate();
+        BlockHeader::SetTag(p, tag);
+        ThreadCache_T::Count(cache, index, 1, size, tag);
+        return p;
     }
     else
     [[unlikely]]
     {
-        return malloc(size);
+        if (auto raw = static_cast<uint8_t*>(malloc(size + kLargeHeaderSize)); raw)
+        [[likely]]
+        {
+            *reinterpret_cast<uint64_t*>(raw) = tag;
+            ThreadCache_T::Count(cache, kLargeSlot, 1, size, tag);
+            return raw + kLargeHeaderSize;
+        }
+        return nullptr;
     }
 #else
 	return malloc(size);
@@ -64,20 +316,114 @@ void* longmarch::MemoryManager::Allocate(const size_t size) noexcept
 void longmarch::MemoryManager::Free(void* p, const size_t size) noexcept
 {
 #if CUSTOM_ALLOCATOR
+    const auto cache = ThreadCache_T::Get();
     if (size <= kMaxBlockSize)
     [[likely]]
     {
         /*
         Find the block size that was used to allocate pointer p by querying the block header.
         */
-        (s_pAllocators + s_pBlockSizeLookup[size])->Free(p);
+        const auto index = s_pBlockSizeLookup[size];
+        // Read the tag before the block is linked into a free list
+        const auto tag = ClampTag(BlockHeader::GetTag(p));
+        if (cache)
+        [[likely]]
+        {
+            cache->Free(p, index);
+        }
+        else
+        [[unlikely]]
+        {
+            (s_pAllocators + index)->Free(p);
+        }
+        ThreadCache_T::Count(cache, index, -1, size, tag);
     }
-    else
+    else if (p)
     [[unlikely]]
     {
-        free(p);
+        auto raw = static_cast<uint8_t*>(p) - kLargeHeaderSize;
+        ThreadCache_T::Count(cache, kLargeSlot, -1, size, ClampTag(*reinterpret_cast<uint64_t*>(raw)));
+        free(raw);
     }
 #else
 	free(p);
 #endif // CUSTOM_ALLOCATOR
 }
+
+
+size_t longmarch::MemoryManager::GetCurrentManagedMemory() noexcept
+{
+    int64_t bytes = 0;
+    atomic_flag_guard _lock(s_countersFlag);
+    for (const auto counters : ThreadCounters())
+    {
+        for (const auto& slot : counters->m_bytes)
+        {
+            bytes += slot.load(std::memory_order_relaxed);
+        }
+    }
+    for (const auto& slot : s_retiredCounters.m_bytes)
+    {
+        bytes += slot.load(std::memory_order_relaxed);
+    }
+    return static_cast<size_t>(std::max<int64_t>(bytes, 0));
+}
+
+std::pmr::memory_resource* longmarch::MemoryManager::GetMemoryResource() noexcept
+{
+    // Never destroyed, containers might release memory during exit
+    static auto resource = new PoolResource_T();
+    return resource;
+}
+
+longmarch::MemoryTag longmarch::MemoryManager::SetThreadTag(MemoryTag tag) noexcept
+{
+    return std::exchange(ThreadCache_T::s_threadTag, tag);
+}
+
+longmarch::MemoryTag longmarch::MemoryManager::GetThreadTag() noexcept
+{
+    return ThreadCache_T::s_threadTag;
+}
+
+void longmarch::MemoryManager::_CollectStats(MemorySnapshot& snapshot)
+{
+    std::call_once(s_flag_init, MemoryManager::Init);
+
+    Counters_T sum;
+    {
+        atomic_flag_guard _lock(s_countersFlag);
+        for (const auto counters : ThreadCounters())
+        {
+            counters->AddTo(sum);
+        }
+        s_retiredCounters.AddTo(sum);
+    }
+
+    snapshot.m_sizeClasses.resize(kNumBlockSizes);
+    for (size_t i = 0; i < kNumBlockSizes; ++i)
+    {
+        const auto stats = s_pAllocators[i].GetStats();
+        auto& pool = snapshot.m_sizeClasses[i];
+        pool.m_name = Str("%uB", kBlockSizes[i]);
+        pool.m_blockSize = stats.m_blockSize;
+        pool.m_pageSize = stats.m_pageSize;
+        pool.m_pages = stats.m_pages;
+        pool.m_blocks = stats.m_pages * stats.m_blocksPerPage;
+        pool.m_usedBlocks = stats.m_usedBlocks;
+        pool.m_peakUsedBlocks = stats.m_peakUsedBlocks;
+        // Counters of different threads are not read at the same instant, so clamp the transient disagreement
+        pool.m_liveBlocks = std::clamp<int64_t>(sum.m_blocks[i].load(std::memory_order_relaxed), 0, pool.m_usedBlocks);
+        pool.m_liveBytes = std::max<int64_t>(sum.m_bytes[i].load(std::memory_order_relaxed), 0);
+    }
+    snapshot.m_largeAllocations = std::max<int64_t>(sum.m_blocks[kLargeSlot].load(std::memory_order_relaxed), 0);
+    snapshot.m_largeBytes = std::max<int64_t>(sum.m_bytes[kLargeSlot].load(std::memory_order_relaxed), 0);
+
+    snapshot.m_tags.resize(kNumMemoryTags);
+    for (size_t i = 0; i < kNumMemoryTags; ++i)
+    {
+        auto& tag = snapshot.m_tags[i];
+        tag.m_name = kMemoryTagNames[i];
+        tag.m_liveBytes = std::max<int64_t>(sum.m_tagBytes[i].load(std::memory_order_relaxed), 0);
+    }
+}
\ No newline at end of file
@@ -1,5 +1,8 @@
 #pragma once
 #include <memory>
+#include <memory_resource>
+#include <cstddef>
+#include <new>
 #include "Allocator.h"
 #include "engine/core/exception/EngineException.h"
 
@@ -11,14 +14,48 @@
 
 namespace longmarch
 {
+    struct MemorySnapshot;
+
+    template <class T>
+    struct Mallocator;
+
+    //! Subsystem that MemoryManager allocations are accounted to, see MemoryTagScope
+    enum class MemoryTag : uint8_t
+    {
+        GENERAL = 0,
+        ECS,
+        PHYSICS,
+        RENDERER,
+        EVENT,
+        JOB,
+        ASSET,
+        UI,
+        NUM
+    };
+
+    constexpr inline uint32_t kNumMemoryTags = {static_cast<uint32_t>(MemoryTag::NUM)};
+
+    constexpr inline const char* kMemoryTagNames[] =
+    {
+        "General", "ECS", "Physics", "Renderer", "Event", "Job", "Asset", "UI"
+    };
+    static_assert(std::size(kMemoryTagNames) == kNumMemoryTags);
+
     /**
      *  @brief Custom MemoryManager that uses a segregated memory list for 8 , 32, 64 alignments, etc
      *
      *  Use it like : MemoryManager::Make_shared<T>(args...);
+     *				 LongMarch_Vector<T>, LongMarch_UnorderedMap<Key, T>, LongMarch_String, etc (see TypeHelper.h) allocate through Mallocator
      *				 MemoryManager::Make_unique<T>(args...);
      *				 Use std::allocator to allocate values with smaller than 8 bytes, it is not going to be efficient
      *
      *  @details Memory page size 4KB, max block size 960B. Class bigger than 960B would allocated by std::malloc 
+     *           Each thread keeps a cache of free blocks per block size in front of the shared allocators, so most allocations and frees
+     *           (including freeing blocks allocated by other threads) do not lock. Caches are refilled from and returned to the shared
+     *           allocators in batches.
+     *           Allocations are always accounted per block size and per memory tag of the allocating thread (see MemoryTagScope and MemoryStats),
+     *           each thread counts into its own relaxed atomics so that counting never locks nor bounces a cache line.
+     *           The tag is stored in the unused next pointer of the allocated block (or in front of a large allocation), so the free is charged to the same tag.
      *
      *  @attention DO NOT delete by base pointer! If you use MemoryManager::New and MemoryManager::Delete, you must new && delete by the same pointer type!
      *  
@@ -32,17 +69,20 @@ namespace longmarch
         static void Init();
         static void Shutdown();
 
-        inline static size_t GetCurrentManagedMemory() noexcept
-        {
-            return s_AllocatedSize;
-        }
+        //! Bytes that are currently allocated, summed over all threads
+        static size_t GetCurrentManagedMemory() noexcept;
+
+        //! Set the memory tag of the calling thread, return the previous one
+        static MemoryTag SetThreadTag(MemoryTag tag) noexcept;
+        static MemoryTag GetThreadTag() noexcept;
 
-        // Replacement for make_shared
+        // Replacement for make_shared, the object and its control block are allocated together as a single block.
+        // Memory of the object is released once the last weak_ptr is gone, prefer TemplateMemoryManager<T>::Make_shared for objects that are observed by long living weak_ptrs
         template <class T, typename... Arguments>
         [[nodiscard]] inline static std::shared_ptr<T> Make_shared(Arguments&&... args) noexcept
         {
 #if CUSTOM_ALLOCATOR == 1
-            return std::shared_ptr<T>(New<T>(std::forward<Arguments>(args)...), Delete<T>);
+            return std::allocate_shared<T>(Mallocator<T>(), std::forward<Arguments>(args)...);
 #else
 			return std::make_shared<T>(std::forward<Arguments>(args)...);
 #endif // CUSTOM_ALLOCATOR
@@ -70,8 +110,7 @@ namespace longmarch
         template <class T, typename... Arguments>
         [[nodiscard]] inline static T* New(Arguments&&... args) noexcept
         {
-            s_AllocatedSize += sizeof(T);
-            //DEBUG_PRINT("New : " + Str(typeid(T).name()) + " " + Str(sizeof(T)) + " " + Str(s_AllocatedSize));
+            //DEBUG_PRINT("New : " + Str(typeid(T).name()) + " " + Str(sizeof(T)) + " " + Str(GetCurrentManagedMemory()));
 #if CUSTOM_ALLOCATOR == 1
             return new(Allocate(sizeof(T))) T(std::forward<Arguments>(args)...);
 #else
@@ -83,8 +122,7 @@ namespace longmarch
         template <class T>
         inline static void Delete(T* p) noexcept
         {
-            s_AllocatedSize -= sizeof(T);
-            //DEBUG_PRINT("Delete : " + Str(typeid(T).name()) + " " + Str(sizeof(T)) + " " + Str(BlockHeader::GetSize(p)) + " " + Str(s_AllocatedSize));
+            //DEBUG_PRINT("Delete : " + Str(typeid(T).name()) + " " + Str(sizeof(T)) + " " + Str(BlockHeader::GetSize(p)) + " " + Str(GetCurrentManagedMemory()));
 #if CUSTOM_ALLOCATOR == 1
             p->~T();
             Free(p, sizeof(T));
@@ -100,6 +138,9 @@ namespace longmarch
         // Replacement for free()
         static void Free(void* p, const size_t size) noexcept;
 
+        //! Memory resource for std::pmr containers, it allocates from the pools and falls back to aligned new for alignments larger than kAlignment
+        [[nodiscard]] static std::pmr::memory_resource* GetMemoryResource() noexcept;
+
     public:
         constexpr inline static const uint32_t kBlockSizes[] =
         {
@@ -124,15 +165,66 @@ namespace longmarch
         // Largest valid block size
         constexpr inline static uint32_t kMaxBlockSize = {kBlockSizes[kNumBlockSizes - 1]};
 
+        // Whether the shared allocator of each block size is lock free, small blocks (control blocks, events, tasks) are the most contended ones
+        constexpr inline static bool kLockFreeBlockSizes[] =
+        {
+            true, true, true, true, true, true, true,
+            true, true, true, true, true,
+
+            true, true, true, true, true,
+            false, false, false, false, false, false,
+
+            false, false, false, false, false
+        };
+        static_assert(std::size(kLockFreeBlockSizes) == kNumBlockSizes);
+
+        // Max number of blocks moved between a thread cache and the shared allocator at once
+        constexpr inline static uint32_t kMaxBatchSize = {64};
+
+        // Bytes moved between a thread cache and the shared allocator at once, it bounds the batch size of large blocks
+        constexpr inline static uint32_t kBatchBytes = {1u << 13};
+
+        // Allocations larger than kMaxBlockSize are prefixed by their memory tag, it keeps the alignment of malloc
+        constexpr inline static uint32_t kLargeHeaderSize = {alignof(std::max_align_t)};
+
+    private:
+        friend class MemoryStats;
+
+        //! Fill per block size and per memory tag statistics of the snapshot
+        static void _CollectStats(MemorySnapshot& snapshot);
+
     private:
-        inline static CACHE_ALIGN std::atomic_size_t s_AllocatedSize = {0u};
+        struct ThreadCache_T;
 
         inline static size_t s_pBlockSizeLookup[kMaxBlockSize + 1] = {0};
         inline static Allocator s_pAllocators[kNumBlockSizes];
         inline static std::once_flag s_flag_init;
+    };
 
-        template <typename T>
-        friend struct Mallocator;
+    /**
+     *  @brief Account MemoryManager allocations of the calling thread to a memory tag within the scope
+     *
+     *  Use it like : MemoryTagScope _tag(MemoryTag::PHYSICS);
+     *
+     *  @details The tag is per thread, jobs that run on worker threads are accounted to the tag of the worker.
+     */
+    class MemoryTagScope
+    {
+    public:
+        NONCOPYABLE(MemoryTagScope);
+        MemoryTagScope() = delete;
+        explicit MemoryTagScope(MemoryTag tag) noexcept
+            :
+            m_prev(MemoryManager::SetThreadTag(tag))
+        {
+        }
+        ~MemoryTagScope()
+        {
+            MemoryManager::SetThreadTag(m_prev);
+        }
+
+    private:
+        MemoryTag m_prev;
     };
 
     /*
@@ -158,12 +250,16 @@ namespace longmarch
 
         [[nodiscard]] T* allocate(std::size_t n)
         {
+            // Blocks are only 8 bytes aligned (e.g. containers of SIMD types or over-aligned hash map slots)
+            if constexpr (alignof(T) > MemoryManager::kAlignment)
+            {
+                return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{alignof(T)}));
+            }
             // Using static_cast instead of reinterpret_cast because MemoryManager::Allocate might return nullptr or NULL
-            if (auto p = static_cast<T*>(MemoryManager::Allocate(n * sizeof(T))); p)
+            else if (auto p = static_cast<T*>(MemoryManager::Allocate(n * sizeof(T))); p)
             [[likely]]
             {
-                MemoryManager::s_AllocatedSize += n * sizeof(T);
-                //DEBUG_PRINT("Allocate vector : " + Str(typeid(T).name()) + " " + Str(n) + " " + Str(sizeof(T)) + " " + Str(n * sizeof(T)) + " " + Str(MemoryManager::s_AllocatedSize));
+                //DEBUG_PRINT("Allocate vector : " + Str(typeid(T).name()) + " " + Str(n) + " " + Str(sizeof(T)) + " " + Str(n * sizeof(T)) + " " + Str(MemoryManager::GetCurrentManagedMemory()));
                 return p;
             }
             else
@@ -175,9 +271,13 @@ namespace longmarch
 
         void deallocate(T* p, std::size_t n) noexcept
         {
+            if constexpr (alignof(T) > MemoryManager::kAlignment)
+            {
+                ::operator delete(p, n * sizeof(T), std::align_val_t{alignof(T)});
+                return;
+            }
             MemoryManager::Free(p, sizeof(T) * n);
-            MemoryManager::s_AllocatedSize -= n * sizeof(T);
-            //DEBUG_PRINT("Free vector : " + Str(typeid(T).name()) + " " + Str(n) + " " + Str(sizeof(T)) + " " + Str(n * sizeof(T)) + " " + Str(MemoryManager::s_AllocatedSize));
+            //DEBUG_PRINT("Free vector : " + Str(typeid(T).name()) + " " + Str(n) + " " + Str(sizeof(T)) + " " + Str(n * sizeof(T)) + " " + Str(MemoryManager::GetCurrentManagedMemory()));
         }
     };
 
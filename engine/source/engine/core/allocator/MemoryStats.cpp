@@ -0,0 +1,210 @@
+#include "engine-precompiled-header.h"
+#include "MemoryStats.h"
+#include "FrameArena.h"
+#include "engine/core/file-system/FileSystem.h"
+
+namespace longmarch
+{
+    namespace
+    {
+        struct Type_T
+        {
+            std::string m_name;
+            const Allocator* m_allocator;
+        };
+
+        std::atomic_flag s_typesFlag;
+
+        //! Allocators of TemplateMemoryManager types, function local so that registration during static initialization is safe
+        std::vector<Type_T>& Types()
+        {
+            static auto types = new std::vector<Type_T>();
+            return *types;
+        }
+
+        std::atomic_flag s_peaksFlag;
+        int64_t s_peakTagBytes[kNumMemoryTags] = {0};
+        int64_t s_peakLargeBytes = {0};
+        int64_t s_peakLiveBytes = {0};
+
+        void DiffPool(MemorySnapshot::Pool_T& to, const MemorySnapshot::Pool_T& from)
+        {
+            to.m_pages -= from.m_pages;
+            to.m_blocks -= from.m_blocks;
+            to.m_usedBlocks -= from.m_usedBlocks;
+            to.m_peakUsedBlocks -= from.m_peakUsedBlocks;
+            to.m_liveBlocks -= from.m_liveBlocks;
+            to.m_liveBytes -= from.m_liveBytes;
+        }
+
+        Json::Value PoolToJson(const MemorySnapshot::Pool_T& pool)
+        {
+            Json::Value value;
+            value["Name"] = pool.m_name;
+            value["Block-size"] = Json::Int64(pool.m_blockSize);
+            value["Pages"] = Json::Int64(pool.m_pages);
+            value["Reserved-bytes"] = Json::Int64(pool.ReservedBytes());
+            value["Blocks"] = Json::Int64(pool.m_blocks);
+            value["Used-blocks"] = Json::Int64(pool.m_usedBlocks);
+            value["Peak-used-blocks"] = Json::Int64(pool.m_peakUsedBlocks);
+            value["Live-blocks"] = Json::Int64(pool.m_liveBlocks);
+            value["Live-bytes"] = Json::Int64(pool.m_liveBytes);
+            value["Cached-blocks"] = Json::Int64(pool.CachedBlocks());
+            value["Free-blocks"] = Json::Int64(pool.FreeBlocks());
+            value["Fragmentation"] = pool.Fragmentation();
+            return value;
+        }
+    }
+}
+
+void longmarch::MemoryStats::RegisterType(const char* name, const Allocator* allocator)
+{
+    atomic_flag_guard _lock(s_typesFlag);
+    Types().emplace_back(Type_T{name, allocator});
+}
+
+longmarch::MemorySnapshot longmarch::MemoryStats::TakeSnapshot()
+{
+    MemorySnapshot snapshot;
+    snapshot.m_frame = FrameArena::GetFrameIndex();
+    MemoryManager::_CollectStats(snapshot);
+    {
+        atomic_flag_guard _lock(s_typesFlag);
+        snapshot.m_types.reserve(Types().size());
+        for (const auto& type : Types())
+        {
+            const auto stats = type.m_allocator->GetStats();
+            auto& pool = snapshot.m_types.emplace_back();
+            pool.m_name = type.m_name;
+            pool.m_blockSize = stats.m_blockSize;
+            pool.m_pageSize = stats.m_pageSize;
+            pool.m_pages = stats.m_pages;
+            pool.m_blocks = stats.m_pages * stats.m_blocksPerPage;
+            pool.m_usedBlocks = stats.m_usedBlocks;
+            pool.m_peakUsedBlocks = stats.m_peakUsedBlocks;
+            // Types are not cached by threads, so every used block is a live block
+            pool.m_liveBlocks = stats.m_usedBlocks;
+            pool.m_liveBytes = stats.m_usedBlocks * stats.m_dataSize;
+        }
+    }
+
+    snapshot.m_liveBytes = snapshot.m_largeBytes;
+    snapshot.m_reservedBytes = snapshot.m_largeBytes + snapshot.m_largeAllocations * MemoryManager::kLargeHeaderSize;
+    for (const auto& pools : {&snapshot.m_sizeClasses, &snapshot.m_types})
+    {
+        for (const auto& pool : *pools)
+        {
+            snapshot.m_liveBytes += pool.m_liveBytes;
+            snapshot.m_reservedBytes += pool.ReservedBytes();
+        }
+    }
+
+    atomic_flag_guard _lock(s_peaksFlag);
+    for (size_t i = 0; i < snapshot.m_tags.size(); ++i)
+    {
+        auto& tag = snapshot.m_tags[i];
+        tag.m_peakBytes = s_peakTagBytes[i] = std::max(s_peakTagBytes[i], tag.m_liveBytes);
+    }
+    snapshot.m_peakLargeBytes = s_peakLargeBytes = std::max(s_peakLargeBytes, snapshot.m_largeBytes);
+    snapshot.m_peakLiveBytes = s_peakLiveBytes = std::max(s_peakLiveBytes, snapshot.m_liveBytes);
+    return snapshot;
+}
+
+longmarch::MemorySnapshot longmarch::MemoryStats::Diff(const MemorySnapshot& from, const MemorySnapshot& to)
+{
+    MemorySnapshot ret = to;
+    ret.m_frame = to.m_frame - from.m_frame;
+    for (size_t i = 0; i < std::min(ret.m_sizeClasses.size(), from.m_sizeClasses.size()); ++i)
+    {
+        DiffPool(ret.m_sizeClasses[i], from.m_sizeClasses[i]);
+    }
+    for (auto& pool : ret.m_types)
+    {
+        if (auto it = std::find_if(from.m_types.begin(), from.m_types.end(), [&pool](const auto& other) { return other.m_name == pool.m_name; });
+            it != from.m_types.end())
+        {
+            DiffPool(pool, *it);
+        }
+    }
+    for (auto& tag : ret.m_tags)
+    {
+        if (auto it = std::find_if(from.m_tags.begin(), from.m_tags.end(), [&tag](const auto& other) { return other.m_name == tag.m_name; });
+            it != from.m_tags.end())
+        {
+            tag.m_liveBytes -= it->m_liveBytes;
+            tag.m_peakBytes -= it->m_peakBytes;
+        }
+    }
+    ret.m_largeAllocations -= from.m_largeAllocations;
+    ret.m_largeBytes -= from.m_largeBytes;
+    ret.m_peakLargeBytes -= from.m_peakLargeBytes;
+    ret.m_liveBytes -= from.m_liveBytes;
+    ret.m_peakLiveBytes -= from.m_peakLiveBytes;
+    ret.m_reservedBytes -= from.m_reservedBytes;
+    return ret;
+}
+
+Json::Value longmarch::MemoryStats::ToJson(const MemorySnapshot& snapshot)
+{
+    Json::Value value;
+    value["Frame"] = Json::UInt64(snapshot.m_frame);
+    value["Live-bytes"] = Json::Int64(snapshot.m_liveBytes);
+    value["Peak-live-bytes"] = Json::Int64(snapshot.m_peakLiveBytes);
+    value["Reserved-bytes"] = Json::Int64(snapshot.m_reservedBytes);
+    value["Large-allocations"] = Json::Int64(snapshot.m_largeAllocations);
+    value["Large-bytes"] = Json::Int64(snapshot.m_largeBytes);
+    value["Peak-large-bytes"] = Json::Int64(snapshot.m_peakLargeBytes);
+    {
+        auto& sizeClasses = value["Size-classes"] = Json::Value(Json::arrayValue);
+        for (const auto& pool : snapshot.m_sizeClasses)
+        {
+            sizeClasses.append(PoolToJson(pool));
+        }
+    }
+    {
+        auto& types = value["Types"] = Json::Value(Json::arrayValue);
+        for (const auto& pool : snapshot.m_types)
+        {
+            types.append(PoolToJson(pool));
+        }
+    }
+    {
+        auto& tags = value["Tags"] = Json::Value(Json::arrayValue);
+        for (const auto& tag : snapshot.m_tags)
+        {
+            Json::Value tagValue;
+            tagValue["Name"] = tag.m_name;
+            tagValue["Live-bytes"] = Json::Int64(tag.m_liveBytes);
+            tagValue["Peak-bytes"] = Json::Int64(tag.m_peakBytes);
+            tags.append(tagValue);
+        }
+    }
+    return value;
+}
+
+void longmarch::MemoryStats::DumpJson(const std::filesystem::path& file, const MemorySnapshot& snapshot)
+{
+    _WriteJson(file, ToJson(snapshot));
+}
+
+void longmarch::MemoryStats::DumpJson(const std::filesystem::path& file, const MemorySnapshot& snapshot, const MemorySnapshot& baseline)
+{
+    Json::Value value;
+    value["Current"] = ToJson(snapshot);
+    value["Baseline"] = ToJson(baseline);
+    value["Growth"] = ToJson(Diff(baseline, snapshot));
+    _WriteJson(file, value);
+}
+
+void longmarch::MemoryStats::_WriteJson(const std::filesystem::path& file, const Json::Value& value)
+{
+    Json::StreamWriterBuilder builder;
+    builder["commentStyle"] = "None";
+    builder["indentation"] = "    ";
+    builder["precision"] = 4;
+    builder["precisionType"] = "decimal";
+    std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+    auto& output = FileSystem::OpenOfstream(file, FileSystem::FileType::OPEN_TEXT);
+    writer->write(value, &output);
+    FileSystem::CloseOfstream(file);
+}
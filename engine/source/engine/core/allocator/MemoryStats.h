@@ -0,0 +1,103 @@
+#pragma once
+#include "MemoryManager.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <json/json.h>
+
+namespace longmarch
+{
+    /**
+     *  @brief Point in time statistics of managed memory, see MemoryStats::TakeSnapshot()
+     *
+     *  @author Hang Yu (yohan680919@gmail.com)
+     */
+    struct MemorySnapshot
+    {
+        //! Statistics of a block size of MemoryManager or of a TemplateMemoryManager type
+        struct Pool_T
+        {
+            std::string m_name;
+            int64_t m_blockSize = {0};
+            int64_t m_pageSize = {0};
+            int64_t m_pages = {0};
+            //! Blocks of all pages
+            int64_t m_blocks = {0};
+            //! Blocks taken out of the shared allocator, it includes blocks that are cached by thread caches
+            int64_t m_usedBlocks = {0};
+            //! High-water mark of m_usedBlocks
+            int64_t m_peakUsedBlocks = {0};
+            //! Blocks that are allocated by users
+            int64_t m_liveBlocks = {0};
+            //! Bytes that are requested by users
+            int64_t m_liveBytes = {0};
+
+            inline int64_t FreeBlocks() const { return m_blocks - m_liveBlocks; }
+            inline int64_t CachedBlocks() const { return m_usedBlocks - m_liveBlocks; }
+            inline int64_t ReservedBytes() const { return m_pages * m_pageSize; }
+            //! Ratio of free blocks to all blocks of the pages, pages are never released so it grows after a peak
+            inline double Fragmentation() const { return (m_blocks > 0) ? static_cast<double>(FreeBlocks()) / m_blocks : 0.0; }
+        };
+
+        //! Statistics of a memory tag
+        struct Tag_T
+        {
+            std::string m_name;
+            int64_t m_liveBytes = {0};
+            int64_t m_peakBytes = {0};
+        };
+
+        uint64_t m_frame = {0};
+        std::vector<Pool_T> m_sizeClasses;
+        std::vector<Pool_T> m_types;
+        std::vector<Tag_T> m_tags;
+        //! Allocations of MemoryManager that are larger than its max block size
+        int64_t m_largeAllocations = {0};
+        int64_t m_largeBytes = {0};
+        int64_t m_peakLargeBytes = {0};
+        //! Bytes that are allocated by users over all size classes, types and large allocations
+        int64_t m_liveBytes = {0};
+        int64_t m_peakLiveBytes = {0};
+        //! Bytes of all pages and large allocations
+        int64_t m_reservedBytes = {0};
+    };
+
+    /**
+     *  @brief Memory accounting of MemoryManager size classes, TemplateMemoryManager types and memory tags
+     *
+     *  Use it like : auto baseline = MemoryStats::TakeSnapshot();
+     *				 ...
+     *				 MemoryStats::DumpJson("$root:memory-stats.json", MemoryStats::TakeSnapshot(), baseline);
+     *
+     *  @details Counting is always on and done by the allocators, taking a snapshot sums the per thread counters and the page statistics.
+     *           High-water marks of allocator blocks are exact, high-water marks of memory tags, large allocations and live bytes are
+     *           sampled by snapshots. Diff two snapshots of a long running session to find the pool, type or tag that keeps growing.
+     *
+     *  @author Hang Yu (yohan680919@gmail.com)
+     */
+    class ENGINE_API MemoryStats
+    {
+    public:
+        NONINSTANTIABLE(MemoryStats);
+
+        //! Called by TemplateMemoryManager<T>::Init
+        static void RegisterType(const char* name, const Allocator* allocator);
+
+        [[nodiscard]] static MemorySnapshot TakeSnapshot();
+
+        //! Element wise to - from, types and tags are matched by name, a type that only exists in to is diffed against zero
+        [[nodiscard]] static MemorySnapshot Diff(const MemorySnapshot& from, const MemorySnapshot& to);
+
+        [[nodiscard]] static Json::Value ToJson(const MemorySnapshot& snapshot);
+
+        //! Write the snapshot as json, it does not need a window nor the editor
+        static void DumpJson(const std::filesystem::path& file, const MemorySnapshot& snapshot);
+
+        //! Write the snapshot and its growth since the baseline as json
+        static void DumpJson(const std::filesystem::path& file, const MemorySnapshot& snapshot, const MemorySnapshot& baseline);
+
+    private:
+        static void _WriteJson(const std::filesystem::path& file, const Json::Value& value);
+    };
+}
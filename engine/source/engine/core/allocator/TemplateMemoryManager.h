@@ -1,13 +1,18 @@
 ﻿#pragma once
 
 #include "MemoryManager.h"
+#include "MemoryStats.h"
 
 namespace longmarch
 {
+    template <class T>
+    struct TemplateMallocator;
+
     /**
      *  @brief A specialized memory manager for a given template class
      *
      *  @detail Support maximum class size of 4096 byte, consider using malloc for class bigger than that.
+     *          The allocator of each type is registered to MemoryStats, so its pages, live blocks and high-water mark are reported per type.
      */
     template <class T>
     class ENGINE_API TemplateMemoryManager
@@ -20,15 +25,26 @@ namespace longmarch
 
         inline static size_t GetCurrentManagedMemory() noexcept
         {
-            return s_AllocatedSize;
+            return s_Allocator.GetStats().m_usedBlocks * sizeof(T);
         }
 
-        // Replacement for make_shared
+        // Replacement for make_shared, the object lives in the type pool and its control block is allocated by MemoryManager
         template <typename... Arguments>
         [[nodiscard]] inline static std::shared_ptr<T> Make_shared(Arguments&&... args) noexcept
         {
 #if CUSTOM_ALLOCATOR == 1
-            return std::shared_ptr<T>(New(std::forward<Arguments>(args)...), Delete);
+            return std::shared_ptr<T>(New(std::forward<Arguments>(args)...), Delete, Mallocator<T>());
+#else
+			return std::make_shared<T>(std::forward<Arguments>(args)...);
+#endif // CUSTOM_ALLOCATOR
+        }
+
+        // Replacement for make_shared for short living objects that are created by the thousands (e.g. events), the object and its control block share one block of a pool of their own
+        template <typename... Arguments>
+        [[nodiscard]] inline static std::shared_ptr<T> Make_shared_pooled(Arguments&&... args)
+        {
+#if CUSTOM_ALLOCATOR == 1
+            return std::allocate_shared<T>(TemplateMallocator<T>(), std::forward<Arguments>(args)...);
 #else
 			return std::make_shared<T>(std::forward<Arguments>(args)...);
 #endif // CUSTOM_ALLOCATOR
@@ -56,8 +72,7 @@ namespace longmarch
         template <typename... Arguments>
         [[nodiscard]] inline static T* New(Arguments&&... args) noexcept
         {
-            s_AllocatedSize += sizeof(T);
-            //DEBUG_PRINT("New : " + Str(typeid(T).name()) + " " + Str(sizeof(T)) + " " + Str(s_AllocatedSize));
+            //DEBUG_PRINT("New : " + Str(typeid(T).name()) + " " + Str(sizeof(T)) + " " + Str(GetCurrentManagedMemory()));
 #if CUSTOM_ALLOCATOR == 1
             return new(Allocate()) T(std::forward<Arguments>(args)...);
 #else
@@ -68,8 +83,7 @@ namespace longmarch
         // Replacement for delete
         inline static void Delete(T* p) noexcept
         {
-            s_AllocatedSize -= sizeof(T);
-            //DEBUG_PRINT("Delete : " + Str(typeid(T).name()) + " " + Str(sizeof(T)) + " " + Str(BlockHeader::GetSize(p)) + " " + Str(s_AllocatedSize));
+            //DEBUG_PRINT("Delete : " + Str(typeid(T).name()) + " " + Str(sizeof(T)) + " " + Str(BlockHeader::GetSize(p)) + " " + Str(GetCurrentManagedMemory()));
 #if CUSTOM_ALLOCATOR == 1
             p->~T();
             Free(p);
@@ -93,8 +107,8 @@ namespace longmarch
             (bUseLargeBlock) ? kPageSizeLarge : kPageSize - sizeof(BlockHeader)
         };
         constexpr inline static uint32_t kAlignment = {1u << 3};
-
-        inline static CACHE_ALIGN std::atomic_size_t s_AllocatedSize = {0u};
+        // Allocate and free w/o locking, e.g. archetype chunks are allocated by parallel jobs
+        constexpr inline static bool kLockFree = {true};
 
         inline static Allocator s_Allocator;
         inline static std::once_flag s_flag_init;
@@ -111,7 +125,9 @@ namespace longmarch
         // initialize the allocator
         s_Allocator.Reset(sizeof(T),
                           (!bUseLargeBlock) ? kPageSize : kPageSizeLarge,
-                          kAlignment);
+                          kAlignment,
+                          kLockFree);
+        MemoryStats::RegisterType(typeid(T).name(), &s_Allocator);
     }
 
     template <class T>
@@ -146,4 +162,65 @@ namespace longmarch
         free(p);
 #endif
     }
+
+    /*
+        Allocate single objects from the pool of their type, std::allocate_shared rebinds it to the type of its control block.
+        Arrays and over-aligned types are allocated by Mallocator.
+    */
+    template <class T>
+    struct TemplateMallocator
+    {
+        using value_type = T;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+
+        using propagate_on_container_move_assignment = std::true_type;
+        using is_always_equal = std::true_type;
+
+        TemplateMallocator() noexcept = default;
+        TemplateMallocator(const TemplateMallocator&) noexcept = default;
+
+        template <class U>
+        TemplateMallocator(const TemplateMallocator<U>&) noexcept
+        {
+        }
+
+        [[nodiscard]] T* allocate(std::size_t n)
+        {
+            if constexpr (alignof(T) <= MemoryManager::kAlignment)
+            {
+                if (n == 1)
+                [[likely]]
+                {
+                    if (auto p = static_cast<T*>(TemplateMemoryManager<T>::Allocate()); p)
+                    [[likely]]
+                    {
+                        return p;
+                    }
+                    throw std::bad_alloc();
+                }
+            }
+            return Mallocator<T>().allocate(n);
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept
+        {
+            if constexpr (alignof(T) <= MemoryManager::kAlignment)
+            {
+                if (n == 1)
+                [[likely]]
+                {
+                    TemplateMemoryManager<T>::Free(p);
+                    return;
+                }
+            }
+            Mallocator<T>().deallocate(p, n);
+        }
+    };
+
+    template <class W, class U>
+    inline bool operator==(const longmarch::TemplateMallocator<W>&, const longmarch::TemplateMallocator<U>&) { return true; }
+
+    template <class W, class U>
+    inline bool operator!=(const longmarch::TemplateMallocator<W>&, const longmarch::TemplateMallocator<U>&) { return false; }
 }
@@ -0,0 +1,168 @@
+#include "engine-precompiled-header.h"
+#include "FrameProfiler.h"
+#include "engine/core/file-system/FileSystem.h"
+
+#include <iomanip>
+#include <unordered_set>
+
+namespace longmarch
+{
+	namespace
+	{
+		void WriteEscaped(std::ostream& os, const char* s)
+		{
+			for (; *s; ++s)
+			{
+				switch (*s)
+				{
+				case '"':
+					os << "\\\"";
+					break;
+				case '\\':
+					os << "\\\\";
+					break;
+				case '\n':
+					os << "\\n";
+					break;
+				default:
+					os << *s;
+					break;
+				}
+			}
+		}
+	}
+}
+
+void longmarch::FrameProfiler::Start()
+{
+	Clear();
+	s_recording.store(true, std::memory_order_release);
+}
+
+void longmarch::FrameProfiler::Stop()
+{
+	s_recording.store(false, std::memory_order_release);
+}
+
+void longmarch::FrameProfiler::Clear()
+{
+	LOCK_GUARD_S();
+	for (auto buffer : _Buffers())
+	{
+		buffer->m_cleared.store(buffer->m_head.load(std::memory_order_acquire), std::memory_order_relaxed);
+	}
+}
+
+void longmarch::FrameProfiler::SetThreadName(const std::string& name)
+{
+	auto buffer = _GetThreadBuffer();
+	LOCK_GUARD_S();
+	buffer->m_name = name;
+}
+
+const char* longmarch::FrameProfiler::InternName(const std::string& name)
+{
+	static auto names = new std::unordered_set<std::string>();
+	LOCK_GUARD_S();
+	return names->emplace(name).first->c_str();
+}
+
+longmarch::FrameProfiler::ThreadBuffer_T* longmarch::FrameProfiler::_GetThreadBuffer()
+{
+	if (!t_buffer)
+	{
+		auto buffer = new ThreadBuffer_T();
+		LOCK_GUARD_S();
+		auto& buffers = _Buffers();
+		buffer->m_tid = static_cast<uint32_t>(buffers.size());
+		buffer->m_name = Str("Thread %u", buffer->m_tid);
+		buffers.emplace_back(buffer);
+		t_buffer = buffer;
+	}
+	return t_buffer;
+}
+
+std::vector<longmarch::FrameProfiler::ThreadBuffer_T*>& longmarch::FrameProfiler::_Buffers()
+{
+	// yuhang : function local so that threads that start during static initialization are safe, buffers are never released so that
+	// the events of threads that have exited can still be exported
+	static auto buffers = new std::vector<ThreadBuffer_T*>();
+	return *buffers;
+}
+
+longmarch::FrameProfiler::ThreadBuffer_T* longmarch::FrameProfiler::_AllocateEvents() noexcept
+{
+	auto buffer = _GetThreadBuffer();
+	if (!buffer->m_events)
+	{
+		// yuhang : published to readers by the release store of m_head of the first event
+		buffer->m_events = std::make_unique<Event_T[]>(kEventsPerThread);
+	}
+	return buffer;
+}
+
+std::vector<std::pair<std::string, std::vector<longmarch::FrameProfiler::Event_T>>> longmarch::FrameProfiler::Collect()
+{
+	std::vector<std::pair<std::string, std::vector<Event_T>>> ret;
+	LOCK_GUARD_S();
+	const auto& buffers = _Buffers();
+	ret.reserve(buffers.size());
+	for (auto buffer : buffers)
+	{
+		auto& [name, events] = ret.emplace_back(buffer->m_name, std::vector<Event_T>());
+		const auto head = buffer->m_head.load(std::memory_order_acquire);
+		if (head == 0)
+		{
+			continue;
+		}
+		const auto cleared = buffer->m_cleared.load(std::memory_order_relaxed);
+		auto tail = std::max(cleared, (head > kEventsPerThread) ? head - kEventsPerThread : 0);
+		events.reserve(head - tail);
+		for (auto i = tail; i < head; ++i)
+		{
+			events.emplace_back(buffer->m_events[i & (kEventsPerThread - 1)]);
+		}
+		// Events whose slots the owning thread has written to while they were being copied may be torn, drop them
+		const auto newHead = buffer->m_head.load(std::memory_order_acquire);
+		if (newHead + 1 > kEventsPerThread + tail)
+		{
+			events.erase(events.begin(), events.begin() + std::min<size_t>(events.size(), newHead + 1 - kEventsPerThread - tail));
+		}
+	}
+	return ret;
+}
+
+void longmarch::FrameProfiler::DumpChromeTrace(const std::filesystem::path& file)
+{
+	const auto threads = Collect();
+	auto& os = FileSystem::OpenOfstream(file, FileSystem::FileType::OPEN_TEXT);
+	os << std::fixed << std::setprecision(3);
+	os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"LongMarch\"}}";
+	for (uint32_t tid = 0; tid < threads.size(); ++tid)
+	{
+		const auto& [name, events] = threads[tid];
+		os << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << tid << ",\"args\":{\"name\":\"";
+		WriteEscaped(os, name.c_str());
+		os << "\"}}";
+		os << ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":0,\"tid\":" << tid << ",\"args\":{\"sort_index\":" << tid << "}}";
+		for (const auto& e : events)
+		{
+			// Chrome trace timestamps are in microseconds
+			os << ",\n{\"name\":\"";
+			WriteEscaped(os, e.m_name);
+			switch (e.m_type)
+			{
+			case EventType::SCOPE:
+				os << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << tid << ",\"ts\":" << e.m_begin * 1e-3 << ",\"dur\":" << (e.m_end - e.m_begin) * 1e-3
+					<< ",\"args\":{\"depth\":" << e.m_depth << "}}";
+				break;
+			case EventType::COUNTER:
+				os << "\",\"ph\":\"C\",\"pid\":0,\"tid\":" << tid << ",\"ts\":" << e.m_begin * 1e-3 << ",\"args\":{\"value\":" << e.m_value << "}}";
+				break;
+			}
+		}
+	}
+	os << "\n]}\n";
+	FileSystem::CloseOfstream(file);
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include "engine/core/thread/Lock.h"
+
+namespace longmarch
+{
+	/**
+	 * @brief Hierarchical CPU profiler that records nested scopes and counters into per thread ring buffers and exports them as a Chrome trace
+	 *
+	 * Use it like : FrameProfiler::Start();
+	 *				 { PROFILE_SCOPE("Physics"); ... { PROFILE_SCOPE("Broadphase"); ... } }
+	 *				 PROFILE_COUNTER("Contacts", numContacts);
+	 *				 FrameProfiler::Stop();
+	 *				 FrameProfiler::DumpChromeTrace("$root:trace.json");
+	 *
+	 * Open the trace in chrome://tracing or https://ui.perfetto.dev, it needs neither a window nor a network connection.
+	 *
+	 * @details Every thread owns a ring buffer of kEventsPerThread events and is the only writer of it, recording a scope is two clock reads
+	 * and a store without any lock. Rings keep the latest events, so a long capture keeps its last kEventsPerThread events of each thread.
+	 * A scope is recorded as a complete event when it closes, its depth is kept for hierarchical views. Names must outlive the capture,
+	 * use string literals or InternName(). Exporting during a capture drops the events that are overwritten while being copied.
+	 *
+	 * @author Hang Yu (yohan680919@gmail.com)
+	 */
+	class FrameProfiler : public BaseAtomicClassStatic
+	{
+	public:
+		NONINSTANTIABLE(FrameProfiler);
+
+		//! 5MB per thread that records anything, allocated on its first event
+		constexpr inline static size_t kEventsPerThread = { 1u << 17 };
+
+		enum class EventType : uint8_t
+		{
+			SCOPE = 0,
+			COUNTER,
+		};
+
+		struct Event_T
+		{
+			const char* m_name;
+			//! Nanoseconds since the process started
+			int64_t m_begin;
+			int64_t m_end;
+			double m_value;
+			uint32_t m_depth;
+			EventType m_type;
+		};
+
+		//! RAII scope, see PROFILE_SCOPE
+		class Scope
+		{
+		public:
+			NONCOPYABLE(Scope);
+			explicit Scope(const char* name) noexcept
+			{
+				if (IsRecording())
+				[[unlikely]]
+				{
+					m_name = name;
+					m_depth = t_depth++;
+					m_begin = Now();
+				}
+			}
+			~Scope() noexcept
+			{
+				End();
+			}
+			//! Close the scope before it goes out of C++ scope
+			void End() noexcept
+			{
+				if (m_name)
+				[[unlikely]]
+				{
+					--t_depth;
+					_Record({ m_name, m_begin, Now(), 0.0, m_depth, EventType::SCOPE });
+					m_name = nullptr;
+				}
+			}
+
+		private:
+			const char* m_name = { nullptr };
+			int64_t m_begin = { 0 };
+			uint32_t m_depth = { 0 };
+		};
+
+		static void Start();
+		static void Stop();
+		inline static bool IsRecording() noexcept { return s_recording.load(std::memory_order_relaxed); }
+
+		//! Drop every recorded event
+		static void Clear();
+
+		inline static int64_t Now() noexcept
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_epoch).count();
+		}
+
+		//! Sample a counter, it shows as a graph in the trace
+		inline static void Counter(const char* name, double value) noexcept
+		{
+			if (IsRecording())
+			[[unlikely]]
+			{
+				const auto now = Now();
+				_Record({ name, now, now, value, t_depth, EventType::COUNTER });
+			}
+		}
+
+		//! Name the timeline of the calling thread
+		static void SetThreadName(const std::string& name);
+
+		//! Return a copy of the name that lives as long as the process, for names that are built at runtime
+		[[nodiscard]] static const char* InternName(const std::string& name);
+
+		//! Copy the events of all threads, each thread in the order its scopes closed
+		[[nodiscard]] static std::vector<std::pair<std::string, std::vector<Event_T>>> Collect();
+
+		//! Write recorded events in the Chrome trace event format that chrome://tracing and Perfetto load
+		static void DumpChromeTrace(const std::filesystem::path& file);
+
+	private:
+		struct ThreadBuffer_T
+		{
+			std::string m_name;
+			uint32_t m_tid = { 0 };
+			std::unique_ptr<Event_T[]> m_events;
+			//! Number of events ever written, only the owning thread writes it
+			std::atomic_uint64_t m_head = { 0 };
+			//! Events before it have been cleared
+			std::atomic_uint64_t m_cleared = { 0 };
+		};
+
+		static std::vector<ThreadBuffer_T*>& _Buffers();
+		static ThreadBuffer_T* _GetThreadBuffer();
+
+		inline static void _Record(const Event_T& e) noexcept
+		{
+			auto buffer = t_buffer;
+			if (!buffer || !buffer->m_events)
+			[[unlikely]]
+			{
+				buffer = _AllocateEvents();
+			}
+			const auto head = buffer->m_head.load(std::memory_order_relaxed);
+			buffer->m_events[head & (kEventsPerThread - 1)] = e;
+			buffer->m_head.store(head + 1, std::memory_order_release);
+		}
+
+		static ThreadBuffer_T* _AllocateEvents() noexcept;
+
+	private:
+		inline static std::atomic_bool s_recording = { false };
+		inline static const std::chrono::steady_clock::time_point s_epoch = { std::chrono::steady_clock::now() };
+		inline static thread_local ThreadBuffer_T* t_buffer = { nullptr };
+		inline static thread_local uint32_t t_depth = { 0 };
+	};
+}
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#ifndef _SHIPPING
+#define PROFILE_SCOPE(name) longmarch::FrameProfiler::Scope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_COUNTER(name, value) longmarch::FrameProfiler::Counter(name, static_cast<double>(value))
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNTER(name, value)
+#endif
@@ -2,6 +2,7 @@
 
 #include "Instrumentor.h"
 #include "InstumentingTimer.h"
+#include "FrameProfiler.h"
 
 #ifndef _SHIPPING
 #define ENG_TIME(name) InstrumentingTimer eng_timer##__LINE__(name, longmarch::Instrumentor::GetEngineInstance())
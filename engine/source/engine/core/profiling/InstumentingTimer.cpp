@@ -8,7 +8,8 @@ namespace longmarch
 		:
 		m_name(name), 
 		m_stopped(false), 
-		m_instumentor(instrumentor) 
+		m_instumentor(instrumentor),
+		m_scope(name)
 	{
 		m_timeBegin = std::chrono::high_resolution_clock::now();
 	}
@@ -24,6 +25,7 @@ namespace longmarch
 	void InstrumentingTimer::End() 
 	{
 		m_stopped = true;
+		m_scope.End();
 		auto timeEnd = std::chrono::high_resolution_clock::now();
 		auto duration = std::chrono::duration<double>(timeEnd - m_timeBegin).count(); // in seconds
 		auto timeInMilliSeconds = duration * 1000.0;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <chrono>
+#include "FrameProfiler.h"
 
 namespace longmarch 
 {
@@ -8,7 +9,7 @@ namespace longmarch
 	class RemoteryInstrumentor;
 
 	/*
-		InstrumentingTimer class follows RAII pattern.
+		InstrumentingTimer class follows RAII pattern, the timed scope is also recorded by the FrameProfiler.
 	*/
 	class InstrumentingTimer 
 	{
@@ -23,5 +24,6 @@ namespace longmarch
 		bool m_stopped;
 		std::chrono::time_point<std::chrono::high_resolution_clock> m_timeBegin;
 		Instrumentor* m_instumentor;
+		FrameProfiler::Scope m_scope;
 	};
 }
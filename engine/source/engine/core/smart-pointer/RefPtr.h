@@ -16,9 +16,10 @@ namespace longmarch
             m_refCounter.fetch_add(1, std::memory_order_relaxed);
         }
 
+        //! Return false if the last reference is gone, acquire-release so that the deleting thread sees all writes of other owners
         inline bool DecrementRef() const noexcept
         {
-            return m_refCounter.fetch_add(-1, std::memory_order_relaxed) > 1;
+            return m_refCounter.fetch_sub(1, std::memory_order_acq_rel) > 1;
         }
 
     protected:
@@ -50,7 +51,11 @@ namespace longmarch
      *          On destruction, the RefPtr tries to decrement the reference counting.
      *
      *  @attention Only those T* created by RefPtr<T>::Allocator::New can be managed by RefPtr<T>.
-     * 
+     *
+     *  @details Prefer RefPtr over std::shared_ptr for objects that are copied around in hot paths, the counter lives in the object
+     *           so that a copy costs one increment on a cache line that is about to be touched anyway, and there is no control block.
+     *           Code that does not take part in ownership (e.g. queries, per frame lists) should pass T* from get() instead of copying.
+     *
      */
     template <class T, typename Allocator_T = TemplateMemoryManager<T>>
     class RefPtr
@@ -64,19 +69,23 @@ namespace longmarch
         {
         }
 
+        RefPtr(std::nullptr_t)
+            : m_ptr(nullptr)
+        {
+        }
+
         RefPtr(T* ref)
             : m_ptr(ref)
         {
-            m_ptr->IncrementRef();
+            if (m_ptr)
+            {
+                m_ptr->IncrementRef();
+            }
         }
 
         ~RefPtr()
         {
-            if (m_ptr && !m_ptr->DecrementRef())
-            {
-                Allocator::Delete(m_ptr);
-                m_ptr = nullptr;
-            }
+            reset();
         }
 
         RefPtr(const RefPtr& other)
@@ -98,12 +107,14 @@ namespace longmarch
         {
             if (this == &other)
                 return *this;
-            this->~RefPtr();
-            m_ptr = other.m_ptr;
-            if (m_ptr)
+            // Take the new reference before releasing the old one in case both point to the same object
+            auto ptr = other.m_ptr;
+            if (ptr)
             {
-                m_ptr->IncrementRef();
+                ptr->IncrementRef();
             }
+            reset();
+            m_ptr = ptr;
             return *this;
         }
 
@@ -111,9 +122,9 @@ namespace longmarch
         {
             if (this == &other)
                 return *this;
-            this->~RefPtr();
-            m_ptr = other.m_ptr;
-            other.m_ptr = nullptr;
+            auto ptr = std::exchange(other.m_ptr, nullptr);
+            reset();
+            m_ptr = ptr;
             return *this;
         }
 
@@ -145,42 +156,37 @@ namespace longmarch
 
         // Operator overloading---------------------------------------------------------------------------------------------
 
-        T* operator->() noexcept
+        // yuhang : constness is shallow like raw pointers and std::shared_ptr, so that a const RefPtr can hand out the pointee to non-owning code
+        T* operator->() const noexcept
         {
             ASSERT(valid(), "RefPtr nullptr error!");
             return m_ptr;
         }
 
-        T& operator*() noexcept
+        T& operator*() const noexcept
         {
             ASSERT(valid(), "RefPtr nullptr error!");
             return *m_ptr;
         }
 
-        const T* operator->() const noexcept
+        explicit operator bool() const noexcept
         {
-            ASSERT(valid(), "RefPtr nullptr error!");
-            return m_ptr;
+            return valid();
         }
 
-        const T& operator*() const noexcept
+        [[nodiscard]] bool operator==(const RefPtr& other) const noexcept
         {
-            ASSERT(valid(), "RefPtr nullptr error!");
-            return *m_ptr;
+            return m_ptr == other.m_ptr;
         }
 
-        // Methods---------------------------------------------------------------------------------------------
-
-        [[nodiscard]] T* get(bool validate = true) noexcept
+        [[nodiscard]] bool operator==(std::nullptr_t) const noexcept
         {
-            if (validate)
-            {
-                ASSERT(valid(), "RefPtr nullptr error!");
-            }
-            return m_ptr;
+            return m_ptr == nullptr;
         }
 
-        [[nodiscard]] const T* get(bool validate = true) const noexcept
+        // Methods---------------------------------------------------------------------------------------------
+
+        [[nodiscard]] T* get(bool validate = true) const noexcept
         {
             if (validate)
             {
@@ -189,9 +195,14 @@ namespace longmarch
             return m_ptr;
         }
 
+        //! Release the reference, the object is deleted by the last owner
         void reset() noexcept
         {
-            this->~RefPtr();
+            if (m_ptr && !m_ptr->DecrementRef())
+            {
+                Allocator::Delete(m_ptr);
+            }
+            m_ptr = nullptr;
         }
 
         [[nodiscard]] bool valid() const noexcept
@@ -210,10 +221,10 @@ namespace longmarch
 */
 namespace std
 {
-    template <class T>
-    struct hash<RefPtr<T>>
+    template <class T, typename Allocator_T>
+    struct hash<longmarch::RefPtr<T, Allocator_T>>
     {
-        std::size_t operator()(const RefPtr<T>& ptr) const noexcept
+        std::size_t operator()(const longmarch::RefPtr<T, Allocator_T>& ptr) const noexcept
         {
             return hash<T*>()(ptr.get(false));
         }
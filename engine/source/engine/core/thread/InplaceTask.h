@@ -0,0 +1,141 @@
+#pragma once
+#include "engine/core/allocator/MemoryManager.h"
+
+#include <type_traits>
+
+namespace longmarch
+{
+    /**
+     * @brief Move-only type-erased void() callable with small buffer optimization.
+     *
+     * @detail Callables up to kInplaceSize bytes are stored in place so that submitting a job does not allocate
+     * for its captures. Larger callables fall back to the MemoryManager.
+     *
+     * @author Hang Yu (yohan680919@gmail.com)
+     */
+    class InplaceTask
+    {
+    public:
+        constexpr inline static size_t kInplaceSize = {64};
+        //! MemoryManager blocks are 8 bytes aligned, so are the in place callables
+        constexpr inline static size_t kInplaceAlignment = {alignof(void*)};
+
+        template <typename F>
+        constexpr inline static bool IsInplace =
+            sizeof(F) <= kInplaceSize && alignof(F) <= kInplaceAlignment && std::is_nothrow_move_constructible_v<F>;
+
+        InplaceTask() = default;
+
+        template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InplaceTask>>>
+        InplaceTask(F&& f)
+        {
+            using Func_T = std::decay_t<F>;
+            if constexpr (IsInplace<Func_T>)
+            {
+                new(m_storage) Func_T(std::forward<F>(f));
+                m_ops = &s_inplaceOps<Func_T>;
+            }
+            else if constexpr (alignof(Func_T) <= kInplaceAlignment)
+            {
+                *reinterpret_cast<Func_T**>(m_storage) = MemoryManager::New<Func_T>(std::forward<F>(f));
+                m_ops = &s_heapOps<Func_T>;
+            }
+            else
+            {
+                *reinterpret_cast<Func_T**>(m_storage) = new Func_T(std::forward<F>(f));
+                m_ops = &s_overAlignedOps<Func_T>;
+            }
+        }
+
+        InplaceTask(const InplaceTask&) = delete;
+        InplaceTask& operator=(const InplaceTask&) = delete;
+
+        InplaceTask(InplaceTask&& other) noexcept
+        {
+            _MoveFrom(other);
+        }
+
+        InplaceTask& operator=(InplaceTask&& other) noexcept
+        {
+            if (this != &other)
+            {
+                _Reset();
+                _MoveFrom(other);
+            }
+            return *this;
+        }
+
+        ~InplaceTask()
+        {
+            _Reset();
+        }
+
+        void operator()()
+        {
+            ASSERT(m_ops, "Invoking an empty task!");
+            m_ops->m_invoke(m_storage);
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return m_ops != nullptr;
+        }
+
+    private:
+        struct Ops_T
+        {
+            void (*m_invoke)(void* storage);
+            //! Move construct into dst and destroy src
+            void (*m_move)(void* dst, void* src) noexcept;
+            void (*m_destroy)(void* storage) noexcept;
+        };
+
+        template <typename Func_T>
+        constexpr inline static Ops_T s_inplaceOps{
+            [](void* storage) { (*static_cast<Func_T*>(storage))(); },
+            [](void* dst, void* src) noexcept
+            {
+                new(dst) Func_T(std::move(*static_cast<Func_T*>(src)));
+                static_cast<Func_T*>(src)->~Func_T();
+            },
+            [](void* storage) noexcept { static_cast<Func_T*>(storage)->~Func_T(); }
+        };
+
+        template <typename Func_T>
+        constexpr inline static Ops_T s_heapOps{
+            [](void* storage) { (**static_cast<Func_T**>(storage))(); },
+            [](void* dst, void* src) noexcept { *static_cast<Func_T**>(dst) = *static_cast<Func_T**>(src); },
+            [](void* storage) noexcept { MemoryManager::Delete(*static_cast<Func_T**>(storage)); }
+        };
+
+        template <typename Func_T>
+        constexpr inline static Ops_T s_overAlignedOps{
+            [](void* storage) { (**static_cast<Func_T**>(storage))(); },
+            [](void* dst, void* src) noexcept { *static_cast<Func_T**>(dst) = *static_cast<Func_T**>(src); },
+            [](void* storage) noexcept { delete *static_cast<Func_T**>(storage); }
+        };
+
+        void _MoveFrom(InplaceTask& other) noexcept
+        {
+            if (other.m_ops)
+            {
+                other.m_ops->m_move(m_storage, other.m_storage);
+                m_ops = other.m_ops;
+                other.m_ops = nullptr;
+            }
+        }
+
+        void _Reset() noexcept
+        {
+            if (m_ops)
+            {
+                m_ops->m_destroy(m_storage);
+                m_ops = nullptr;
+            }
+        }
+
+    private:
+        alignas(kInplaceAlignment) std::byte m_storage[kInplaceSize];
+        const Ops_T* m_ops{nullptr};
+    };
+}
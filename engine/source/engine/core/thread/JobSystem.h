@@ -0,0 +1,248 @@
+#pragma once
+#include "StealThreadPool.h"
+#include "engine/core/allocator/MemoryManager.h"
+#include "engine/core/exception/EngineException.h"
+
+#include <chrono>
+#include <algorithm>
+
+namespace longmarch
+{
+    /**
+     * @brief std::future whose wait() and get() help running pending jobs instead of blocking the calling thread
+     *
+     * @detail Returned by JobSystem::Async, so jobs that wait on other jobs (e.g. a component system waiting on its ParEach) never
+     * stall a worker of the job system.
+     *
+     * @author Hang Yu (yohan680919@gmail.com)
+     */
+    template <typename T>
+    class JobFuture : public std::future<T>
+    {
+    public:
+        JobFuture() = default;
+
+        JobFuture(std::future<T>&& other) noexcept
+            :
+            std::future<T>(std::move(other))
+        {
+        }
+
+        void wait() const;
+
+        decltype(auto) get()
+        {
+            wait();
+            return std::future<T>::get();
+        }
+    };
+
+    /**
+     * @brief Fork-join job system built on top of the default StealThreadPool
+     *
+     * @detail A thread that waits on jobs (JobSystem::Wait, JobFuture::wait, ParallelFor, ParallelReduce) runs pending jobs of the pool
+     * in the meantime, so parallel loops can be nested inside jobs without deadlock and every job shares one pool without thread oversubscription.
+     * Beware that a helping thread could pick up any pending job, so do not wait on jobs while holding a lock that the other jobs might acquire.
+     *
+     * Use it like : JobSystem::ParallelFor(0, n, 64, [&](size_t first, size_t last) { for (auto i = first; i < last; ++i) {...} });
+     *				 auto sum = JobSystem::ParallelReduce(0, n, 64, 0.0, [&](size_t first, size_t last) { ... return partial; }, std::plus<>());
+     *
+     * @author Hang Yu (yohan680919@gmail.com)
+     */
+    class JobSystem
+    {
+    public:
+        NONINSTANTIABLE(JobSystem);
+
+        inline static StealThreadPool& GetPool()
+        {
+            return *StealThreadPool::GetInstance();
+        }
+
+        //! Number of worker threads, not counting the calling thread that helps while waiting
+        inline static int NumWorkers()
+        {
+            return GetPool().threads;
+        }
+
+        //! Run a job asynchronously
+        template <typename F, typename... Args>
+        [[nodiscard]] static auto Async(F&& f, Args&&... args) -> JobFuture<std::invoke_result_t<F, Args...>>
+        {
+            return GetPool().enqueue_task(std::forward<F>(f), std::forward<Args>(args)...);
+        }
+
+        //! Run pending jobs on the calling thread until pred returns true
+        template <typename Pred>
+        static void WaitUntil(Pred&& pred)
+        {
+            auto& pool = GetPool();
+            while (!pred())
+            {
+                if (!pool.try_run_one())
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        //! Wait on a std::future or std::shared_future while helping to run pending jobs
+        template <typename Future_T>
+        static void Wait(const Future_T& future)
+        {
+            WaitUntil([&future]()
+            {
+                return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+            });
+        }
+
+        /**
+         * @brief Invoke fn(first, last) on sub ranges [first, last) of [begin, end) in parallel, return after all sub ranges are done.
+         *
+         * @param grain Number of indices per sub range, 0 picks a grain that gives each worker a few sub ranges
+         */
+        template <typename F>
+        static void ParallelFor(size_t begin, size_t end, size_t grain, F&& fn)
+        {
+            if (begin >= end)
+            {
+                return;
+            }
+            const auto num = end - begin;
+            grain = _Grain(num, grain);
+            const auto numChunks = (num + grain - 1) / grain;
+            if (numChunks == 1)
+            {
+                fn(begin, end);
+                return;
+            }
+            _ParallelChunks(numChunks, [&fn, begin, end, grain](size_t chunk)
+            {
+                const auto first = begin + chunk * grain;
+                fn(first, std::min(end, first + grain));
+            });
+        }
+
+        /**
+         * @brief Same as ParallelFor, but the calling thread only runs sub ranges of this loop and never picks up other pending jobs.
+         *
+         * @detail For loops that run while holding a lock that other jobs might acquire (e.g. Scene::Step), as long as fn does not acquire it.
+         */
+        template <typename F>
+        static void ParallelForNoHelp(size_t begin, size_t end, size_t grain, F&& fn)
+        {
+            if (begin >= end)
+            {
+                return;
+            }
+            const auto num = end - begin;
+            grain = _Grain(num, grain);
+            const auto numChunks = (num + grain - 1) / grain;
+            if (numChunks == 1)
+            {
+                fn(begin, end);
+                return;
+            }
+            _ParallelChunks(numChunks, [&fn, begin, end, grain](size_t chunk)
+            {
+                const auto first = begin + chunk * grain;
+                fn(first, std::min(end, first + grain));
+            }, false);
+        }
+
+        /**
+         * @brief Reduce map(first, last) of sub ranges [first, last) of [begin, end) in parallel.
+         *
+         * @detail Partial results are reduced in order of sub ranges on the calling thread, so the result is deterministic for a given grain.
+         */
+        template <typename T, typename Map, typename Reduce>
+        [[nodiscard]] static T ParallelReduce(size_t begin, size_t end, size_t grain, T identity, Map&& map, Reduce&& reduce)
+        {
+            if (begin >= end)
+            {
+                return identity;
+            }
+            const auto num = end - begin;
+            grain = _Grain(num, grain);
+            const auto numChunks = (num + grain - 1) / grain;
+            if (numChunks == 1)
+            {
+                return reduce(std::move(identity), map(begin, end));
+            }
+            auto partials = std::make_unique<T[]>(numChunks);
+            _ParallelChunks(numChunks, [&map, &partials, begin, end, grain](size_t chunk)
+            {
+                const auto first = begin + chunk * grain;
+                partials[chunk] = map(first, std::min(end, first + grain));
+            });
+            for (size_t i = 0; i < numChunks; ++i)
+            {
+                identity = reduce(std::move(identity), std::move(partials[i]));
+            }
+            return identity;
+        }
+
+    private:
+        struct ForState_T
+        {
+            //! Index of the next chunk to be picked up
+            std::atomic_size_t m_next{0};
+            //! Number of chunks done
+            std::atomic_size_t m_finished{0};
+        };
+
+        inline static size_t _Grain(size_t num, size_t grain)
+        {
+            if (grain == 0)
+            {
+                grain = num / (static_cast<size_t>(NumWorkers() + 1) * 4);
+            }
+            return std::max(grain, size_t(1));
+        }
+
+        //! Workers and the calling thread grab chunks from a shared counter, the calling thread helps until all chunks are done
+        template <typename Body>
+        static void _ParallelChunks(size_t numChunks, const Body& body, bool helpOtherJobs = true)
+        {
+            auto state = MemoryManager::Make_shared<ForState_T>();
+            // yuhang : helpers hold the state but never touch body once all chunks are picked up, so body could live on the stack of the calling thread
+            auto runChunks = [state, numChunks, pBody = &body]()
+            {
+                for (size_t chunk; (chunk = state->m_next.fetch_add(1, std::memory_order_relaxed)) < numChunks;)
+                {
+                    ENGINE_TRY_CATCH((*pBody)(chunk););
+                    state->m_finished.fetch_add(1, std::memory_order_release);
+                }
+            };
+            auto& pool = GetPool();
+            const auto numHelpers = std::min(numChunks - 1, static_cast<size_t>(pool.threads));
+            for (size_t i = 0; i < numHelpers; ++i)
+            {
+                pool.enqueue_work(runChunks);
+            }
+            runChunks();
+            auto allFinished = [&state, numChunks]()
+            {
+                return state->m_finished.load(std::memory_order_acquire) == numChunks;
+            };
+            if (helpOtherJobs)
+            {
+                WaitUntil(allFinished);
+            }
+            else
+            {
+                // every chunk has been picked up at this point, only wait for the ones that are still running on workers
+                while (!allFinished())
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    };
+
+    template <typename T>
+    void JobFuture<T>::wait() const
+    {
+        JobSystem::Wait(static_cast<const std::future<T>&>(*this));
+    }
+}
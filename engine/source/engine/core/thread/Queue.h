@@ -1,7 +1,11 @@
 // Reference : https://github.com/mvorbrodt/blog/blob/master/src/queue.hpp
 #pragma once
+#include <bit>
 #include <mutex>
 #include <queue>
+#include <atomic>
+#include <memory>
+#include <vector>
 #include <utility>
 #include <type_traits>
 #include <condition_variable>
@@ -207,6 +211,94 @@ namespace longmarch
         std::deque<T> m_queue;
     };
 
+    /**
+     * Bounded lock-free multi-producer single-consumer ring buffer, try_push fails instead of blocking or allocating when it is full.
+     * Every slot carries a sequence number that hands the slot over between producers and the consumer, so T can be any movable type (e.g. std::shared_ptr).
+     * Only one thread at a time may pop.
+     *
+     * Reference : Dmitry Vyukov's bounded MPMC queue, https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+     */
+    template <typename T>
+    class MpscRingBuffer
+    {
+    public:
+        NONCOPYABLE(MpscRingBuffer);
+        //! Capacity is rounded up to a power of two
+        explicit MpscRingBuffer(size_t capacity)
+            :
+            m_mask(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1),
+            m_slots(std::make_unique<Slot[]>(m_mask + 1))
+        {
+            for (size_t i = 0; i <= m_mask; ++i)
+            {
+                m_slots[i].m_sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        template <typename U>
+        bool try_push(U&& item) noexcept
+        {
+            auto pos = m_head.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                auto& slot = m_slots[pos & m_mask];
+                const auto diff = static_cast<intptr_t>(slot.m_sequence.load(std::memory_order_acquire)) - static_cast<intptr_t>(pos);
+                if (diff == 0)
+                {
+                    // The slot is free for pos, claim it
+                    if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        slot.m_item = std::forward<U>(item);
+                        slot.m_sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    // The consumer has not released the slot of the previous lap, the buffer is full
+                    return false;
+                }
+                else
+                {
+                    // Another producer claimed pos
+                    pos = m_head.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool try_pop(T& item) noexcept
+        {
+            auto& slot = m_slots[m_tail & m_mask];
+            if (slot.m_sequence.load(std::memory_order_acquire) != m_tail + 1)
+            {
+                return false;
+            }
+            item = std::move(slot.m_item);
+            slot.m_item = T();
+            // Release the slot to the producer of the next lap
+            slot.m_sequence.store(m_tail + m_mask + 1, std::memory_order_release);
+            ++m_tail;
+            return true;
+        }
+
+        size_t capacity() const noexcept
+        {
+            return m_mask + 1;
+        }
+
+    private:
+        struct Slot
+        {
+            std::atomic_size_t m_sequence{0};
+            T m_item;
+        };
+
+        const size_t m_mask;
+        std::unique_ptr<Slot[]> m_slots;
+        CACHE_ALIGN std::atomic_size_t m_head{0};
+        CACHE_ALIGN size_t m_tail{0};
+    };
+
     /**
      * Enumerates concurrent queue modes.
      */
@@ -412,4 +504,159 @@ namespace longmarch
 
         std::atomic_int32_t m_size{0};
     };
+
+    /**
+     * Lock-free Chase-Lev work-stealing deque
+     * The owner thread pushes and pops at the bottom (LIFO), other threads steal from the top (FIFO).
+     * Only trivially copyable items (e.g. pointers) are supported as a thief might read a slot that is being overwritten.
+     *
+     * Reference : Correct and Efficient Work-Stealing for Weak Memory Models (Le, Pop, Cohen, Zappa Nardelli, PPoPP 2013)
+     */
+    template <typename T>
+    class WorkStealingDeque
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "WorkStealingDeque only supports trivially copyable items!");
+
+        struct RingBuffer
+        {
+            NONCOPYABLE(RingBuffer);
+            explicit RingBuffer(int64_t capacity)
+                :
+                m_capacity(capacity),
+                m_mask(capacity - 1),
+                m_items(new std::atomic<T>[capacity])
+            {
+                ASSERT((capacity & (capacity - 1)) == 0, "Capacity must be power of 2!");
+            }
+
+            ~RingBuffer()
+            {
+                delete[] m_items;
+            }
+
+            T get(int64_t i) const noexcept
+            {
+                return m_items[i & m_mask].load(std::memory_order_relaxed);
+            }
+
+            void put(int64_t i, T item) noexcept
+            {
+                m_items[i & m_mask].store(item, std::memory_order_relaxed);
+            }
+
+            RingBuffer* grow(int64_t bottom, int64_t top) const
+            {
+                auto ret = new RingBuffer(m_capacity << 1);
+                for (auto i = top; i != bottom; ++i)
+                {
+                    ret->put(i, get(i));
+                }
+                return ret;
+            }
+
+            const int64_t m_capacity;
+            const int64_t m_mask;
+            std::atomic<T>* m_items;
+        };
+
+    public:
+        NONCOPYABLE(WorkStealingDeque);
+
+        explicit WorkStealingDeque(int64_t capacity = 1024)
+            :
+            m_buffer(new RingBuffer(capacity))
+        {
+        }
+
+        ~WorkStealingDeque()
+        {
+            for (auto buffer : m_retiredBuffers)
+            {
+                delete buffer;
+            }
+            delete m_buffer.load(std::memory_order_relaxed);
+        }
+
+        //! Owner thread only
+        void push(T item)
+        {
+            const auto b = m_bottom.load(std::memory_order_relaxed);
+            const auto t = m_top.load(std::memory_order_acquire);
+            auto buffer = m_buffer.load(std::memory_order_relaxed);
+            if (b - t > buffer->m_capacity - 1)
+            [[unlikely]]
+            {
+                // Thieves might still read the old buffer, so retire it instead of deleting it
+                m_retiredBuffers.push_back(buffer);
+                buffer = buffer->grow(b, t);
+                m_buffer.store(buffer, std::memory_order_release);
+            }
+            buffer->put(b, item);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        //! Owner thread only
+        bool pop(T& item) noexcept
+        {
+            const auto b = m_bottom.load(std::memory_order_relaxed) - 1;
+            const auto buffer = m_buffer.load(std::memory_order_relaxed);
+            m_bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto t = m_top.load(std::memory_order_relaxed);
+            if (t <= b)
+            {
+                item = buffer->get(b);
+                if (t == b)
+                {
+                    // Last item, race against thieves
+                    const bool won = m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                                   std::memory_order_relaxed);
+                    m_bottom.store(b + 1, std::memory_order_relaxed);
+                    return won;
+                }
+                return true;
+            }
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        //! Any thread
+        bool steal(T& item) noexcept
+        {
+            auto t = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const auto b = m_bottom.load(std::memory_order_acquire);
+            if (t < b)
+            {
+                const auto buffer = m_buffer.load(std::memory_order_acquire);
+                const auto ret = buffer->get(t);
+                if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    return false;
+                }
+                item = ret;
+                return true;
+            }
+            return false;
+        }
+
+        bool empty() const noexcept
+        {
+            return size() == 0;
+        }
+
+        size_t size() const noexcept
+        {
+            const auto b = m_bottom.load(std::memory_order_relaxed);
+            const auto t = m_top.load(std::memory_order_relaxed);
+            return (b > t) ? static_cast<size_t>(b - t) : 0;
+        }
+
+    private:
+        CACHE_ALIGN std::atomic<int64_t> m_top{0};
+        CACHE_ALIGN std::atomic<int64_t> m_bottom{0};
+        CACHE_ALIGN std::atomic<RingBuffer*> m_buffer;
+        std::vector<RingBuffer*> m_retiredBuffers;
+    };
 }
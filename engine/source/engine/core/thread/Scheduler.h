@@ -1,4 +1,5 @@
 // Reference https://vorbrodt.blog/2019/02/25/better-timer-class/
+// Reference http://www.cs.columbia.edu/~nahum/w6998/papers/ton97-timing-wheels.pdf
 
 #pragma once
 
@@ -6,11 +7,12 @@
 #include <chrono>
 #include <memory>
 #include <functional>
-#include <set>
-#include <iterator>
 #include <cassert>
 #include "Lock.h"
+#include "StealThreadPool.h"
 #include "../utility/TypeHelper.h"
+#include "../allocator/TemplateMemoryManager.h"
+#include "../smart-pointer/RefPtr.h"
 
 namespace longmarch
 {
@@ -58,11 +60,59 @@ namespace longmarch
 		std::condition_variable m_cv;
 	};
 
+	/**
+	 * @brief Cancellation token of a scheduled call, signal() is lock free and never touches the scheduler.
+	 *
+	 * @author Hang Yu (yohan680919@gmail.com)
+	 */
+	struct scheduler_token final : public BaseRefCountClassNC
+	{
+		void signal() noexcept
+		{
+			m_signaled.store(true, std::memory_order_release);
+			m_signaled.notify_all();
+		}
+
+		bool is_signaled() const noexcept
+		{
+			return m_signaled.load(std::memory_order_acquire);
+		}
+
+		void wait() const noexcept
+		{
+			m_signaled.wait(false, std::memory_order_acquire);
+		}
+
+	private:
+		std::atomic_bool m_signaled = false;
+	};
+
+	/**
+	 * @brief Timer thread that runs timeouts and intervals on the StealThreadPool.
+	 *
+	 * Use it like : auto handle = Scheduler::GetInstance(33)->set_interval(std::chrono::milliseconds(33), [](){...});
+	 *				 ...
+	 *				 handle->signal(); // Stop the interval
+	 *
+	 * @details Timers live in a hierarchical timing wheel of kNumWheels levels of kWheelSize slots, so that scheduling is O(1) and a tick
+	 * only visits the timers that expire on it (plus a cascade of one slot every kWheelSize ticks), no matter how many timers are pending.
+	 * Cancellation is lazy, a signaled timer is dropped when its slot comes up. Expired calls are dispatched as jobs so that a slow callback
+	 * never delays the wheel, an interval whose previous call is still running skips the period instead of running twice concurrently.
+	 *
+	 * @author Hang Yu (yohan680919@gmail.com)
+	 */
 	class Scheduler : AdaptiveAtomicClassNC, BaseAtomicClassStatic
 	{
 	public:
 		NONCOPYABLE(Scheduler);
-		using SchedulerHandle = std::shared_ptr<manual_event>;
+		using SchedulerHandle = RefPtr<scheduler_token>;
+
+		constexpr inline static uint32_t kWheelBits = { 8 };
+		constexpr inline static uint32_t kWheelSize = { 1u << kWheelBits };
+		constexpr inline static uint32_t kWheelMask = { kWheelSize - 1 };
+		constexpr inline static uint32_t kNumWheels = { 4 };
+		//! Longest delay in ticks, about 49 days of 1ms ticks, longer delays are clamped
+		constexpr inline static uint64_t kMaxTicks = { (1ull << (kWheelBits * kNumWheels)) - 1 };
 
 		static Scheduler* GetInstance(uint32_t _millisecondsTick)
 		{
@@ -78,6 +128,13 @@ namespace longmarch
 			}
 		}
 
+		//! Stop all scheduler threads, called by the engine before the thread pool goes away
+		static void ShutDown()
+		{
+			LOCK_GUARD_S();
+			s_intanceManager.clear();
+		}
+
 		template<typename T>
 		Scheduler(T&& tick)
 			:
@@ -91,25 +148,7 @@ namespace longmarch
 			{
 				{
 					LOCK_GUARD_ADAPTIVE_NC();
-					++m_ticks;
-					auto it = std::begin(m_events);
-					auto end = std::end(m_events);
-					while (it != end)
-					{
-						if (auto event = *it; ++event.elapsed == event.ticks)
-						{
-							if (auto remove = event.proc(); remove)
-							{
-								m_events.erase(it++);
-								continue;
-							}
-							else
-							{
-								event.elapsed = 0;
-							}
-						}
-						++it;
-					}
+					_Tick();
 				}
 				std::this_thread::yield();
 				auto now = std::chrono::high_resolution_clock::now();
@@ -124,86 +163,199 @@ namespace longmarch
 		{
 			m_event.signal();
 			m_thread.join();
+			for (auto& wheel : m_wheels)
+			{
+				for (auto& slot : wheel)
+				{
+					while (auto timer = slot)
+					{
+						slot = timer->m_next;
+						// yuhang : a job that is still running owns its interval timer, leak it rather than pulling it out from under the job
+						if (!timer->m_running.load(std::memory_order_acquire))
+						{
+							TemplateMemoryManager<Timer_T>::Delete(timer);
+						}
+					}
+				}
+			}
 		}
 
-
 		// Execute a function once after a period of time only if the handle is not signal by the user earlier.
-		// E.g. auto handle = scheduler->set_timeout(...); // Optional : handle.signal() to cancel the scheduled call;
+		// E.g. auto handle = scheduler->set_timeout(...); // Optional : handle->signal() to cancel the scheduled call;
 		template<typename T, typename F, typename... Args>
 		[[nodiscard]] SchedulerHandle set_timeout(T&& timeout, F f, Args&&... args)
 		{
-			LOCK_GUARD_ADAPTIVE_NC();
-			assert(std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count() >= m_tick.count());
-			auto _event = std::make_shared<manual_event>();
-			auto proc = [=]() {
-				if (_event->wait_for(std::chrono::seconds(0))) return true;
-				f(args...);
-				return true;
-			};
-			m_events.insert({ event_ctx::kNextSeqNum++, proc,
-				static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count() / m_tick.count()), 0, _event });
-			return _event;
+			return _Schedule(timeout, false, [=]() { f(args...); });
 		}
 
 		// Execute a function periodically with a time interval until the handle is signaled by the user.
-		// E.g. auto handle = scheduler->set_interval(...); // Do something...; handle.signal(); // Call signal to end the interval calling
+		// E.g. auto handle = scheduler->set_interval(...); // Do something...; handle->signal(); // Call signal to end the interval calling
 		template<typename T, typename F, typename... Args>
 		[[nodiscard]] SchedulerHandle set_interval(T&& interval, F f, Args&&... args)
 		{
-			LOCK_GUARD_ADAPTIVE_NC();
-			assert(std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count() >= m_tick.count());
-			auto _event = std::make_shared<manual_event>();
-			auto proc = [=]() {
-				if (_event->wait_for(std::chrono::seconds(0))) return true;
-				f(args...);
-				return false;
-			};
-			m_events.insert({ event_ctx::kNextSeqNum++, proc,
-				static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count() / m_tick.count()), 0, _event });
-			return _event;
+			return _Schedule(interval, true, [=]() { f(args...); });
 		}
 
 		// Execute a function periodically with a time interval until the function returns true or until the handle is signaled by the user.
-		// E.g. auto handle = scheduler->set_interval_conditioanl(...); // Do something...; handle.wait(); // Call wait to block until function returns true
+		// E.g. auto handle = scheduler->set_interval_conditioanl(...); // Do something...; handle->wait(); // Call wait to block until function returns true
 		template<typename T, typename F, typename... Args>
 		[[nodiscard]] SchedulerHandle set_interval_conditioanl(T&& interval, F f, Args&&... args)
 		{
-			LOCK_GUARD_ADAPTIVE_NC();
-			assert(std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count() >= m_tick.count());
-			auto _event = std::make_shared<manual_event>();
-			auto proc = [=]() {
-				if (_event->wait_for(std::chrono::seconds(0))) return true;
-				if(f(args...))
+			auto token = SchedulerHandle::Allocator::New();
+			// yuhang : the timer holds a reference to the token and outlives every call of the proc, so a raw pointer is enough
+			return _Schedule(interval, true, [=]() {
+				if (f(args...))
+				{
+					token->signal();
+				}
+			}, token);
+		}
+
+	private:
+		struct Timer_T
+		{
+			Timer_T* m_next = { nullptr };
+			uint64_t m_expire = { 0 };
+			//! Period in ticks, 0 for a timeout
+			uint64_t m_interval = { 0 };
+			InplaceTask m_proc;
+			SchedulerHandle m_token;
+			//! Set by the wheel thread on dispatching an interval call and cleared by the job once the call returns
+			std::atomic_bool m_running = { false };
+		};
+
+		template<typename T, typename Proc>
+		[[nodiscard]] SchedulerHandle _Schedule(T&& delay, bool repeat, Proc&& proc, scheduler_token* token = nullptr)
+		{
+			const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(delay).count();
+			assert(ns >= m_tick.count());
+			const auto ticks = std::clamp<uint64_t>(static_cast<uint64_t>(ns / m_tick.count()), 1, kMaxTicks);
+
+			auto timer = TemplateMemoryManager<Timer_T>::New();
+			timer->m_interval = repeat ? ticks : 0;
+			timer->m_proc = InplaceTask(std::forward<Proc>(proc));
+			timer->m_token = token ? SchedulerHandle(token) : SchedulerHandle(SchedulerHandle::Allocator::New());
+			SchedulerHandle ret = timer->m_token;
+			{
+				LOCK_GUARD_ADAPTIVE_NC();
+				timer->m_expire = m_ticks + ticks;
+				_Insert(timer);
+			}
+			return ret;
+		}
+
+		//! Put the timer into the lowest wheel whose range covers its remaining ticks
+		void _Insert(Timer_T* timer)
+		{
+			const auto delta = (timer->m_expire > m_ticks) ? timer->m_expire - m_ticks : 0;
+			uint32_t level = 0;
+			while (level + 1 < kNumWheels && delta >= (1ull << (kWheelBits * (level + 1))))
+			{
+				++level;
+			}
+			auto& slot = m_wheels[level][(timer->m_expire >> (kWheelBits * level)) & kWheelMask];
+			timer->m_next = slot;
+			slot = timer;
+		}
+
+		//! Re-insert the timers of the current slot of a higher wheel, they all land on lower wheels
+		void _Cascade(uint32_t level)
+		{
+			auto& slot = m_wheels[level][(m_ticks >> (kWheelBits * level)) & kWheelMask];
+			auto timer = slot;
+			slot = nullptr;
+			while (timer)
+			{
+				auto next = timer->m_next;
+				_Insert(timer);
+				timer = next;
+			}
+		}
+
+		void _Tick()
+		{
+			++m_ticks;
+			// A wheel turns over when the bits of all wheels below it are zero
+			uint32_t levels = 0;
+			while (levels + 1 < kNumWheels && ((m_ticks >> (kWheelBits * levels)) & kWheelMask) == 0)
+			{
+				++levels;
+			}
+			for (auto level = levels; level >= 1; --level)
+			{
+				_Cascade(level);
+			}
+
+			auto& slot = m_wheels[0][m_ticks & kWheelMask];
+			auto timer = slot;
+			slot = nullptr;
+			while (timer)
+			{
+				auto next = timer->m_next;
+				_Expire(timer);
+				timer = next;
+			}
+		}
+
+		void _Expire(Timer_T* timer)
+		{
+			const bool cancelled = timer->m_token->is_signaled();
+			if (timer->m_interval == 0)
+			{
+				if (cancelled)
 				{
-					_event->signal();
-					return true;
+					TemplateMemoryManager<Timer_T>::Delete(timer);
+					return;
 				}
-				return false;
-			};
-			m_events.insert({ event_ctx::kNextSeqNum++, proc,
-				static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count() / m_tick.count()), 0, _event });
-			return _event;
+				// The timeout has left the wheel, the job owns it from now on
+				StealThreadPool::GetInstance()->enqueue_work([timer]() {
+					if (!timer->m_token->is_signaled())
+					{
+						timer->m_proc();
+					}
+					TemplateMemoryManager<Timer_T>::Delete(timer);
+				});
+				return;
+			}
+
+			const bool running = timer->m_running.load(std::memory_order_acquire);
+			if (cancelled)
+			[[unlikely]]
+			{
+				if (!running)
+				{
+					TemplateMemoryManager<Timer_T>::Delete(timer);
+					return;
+				}
+				// The last call is still running, check back on the next tick
+				timer->m_expire = m_ticks + 1;
+				_Insert(timer);
+				return;
+			}
+
+			if (!running)
+			[[likely]]
+			{
+				timer->m_running.store(true, std::memory_order_relaxed);
+				StealThreadPool::GetInstance()->enqueue_work([timer]() {
+					if (!timer->m_token->is_signaled())
+					{
+						timer->m_proc();
+					}
+					timer->m_running.store(false, std::memory_order_release);
+				});
+			}
+			timer->m_expire = m_ticks + timer->m_interval;
+			_Insert(timer);
 		}
 
 	private:
 		std::chrono::nanoseconds m_tick;
-		unsigned long long m_ticks = 0;
+		uint64_t m_ticks = 0;
 		manual_event m_event;
+		Timer_T* m_wheels[kNumWheels][kWheelSize] = {};
 		std::thread m_thread;
 
-		struct event_ctx
-		{
-			bool operator < (const event_ctx& rhs) const { return seq_num < rhs.seq_num; }
-			static inline unsigned long long kNextSeqNum = 0;
-			unsigned long long seq_num;
-			std::function<bool(void)> proc;
-			unsigned long long ticks;
-			mutable unsigned long long elapsed;
-			std::shared_ptr<manual_event> event;
-		};
-
-		using EventSet = std::set<event_ctx>; // Should not use phmap's block set because iterators are invalidated on erase
-		EventSet m_events;
 	private:
 		inline static LongMarch_UnorderedMap<uint32_t, std::unique_ptr<Scheduler>> s_intanceManager;
 	};
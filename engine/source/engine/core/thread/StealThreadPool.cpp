@@ -1,44 +1,59 @@
 #include "engine-precompiled-header.h"
 #include "StealThreadPool.h"
 #include "engine/core/utility/Timer.h"
+#include "engine/core/profiling/FrameProfiler.h"
 #include "engine/delegate/engineDelegates/EngineDelegates.h"
 
 longmarch::StealThreadPool::StealThreadPool(int threads)
     :
     threads(threads),
-    m_queues(threads),
     m_count(threads)
 {
-    if (!threads)
+    if (threads <= 0)
     {
         throw std::invalid_argument("Invalid thread count!");
     }
 
-    for (auto i(0u); i < threads; ++i)
+    for (auto i(0); i < threads; ++i)
+    {
+        m_deques.emplace_back(std::make_unique<Deque>());
+    }
+    for (auto i(0); i < threads; ++i)
     {
         m_threads.emplace_back(
             [this, i = i]
             {
+                t_pool = this;
+                t_workerIndex = i;
+                MemoryManager::SetThreadTag(MemoryTag::JOB);
+                FrameProfiler::SetThreadName(Str("Worker %d", i));
                 const auto t_id = std::this_thread::get_id();
                 const auto id = *(uint32_t*)&(t_id);
                 Timer timer;
                 for (;;)
                 {
-                    Proc task;
-                    for (auto n(0u); n < m_count * K; ++n)
+                    if (Task* task; _TryGetTask(i, task))
                     {
-                        if (m_queues[(i + n) % m_count].try_pop(task))
+                        delegates::WorkerThreadReportWait.InvokeAll(id, i, timer.MarkMilli(true));
                         {
-                            break;
+                            PROFILE_SCOPE("Job");
+                            _Run(task);
                         }
+                        delegates::WorkerThreadReportExec.InvokeAll(id, i, timer.MarkMilli(true));
+                        continue;
                     }
-                    if (!task && !m_queues[i].pop(task))
+                    // Nothing to steal, sleep until new jobs are submitted
+                    std::unique_lock lock(m_sleepMutex);
+                    m_numSleeping.fetch_add(1, std::memory_order_seq_cst);
+                    m_sleepCv.wait(lock, [this]()
+                    {
+                        return m_numPending.load(std::memory_order_seq_cst) > 0 || m_done.load(std::memory_order_acquire);
+                    });
+                    m_numSleeping.fetch_sub(1, std::memory_order_relaxed);
+                    if (m_done.load(std::memory_order_acquire) && m_numPending.load(std::memory_order_acquire) <= 0)
                     {
                         break;
                     }
-                    delegates::WorkerThreadReportWait.InvokeAll(id, i, timer.MarkMilli(true));
-                    task();
-                    delegates::WorkerThreadReportExec.InvokeAll(id, i, timer.MarkMilli(true));
                 }
             }
         );
@@ -47,14 +62,85 @@ longmarch::StealThreadPool::StealThreadPool(int threads)
 
 longmarch::StealThreadPool::~StealThreadPool()
 {
-    for (auto& queue : m_queues)
     {
-        queue.done();
+        std::scoped_lock lock(m_sleepMutex);
+        m_done.store(true, std::memory_order_release);
     }
+    m_sleepCv.notify_all();
     for (auto& thread : m_threads)
     {
         thread.join();
     }
+    m_injectionQueue.done();
+}
+
+bool longmarch::StealThreadPool::try_run_one()
+{
+    if (Task* task; _TryGetTask((t_pool == this) ? t_workerIndex : -1, task))
+    {
+        _Run(task);
+        return true;
+    }
+    return false;
+}
+
+void longmarch::StealThreadPool::_Submit(Task&& task)
+{
+    auto node = MemoryManager::New<Task>(std::move(task));
+    if (t_pool == this)
+    [[likely]]
+    {
+        m_deques[t_workerIndex]->push(node);
+    }
+    else
+    {
+        m_injectionQueue.push(node);
+    }
+    m_numPending.fetch_add(1, std::memory_order_seq_cst);
+    // Only pay for the wake up if any worker is sleeping
+    if (m_numSleeping.load(std::memory_order_seq_cst) > 0)
+    {
+        {
+            std::scoped_lock lock(m_sleepMutex);
+        }
+        m_sleepCv.notify_one();
+    }
+}
+
+bool longmarch::StealThreadPool::_TryGetTask(int workerIndex, Task*& task)
+{
+    bool found = (workerIndex >= 0 && m_deques[workerIndex]->pop(task)) || m_injectionQueue.try_pop(task);
+    if (!found)
+    {
+        // Randomized stealing, xorshift seeded by the address of the thread local state
+        thread_local uint64_t t_seed = reinterpret_cast<uint64_t>(&t_seed) | 1ull;
+        t_seed ^= t_seed << 13;
+        t_seed ^= t_seed >> 7;
+        t_seed ^= t_seed << 17;
+        const auto start = static_cast<int>(t_seed % static_cast<uint64_t>(m_count));
+        for (auto n(0); n < m_count && !found; ++n)
+        {
+            if (const auto victim = (start + n) % m_count; victim != workerIndex)
+            {
+                found = m_deques[victim]->steal(task);
+            }
+        }
+    }
+    if (found)
+    {
+        m_numPending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+    return found;
+}
+
+void longmarch::StealThreadPool::_Run(Task* task)
+{
+    ENGINE_TRY_CATCH(
+        {
+            (*task)();
+        }
+    );
+    MemoryManager::Delete(task);
 }
 
 void StealThreadPool::ResetStats()
@@ -94,4 +180,15 @@ void StealThreadPool::ReportStats()
         Instrumentor::GetEngineInstance()->AddInstrumentorResult({Str("Busy #%u worker %u", worker_id, t_id).c_str(),time, "ms"});
         Instrumentor::GetApplicationInstance()->AddInstrumentorResult({Str("Busy #%u worker %u", worker_id, t_id).c_str(),time, "ms"});
     }
+    // Per frame busy and idle time of each worker as counters of the trace, gaps of the "Job" scopes of a worker timeline show the same idle time
+    if (FrameProfiler::IsRecording())
+    {
+        for (const auto& [stats, prefix] : {std::pair{&s_threadExecMap, "Busy ms #%u"}, std::pair{&s_threadWaitMap, "Idle ms #%u"}})
+        {
+            for (const auto& [id, time] : *stats)
+            {
+                FrameProfiler::Counter(FrameProfiler::InternName(Str(prefix, static_cast<uint32_t>(id & 0xFFFFFFFF))), time);
+            }
+        }
+    }
 }
@@ -1,13 +1,16 @@
 #pragma once
 
 // Reference: https://github.com/mvorbrodt/blog/blob/master/src/pool.hpp
+// Work stealing with per worker Chase-Lev deques, see WorkStealingDeque in Queue.h
 #include <vector>
 #include <memory>
 #include <thread>
 #include <future>
 #include <functional>
 #include <stdexcept>
+#include <condition_variable>
 #include "Queue.h"
+#include "InplaceTask.h"
 
 namespace longmarch
 {
@@ -25,25 +28,22 @@ namespace longmarch
         explicit StealThreadPool(int threads = std::thread::hardware_concurrency() - 1);
         ~StealThreadPool();
 
-        // template <typename F, typename... Args>
-        // void enqueue_work(F&& f, Args&&... args)
-        // {
-        //     auto work = [p = std::forward<F>(f), t = std::make_tuple(std::forward<Args>(args)...)]()
-        //     {
-        //         std::apply(p, t);
-        //     };
-        //     const auto i = (m_index.fetch_add(1, std::memory_order_relaxed) % m_count);
-        //
-        //     for (auto n(0u); n < m_count * K; ++n)
-        //     {
-        //         if (m_queues[(i + n) % m_count].try_push(work))
-        //         {
-        //             return;
-        //         }
-        //     }
-        //
-        //     m_queues[i % m_count].push(std::move(work));
-        // }
+        //! Fire and forget a job, captures that fit into InplaceTask::kInplaceSize bytes do not allocate
+        template <typename F, typename... Args>
+        void enqueue_work(F&& f, Args&&... args)
+        {
+            if constexpr (sizeof...(Args) == 0)
+            {
+                _Submit(Task(std::forward<F>(f)));
+            }
+            else
+            {
+                _Submit(Task([p = std::forward<F>(f), t = std::make_tuple(std::forward<Args>(args)...)]() mutable
+                {
+                    std::apply(p, t);
+                }));
+            }
+        }
 
         template <typename F, typename... Args>
         [[nodiscard]] auto enqueue_task(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>>
@@ -51,22 +51,16 @@ namespace longmarch
             using task_return_type = std::invoke_result_t<F, Args...>;
             using task_type = std::packaged_task<task_return_type()>;
 
-            auto task = std::make_shared<task_type>(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
-            auto result = task->get_future();
-            auto work = [task = std::move(task)]() { (*task)(); };
-            const auto i = (m_index.fetch_add(1, std::memory_order_relaxed) % m_count);
-
-            for (auto n(0); n < m_count * K; ++n)
-            {
-                if (m_queues[(i + n) % m_count].try_push(work, true))
-                {
-                    return result;
-                }
-            }
-            m_queues[i].push(std::move(work));
+            // yuhang : packaged task is move only and stored in place, so the only allocation is the shared state of the future
+            task_type task(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+            auto result = task.get_future();
+            _Submit(Task([task = std::move(task)]() mutable { task(); }));
             return result;
         }
 
+        //! Run one pending job on the calling thread if there is any, return true if a job has been run. Threads waiting on jobs of this pool could call it to help
+        bool try_run_one();
+
     public:
         static void ResetStats();
 
@@ -83,17 +77,32 @@ namespace longmarch
         int threads;
 
     private:
-        using Proc = std::function<void(void)>;
-        using Queue = blocking_queue<Proc>;
-        using Queues = std::vector<Queue>;
+        using Task = InplaceTask;
+        using Deque = WorkStealingDeque<Task*>;
         using Thread = std::thread;
         using Threads = std::vector<Thread>;
 
-        constexpr inline static int K = {2};
+        void _Submit(Task&& task);
+        //! Pop from own deque (LIFO), then the injection queue, then steal from a random victim (FIFO)
+        bool _TryGetTask(int workerIndex, Task*& task);
+        void _Run(Task* task);
 
-        Queues m_queues;
+        //! Per worker deque, only its worker pushes and pops, other threads steal
+        std::vector<std::unique_ptr<Deque>> m_deques;
+        //! Jobs submitted by threads that are not workers of this pool
+        blocking_queue<Task*> m_injectionQueue;
         Threads m_threads;
         int m_count;
-        std::atomic_int_fast32_t m_index = {0};
+
+        //! Number of submitted jobs that are not yet picked up, workers sleep when it drops to zero
+        CACHE_ALIGN std::atomic_int64_t m_numPending{0};
+        std::atomic_int32_t m_numSleeping{0};
+        std::atomic_bool m_done{false};
+        std::mutex m_sleepMutex;
+        std::condition_variable m_sleepCv;
+
+        //! Pool and worker index of the calling thread, used to push jobs submitted from workers to their own deque
+        inline static thread_local const StealThreadPool* t_pool{nullptr};
+        inline static thread_local int t_workerIndex{-1};
     };
 }
@@ -5,40 +5,64 @@
 #include <type_traits>
 #include <vector>
 #include <map>
+#include <string>
 #include <phmap/phmap.h>
 #include <phmap/btree.h>
 
+// Include memory manager in order to use the custom mallocator
+#include "../allocator/MemoryManager.h"
+
 namespace longmarch
 {
-	template <typename Key, typename T>
-	using LongMarch_Map = phmap::btree_map<Key, T>; // std::map<Key, T>
+	/*
+		Containers below allocate from MemoryManager by default. Pass a stateful or polymorphic allocator as the last template argument to override it,
+		e.g. LongMarch_UnorderedMap<Key, T, std::pmr::polymorphic_allocator<std::pair<const Key, T>>> with FrameArena::GetMemoryResource()
+	*/
+#if CUSTOM_ALLOCATOR == 1
+	template <typename T>
+	using LongMarch_DefaultAllocator = longmarch::Mallocator<T>;
+#else
+	template <typename T>
+	using LongMarch_DefaultAllocator = std::allocator<T>;
+#endif // CUSTOM_ALLOCATOR
+
+	using LongMarch_String = std::basic_string<char, std::char_traits<char>, LongMarch_DefaultAllocator<char>>;
+
+	template <typename Key, typename T, typename Alloc = LongMarch_DefaultAllocator<std::pair<const Key, T>>>
+	using LongMarch_Map = phmap::btree_map<Key, T, std::less<Key>, Alloc>; // std::map<Key, T>
+
+	template <typename T, typename Alloc = LongMarch_DefaultAllocator<T>>
+	using LongMarch_Set = phmap::btree_set<T, std::less<T>, Alloc>; // std::set<T>
 
 	template <typename T>
-	using LongMarch_Set = phmap::btree_set<T>; // std::set<T>
+	using LongMarch_SetHash = phmap::priv::hash_default_hash<T>;
 
-	// For small set of data <= 64
 	template <typename T>
-	using LongMarch_UnorderedSet = phmap::flat_hash_set<T>;
+	using LongMarch_SetEq = phmap::priv::hash_default_eq<T>;
+
+	// For small set of data <= 64
+	template <typename T, typename Alloc = LongMarch_DefaultAllocator<T>>
+	using LongMarch_UnorderedSet = phmap::flat_hash_set<T, LongMarch_SetHash<T>, LongMarch_SetEq<T>, Alloc>;
 
 	// For small set of data <= 64. All data are stable upon insertion, and use this if move is expensive or not allowed
-	template <typename T>
-	using LongMarch_UnorderedSet_node = phmap::node_hash_set<T>;
+	template <typename T, typename Alloc = LongMarch_DefaultAllocator<T>>
+	using LongMarch_UnorderedSet_node = phmap::node_hash_set<T, LongMarch_SetHash<T>, LongMarch_SetEq<T>, Alloc>;
 
 	// For small set of data <= 64. Might move all data on insertion
-	template <typename T>
-	using LongMarch_UnorderedSet_flat = phmap::flat_hash_set<T>;
+	template <typename T, typename Alloc = LongMarch_DefaultAllocator<T>>
+	using LongMarch_UnorderedSet_flat = phmap::flat_hash_set<T, LongMarch_SetHash<T>, LongMarch_SetEq<T>, Alloc>;
 
 	// For large set of data > 64
-	template <typename T>
-	using LongMarch_UnorderedSet_Par = phmap::parallel_flat_hash_set<T>;
+	template <typename T, typename Alloc = LongMarch_DefaultAllocator<T>>
+	using LongMarch_UnorderedSet_Par = phmap::parallel_flat_hash_set<T, LongMarch_SetHash<T>, LongMarch_SetEq<T>, Alloc>;
 
 	// For large set of data > 64. All data are stable upon insertion, and use this if move is expensive or not allowed
-	template <typename T>
-	using LongMarch_UnorderedSet_Par_node = phmap::parallel_node_hash_set<T>;
+	template <typename T, typename Alloc = LongMarch_DefaultAllocator<T>>
+	using LongMarch_UnorderedSet_Par_node = phmap::parallel_node_hash_set<T, LongMarch_SetHash<T>, LongMarch_SetEq<T>, Alloc>;
 
 	// For large set of data > 64. Might move all data on insertion
-	template <typename T>
-	using LongMarch_UnorderedSet_Par_flat = phmap::parallel_flat_hash_set<T>;
+	template <typename T, typename Alloc = LongMarch_DefaultAllocator<T>>
+	using LongMarch_UnorderedSet_Par_flat = phmap::parallel_flat_hash_set<T, LongMarch_SetHash<T>, LongMarch_SetEq<T>, Alloc>;
 
 	struct LongMarch_EnumClassHash
 	{
@@ -47,17 +71,20 @@ namespace longmarch
 	template <typename Key>
 	using LongMarch_HashType = typename std::conditional<std::is_enum<Key>::value, LongMarch_EnumClassHash, std::hash<Key>>::type;
 
+	template <typename Key>
+	using LongMarch_KeyEq = phmap::priv::hash_default_eq<Key>;
+
 	// For small set of data <= 64
-	template <typename Key, typename T>
-	using LongMarch_UnorderedMap = phmap::flat_hash_map<Key, T, LongMarch_HashType<Key>>;
+	template <typename Key, typename T, typename Alloc = LongMarch_DefaultAllocator<std::pair<const Key, T>>>
+	using LongMarch_UnorderedMap = phmap::flat_hash_map<Key, T, LongMarch_HashType<Key>, LongMarch_KeyEq<Key>, Alloc>;
 
 	// For small set of data <= 64. All data are stable upon insertion, and use this if move is expensive or not allowed
-	template <typename Key, typename T>
-	using LongMarch_UnorderedMap_node = phmap::node_hash_map<Key, T, LongMarch_HashType<Key>>;
+	template <typename Key, typename T, typename Alloc = LongMarch_DefaultAllocator<std::pair<const Key, T>>>
+	using LongMarch_UnorderedMap_node = phmap::node_hash_map<Key, T, LongMarch_HashType<Key>, LongMarch_KeyEq<Key>, Alloc>;
 
 	// For small set of data <= 64. Might move all data on insertion
-	template <typename Key, typename T>
-	using LongMarch_UnorderedMap_flat = phmap::flat_hash_map<Key, T, LongMarch_HashType<Key>>;
+	template <typename Key, typename T, typename Alloc = LongMarch_DefaultAllocator<std::pair<const Key, T>>>
+	using LongMarch_UnorderedMap_flat = phmap::flat_hash_map<Key, T, LongMarch_HashType<Key>, LongMarch_KeyEq<Key>, Alloc>;
 
 	// // For large set of data > 64, warning : no internal lock for parallel access within the same bucket
 	// template <typename Key, typename T>
@@ -72,14 +99,14 @@ namespace longmarch
 	// using LongMarch_UnorderedMap_Par_flat = phmap::parallel_flat_hash_map<Key, T, LongMarch_HashType<Key>>;
 
 	// Parallel hash map should be called as concurrent hash map, which does not support faster look up 
-	template <typename Key, typename T>
-	using LongMarch_UnorderedMap_Par = phmap::flat_hash_map<Key, T, LongMarch_HashType<Key>>;
+	template <typename Key, typename T, typename Alloc = LongMarch_DefaultAllocator<std::pair<const Key, T>>>
+	using LongMarch_UnorderedMap_Par = phmap::flat_hash_map<Key, T, LongMarch_HashType<Key>, LongMarch_KeyEq<Key>, Alloc>;
 	
-	template <typename Key, typename T>
-	using LongMarch_UnorderedMap_Par_node = phmap::node_hash_map<Key, T, LongMarch_HashType<Key>>;
+	template <typename Key, typename T, typename Alloc = LongMarch_DefaultAllocator<std::pair<const Key, T>>>
+	using LongMarch_UnorderedMap_Par_node = phmap::node_hash_map<Key, T, LongMarch_HashType<Key>, LongMarch_KeyEq<Key>, Alloc>;
 	
-	template <typename Key, typename T>
-	using LongMarch_UnorderedMap_Par_flat = phmap::flat_hash_map<Key, T, LongMarch_HashType<Key>>;
+	template <typename Key, typename T, typename Alloc = LongMarch_DefaultAllocator<std::pair<const Key, T>>>
+	using LongMarch_UnorderedMap_Par_flat = phmap::flat_hash_map<Key, T, LongMarch_HashType<Key>, LongMarch_KeyEq<Key>, Alloc>;
 
 	
 	template<typename T>
@@ -268,15 +295,12 @@ namespace longmarch
 	}
 }
 
-// Include memory manager in order to use the custom mallocator
-#include "../allocator/MemoryManager.h"
-
 namespace longmarch
 {
 	
 #if CUSTOM_ALLOCATOR == 1
-	template<class T>
-	using LongMarch_Vector = std::vector<T, longmarch::Mallocator<T>>;
+	template<class T, typename Alloc = LongMarch_DefaultAllocator<T>>
+	using LongMarch_Vector = std::vector<T, Alloc>;
 
 	template<typename Func, typename T>
 	inline void LongMarch_ForEach(Func callback, std::initializer_list<const LongMarch_Vector<T>*> list)
@@ -361,8 +385,8 @@ namespace longmarch
 		return vc;
 	}
 #else
-	template<class T>
-	using LongMarch_Vector = std::vector<T>;
+	template<class T, typename Alloc = LongMarch_DefaultAllocator<T>>
+	using LongMarch_Vector = std::vector<T, Alloc>;
 #endif // CUSTOM_ALLOCATOR
 }
 
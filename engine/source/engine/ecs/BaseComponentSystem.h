@@ -124,6 +124,44 @@ namespace longmarch
         inline void SetWorld(GameWorld* world) const
         {
             m_parentWorld = world;
+            m_query = nullptr;
+        }
+
+        /*
+         *	@brief Persistent query of the system signature, iterate it to walk registered entities or chunks w/o allocation
+         **/
+        inline const EntityQuery& GetQuery() const
+        {
+            ENGINE_EXCEPT_IF(m_systemSignature == BitMaskSignature(),
+                             L"GetQuery() called on a trivial bit mask. System with trivial bit mask should always use User Registered Entities.");
+            if (!m_query || m_query->GetSignature() != m_systemSignature)
+            [[unlikely]]
+            {
+                m_query = &m_parentWorld->GetQuery(m_systemSignature);
+            }
+            return *m_query;
+        }
+
+        /*
+         *	@brief Begin tracking changes for this update, return the change version of the last update of this system.
+         *	The game world advances the change version before invoking each system, so components written by this system
+         *	from now on are not reported to this system in its next update, but components written by any later system are.
+         *	Use it like : const auto since = BeginChangeTracking(); ForEachChunkChanged<Transform3DCom>(since, ...);
+         **/
+        inline uint32_t BeginChangeTracking()
+        {
+            const auto since = m_lastChangeVersion;
+            m_lastChangeVersion = ArcheTypeManager::GetChangeVersion();
+            return since;
+        }
+
+        /*
+         *	@brief Iterate registered chunks whose component ComponentType is written after sinceVersion
+         **/
+        template <typename ComponentType, typename Func>
+        void ForEachChunkChanged(uint32_t sinceVersion, Func&& func) const
+        {
+            GetQuery().ForEachChunkChanged<ComponentType>(sinceVersion, std::forward<Func>(func));
         }
 
         //! Dispatcher to parent world
@@ -133,6 +171,13 @@ namespace longmarch
             return m_parentWorld->GetComponent<ComponentType>(entity);
         }
 
+        //! Dispatcher to parent world
+        template <class ComponentType>
+        const ComponentType* GetConstComponent(const Entity& entity) const
+        {
+            return m_parentWorld->GetConstComponent<ComponentType>(entity);
+        }
+
         //! Dispatcher to parent world
         template <class ComponentType>
         bool HasComponent(const Entity& entity) const
@@ -143,42 +188,42 @@ namespace longmarch
         //! Dispatcher to parent world : UE5 Mass ECS per Entity Chunk iteration
         inline void ForEach(const std::type_identity_t<std::function<void(const EntityDecorator& e)>>& func) const
         {
-            m_parentWorld->ForEach(GetRegisteredEntities(), func);
+            m_parentWorld->ForEach(GetQuery(), func);
         }
 
         //! Dispatcher to parent world : Unity DOTS ECS per Entity iteration
-        [[nodiscard]] inline std::future<void> BackEach(
+        [[nodiscard]] inline JobFuture<void> BackEach(
             const std::type_identity_t<std::function<void(const EntityDecorator& e)>>& func) const
         {
-            return m_parentWorld->BackEach(GetRegisteredEntities(), func);
+            return m_parentWorld->BackEach(GetQuery(), func);
         }
 
         //! Dispatcher to parent world : Unity DOTS ECS per Entity iteration
-        [[nodiscard]] inline std::future<void> ParEach(
+        [[nodiscard]] inline JobFuture<void> ParEach(
             const std::type_identity_t<std::function<void(const EntityDecorator& e)>>& func, int min_batch = -1) const
         {
-            return m_parentWorld->ParEach(GetRegisteredEntities(), func, min_batch);
+            return m_parentWorld->ParEach(GetQuery(), func, min_batch);
         }
 
         //! Dispatcher to parent world : Unity DOTS ECS per Entity iteration
         inline void ForEachChunk(const std::type_identity_t<std::function<void(const EntityChunkContext& e)>>& func) const
         {
-            m_parentWorld->ForEachChunk(GetRegisteredEntityChunks(), func);
+            m_parentWorld->ForEachChunk(GetQuery(), func);
         }
         
         //! Dispatcher to parent world : UE5 Mass ECS per Entity Chunk iteration
-        [[nodiscard]] inline std::future<void> BackEachChunk(
+        [[nodiscard]] inline JobFuture<void> BackEachChunk(
             const std::type_identity_t<std::function<void(const EntityChunkContext& e)>>& func) const
         {
-            return m_parentWorld->BackEachChunk(GetRegisteredEntityChunks(), func);
+            return m_parentWorld->BackEachChunk(GetQuery(), func);
         }
         
         //! Dispatcher to parent world : UE5 Mass ECS per Entity Chunk iteration
-        [[nodiscard]] inline std::future<void> ParEachChunk(
+        [[nodiscard]] inline JobFuture<void> ParEachChunk(
             const std::type_identity_t<std::function<void(const EntityChunkContext& e)>>& func,
             int min_batch = -1) const
         {
-            return m_parentWorld->ParEachChunk(GetRegisteredEntityChunks(), func, min_batch);
+            return m_parentWorld->ParEachChunk(GetQuery(), func, min_batch);
         }
 
         //! Dispatcher to parent world
@@ -188,14 +233,14 @@ namespace longmarch
         }
 
         //! Dispatcher to parent world
-        [[nodiscard]] inline std::future<void> BackEachUser(
+        [[nodiscard]] inline JobFuture<void> BackEachUser(
             const std::type_identity_t<std::function<void(const EntityDecorator& e)>>& func) const
         {
             return m_parentWorld->BackEach(GetUserRegisteredEntities(), func);
         }
 
         //! Dispatcher to parent world
-        [[nodiscard]] inline std::future<void> ParEachUser(
+        [[nodiscard]] inline JobFuture<void> ParEachUser(
             const std::type_identity_t<std::function<void(const EntityDecorator& e)>>& func, int min_batch = -1) const
         {
             return m_parentWorld->ParEach(GetUserRegisteredEntities(), func, min_batch);
@@ -296,6 +341,36 @@ namespace longmarch
             return m_systemSignature;
         }
 
+        /*
+         *	@brief Components read by this system, used by GameWorld to run non-conflicting systems concurrently.
+         *	By default, a system reads all components in its signature.
+         *	Override it if the system reads components outside of its signature.
+         **/
+        virtual BitMaskSignature GetReadSignature() const
+        {
+            return m_systemSignature;
+        }
+
+        /*
+         *	@brief Components written by this system, used by GameWorld to run non-conflicting systems concurrently.
+         *	By default, a system writes all components in its signature.
+         *	Override it if the system only reads some of them or writes components outside of its signature.
+         **/
+        virtual BitMaskSignature GetWriteSignature() const
+        {
+            return m_systemSignature;
+        }
+
+        /*
+         *	@brief An exclusive system never runs concurrently with other systems.
+         *	By default, systems with a trivial signature (i.e. working on user registered entities) are exclusive
+         *	because their component access could not be derived.
+         **/
+        virtual bool IsExclusive() const
+        {
+            return m_systemSignature == BitMaskSignature();
+        }
+
     protected:
         LongMarch_Vector<Entity> m_UserRegisteredEntities;
         //! Use Per InvokationPhase Job Queue to pass lambda that wait on futures (e.g. pareach in Update and wait in LateUpdate)
@@ -303,5 +378,9 @@ namespace longmarch
 
         BitMaskSignature m_systemSignature;
         mutable GameWorld* m_parentWorld{nullptr};
+        //! Cached persistent query of m_systemSignature in m_parentWorld
+        mutable const EntityQuery* m_query{nullptr};
+        //! Change version of the last update that tracked changes, 0 reports every chunk as changed
+        uint32_t m_lastChangeVersion{0};
     };
 }
@@ -132,6 +132,16 @@ namespace longmarch
 			return oldMask.IsAMatch(target) && !this->IsAMatch(target);
 		}
 
+		// return true if this mask shares at least one bit with target
+		inline bool Intersects(const BitMaskSignature& target) const noexcept
+		{
+#if USE_LARGE_COMPONENT_BIT_MASK == 0
+			return (m_mask & target.m_mask) != 0ull;
+#else
+			return ((m_mask & target.m_mask) != 0ull) || ((m_mask2 & target.m_mask2) != 0ull);
+#endif
+		}
+
 		// return true if this mask contain all bits in target
 		inline bool IsAMatch(const BitMaskSignature& target) const noexcept 
 		{
@@ -7,16 +7,27 @@
 #include "engine/core/thread/Lock.h"
 #include "engine/core/utility/TypeHelper.h"
 
+#include <atomic>
+
 #define RESERVE_SIZE 64
-#define NUM_COMPONENTS_PER_CHUNK 64
-#define CHUNK_INDEX(x) ((x) / NUM_COMPONENTS_PER_CHUNK)
-#define COM_INDEX(x) ((x) % NUM_COMPONENTS_PER_CHUNK)
+#define ARCHETYPE_CHUNK_SIZE (1u << 14) // 16KB of component data per archetype chunk
+#define ARCHETYPE_CHUNK_ALIGNMENT 64u // Column alignment within a chunk
+#define ARCHETYPE_ALIGN(x, a) (((x) + ((a) - 1)) & ~((a) - 1))
 
 namespace longmarch
 {
     class EntityChunkContext;
     class GameWorld;
 
+    /**
+     * @brief Type erased operations on a single component type.
+     *
+     * @detail Archetype chunks store components of different types side by side in raw memory,
+        so the archetype needs a way to construct, move and destroy a component without knowing its type.
+        Each component type gets exactly one (stateless) component manager.
+     *
+     * @author Dushyant Shukla (dushyant.shukla@digipen.edu | 60000519), Hang Yu (yohan680919@gmail.com)
+     */
     class BaseComponentManager
     {
     public:
@@ -25,246 +36,173 @@ namespace longmarch
         virtual ~BaseComponentManager() = default;
 
     public:
-        virtual void MoveBaseComponentByIndex(size_t index, BaseComponentInterface* component) = 0;
-        virtual BaseComponentInterface* GetBaseComponentByIndex(size_t index) const = 0;
-        virtual bool RemoveComponentByIndex(size_t index) = 0;
-        virtual bool HasIndex(size_t index, size_t& o_chunk_index, size_t& o_com_index) const = 0;
-
-        //! Get total number of components managed in this component manager
-        virtual size_t Size() const = 0;
-        virtual void ExpandSize(size_t newSize) = 0;
-
-        //! Get number of chunks
-        virtual size_t NumOfChunks() const = 0;
-        //! Get number of components in a chunk
-        virtual size_t GetNumOfComponentsAtChunk(size_t chunk_index) const = 0;
-
-        //! Copy/Clone all data from component manager to a new one
-        virtual std::shared_ptr<BaseComponentManager> Copy() const = 0;
-        //! Create new component manager of the same component type with empty data
-        virtual std::shared_ptr<BaseComponentManager> Create() const = 0;
-        //! Set the gameworld for all managed components
-        virtual void SetWorld(GameWorld* world) const = 0;
+        virtual ComponentTypeIndex_T GetTypeIndex() const = 0;
+        virtual size_t SizeOf() const = 0;
+        virtual size_t AlignOf() const = 0;
+
+        //! Default construct a component at uninitialized memory dst
+        virtual void DefaultConstruct(void* dst) const = 0;
+        //! Copy construct a component at uninitialized memory dst
+        virtual void CopyConstruct(void* dst, const void* src) const = 0;
+        //! Move construct a component at uninitialized memory dst, src is destroyed afterward
+        virtual void MoveConstructAndDestroy(void* dst, void* src) const = 0;
+        //! Destroy the component at p, p becomes uninitialized memory
+        virtual void Destroy(void* p) const = 0;
+
+        virtual BaseComponentInterface* GetBaseComponent(void* p) const = 0;
+        //! Set the gameworld for the component at p
+        virtual void SetWorld(void* p, GameWorld* world) const = 0;
     };
 
     /**
-     * @brief Component manager brings the entities and their corresponding components together.
-        Each component-type gets a component-manager.
-
-     * @detail Instead of making entities own their components, it is much more cache efficient
-        to store all components of a type at a single location. This ensures that when
-        systems run their update methods, they access all required components of a type
-        from a contiguous memory.
+     * @brief Component manager implements the type erased operations of a component type.
      *
      * @author Dushyant Shukla (dushyant.shukla@digipen.edu | 60000519), Hang Yu (yohan680919@gmail.com)
      */
     template <typename ComponentType>
-    class ComponentManager : public BaseComponentManager
+    class ComponentManager final : public BaseComponentManager
     {
     public:
-        struct ComponentChunk
-        {
-            // Component m_chunk storing a fixed number of elements, additionally, storing the index of the last available element
-            ComponentChunk() = default;
-            ComponentChunk(const ComponentChunk&) = default;
-
-            std::array<ComponentType, NUM_COMPONENTS_PER_CHUNK> m_chunk;
-            size_t m_lastIndex{NUM_COMPONENTS_PER_CHUNK - 1};
-        };
-
         NONCOPYABLE(ComponentManager);
         ComponentManager() = default;
 
-        //! ComponentType* is local and temporal because it might subject to change upon adding/removing elements happens in the component manager internally
-        // So do not store ComponentType* across frames
-        [[nodiscard]] ComponentType* GetComponentByIndex(size_t index) const
+        static const ComponentManager* GetInstance()
         {
-            size_t chunk_index, com_index;
-            if (HasIndex(index, chunk_index, com_index))
-            {
-                return const_cast<ComponentType*>(&_GetComponentInChunkByIndex(chunk_index, com_index));
-            }
-            else
-            {
-                return nullptr;
-            }
+            static const ComponentManager s_instance;
+            return &s_instance;
         }
 
-        void AddComponentToIndex(size_t index, const ComponentType& component)
+        virtual ComponentTypeIndex_T GetTypeIndex() const override
         {
-            size_t chunk_index, com_index;
-            ASSERT(HasIndex(index, chunk_index, com_index));
-            _GetComponentInChunkByIndex(chunk_index, com_index) = component;
+            return GetComponentTypeIndex<ComponentType>();
         }
 
-        void MoveComponentToIndex(size_t index, ComponentType&& component)
+        virtual size_t SizeOf() const override
         {
-            size_t chunk_index, com_index;
-            ASSERT(HasIndex(index, chunk_index, com_index));
-            _GetComponentInChunkByIndex(chunk_index, com_index) = std::move(component);
+            return sizeof(ComponentType);
         }
 
-        virtual void MoveBaseComponentByIndex(size_t index, BaseComponentInterface* component) override
+        virtual size_t AlignOf() const override
         {
-            auto com = static_cast<ComponentType*>(component);
-            ASSERT(com);
-            MoveComponentToIndex(index, std::move(*com));
+            return alignof(ComponentType);
         }
 
-        virtual BaseComponentInterface* GetBaseComponentByIndex(size_t index) const override
+        virtual void DefaultConstruct(void* dst) const override
         {
-            return static_cast<BaseComponentInterface*>(GetComponentByIndex(index));
+            new(dst) ComponentType();
         }
 
-        virtual bool RemoveComponentByIndex(size_t index) override
+        virtual void CopyConstruct(void* dst, const void* src) const override
         {
-            size_t chunk_index, com_index;
-            if (HasIndex(index, chunk_index, com_index))
-            {
-                // Swap between current m_chunk with last m_chunk
-                auto& m_chunk = m_componentChunks[chunk_index];
-                auto& last_chunk = m_componentChunks.back();
-                std::iter_swap(m_chunk->m_chunk.begin() + com_index,
-                               last_chunk->m_chunk.begin() + last_chunk->m_lastIndex);
-                if (last_chunk->m_lastIndex-- == 0)
-                {
-                    m_componentChunks.pop_back();
-                }
-                return true;
-            }
-            else
-            {
-                return false;
-            }
+            new(dst) ComponentType(*static_cast<const ComponentType*>(src));
         }
 
-        virtual bool HasIndex(size_t index, size_t& o_chunk_index, size_t& o_com_index) const override
+        virtual void MoveConstructAndDestroy(void* dst, void* src) const override
         {
-            if (o_chunk_index = CHUNK_INDEX(index);
-                o_chunk_index < m_componentChunks.size())
-            {
-                o_com_index = COM_INDEX(index);
-                return o_com_index <= m_componentChunks[o_chunk_index]->m_lastIndex;
-            }
-            else
-            {
-                return false;
-            }
+            auto com = static_cast<ComponentType*>(src);
+            new(dst) ComponentType(std::move(*com));
+            com->~ComponentType();
         }
 
-        virtual size_t Size() const override
+        virtual void Destroy(void* p) const override
         {
-            size_t ret = 0;
-            for (const auto& m_chunk : m_componentChunks)
-            {
-                ret += (m_chunk->m_lastIndex + 1);
-            }
-            return ret;
-        }
-
-        virtual void ExpandSize(size_t newSize) override
-        {
-            auto chunk_index = CHUNK_INDEX(newSize - 1);
-            auto com_index = COM_INDEX(newSize - 1);
-            if (m_componentChunks.empty())
-            [[unlikely]]
-            {
-                ASSERT(chunk_index == 0);
-                auto m_chunk = TemplateMemoryManager<ComponentChunk>::Make_shared();
-                m_chunk->m_lastIndex = com_index;
-                m_componentChunks.emplace_back(std::move(m_chunk));
-            }
-            else
-            [[likely]]
-            {
-                auto last_available_chunk_index = m_componentChunks.size() - 1;
-                ASSERT(chunk_index >= last_available_chunk_index);
-                for (int i = (chunk_index - last_available_chunk_index); i > 0; --i)
-                {
-                    auto m_chunk = TemplateMemoryManager<ComponentChunk>::Make_shared();
-                    m_componentChunks.emplace_back(std::move(m_chunk));
-                }
-                m_componentChunks[chunk_index]->m_lastIndex = com_index;
-            }
-        }
-
-        //! Helper method to define a EntityChunkContext
-        virtual size_t NumOfChunks() const
-        {
-            return m_componentChunks.size();
+            static_cast<ComponentType*>(p)->~ComponentType();
         }
 
-        //! Helper method to define a EntityChunkContext
-        ComponentType* GetComponentChunkPtr(size_t chunk_index) const
+        virtual BaseComponentInterface* GetBaseComponent(void* p) const override
         {
-            ASSERT(chunk_index < m_componentChunks.size());
-            return m_componentChunks[chunk_index]->m_chunk.data();
+            return static_cast<BaseComponentInterface*>(static_cast<ComponentType*>(p));
         }
 
-        //! Helper method to define a EntityChunkContext
-        size_t GetNumOfComponentsAtChunk(size_t chunk_index) const
+        virtual void SetWorld(void* p, GameWorld* world) const override
         {
-            ASSERT(chunk_index < m_componentChunks.size());
-            return m_componentChunks[chunk_index]->m_lastIndex + 1;
-        }
-
-        virtual std::shared_ptr<BaseComponentManager> Copy() const override
-        {
-            auto ret = MemoryManager::Make_shared<ComponentManager>();
-            for (const auto& m_chunk : m_componentChunks)
-            {
-                ret->m_componentChunks.emplace_back(
-                    std::move(TemplateMemoryManager<ComponentChunk>::Make_shared(*m_chunk)));
-            }
-            return ret;
-        }
-
-        virtual std::shared_ptr<BaseComponentManager> Create() const override
-        {
-            return MemoryManager::Make_shared<ComponentManager>();
+            static_cast<ComponentType*>(p)->SetWorld(world);
         }
+    };
 
-        virtual void SetWorld(GameWorld* world) const override
-        {
-            for (auto& m_chunk : m_componentChunks)
-            {
-                for (size_t i = 0; i <= m_chunk->m_lastIndex; ++i)
-                {
-                    m_chunk->m_chunk[i].SetWorld(world);
-                }
-            }
-        }
+    /**
+     * @brief A fixed size block of memory that stores all component columns of an archetype side by side (SoA)
+     *
+     * @detail For an archetype with components A, B, C and a chunk capacity of N, the chunk is laid out as
+        [vA vB vC][A0 A1 ... AN-1][B0 B1 ... BN-1][C0 C1 ... CN-1], each column being aligned to ARCHETYPE_CHUNK_ALIGNMENT.
+        The header [vA vB vC] holds the change version of each column, that is the last version at which the column is written.
+     *
+     * @author Hang Yu (yohan680919@gmail.com)
+     */
+    struct ArcheTypeChunk
+    {
+        NONCOPYABLE(ArcheTypeChunk);
+        ArcheTypeChunk() = default;
 
-    private:
-        [[nodiscard]] ComponentType& _GetComponentInChunkByIndex(size_t chunk_index, size_t com_index) const
+        //! Our allocator only guarantees 8 bytes alignment, so we pad the data and align it manually
+        std::byte* GetData() noexcept
         {
-            return m_componentChunks[chunk_index]->m_chunk[com_index];
+            return reinterpret_cast<std::byte*>(ARCHETYPE_ALIGN(reinterpret_cast<uintptr_t>(m_data),
+                                                                static_cast<uintptr_t>(ARCHETYPE_CHUNK_ALIGNMENT)));
         }
 
-
-    private:
-        friend class ArcheTypeManager;
-        // Stores all the component instances in an array
-        LongMarch_Vector<std::shared_ptr<ComponentChunk>> m_componentChunks;
+        //! Number of entities stored in this chunk
+        size_t m_size{0};
+        std::byte m_data[ARCHETYPE_CHUNK_SIZE + ARCHETYPE_CHUNK_ALIGNMENT];
     };
 
     /**
      * @brief Archetype is equivalent to a collection of entities with the same set of components.
      * The ArcheTypeManager manages push and pop of every entity of certain archetype on adding/removing components
 
-     * @detail The ArcheTypeManager maintains the list of entities and their underlying indices 
+     * @detail The ArcheTypeManager owns a list of 16KB chunks, each holding all component columns of the archetype
+        side by side, so that iterating on a chunk walks contiguous memory for every component type.
+        All chunks are full except the last one, so entity index i lives in chunk (i / capacity) at row (i % capacity).
+        The archetype does not map entities to their indices, the game world keeps track of the index (row) of each entity
+        and addresses components by it.
+
+        Every mutable access to a component (and every add/remove that moves components) stamps the column of its chunk
+        with the current change version, so that systems could skip chunks that have not been written since they last run.
      *
      * @author Hang Yu (yohan680919@gmail.com)
      */
     class ArcheTypeManager
     {
+    private:
+        struct ComponentColumn
+        {
+            const BaseComponentManager* m_manager{nullptr};
+            //! Byte offset of the column from the beginning of the chunk data
+            size_t m_offset{0};
+        };
+
+        using ChangeVersion_T = std::atomic_uint32_t;
+        static_assert(ChangeVersion_T::is_always_lock_free && sizeof(ChangeVersion_T) == sizeof(uint32_t));
+
     public:
         NONCOPYABLE(ArcheTypeManager);
 
+        //! Current change version, components written from now on are stamped with it
+        inline static uint32_t GetChangeVersion()
+        {
+            return s_changeVersion.load(std::memory_order_acquire);
+        }
+
+        //! Increment the change version and return the new version
+        inline static uint32_t AdvanceChangeVersion()
+        {
+            return s_changeVersion.fetch_add(1, std::memory_order_acq_rel) + 1;
+        }
+
+        //! Wrap around safe comparison of change versions
+        inline static bool IsNewerVersion(uint32_t version, uint32_t since)
+        {
+            return static_cast<int32_t>(version - since) > 0;
+        }
+
         ArcheTypeManager()
         {
             m_entities.reserve(RESERVE_SIZE);
-            m_entitiesAndComponentIndices.reserve(RESERVE_SIZE);
+        }
+
+        ~ArcheTypeManager()
+        {
+            _Clear();
         }
 
         size_t Size() const
@@ -275,13 +213,29 @@ namespace longmarch
         void CopyComponentManagerFrom(const ArcheTypeManager& other)
         {
             ASSERT(this->m_entities.empty());
-            ASSERT(this->m_entitiesAndComponentIndices.empty());
-            ASSERT(this->m_componentManagers.empty());
+            ASSERT(this->m_columns.empty());
+
+            for (const auto& column : other.m_columns)
+            {
+                _AddColumn(column.m_manager);
+            }
+            _UpdateLayout();
+        }
+
+        //! Same as CopyComponentManagerFrom, but exclude one component type
+        void CopyComponentManagerFrom(const ArcheTypeManager& other, ComponentTypeIndex_T excludedComTypeIndex)
+        {
+            ASSERT(this->m_entities.empty());
+            ASSERT(this->m_columns.empty());
 
-            for (const auto& [comType, comManger] : other.m_componentManagers)
+            for (const auto& column : other.m_columns)
             {
-                this->m_componentManagers[comType] = comManger->Create();
+                if (column.m_manager->GetTypeIndex() != excludedComTypeIndex)
+                {
+                    _AddColumn(column.m_manager);
+                }
             }
+            _UpdateLayout();
         }
 
         template <typename ComponentType>
@@ -289,258 +243,459 @@ namespace longmarch
         {
             ASSERT(this->m_entities.empty(),
                    Str("AddComponentManger should only be invoked on a newly allocated Archetype"));
-            ASSERT(this->m_entitiesAndComponentIndices.empty(),
+            ASSERT(_ColumnIndex(GetComponentTypeIndex<ComponentType>()) < 0,
+                   Str("AddComponentManger should not add a existing component manager"));
+            _AddColumn(ComponentManager<ComponentType>::GetInstance());
+            _UpdateLayout();
+        }
+
+        //! Add multiple component managers at once so that the chunk layout is only computed once
+        template <typename C1, typename C2, typename... ComponentTypes>
+        void AddComponentManger()
+        {
+            ASSERT(this->m_entities.empty(),
                    Str("AddComponentManger should only be invoked on a newly allocated Archetype"));
-            auto type = GetComponentTypeIndex<ComponentType>();
-            ASSERT(!m_componentManagers.contains(type),
+            ASSERT(_ColumnIndex(GetComponentTypeIndex<C1>()) < 0 &&
+                   _ColumnIndex(GetComponentTypeIndex<C2>()) < 0 &&
+                   ((_ColumnIndex(GetComponentTypeIndex<ComponentTypes>()) < 0) && ...),
                    Str("AddComponentManger should not add a existing component manager"));
-            m_componentManagers[type] = MemoryManager::Make_shared<ComponentManager<ComponentType>>();
+            _AddColumn(ComponentManager<C1>::GetInstance());
+            _AddColumn(ComponentManager<C2>::GetInstance());
+            (_AddColumn(ComponentManager<ComponentTypes>::GetInstance()), ...);
+            _UpdateLayout();
         }
 
-        [[nodiscard]] BaseComponentInterface* GetBaseComponentByEntity(const Entity& entity,
-                                                                       ComponentTypeIndex_T comTypeIndex) const
+        //! Mutable access, stamps the component column of the chunk with the current change version
+        [[nodiscard]] BaseComponentInterface* GetBaseComponentByIndex(size_t index, ComponentTypeIndex_T comTypeIndex) const
         {
-            size_t index;
-            if (_HasEntity(entity, index))
-            {
-                ASSERT(m_componentManagers.contains(comTypeIndex));
-                const auto& manager = m_componentManagers.at(comTypeIndex);
-                ASSERT(manager, Str("ArcheType should already contain %ud", comTypeIndex));
+            const auto columnIndex = _ColumnIndex(comTypeIndex);
+            ASSERT(columnIndex >= 0, Str("ArcheType should already contain %ud", comTypeIndex));
+            const auto& column = m_columns[columnIndex];
+            _MarkChanged(index / m_chunkCapacity, columnIndex);
+            return column.m_manager->GetBaseComponent(_GetComponentAddress(column, index));
+        }
 
-                ASSERT([=](){size_t _1; size_t _2; return manager->HasIndex(index,_1,_2);}(),
-                       Str("ArcheType component manager %ud should already contain index %ull", comTypeIndex, index));
-                return manager->GetBaseComponentByIndex(index);
-            }
-            else
-            {
-                ENGINE_EXCEPT(wStr(L"Entity %s is not registered", wStr(entity).c_str()));
-                return nullptr;
-            }
+        //! Mutable access, stamps the component column of the chunk with the current change version
+        template <typename ComponentType>
+        [[nodiscard]] ComponentType* GetComponentByIndex(size_t index) const
+        {
+            const auto columnIndex = _ColumnIndex(GetComponentTypeIndex<ComponentType>());
+            ASSERT(columnIndex >= 0, Str("ArcheType should already contain %s", typeid(ComponentType).name()));
+            _MarkChanged(index / m_chunkCapacity, columnIndex);
+            return static_cast<ComponentType*>(_GetComponentAddress(m_columns[columnIndex], index));
         }
 
+        //! Read only access, does not change the change version
         template <typename ComponentType>
-        [[nodiscard]] ComponentType* GetComponentByEntity(const Entity& entity) const
+        [[nodiscard]] const ComponentType* GetConstComponentByIndex(size_t index) const
+        {
+            return _GetComponentByIndex<ComponentType>(index);
+        }
+
+        /**
+         * @brief Move an entity and all its shared components to the other archetype. Components that only exist in the
+         * other archetype are constructed from the given components if provided, otherwise default constructed.
+         * Components that only exist in this archetype are destroyed.
+         *
+         * The entity is pushed back to the other archetype, so its new index is other.Size() - 1.
+         *
+         * @return The entity that is swapped into the vacant index of this archetype, or an empty entity if none
+         */
+        template <typename... ComponentTypes>
+        Entity MoveOutEntity(size_t index, ArcheTypeManager& other, ComponentTypes&&... components)
         {
-            size_t index;
-            if (_HasEntity(entity, index))
+            // Sanity checks
+            ASSERT(this->m_columns.size() != other.m_columns.size());
+            ENGINE_EXCEPT_IF(index >= this->m_entities.size(), wStr(L"Cannot move out a unmanaged index %zu", index));
+
+            // Emplace entity to the other manager
+            const size_t emplaceIndex = other._AddEntity(this->m_entities[index]);
+            const ComponentTypeIndex_T providedTypeIndices[] = {GetComponentTypeIndex<std::remove_cvref_t<ComponentTypes>>()..., 0};
+
+            for (const auto& column : other.m_columns)
             {
-                auto manager = static_cast<ComponentManager<ComponentType>*>(m_componentManagers.at(
-                    GetComponentTypeIndex<ComponentType>()).get());
-                ASSERT(manager, Str("ArcheType should already contain %s", typeid(ComponentType).name()));
-                ASSERT([=](){size_t _1; size_t _2; return manager->HasIndex(index,_1,_2);}(),
-                       Str("ArcheType component manager %s should already contain index %ull", typeid(ComponentType).
-                           name(), index));
-                return manager->GetComponentByIndex(index);
+                auto dst = other._GetComponentAddress(column, emplaceIndex);
+                if (const auto columnIndex = this->_ColumnIndex(column.m_manager->GetTypeIndex());
+                    columnIndex >= 0)
+                {
+                    column.m_manager->MoveConstructAndDestroy(dst, this->_GetComponentAddress(this->m_columns[columnIndex], index));
+                }
+                else if (!_Contains(providedTypeIndices, sizeof...(ComponentTypes), column.m_manager->GetTypeIndex()))
+                {
+                    column.m_manager->DefaultConstruct(dst);
+                }
             }
-            else
+            (other._ConstructComponent(emplaceIndex, std::forward<ComponentTypes>(components)), ...);
+            for (const auto& column : this->m_columns)
             {
-                ENGINE_EXCEPT(wStr(L"Entity %s is not registered", wStr(entity).c_str()));
-                return nullptr;
+                if (other._ColumnIndex(column.m_manager->GetTypeIndex()) < 0)
+                {
+                    column.m_manager->Destroy(this->_GetComponentAddress(column, index));
+                }
             }
+            // Destroy entity for this manager
+            return this->_RemoveEntityAtIndex(index, true);
         }
 
-        template <typename ComponentType>
-        void AddComponentToEntity(const Entity& entity, const ComponentType& component)
+        /**
+         * @brief Add a new entity whose components are constructed in place from the given components, components of
+         * this archetype that are not provided are default constructed.
+         *
+         * @return The index of the new entity
+         */
+        template <typename... ComponentTypes>
+        size_t EmplaceEntity(const Entity& entity, ComponentTypes&&... components)
         {
-            auto manager = static_cast<ComponentManager<ComponentType>*>(m_componentManagers[GetComponentTypeIndex<
-                ComponentType>()].get());
-            ASSERT(manager, Str("ArcheType should already contain %s", typeid(ComponentType).name()));
-            size_t index;
-            if (!_HasEntity(entity, index))
+            const auto index = _AddEntity(entity);
+            const ComponentTypeIndex_T providedTypeIndices[] = {GetComponentTypeIndex<std::remove_cvref_t<ComponentTypes>>()..., 0};
+            for (const auto& column : m_columns)
             {
-                index = m_entities.size();
-                m_entities.push_back(entity);
-                m_entitiesAndComponentIndices[entity] = index;
+                if (!_Contains(providedTypeIndices, sizeof...(ComponentTypes), column.m_manager->GetTypeIndex()))
+                {
+                    column.m_manager->DefaultConstruct(_GetComponentAddress(column, index));
+                }
             }
-            manager->ExpandSize(index + 1);
-            manager->AddComponentToIndex(index, component);
-            ASSERT(m_entities.size() == manager->Size());
+            (_ConstructComponent(index, std::forward<ComponentTypes>(components)), ...);
+            ASSERT(m_entities.size() == _NumOfConstructedRows());
+            return index;
         }
 
-        template <typename ComponentType>
-        void MoveComponentToEntity(const Entity& entity, ComponentType&& component)
+        //! Reserve bookkeeping storage for entities that are about to be added
+        void Reserve(size_t num)
         {
-            auto manager = static_cast<ComponentManager<ComponentType>*>(m_componentManagers[GetComponentTypeIndex<
-                ComponentType>()].get());
-            ASSERT(manager, Str("ArcheType should already contain %s", typeid(ComponentType).name()));
-            size_t index;
-            if (!_HasEntity(entity, index))
+            m_entities.reserve(num);
+            if (m_chunkCapacity > 0)
             {
-                index = m_entities.size();
-                m_entities.push_back(entity);
-                m_entitiesAndComponentIndices[entity] = index;
+                m_chunks.reserve((num + m_chunkCapacity - 1) / m_chunkCapacity);
             }
-            manager->ExpandSize(index + 1);
-            manager->MoveComponentToIndex(index, component);
-            ASSERT(m_entities.size() == manager->Size());
         }
 
-        void MoveOutEntity(const Entity& entity, ArcheTypeManager& other)
+        /**
+         * @brief Remove the entity at index and destroy all its components
+         *
+         * @return The entity that is swapped into the vacant index of this archetype, or an empty entity if none
+         */
+        Entity RemoveEntity(size_t index)
         {
-            // Sanity checks
-            ASSERT(this->m_componentManagers.size() != other.m_componentManagers.size());
-            size_t index;
-            ENGINE_EXCEPT_IF(other._HasEntity(entity, index), wStr(L"Cannot move in a managed entity %s", Str(entity)));
-            ENGINE_EXCEPT_IF(!this->_HasEntity(entity, index),
-                             wStr(L"Cannot move out a unmanaged entity %s", Str(entity)));
+            ENGINE_EXCEPT_IF(index >= this->m_entities.size(), wStr(L"Cannot remove a unmanaged index %zu", index));
+            // Destroy entity for this manager
+            return this->_RemoveEntityAtIndex(index, false);
+        }
 
-            // Emplace entity to the other manager
-            const size_t emplaceIndex = other._AddEntityAndExpandComponentArray(entity);
+        [[nodiscard]] const Entity& GetEntity(size_t index) const
+        {
+            ASSERT(index < m_entities.size());
+            return m_entities[index];
+        }
+
+        const LongMarch_Vector<Entity>& GetEntityView() const
+        {
+            return m_entities;
+        }
+
+        size_t NumOfChunks() const
+        {
+            return m_chunks.size();
+        }
+
+        //! Max number of entities in a chunk
+        size_t ChunkCapacity() const
+        {
+            return m_chunkCapacity;
+        }
+
+        size_t GetNumOfEntitiesAtChunk(size_t chunk_index) const
+        {
+            ASSERT(chunk_index < m_chunks.size());
+            return m_chunks[chunk_index]->m_size;
+        }
+
+        //! Pointer to the first component of the chunk. Do not store it across frames as adding/removing entities would move components
+        //! Mutable access, stamps the component column of the chunk with the current change version
+        template <typename ComponentType>
+        [[nodiscard]] ComponentType* GetComponentChunkPtr(size_t chunk_index) const
+        {
+            ASSERT(chunk_index < m_chunks.size());
+            const auto columnIndex = _ColumnIndex(GetComponentTypeIndex<ComponentType>());
+            ASSERT(columnIndex >= 0, Str("ArcheType should already contain %s", typeid(ComponentType).name()));
+            _MarkChanged(chunk_index, columnIndex);
+            return reinterpret_cast<ComponentType*>(m_chunks[chunk_index]->GetData() + m_columns[columnIndex].m_offset);
+        }
+
+        //! Read only access, does not change the change version
+        template <typename ComponentType>
+        [[nodiscard]] const ComponentType* GetConstComponentChunkPtr(size_t chunk_index) const
+        {
+            ASSERT(chunk_index < m_chunks.size());
+            const auto columnIndex = _ColumnIndex(GetComponentTypeIndex<ComponentType>());
+            ASSERT(columnIndex >= 0, Str("ArcheType should already contain %s", typeid(ComponentType).name()));
+            return reinterpret_cast<const ComponentType*>(m_chunks[chunk_index]->GetData() + m_columns[columnIndex].m_offset);
+        }
+
+        //! Last version at which the component column of the chunk is written
+        [[nodiscard]] uint32_t GetChunkChangeVersion(size_t chunk_index, ComponentTypeIndex_T comTypeIndex) const
+        {
+            ASSERT(chunk_index < m_chunks.size());
+            const auto columnIndex = _ColumnIndex(comTypeIndex);
+            ASSERT(columnIndex >= 0, Str("ArcheType should already contain %ud", comTypeIndex));
+            return _GetChunkVersions(chunk_index)[columnIndex].load(std::memory_order_relaxed);
+        }
+
+        //! Pointer to the first entity of the chunk
+        [[nodiscard]] const Entity* GetEntityChunkPtr(size_t chunk_index) const
+        {
+            ASSERT(chunk_index < m_chunks.size());
+            return m_entities.data() + chunk_index * m_chunkCapacity;
+        }
 
-            if (const bool updateBasedOnThis = m_componentManagers.size() < other.m_componentManagers.size();
-                updateBasedOnThis)
+        [[nodiscard]] std::shared_ptr<ArcheTypeManager> Copy() const
+        {
+            auto ret = MemoryManager::Make_shared<ArcheTypeManager>();
+            ret->CopyComponentManagerFrom(*this);
+            for (size_t index = 0; index < m_entities.size(); ++index)
             {
-                for (const auto& [comType, comManger] : this->m_componentManagers)
+                const auto emplaceIndex = ret->_AddEntity(m_entities[index]);
+                ASSERT(emplaceIndex == index);
+                for (size_t i = 0; i < m_columns.size(); ++i)
                 {
-                    ASSERT(other.m_componentManagers.contains(comType),
-                           Str("Component type %ud not contained by other", comType));
-                    other.m_componentManagers[comType]->MoveBaseComponentByIndex(
-                        emplaceIndex, comManger->GetBaseComponentByIndex(index));
+                    m_columns[i].m_manager->CopyConstruct(ret->_GetComponentAddress(ret->m_columns[i], emplaceIndex),
+                                                          _GetComponentAddress(m_columns[i], index));
                 }
             }
-            else
+            return ret;
+        }
+
+        void SetWorld(GameWorld* world) const
+        {
+            for (size_t index = 0; index < m_entities.size(); ++index)
             {
-                for (auto& [comType, comManger] : other.m_componentManagers)
+                for (const auto& column : m_columns)
                 {
-                    ASSERT(this->m_componentManagers.contains(comType),
-                           Str("Component type %ud not contained by other", comType));
-                    comManger->MoveBaseComponentByIndex(emplaceIndex,
-                                                        this->m_componentManagers[comType]->GetBaseComponentByIndex(
-                                                            index));
+                    column.m_manager->SetWorld(_GetComponentAddress(column, index), world);
                 }
             }
-            // Destroy entity for this manager
-            this->_RemoveEntityAtIndex(entity, index);
         }
 
-        void RemoveEntity(const Entity& entity)
+    private:
+        void _AddColumn(const BaseComponentManager* manager)
         {
-            size_t index;
-            ENGINE_EXCEPT_IF(!this->_HasEntity(entity, index),
-                             wStr(L"Cannot remove a unmanaged entity %s", Str(entity)));
-            // Destroy entity for this manager
-            this->_RemoveEntityAtIndex(entity, index);
+            m_columns.emplace_back(ComponentColumn{manager, 0});
+            // Keep columns sorted by component type index so that archetypes with the same signature share the same layout
+            std::sort(m_columns.begin(), m_columns.end(), [](const ComponentColumn& lhs, const ComponentColumn& rhs)
+            {
+                return lhs.m_manager->GetTypeIndex() < rhs.m_manager->GetTypeIndex();
+            });
+            m_columnIndices.clear();
+            for (size_t i = 0; i < m_columns.size(); ++i)
+            {
+                const auto comTypeIndex = m_columns[i].m_manager->GetTypeIndex();
+                if (comTypeIndex >= m_columnIndices.size())
+                {
+                    m_columnIndices.resize(comTypeIndex + 1, -1);
+                }
+                m_columnIndices[comTypeIndex] = static_cast<int32_t>(i);
+            }
+        }
+
+        //! Index of the column in m_columns, -1 if the archetype does not have the component type
+        int32_t _ColumnIndex(ComponentTypeIndex_T comTypeIndex) const
+        {
+            return (comTypeIndex < m_columnIndices.size()) ? m_columnIndices[comTypeIndex] : -1;
+        }
+
+        //! Find the largest chunk capacity such that the change version header and all columns fit into a single chunk
+        void _UpdateLayout()
+        {
+            ASSERT(m_chunks.empty(), "Chunk layout should only be updated on an empty archetype");
+            size_t rowSize = 0;
+            for (const auto& column : m_columns)
+            {
+                ASSERT(column.m_manager->AlignOf() <= ARCHETYPE_CHUNK_ALIGNMENT, "Component alignment is too large!");
+                rowSize += column.m_manager->SizeOf();
+            }
+            if (rowSize == 0)
+            {
+                m_chunkCapacity = 0;
+                return;
+            }
+            const size_t headerSize = ARCHETYPE_ALIGN(m_columns.size() * sizeof(ChangeVersion_T), ARCHETYPE_CHUNK_ALIGNMENT);
+            size_t capacity = (ARCHETYPE_CHUNK_SIZE - headerSize) / rowSize;
+            for (; capacity > 0; --capacity)
+            {
+                size_t offset = headerSize;
+                for (auto& column : m_columns)
+                {
+                    offset = ARCHETYPE_ALIGN(offset, column.m_manager->AlignOf());
+                    column.m_offset = offset;
+                    offset += column.m_manager->SizeOf() * capacity;
+                }
+                if (offset <= ARCHETYPE_CHUNK_SIZE)
+                {
+                    break;
+                }
+            }
+            ENGINE_EXCEPT_IF(capacity == 0, wStr(L"Archetype row size %zu does not fit into a chunk!", rowSize));
+            m_chunkCapacity = capacity;
         }
 
-        [[nodiscard]] bool HasEntity(const Entity& entity) const
+        [[nodiscard]] void* _GetComponentAddress(const ComponentColumn& column, size_t index) const
         {
-            size_t _;
-            return _HasEntity(entity, _);
+            const auto chunk_index = index / m_chunkCapacity;
+            const auto row_index = index % m_chunkCapacity;
+            ASSERT(chunk_index < m_chunks.size() && row_index < m_chunks[chunk_index]->m_size);
+            return m_chunks[chunk_index]->GetData() + column.m_offset + row_index * column.m_manager->SizeOf();
         }
 
         template <typename ComponentType>
-        [[nodiscard]] ComponentManager<ComponentType>* GetComponentManger() const
+        [[nodiscard]] ComponentType* _GetComponentByIndex(size_t index) const
         {
-            ASSERT(m_componentManagers.contains(GetComponentTypeIndex<ComponentType>()));
-            return static_cast<ComponentManager<ComponentType>*>(m_componentManagers.at(
-                GetComponentTypeIndex<ComponentType>()).get());
+            const auto columnIndex = _ColumnIndex(GetComponentTypeIndex<ComponentType>());
+            ASSERT(columnIndex >= 0, Str("ArcheType should already contain %s", typeid(ComponentType).name()));
+            const auto& column = m_columns[columnIndex];
+            return static_cast<ComponentType*>(_GetComponentAddress(column, index));
         }
 
-        const LongMarch_Vector<Entity>& GetEntityView() const
+        [[nodiscard]] ChangeVersion_T* _GetChunkVersions(size_t chunk_index) const
         {
-            return m_entities;
+            return reinterpret_cast<ChangeVersion_T*>(m_chunks[chunk_index]->GetData());
         }
 
-        size_t NumOfChunks() const
+        void _MarkChanged(size_t chunk_index, int32_t columnIndex) const
         {
-            if (m_componentManagers.empty())
-            [[unlikely]]
+            auto& version = _GetChunkVersions(chunk_index)[columnIndex];
+            // Parallel jobs write many components of the same chunk, only store once per version to keep the cache line shared
+            if (const auto current = GetChangeVersion(); version.load(std::memory_order_relaxed) != current)
             {
-                return 0;
+                version.store(current, std::memory_order_relaxed);
             }
-            else
-            [[likely]]
+        }
+
+        void _MarkChunkChanged(size_t chunk_index) const
+        {
+            for (int32_t i = 0; i < static_cast<int32_t>(m_columns.size()); ++i)
             {
-                const auto& arbitraryComponentManager = this->m_componentManagers.begin()->second;
-                return arbitraryComponentManager->NumOfChunks();
+                _MarkChanged(chunk_index, i);
             }
         }
 
-        [[nodiscard]] std::shared_ptr<ArcheTypeManager> Copy() const
+        //! Placement construct a component at a reserved row
+        template <typename ComponentType>
+        void _ConstructComponent(size_t index, ComponentType&& component)
         {
-            auto ret = MemoryManager::Make_shared<ArcheTypeManager>();
+            using Com_T = std::remove_cvref_t<ComponentType>;
+            new(_GetComponentByIndex<Com_T>(index)) Com_T(std::forward<ComponentType>(component));
+        }
 
-            ret->m_entities = m_entities;
-            ret->m_entitiesAndComponentIndices = m_entitiesAndComponentIndices;
-            for (const auto& [comType, comManager] : m_componentManagers)
-            {
-                ret->m_componentManagers[comType] = comManager->Copy();
-            }
-            return ret;
+        static bool _Contains(const ComponentTypeIndex_T* indices, size_t num, ComponentTypeIndex_T comTypeIndex)
+        {
+            return std::find(indices, indices + num, comTypeIndex) != indices + num;
         }
 
-        void SetWorld(GameWorld* world) const
+        size_t _NumOfConstructedRows() const
         {
-            for (const auto& [_, comManger] : m_componentManagers)
+            size_t ret = 0;
+            for (const auto chunk : m_chunks)
             {
-                comManger->SetWorld(world);
+                ret += chunk->m_size;
             }
+            return ret;
         }
 
-    private:
-        [[nodiscard]] size_t _AddEntityAndExpandComponentArray(const Entity& entity)
+        //! Push back an entity and reserve a row for it, components are left uninitialized
+        [[nodiscard]] size_t _AddEntity(const Entity& entity)
         {
-            size_t index;
-            ASSERT(!_HasEntity(entity, index));
+            ASSERT(m_chunkCapacity > 0, "Adding entity to an archetype without component");
             // Push back entity
-            index = m_entities.size();
+            const size_t index = m_entities.size();
             m_entities.push_back(entity);
-            m_entitiesAndComponentIndices[entity] = index;
-            for (auto& [_, comManager] : m_componentManagers)
+            // Allocate a new chunk if all chunks are full
+            if (index == m_chunks.size() * m_chunkCapacity)
+            {
+                m_chunks.emplace_back(TemplateMemoryManager<ArcheTypeChunk>::New());
+                const auto versions = _GetChunkVersions(m_chunks.size() - 1);
+                for (size_t i = 0; i < m_columns.size(); ++i)
+                {
+                    new(versions + i) ChangeVersion_T(GetChangeVersion());
+                }
+            }
+            else
             {
-                // Asset entity length matches component list size
-                ASSERT(index == comManager->Size());
-                // Expand component array by 1 with uninitialized value
-                comManager->ExpandSize(index + 1);
+                _MarkChunkChanged(m_chunks.size() - 1);
             }
+            ++m_chunks.back()->m_size;
             return index;
         }
 
-        void _RemoveEntityAtIndex(const Entity& entity, size_t index)
+        //! Swap the last entity into the vacant index, return the swapped entity
+        Entity _RemoveEntityAtIndex(size_t index, bool componentsDestroyed)
         {
             ASSERT(index < m_entities.size());
-            const bool shouldSwapBack = index != (m_entities.size() - 1);
+            const size_t lastIndex = m_entities.size() - 1;
+            const bool shouldSwapBack = index != lastIndex;
 
-            if (shouldSwapBack)
+            for (const auto& column : m_columns)
             {
-                m_entitiesAndComponentIndices[m_entities.back()] = index;
+                auto dst = _GetComponentAddress(column, index);
+                if (!componentsDestroyed)
+                {
+                    column.m_manager->Destroy(dst);
+                }
+                if (shouldSwapBack)
+                {
+                    column.m_manager->MoveConstructAndDestroy(dst, _GetComponentAddress(column, lastIndex));
+                }
             }
-            m_entitiesAndComponentIndices.erase(entity);
 
+            Entity swapped;
             if (shouldSwapBack)
             {
-                std::iter_swap(m_entities.begin() + index, m_entities.end() - 1);
+                _MarkChunkChanged(index / m_chunkCapacity);
+                swapped = m_entities.back();
+                m_entities[index] = swapped;
             }
             m_entities.pop_back();
 
-            for (auto& [_, comManager] : m_componentManagers)
+            // Release the last chunk once it becomes empty
+            if (auto& lastChunk = m_chunks.back(); --lastChunk->m_size == 0)
             {
-                comManager->RemoveComponentByIndex(index);
+                TemplateMemoryManager<ArcheTypeChunk>::Delete(lastChunk);
+                m_chunks.pop_back();
             }
+            return swapped;
         }
 
-        [[nodiscard]] bool _HasEntity(const Entity& entity, size_t& index) const
+        void _Clear()
         {
-            if (const auto it = m_entitiesAndComponentIndices.find(entity);
-                it != m_entitiesAndComponentIndices.end())
+            for (size_t index = 0; index < m_entities.size(); ++index)
             {
-                index = it->second;
-                return true;
+                for (const auto& column : m_columns)
+                {
+                    column.m_manager->Destroy(_GetComponentAddress(column, index));
+                }
             }
-            else
+            for (auto chunk : m_chunks)
             {
-                return false;
+                TemplateMemoryManager<ArcheTypeChunk>::Delete(chunk);
             }
+            m_chunks.clear();
+            m_entities.clear();
         }
 
     private:
         friend EntityChunkContext;
-        // Stores all entities indexed by the index of the component instance in m_components
+        // Stores all entities indexed by the index of their components in the chunks
         LongMarch_Vector<Entity> m_entities;
-        // Maps the entity to the index of the component instance in the m_components
-        LongMarch_UnorderedMap_node<Entity, size_t> m_entitiesAndComponentIndices;
-        // Contains all component managers which are indexed by component indices
-        LongMarch_UnorderedMap_node<ComponentTypeIndex_T, std::shared_ptr<BaseComponentManager>> m_componentManagers;
+        // Component columns sorted by component type index
+        LongMarch_Vector<ComponentColumn> m_columns;
+        // Maps component type index to the index of the column in m_columns, -1 if absent
+        LongMarch_Vector<int32_t> m_columnIndices;
+        // Chunks that store all component columns, all chunks are full except the last one
+        LongMarch_Vector<ArcheTypeChunk*> m_chunks;
+        // Max number of entities per chunk
+        size_t m_chunkCapacity{0};
+
+        //! Change version shared by all archetypes of all game worlds
+        inline static ChangeVersion_T s_changeVersion{1};
     };
 
     //! Pass this as argument to the lambda method for iteration
@@ -552,16 +707,40 @@ namespace longmarch
             m_manager(archetype_manger),
             m_chunkIndex(chunk_index)
         {
-            const auto& arbitraryComponentManager = archetype_manger->m_componentManagers.begin()->second;
-            m_iterEndIndex = arbitraryComponentManager->GetNumOfComponentsAtChunk(chunk_index) - 1;
+            m_iterEndIndex = archetype_manger->GetNumOfEntitiesAtChunk(chunk_index) - 1;
         }
 
+        //! Mutable access, marks the component of this chunk as changed
         template <typename ComponentType>
         ComponentType* GetComponentPtr() const
         {
-            auto componentManager = m_manager->GetComponentManger<ComponentType>();
-            ASSERT(componentManager);
-            return componentManager->GetComponentChunkPtr(m_chunkIndex);
+            return m_manager->GetComponentChunkPtr<ComponentType>(m_chunkIndex);
+        }
+
+        //! Read only access, does not mark the component of this chunk as changed
+        template <typename ComponentType>
+        const ComponentType* GetConstComponentPtr() const
+        {
+            return m_manager->GetConstComponentChunkPtr<ComponentType>(m_chunkIndex);
+        }
+
+        //! Last version at which the component of this chunk is written
+        template <typename ComponentType>
+        uint32_t GetChangeVersion() const
+        {
+            return m_manager->GetChunkChangeVersion(m_chunkIndex, GetComponentTypeIndex<ComponentType>());
+        }
+
+        //! Return true if the component of this chunk is written after the given version
+        template <typename ComponentType>
+        bool HasChangedSince(uint32_t version) const
+        {
+            return ArcheTypeManager::IsNewerVersion(GetChangeVersion<ComponentType>(), version);
+        }
+
+        const Entity* GetEntityPtr() const
+        {
+            return m_manager->GetEntityChunkPtr(m_chunkIndex);
         }
 
         size_t BeginIndex() const
@@ -579,11 +758,11 @@ namespace longmarch
         ArcheTypeManager* m_manager;
         size_t m_chunkIndex;
         size_t m_iterBeginIndex{0};
-        size_t m_iterEndIndex{NUM_COMPONENTS_PER_CHUNK - 1};
+        size_t m_iterEndIndex{0};
     };
 }
 
 #undef RESERVE_SIZE
-#undef NUM_COMPONENTS_PER_CHUNK 64
-#undef CHUNK_INDEX
-#undef COM_INDEX
+#undef ARCHETYPE_CHUNK_SIZE
+#undef ARCHETYPE_CHUNK_ALIGNMENT
+#undef ARCHETYPE_ALIGN
@@ -9,6 +9,11 @@ namespace longmarch
     typedef uint32_t EntityID;
     typedef int32_t EntityType;
 
+    //! Entity id packs the index of the entity in the lower bits and its version in the higher bits
+    constexpr inline uint32_t ENTITY_INDEX_BITS = {20u};
+    constexpr inline EntityID ENTITY_INDEX_MASK = {(1u << ENTITY_INDEX_BITS) - 1u};
+    constexpr inline EntityID ENTITY_VERSION_MASK = {~EntityID(0) >> ENTITY_INDEX_BITS};
+
     /**
      * @brief Default constructor creates: (EntityID:0, EntityType:0).
         In your entity enum class, you should create an item called
@@ -18,12 +23,15 @@ namespace longmarch
         id. Entities and their components are held together by component
         managers.For more information on component-managers, please check
         ComponentManager.h. To avoid false sharing, Entity class is 64 bytes aligned
+
+        The id is a generational handle : index of an entity is recycled once it is destroyed, but its
+        version is bumped, so a handle to a destroyed entity never matches a new entity at the same index.
      *
      * @author Dushyant Shukla (dushyant.shukla@digipen.edu | 60000519), Hang Yu (yohan680919@gmail.com)
      */
     struct MS_ALIGN8 Entity
     {
-        EntityID m_id{0}; // Entity id, >0 is valid
+        EntityID m_id{0}; // Entity id (index + version), index > 0 is valid
         EntityType m_type{0};
 
         /*
@@ -72,7 +80,24 @@ namespace longmarch
 
         bool Valid() const
         {
-            return this->m_id > 0;
+            return Index() > 0;
+        }
+
+        //! Index of the entity, unique among all living entities
+        uint32_t Index() const
+        {
+            return m_id & ENTITY_INDEX_MASK;
+        }
+
+        //! Version of the entity, bumped each time its index is recycled
+        uint32_t Version() const
+        {
+            return m_id >> ENTITY_INDEX_BITS;
+        }
+
+        static constexpr EntityID MakeID(uint32_t index, uint32_t version)
+        {
+            return ((version & ENTITY_VERSION_MASK) << ENTITY_INDEX_BITS) | (index & ENTITY_INDEX_MASK);
         }
 
         friend inline bool operator==(const Entity& lhs, const Entity& rhs)
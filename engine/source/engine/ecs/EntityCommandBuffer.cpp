@@ -0,0 +1,85 @@
+#include "engine-precompiled-header.h"
+#include "EntityCommandBuffer.h"
+#include "GameWorld.h"
+
+longmarch::EntityCommandBuffer::EntityCommandBuffer(GameWorld* world)
+    :
+    m_world(world)
+{
+}
+
+Entity longmarch::EntityCommandBuffer::CreateEntity(EntityType type, bool active, bool add_to_root,
+                                                    OnCreated_T&& onCreated)
+{
+    const auto entity = m_world->m_entityManager->Reserve(type);
+    m_commands.emplace_back([entity, active, add_to_root, onCreated = std::move(onCreated)](GameWorld* world)
+    {
+        auto e = world->_GenerateEntity(entity, active, add_to_root);
+        if (onCreated)
+        {
+            onCreated(e);
+        }
+    });
+    return entity;
+}
+
+Entity longmarch::EntityCommandBuffer::CreateEntity3D(EntityType type, bool active, bool add_to_root,
+                                                      OnCreated_T&& onCreated)
+{
+    const auto entity = m_world->m_entityManager->Reserve(type);
+    m_commands.emplace_back([entity, active, add_to_root, onCreated = std::move(onCreated)](GameWorld* world)
+    {
+        auto e = world->_GenerateEntity3D(entity, active, add_to_root, true);
+        if (onCreated)
+        {
+            onCreated(e);
+        }
+    });
+    return entity;
+}
+
+Entity longmarch::EntityCommandBuffer::CreateEntity3DNoCollision(EntityType type, bool active, bool add_to_root,
+                                                                 OnCreated_T&& onCreated)
+{
+    const auto entity = m_world->m_entityManager->Reserve(type);
+    m_commands.emplace_back([entity, active, add_to_root, onCreated = std::move(onCreated)](GameWorld* world)
+    {
+        auto e = world->_GenerateEntity3D(entity, active, add_to_root, false);
+        if (onCreated)
+        {
+            onCreated(e);
+        }
+    });
+    return entity;
+}
+
+void longmarch::EntityCommandBuffer::DestroyEntity(const Entity& entity)
+{
+    m_commands.emplace_back([entity](GameWorld* world)
+    {
+        if (world->HasEntity(entity))
+        {
+            world->RemoveFromParent_Helper(entity);
+            world->RemoveEntity(entity);
+        }
+    });
+}
+
+void longmarch::EntityCommandBuffer::Record(Command_T&& command)
+{
+    m_commands.emplace_back(std::move(command));
+}
+
+void longmarch::EntityCommandBuffer::Playback()
+{
+    // Commands could record new commands into this buffer (e.g. onCreated callbacks), so swap before executing
+    while (!m_commands.empty())
+    {
+        LongMarch_Vector<Command_T> commands;
+        commands.swap(m_commands);
+        for (auto& command : commands)
+        {
+            ENGINE_TRY_CATCH(command(m_world););
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "Entity.h"
+#include "EntityType.h"
+#include "engine/core/exception/EngineException.h"
+#include "engine/core/utility/TypeHelper.h"
+
+#include <functional>
+
+namespace longmarch
+{
+    class GameWorld;
+    struct EntityDecorator;
+
+    /**
+     * @brief Records structural changes (create/destroy entity, add/remove component) and plays them back in a batch
+     *
+     * @detail Each worker thread owns its own command buffer (see GameWorld::GetCommandBuffer()), so recording
+     * does not acquire the game world rival lock and can be done freely inside ParEach/ParEachChunk jobs.
+     * Recorded commands are played back by the game world at its sync points (after Update, after LateUpdate
+     * and after PreRenderUpdate). Entities created by a command buffer get their id immediately, so later
+     * commands in the same buffer could refer to them, but they only become visible after playback.
+     *
+     * @author Hang Yu (yohan680919@gmail.com)
+     */
+    class EntityCommandBuffer
+    {
+    public:
+        using Command_T = std::function<void(GameWorld* world)>;
+        using OnCreated_T = std::function<void(const EntityDecorator& e)>;
+
+        NONCOPYABLE(EntityCommandBuffer);
+        EntityCommandBuffer() = delete;
+        explicit EntityCommandBuffer(GameWorld* world);
+
+        //! Record an entity with basic components, see GameWorld::GenerateEntity()
+        Entity CreateEntity(EntityType type, bool active, bool add_to_root, OnCreated_T&& onCreated = nullptr);
+
+        //! Record an entity with basic and 3D components, see GameWorld::GenerateEntity3D()
+        Entity CreateEntity3D(EntityType type, bool active, bool add_to_root, OnCreated_T&& onCreated = nullptr);
+
+        //! Record an entity with basic and 3D components but no Body3DCom, see GameWorld::GenerateEntity3DNoCollision()
+        Entity CreateEntity3DNoCollision(EntityType type, bool active, bool add_to_root, OnCreated_T&& onCreated = nullptr);
+
+        //! Record removing an entity and all its components, removing an entity that does not exist at playback is a no-op
+        void DestroyEntity(const Entity& entity);
+
+        //! Record adding a component, adding to an entity that does not exist at playback is a no-op
+        template <typename ComponentType>
+        void AddComponent(const Entity& entity, ComponentType&& component);
+
+        //! Record removing a component, removing a component that does not exist at playback is a no-op
+        template <typename ComponentType>
+        void RemoveComponent(const Entity& entity);
+
+        //! Record an arbitrary command that should run at the next sync point
+        void Record(Command_T&& command);
+
+        //! Execute all recorded commands in order of recording and clear the buffer, must be called from a sync point
+        void Playback();
+
+        inline bool Empty() const
+        {
+            return m_commands.empty();
+        }
+
+        inline size_t Size() const
+        {
+            return m_commands.size();
+        }
+
+    private:
+        LongMarch_Vector<Command_T> m_commands;
+        GameWorld* m_world{nullptr};
+    };
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "EntityCommandBuffer.h"
+
+namespace longmarch
+{
+    template <typename ComponentType>
+    void EntityCommandBuffer::AddComponent(const Entity& entity, ComponentType&& component)
+    {
+        using Com_T = std::remove_cvref_t<ComponentType>;
+        m_commands.emplace_back([entity, component = Com_T(std::forward<ComponentType>(component))](GameWorld* world)
+        {
+            if (world->HasEntity(entity))
+            {
+                world->AddComponent<Com_T>(entity, component);
+            }
+        });
+    }
+
+    template <typename ComponentType>
+    void EntityCommandBuffer::RemoveComponent(const Entity& entity)
+    {
+        m_commands.emplace_back([entity](GameWorld* world)
+        {
+            if (world->HasEntity(entity) && world->HasComponent<ComponentType>(entity))
+            {
+                world->RemoveComponent<ComponentType>(entity);
+            }
+        });
+    }
+}
@@ -49,6 +49,10 @@ namespace longmarch
         template <typename ComponentType>
         [[nodiscard]] ComponentDecorator<ComponentType> GetComponent() const;
 
+        //! Read only access, does not mark the component as changed
+        template <typename ComponentType>
+        [[nodiscard]] const ComponentType* GetConstComponent() const;
+
         template <typename ComponentType>
         [[nodiscard]] bool HasComponent() const;
 
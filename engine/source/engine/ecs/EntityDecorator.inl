@@ -21,6 +21,12 @@ namespace longmarch
         return GetWorld()->GetComponent<ComponentType>(m_entity);
     }
 
+    template <typename ComponentType>
+    const ComponentType* EntityDecorator::GetConstComponent() const
+    {
+        return GetWorld()->GetConstComponent<ComponentType>(m_entity);
+    }
+
     template <typename ComponentType>
     bool EntityDecorator::HasComponent() const
     {
@@ -2,13 +2,18 @@
 #include "engine/EngineEssential.h"
 #include "Entity.h"
 
+#include <span>
+
 namespace longmarch
 {
     /**
      * @brief Entity managers takes care of assigning entity-ids to entities during their creations.
      *
      *  It makes sure that no two entities within
-     *	the system share the same entity-id.
+     *	the system share the same entity-id. Indices of destroyed entities are recycled with a bumped version.
+     *
+     *  Registered entities are indexed by their entity index, so that looking up an entity from its id and
+     *  destroying an entity (swap and pop from its type bucket) are both O(1).
      *
      * @author Dushyant Shukla (dushyant.shukla@digipen.edu | 60000519), Hang Yu (yohan680919@gmail.com)
      */
@@ -20,24 +25,77 @@ namespace longmarch
 
         inline const Entity Create(EntityType type)
         {
-            auto ret = Entity{++m_entityID, type};
-            m_typeToEntity[type].push_back(ret);
+            auto ret = Reserve(type);
+            Register(ret);
             return ret;
         }
 
-        // Should use the same poping strategy as component manager to counter memory diffusion
+        //! Thread safe, hand out a unique entity id w/o registering the entity (used by deferred entity creation)
+        inline const Entity Reserve(EntityType type)
+        {
+            atomic_flag_guard _lock(m_freeIDFlag);
+            if (!m_freeIDs.empty())
+            {
+                const auto id = m_freeIDs.back();
+                m_freeIDs.pop_back();
+                return Entity{id, type};
+            }
+            // Index 0 is reserved for the empty entity
+            const auto index = ++m_numIndices;
+            ENGINE_EXCEPT_IF(index > ENTITY_INDEX_MASK, L"Run out of entity indices!");
+            return Entity{Entity::MakeID(index, 0), type};
+        }
+
+        //! Register an entity that has been reserved before
+        inline void Register(const Entity& entity)
+        {
+            const auto index = entity.Index();
+            if (index >= m_slots.size())
+            {
+                m_slots.resize(index + 1);
+            }
+            auto& slot = m_slots[index];
+            ASSERT(!slot.m_entity.Valid(), "Entity index is already registered!");
+            auto& entities = m_typeToEntity[entity.m_type];
+            slot.m_entity = entity;
+            slot.m_indexInType = static_cast<uint32_t>(entities.size());
+            entities.push_back(entity);
+        }
+
+        // Use the same swap and pop strategy as component manager to counter memory diffusion
         inline void Destroy(const Entity& entity)
         {
-            LongMarch_EraseFirst(m_typeToEntity[entity.m_type], entity);
+            const auto index = entity.Index();
+            if (index >= m_slots.size() || m_slots[index].m_entity != entity)
+            {
+                ENGINE_EXCEPT(wStr(L"Destroying an unregistered entity %s", wStr(entity).c_str()));
+                return;
+            }
+            auto& slot = m_slots[index];
+            auto& entities = m_typeToEntity[entity.m_type];
+            if (const auto last = entities.back(); last != entity)
+            {
+                entities[slot.m_indexInType] = last;
+                m_slots[last.Index()].m_indexInType = slot.m_indexInType;
+            }
+            entities.pop_back();
+            slot = Slot_T();
+            // Recycle the index with the next version
+            atomic_flag_guard _lock(m_freeIDFlag);
+            m_freeIDs.push_back(Entity::MakeID(index, entity.Version() + 1));
         }
 
         inline void RemoveAll()
         {
             m_typeToEntity.clear();
-            m_entityID = 0;
+            m_slots.clear();
+            atomic_flag_guard _lock(m_freeIDFlag);
+            m_freeIDs.clear();
+            m_numIndices = 0;
         }
 
-        inline const LongMarch_Vector<Entity> GetAllEntitiesWithType(EntityType type) const
+        //! The span is invalidated by creating or destroying entities of the same type, copy it if you need to do so while iterating
+        inline std::span<const Entity> GetAllEntitiesWithType(EntityType type) const
         {
             if (auto it = m_typeToEntity.find(type); it != m_typeToEntity.end())
             {
@@ -45,21 +103,17 @@ namespace longmarch
             }
             else
             {
-                return LongMarch_Vector<Entity>();
+                return {};
             }
         }
 
+        //! Return an empty entity if no registered entity has the id (e.g. the entity has been destroyed)
         inline Entity GetEntityFromID(EntityID ID) const
         {
-            for (const auto& [type, entities] : m_typeToEntity)
+            const auto index = ID & ENTITY_INDEX_MASK;
+            if (index < m_slots.size() && m_slots[index].m_entity.m_id == ID)
             {
-                for (const auto& e : entities)
-                {
-                    if (ID == e.m_id)
-                    {
-                        return e;
-                    }
-                }
+                return m_slots[index].m_entity;
             }
             return Entity();
         }
@@ -68,12 +122,29 @@ namespace longmarch
         {
             auto ret = MemoryManager::Make_shared<EntityManager>();
             ret->m_typeToEntity = m_typeToEntity;
-            ret->m_entityID = m_entityID;
+            ret->m_slots = m_slots;
+            atomic_flag_guard _lock(m_freeIDFlag);
+            ret->m_freeIDs = m_freeIDs;
+            ret->m_numIndices = m_numIndices;
             return ret;
         }
 
     private:
+        struct Slot_T
+        {
+            //! Registered entity at this index, empty if none
+            Entity m_entity;
+            //! Position of the entity in its type bucket
+            uint32_t m_indexInType{0};
+        };
+
         LongMarch_UnorderedMap_Par_node<EntityType, LongMarch_Vector<Entity>> m_typeToEntity;
-        EntityID m_entityID{0};
+        //! Registered entities indexed by entity index
+        LongMarch_Vector<Slot_T> m_slots;
+        //! Ids of destroyed entities with their versions bumped, ready to be handed out again
+        LongMarch_Vector<EntityID> m_freeIDs;
+        //! Number of entity indices ever handed out
+        uint32_t m_numIndices{0};
+        mutable std::atomic_flag m_freeIDFlag;
     };
 }
@@ -0,0 +1,126 @@
+#pragma once
+#include "BitMaskSignature.h"
+#include "ComponentManager.h"
+
+namespace longmarch
+{
+    class GameWorld;
+
+    /**
+     * @brief Persistent query of all archetypes that match a component signature
+     *
+     * @detail Queries are owned by the game world (see GameWorld::GetQuery()). When a new archetype is created, the game world
+        pushes it to every matching query, so a query never rescans archetypes. Entity and chunk counts are read from the
+        cached archetypes on the fly, so iterating a query walks entities and chunks w/o allocation and is always up to date.
+        As for any other view, iterate a query while holding the game world read lock and do not add/remove
+        components or entities while iterating, use the command buffer instead.
+     *
+     * @author Hang Yu (yohan680919@gmail.com)
+     */
+    class EntityQuery
+    {
+    public:
+        NONCOPYABLE(EntityQuery);
+        EntityQuery() = delete;
+
+        explicit EntityQuery(const BitMaskSignature& mask)
+            :
+            m_mask(mask)
+        {
+        }
+
+        const BitMaskSignature& GetSignature() const
+        {
+            return m_mask;
+        }
+
+        //! Matching archetypes in order of their creation
+        const LongMarch_Vector<ArcheTypeManager*>& GetArcheTypes() const
+        {
+            return m_archetypes;
+        }
+
+        size_t NumOfEntities() const
+        {
+            size_t ret = 0;
+            for (const auto archetype : m_archetypes)
+            {
+                ret += archetype->Size();
+            }
+            return ret;
+        }
+
+        size_t NumOfChunks() const
+        {
+            size_t ret = 0;
+            for (const auto archetype : m_archetypes)
+            {
+                ret += archetype->NumOfChunks();
+            }
+            return ret;
+        }
+
+        //! func(const Entity& e)
+        template <typename Func>
+        void ForEachEntity(Func&& func) const
+        {
+            for (const auto archetype : m_archetypes)
+            {
+                for (const auto& e : archetype->GetEntityView())
+                {
+                    func(e);
+                }
+            }
+        }
+
+        //! func(const EntityChunkContext& e)
+        template <typename Func>
+        void ForEachChunk(Func&& func) const
+        {
+            for (const auto archetype : m_archetypes)
+            {
+                for (size_t i = 0; i < archetype->NumOfChunks(); ++i)
+                {
+                    func(EntityChunkContext(archetype, i));
+                }
+            }
+        }
+
+        /**
+         * @brief Iterate chunks whose component ComponentType is written after sinceVersion, func(const EntityChunkContext& e)
+         *
+         * @detail Chunks are stamped per component type on mutable access (see ArcheTypeManager), so unchanged chunks are skipped w/o touching their components.
+         */
+        template <typename ComponentType, typename Func>
+        void ForEachChunkChanged(uint32_t sinceVersion, Func&& func) const
+        {
+            ASSERT(m_mask.IsAMatch(BitMaskSignature::Create<ComponentType>()), "Query does not contain the component type!");
+            const auto comTypeIndex = GetComponentTypeIndex<ComponentType>();
+            for (const auto archetype : m_archetypes)
+            {
+                for (size_t i = 0; i < archetype->NumOfChunks(); ++i)
+                {
+                    if (ArcheTypeManager::IsNewerVersion(archetype->GetChunkChangeVersion(i, comTypeIndex), sinceVersion))
+                    {
+                        func(EntityChunkContext(archetype, i));
+                    }
+                }
+            }
+        }
+
+    private:
+        friend GameWorld;
+
+        void _TryAdd(const BitMaskSignature& mask, ArcheTypeManager* archetype)
+        {
+            if (archetype && mask.IsAMatch(m_mask))
+            {
+                m_archetypes.push_back(archetype);
+            }
+        }
+
+    private:
+        BitMaskSignature m_mask;
+        LongMarch_Vector<ArcheTypeManager*> m_archetypes;
+    };
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include "Entity.h"
+#include "engine/EngineEssential.h"
+
+namespace longmarch
+{
+    /**
+     * @brief Map from generational entity handles to values, without hashing
+     *
+     * @detail The sparse array is indexed by the index of the entity and stores the position of the entity in the dense arrays.
+        Dense arrays store entities and values contiguously, so lookup is two array reads and a handle compare,
+        and a handle to a destroyed entity (stale version) is simply not found. Removal swaps the last element into the vacancy.
+        Pointers and references to values are invalidated by insertion and removal.
+     *
+     * @author Hang Yu (yohan680919@gmail.com)
+     */
+    template <typename Value_T>
+    class EntitySparseSet
+    {
+    private:
+        constexpr inline static uint32_t INVALID_INDEX = {~0u};
+
+    public:
+        bool Contains(const Entity& entity) const
+        {
+            return _DenseIndex(entity) != INVALID_INDEX;
+        }
+
+        //! Return nullptr if the entity does not exist
+        Value_T* Find(const Entity& entity)
+        {
+            const auto i = _DenseIndex(entity);
+            return (i != INVALID_INDEX) ? &m_values[i] : nullptr;
+        }
+
+        //! Return nullptr if the entity does not exist
+        const Value_T* Find(const Entity& entity) const
+        {
+            const auto i = _DenseIndex(entity);
+            return (i != INVALID_INDEX) ? &m_values[i] : nullptr;
+        }
+
+        //! Return the value of the entity, insert a default value if the entity does not exist
+        Value_T& operator[](const Entity& entity)
+        {
+            if (const auto i = _DenseIndex(entity); i != INVALID_INDEX)
+            {
+                return m_values[i];
+            }
+            const auto index = entity.Index();
+            if (index >= m_sparse.size())
+            {
+                m_sparse.resize(index + 1, INVALID_INDEX);
+            }
+            // A stale entity at the same index must have been erased before its index got recycled
+            ASSERT(m_sparse[index] == INVALID_INDEX, "Entity index is still in use by another version!");
+            m_sparse[index] = static_cast<uint32_t>(m_dense.size());
+            m_dense.emplace_back(entity);
+            return m_values.emplace_back();
+        }
+
+        //! Return true if the entity is erased
+        bool Erase(const Entity& entity)
+        {
+            const auto i = _DenseIndex(entity);
+            if (i == INVALID_INDEX)
+            {
+                return false;
+            }
+            if (const auto last = m_dense.size() - 1; i != last)
+            {
+                m_dense[i] = m_dense[last];
+                m_values[i] = std::move(m_values[last]);
+                m_sparse[m_dense[i].Index()] = i;
+            }
+            m_sparse[entity.Index()] = INVALID_INDEX;
+            m_dense.pop_back();
+            m_values.pop_back();
+            return true;
+        }
+
+        void Reserve(size_t num)
+        {
+            m_dense.reserve(num);
+            m_values.reserve(num);
+        }
+
+        void Clear()
+        {
+            m_sparse.clear();
+            m_dense.clear();
+            m_values.clear();
+        }
+
+        size_t Size() const
+        {
+            return m_dense.size();
+        }
+
+        //! All entities in the set, in dense order
+        const LongMarch_Vector<Entity>& GetEntities() const
+        {
+            return m_dense;
+        }
+
+        //! All values in the set, in the same order as GetEntities()
+        LongMarch_Vector<Value_T>& GetValues()
+        {
+            return m_values;
+        }
+
+    private:
+        uint32_t _DenseIndex(const Entity& entity) const
+        {
+            const auto index = entity.Index();
+            if (index < m_sparse.size())
+            {
+                // Compare the whole handle, so that stale versions are rejected
+                if (const auto i = m_sparse[index]; i != INVALID_INDEX && m_dense[i] == entity)
+                {
+                    return i;
+                }
+            }
+            return INVALID_INDEX;
+        }
+
+    private:
+        //! Entity index to dense index
+        LongMarch_Vector<uint32_t> m_sparse;
+        LongMarch_Vector<Entity> m_dense;
+        LongMarch_Vector<Value_T> m_values;
+    };
+}
@@ -160,7 +160,7 @@ GameWorld* longmarch::GameWorld::Clone(const std::string& newName, const GameWor
         {
             // (E) Copy entities
             newWorld->m_entityManager = from->m_entityManager->Copy();
-            newWorld->m_entityMaskMap = from->m_entityMaskMap;
+            newWorld->m_entityRecords = from->m_entityRecords;
 
             // (C) Copy components
             newWorld->m_maskArcheTypeMap.clear();
@@ -175,6 +175,15 @@ GameWorld* longmarch::GameWorld::Clone(const std::string& newName, const GameWor
                     newWorld->m_maskArcheTypeMap[mask] = std::move(copy);
                 }
             }
+            // Copied archetypes keep the order of entities, only archetype pointers need to be redirected
+            for (auto& record : newWorld->m_entityRecords.GetValues())
+            {
+                if (record.m_archetype)
+                {
+                    record.m_archetype = newWorld->m_maskArcheTypeMap[record.m_mask].get();
+                }
+            }
+            newWorld->_RebuildQueries();
 
             // (S) Copy systems
             newWorld->m_systemsName = from->m_systemsName;
@@ -234,19 +243,158 @@ void longmarch::GameWorld::InitECS()
         system->SetWorld(this);
         system->Init();
     }
+    m_systemGraphDirty = true;
 }
 
 void longmarch::GameWorld::Update(double frameTime)
 {
     if (m_paused) frameTime = 0.0;
+#if PARALLEL_SYSTEM_UPDATE
+    _RunSystemGraph([frameTime](BaseComponentSystem* system)
+    {
+        ArcheTypeManager::AdvanceChangeVersion();
+        system->Update(frameTime);
+    });
+    PlaybackCommandBuffers();
+    _RunSystemGraph([frameTime](BaseComponentSystem* system)
+    {
+        ArcheTypeManager::AdvanceChangeVersion();
+        system->LateUpdate(frameTime);
+    });
+    PlaybackCommandBuffers();
+#else
     for (auto& system : m_systems)
     {
+        ArcheTypeManager::AdvanceChangeVersion();
         system->Update(frameTime);
     }
+    PlaybackCommandBuffers();
     for (auto& system : m_systems)
     {
+        ArcheTypeManager::AdvanceChangeVersion();
         system->LateUpdate(frameTime);
     }
+    PlaybackCommandBuffers();
+#endif
+}
+
+void longmarch::GameWorld::_BuildSystemGraph()
+{
+    const auto num = static_cast<uint32_t>(m_systems.size());
+    LongMarch_Vector<BitMaskSignature> reads(num);
+    LongMarch_Vector<BitMaskSignature> writes(num);
+    LongMarch_Vector<bool> exclusives(num);
+    for (uint32_t i = 0; i < num; ++i)
+    {
+        reads[i] = m_systems[i]->GetReadSignature();
+        writes[i] = m_systems[i]->GetWriteSignature();
+        exclusives[i] = m_systems[i]->IsExclusive();
+    }
+
+    m_systemGraph.m_nodes.clear();
+    m_systemGraph.m_nodes.resize(num);
+    m_systemGraph.m_roots.clear();
+    size_t numEdges = 0;
+    // Conflicting systems keep their order of registration
+    for (uint32_t j = 0; j < num; ++j)
+    {
+        for (uint32_t i = 0; i < j; ++i)
+        {
+            if (exclusives[i] || exclusives[j] ||
+                writes[i].Intersects(reads[j]) || writes[i].Intersects(writes[j]) || reads[i].Intersects(writes[j]))
+            {
+                m_systemGraph.m_nodes[i].m_dependents.emplace_back(j);
+                ++m_systemGraph.m_nodes[j].m_numDependencies;
+                ++numEdges;
+            }
+        }
+        m_systemGraph.m_nodes[j].m_exclusive = exclusives[j];
+        if (m_systemGraph.m_nodes[j].m_numDependencies == 0)
+        {
+            m_systemGraph.m_roots.emplace_back(j);
+        }
+    }
+    // Every pair of systems conflicts
+    m_systemGraph.m_sequential = (numEdges == size_t(num) * (num > 0 ? num - 1 : 0) / 2);
+    m_systemGraphDirty = false;
+}
+
+void longmarch::GameWorld::_RunSystemGraph(const std::function<void(BaseComponentSystem*)>& invoke)
+{
+    if (m_systemGraphDirty)
+    {
+        _BuildSystemGraph();
+    }
+    const auto& nodes = m_systemGraph.m_nodes;
+    // Nothing to run concurrently
+    if (m_systemGraph.m_sequential)
+    {
+        for (auto& system : m_systems)
+        {
+            invoke(system.get());
+        }
+        return;
+    }
+
+    auto run = std::make_shared<SystemGraphRun_T>();
+    run->m_pending = std::make_unique<std::atomic_uint32_t[]>(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        run->m_pending[i].store(nodes[i].m_numDependencies, std::memory_order_relaxed);
+    }
+    run->m_remaining.store(nodes.size(), std::memory_order_relaxed);
+    for (const auto root : m_systemGraph.m_roots)
+    {
+        _ScheduleSystemNode(run, root, invoke);
+    }
+    // Run exclusive systems in place and help running the other systems and their jobs until all systems are done
+    auto& pool = JobSystem::GetPool();
+    while (run->m_remaining.load(std::memory_order_acquire) != 0)
+    {
+        if (const auto exclusive = run->m_readyExclusive.exchange(SystemGraphRun_T::kNoSystem, std::memory_order_acq_rel);
+            exclusive != SystemGraphRun_T::kNoSystem)
+        {
+            _RunSystemNode(run, exclusive, invoke);
+        }
+        else if (!pool.try_run_one())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void longmarch::GameWorld::_ScheduleSystemNode(const std::shared_ptr<SystemGraphRun_T>& run, uint32_t index,
+                                               const std::function<void(BaseComponentSystem*)>& invoke)
+{
+    if (m_systemGraph.m_nodes[index].m_exclusive)
+    {
+        run->m_readyExclusive.store(index, std::memory_order_release);
+    }
+    else
+    {
+        JobSystem::GetPool().enqueue_work([this, run, index, &invoke]()
+        {
+            _RunSystemNode(run, index, invoke);
+        });
+    }
+}
+
+void longmarch::GameWorld::_RunSystemNode(const std::shared_ptr<SystemGraphRun_T>& run, uint32_t index,
+                                          const std::function<void(BaseComponentSystem*)>& invoke)
+{
+    ENGINE_TRY_CATCH(
+        {
+            invoke(m_systems[index].get());
+        }
+    );
+    for (const auto dependent : m_systemGraph.m_nodes[index].m_dependents)
+    {
+        if (run->m_pending[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            _ScheduleSystemNode(run, dependent, invoke);
+        }
+    }
+    run->m_remaining.fetch_sub(1, std::memory_order_acq_rel);
 }
 
 #if MULTITHREAD_UPDATE
@@ -274,14 +422,17 @@ void longmarch::GameWorld::PreRenderUpdate(double frameTime)
     if (m_paused) frameTime = 0.0;
     for (auto& system : m_systems)
     {
+        ArcheTypeManager::AdvanceChangeVersion();
         system->PreRenderUpdate(frameTime);
     }
+    PlaybackCommandBuffers();
 }
 
 void longmarch::GameWorld::PreRenderPass(double frameTime)
 {
     for (auto& system : m_systems)
     {
+        ArcheTypeManager::AdvanceChangeVersion();
         system->PreRenderPass();
     }
 }
@@ -290,6 +441,7 @@ void longmarch::GameWorld::PostRenderPass(double frameTime)
 {
     for (auto& system : m_systems)
     {
+        ArcheTypeManager::AdvanceChangeVersion();
         system->PostRenderPass();
     }
 }
@@ -299,6 +451,7 @@ void longmarch::GameWorld::PostRenderUpdate(double frameTime)
     if (m_paused) frameTime = 0.0;
     for (auto& system : m_systems)
     {
+        ArcheTypeManager::AdvanceChangeVersion();
         system->PostRenderUpdate(frameTime);
     }
 }
@@ -307,6 +460,7 @@ void longmarch::GameWorld::RenderUI()
 {
     for (auto& system : m_systems)
     {
+        ArcheTypeManager::AdvanceChangeVersion();
         system->RenderUI();
     }
 }
@@ -335,16 +489,29 @@ void longmarch::GameWorld::RemoveFromParent_Helper(Entity e)
 }
 
 EntityDecorator longmarch::GameWorld::GenerateEntity(EntityType type, bool active, bool add_to_root)
+{
+    return _GenerateEntity(m_entityManager->Reserve(type), active, add_to_root);
+}
+
+EntityDecorator longmarch::GameWorld::GenerateEntity3D(EntityType type, bool active, bool add_to_root)
+{
+    return _GenerateEntity3D(m_entityManager->Reserve(type), active, add_to_root, true);
+}
+
+EntityDecorator longmarch::GameWorld::GenerateEntity3DNoCollision(EntityType type, bool active, bool add_to_root)
+{
+    return _GenerateEntity3D(m_entityManager->Reserve(type), active, add_to_root, false);
+}
+
+EntityDecorator longmarch::GameWorld::_GenerateEntity(const Entity& reserved, bool active, bool add_to_root)
 {
     EntityDecorator entity;
     {
         TRY_LOCK_WRITE();
-        entity = EntityDecorator{m_entityManager->Create(type), this};
+        m_entityManager->Register(reserved);
+        entity = EntityDecorator{reserved, this};
     }
-    entity.Volatile().AddComponent(ActiveCom(active));
-    entity.Volatile().AddComponent(IDNameCom(entity));
-    entity.Volatile().AddComponent(ParentCom(entity));
-    entity.Volatile().AddComponent(ChildrenCom(entity));
+    AddComponents(entity, ActiveCom(active), IDNameCom(entity), ParentCom(entity), ChildrenCom(entity));
     if (add_to_root)
     {
         auto root = GetTheOnlyEntityWithType((EntityType)(EngineEntityType::SCENE_ROOT));
@@ -353,27 +520,136 @@ EntityDecorator longmarch::GameWorld::GenerateEntity(EntityType type, bool activ
     return entity;
 }
 
-EntityDecorator longmarch::GameWorld::GenerateEntity3D(EntityType type, bool active, bool add_to_root)
+EntityDecorator longmarch::GameWorld::_GenerateEntity3D(const Entity& reserved, bool active, bool add_to_root, bool collision)
 {
-    auto entity = GenerateEntity(type, active, add_to_root);
-    entity.Volatile().AddComponent(Transform3DCom(entity));
-    entity.Volatile().AddComponent(Scene3DCom(entity));
-    entity.Volatile().AddComponent(Body3DCom(entity));
+    EntityDecorator entity;
+    {
+        TRY_LOCK_WRITE();
+        m_entityManager->Register(reserved);
+        entity = EntityDecorator{reserved, this};
+    }
+    // Add all components at once so that the entity is placed into its final archetype directly
+    if (collision)
+    {
+        AddComponents(entity, ActiveCom(active), IDNameCom(entity), ParentCom(entity), ChildrenCom(entity),
+                      Transform3DCom(entity), Scene3DCom(entity), Body3DCom(entity));
+    }
+    else
+    {
+        AddComponents(entity, ActiveCom(active), IDNameCom(entity), ParentCom(entity), ChildrenCom(entity),
+                      Transform3DCom(entity), Scene3DCom(entity));
+    }
+    if (add_to_root)
+    {
+        auto root = GetTheOnlyEntityWithType((EntityType)(EngineEntityType::SCENE_ROOT));
+        AddChild_Helper(root, entity);
+    }
     return entity;
 }
 
-EntityDecorator longmarch::GameWorld::GenerateEntity3DNoCollision(EntityType type, bool active, bool add_to_root)
+EntityCommandBuffer& longmarch::GameWorld::GetCommandBuffer() const
 {
-    auto entity = GenerateEntity(type, active, add_to_root);
-    entity.Volatile().AddComponent(Transform3DCom(entity));
-    entity.Volatile().AddComponent(Scene3DCom(entity));
-    return entity;
+    struct CommandBufferCache_T
+    {
+        uint64_t m_worldUID{0};
+        EntityCommandBuffer* m_buffer{nullptr};
+    };
+    // Most of the time a thread records to the same world, so cache the last buffer to avoid locking
+    thread_local CommandBufferCache_T t_cache;
+    if (t_cache.m_worldUID == m_uid) [[likely]]
+    {
+        return *t_cache.m_buffer;
+    }
+    atomic_flag_guard _lock(m_commandBufferFlag);
+    auto& buffer = m_commandBufferMap[std::this_thread::get_id()];
+    if (!buffer)
+    {
+        buffer = m_commandBuffers.emplace_back(std::make_unique<EntityCommandBuffer>(const_cast<GameWorld*>(this))).get();
+    }
+    t_cache = CommandBufferCache_T{m_uid, buffer};
+    return *buffer;
+}
+
+void longmarch::GameWorld::PlaybackCommandBuffers()
+{
+    // Playing back a command could record new commands into any buffer (e.g. onCreated callbacks), so repeat until all buffers are drained
+    LongMarch_Vector<EntityCommandBuffer*> buffers;
+    do
+    {
+        buffers.clear();
+        {
+            atomic_flag_guard _lock(m_commandBufferFlag);
+            for (const auto& buffer : m_commandBuffers)
+            {
+                if (!buffer->Empty())
+                {
+                    buffers.emplace_back(buffer.get());
+                }
+            }
+        }
+        for (auto buffer : buffers)
+        {
+            buffer->Playback();
+        }
+    }
+    while (!buffers.empty());
+}
+
+void longmarch::GameWorld::_UpdateEntityIndex(const Entity& swapped, size_t index)
+{
+    if (swapped.Valid())
+    {
+        if (auto record = m_entityRecords.Find(swapped))
+        {
+            record->m_index = index;
+        }
+    }
+}
+
+void longmarch::GameWorld::_OnArcheTypeCreated(const BitMaskSignature& mask, ArcheTypeManager* archetype)
+{
+    atomic_flag_guard _lock(m_queryFlag);
+    for (auto& [_, query] : m_queries)
+    {
+        query->_TryAdd(mask, archetype);
+    }
+}
+
+void longmarch::GameWorld::_RebuildQueries()
+{
+    atomic_flag_guard _lock(m_queryFlag);
+    for (auto& [_, query] : m_queries)
+    {
+        query->m_archetypes.clear();
+        for (const auto& [mask, manager] : m_maskArcheTypeMap)
+        {
+            query->_TryAdd(mask, manager.get());
+        }
+    }
+}
+
+const EntityQuery& longmarch::GameWorld::GetQuery(const BitMaskSignature& bitMask) const
+{
+    TRY_LOCK_READ();
+    atomic_flag_guard _lock(m_queryFlag);
+    auto& query = m_queries[bitMask];
+    if (!query)
+    [[unlikely]]
+    {
+        // Only scan existing archetypes once, later archetypes are pushed by _OnArcheTypeCreated
+        query = std::make_unique<EntityQuery>(bitMask);
+        for (const auto& [mask, manager] : m_maskArcheTypeMap)
+        {
+            query->_TryAdd(mask, manager.get());
+        }
+    }
+    return *query;
 }
 
 bool longmarch::GameWorld::HasEntity(const Entity& entity) const
 {
     TRY_LOCK_READ();
-    return LongMarch_contains(m_entityMaskMap, entity);
+    return m_entityRecords.Contains(entity);
 }
 
 void longmarch::GameWorld::AddChild_Helper(Entity parent, Entity child)
@@ -391,6 +667,7 @@ void longmarch::GameWorld::RegisterSystem(const std::shared_ptr<BaseComponentSys
     m_systems.emplace_back(system);
     m_systemsName.emplace_back(name);
     m_systemsNameMap[name] = system;
+    m_systemGraphDirty = true;
 }
 
 BaseComponentSystem* longmarch::GameWorld::GetComponentSystem(const std::string& name)
@@ -436,16 +713,20 @@ void longmarch::GameWorld::RemoveEntity(const Entity& entity)
     {
         TRY_LOCK_WRITE();
         // Then remove the entity
-        m_entityManager->Destroy(entity);
-        const auto it = m_entityMaskMap.find(entity);
-        ASSERT(it != m_entityMaskMap.end());
-        m_entityMaskMap.erase(it);
+        const bool erased = m_entityRecords.Erase(entity);
+        ASSERT(erased);
+        if (erased)
+        {
+            // Only recycle the index of an entity once
+            m_entityManager->Destroy(entity);
+        }
     }
 }
 
 const Entity longmarch::GameWorld::GetTheOnlyEntityWithType(EntityType type) const
 {
-    auto es = GetAllEntityWithType(type);
+    TRY_LOCK_READ();
+    const auto es = m_entityManager->GetAllEntitiesWithType(type);
     if (es.size() == 1)
     {
         return es[0];
@@ -476,9 +757,8 @@ const LongMarch_Vector<Entity> longmarch::GameWorld::GetAllEntityWithType(
     LongMarch_Vector<Entity> result;
     for (auto& type : types)
     {
-        auto entities = m_entityManager->GetAllEntitiesWithType(type);
-        std::ranges::copy(entities.begin(), entities.end(),
-                          std::back_inserter(result));
+        const auto entities = m_entityManager->GetAllEntitiesWithType(type);
+        result.insert(result.end(), entities.begin(), entities.end());
     }
     return result;
 }
@@ -493,28 +773,21 @@ const LongMarch_Vector<BaseComponentInterface*> longmarch::GameWorld::GetAllComp
 {
     TRY_LOCK_READ();
     LongMarch_Vector<BaseComponentInterface*> ret;
-    if (auto it = m_entityMaskMap.find(entity);
-        it != m_entityMaskMap.end())
+    if (const auto record = m_entityRecords.Find(entity))
     {
-        const auto& mask = it->second.GetBitMask();
-        if (const auto iter_manager = m_maskArcheTypeMap.find(mask);
-            iter_manager != m_maskArcheTypeMap.end())
+        if (const auto manager = record->m_archetype)
         {
-            if (const auto& manager = iter_manager->second;
-                manager)
+            const auto& allComType = record->m_mask.GetAllComponentTypeIndex();
+            ret.reserve(allComType.size());
+            for (auto comType : allComType)
             {
-                const auto& allComType = mask.GetAllComponentTypeIndex();
-                ret.reserve(allComType.size());
-                for (auto comType : allComType)
-                {
-                    ret.push_back(manager->GetBaseComponentByEntity(entity, comType));
-                }
-            }
-            else
-            {
-                ASSERT(mask == BitMaskSignature());
+                ret.push_back(manager->GetBaseComponentByIndex(record->m_index, comType));
             }
         }
+        else
+        {
+            ASSERT(record->m_mask == BitMaskSignature());
+        }
     }
     else
     {
@@ -527,16 +800,15 @@ const LongMarch_Vector<BaseComponentInterface*> longmarch::GameWorld::GetAllComp
 void longmarch::GameWorld::RemoveAllComponent(const Entity& entity)
 {
     TRY_LOCK_WRITE();
-    if (auto it = m_entityMaskMap.find(entity);
-        it != m_entityMaskMap.end())
+    if (const auto record = m_entityRecords.Find(entity))
     {
-        auto& mask = it->second.GetBitMask();
-        if (auto& manager = m_maskArcheTypeMap[mask];
-            manager)
+        if (const auto manager = record->m_archetype)
         {
-            manager->RemoveEntity(entity);
+            _UpdateEntityIndex(manager->RemoveEntity(record->m_index), record->m_index);
         }
-        mask.Reset();
+        record->m_mask.Reset();
+        record->m_archetype = nullptr;
+        record->m_index = 0;
     }
 }
 
@@ -546,15 +818,13 @@ const LongMarch_Vector<Entity> GameWorld::EntityView(const BitMaskSignature& mas
 
     ENGINE_EXCEPT_IF(mask == BitMaskSignature(),
                      L"GameWorld::EntityView should not receive a trivial bit mask. Double check EntityView argument.");
+    const auto& query = GetQuery(mask);
     LongMarch_Vector<Entity> ret;
-    ret.reserve(256);
-    for (const auto& [comTypes, manager] : m_maskArcheTypeMap)
+    ret.reserve(query.NumOfEntities());
+    for (const auto archetype : query.GetArcheTypes())
     {
-        if (manager && comTypes.IsAMatch(mask))
-        {
-            const auto& entities = manager->GetEntityView();
-            std::ranges::copy(entities.begin(), entities.end(), std::back_inserter(ret));
-        }
+        const auto& entities = archetype->GetEntityView();
+        ret.insert(ret.end(), entities.begin(), entities.end());
     }
     return ret;
 }
@@ -571,12 +841,12 @@ const
 }
 
 [[nodiscard]]
-std::future<void> longmarch::GameWorld::BackEach(const LongMarch_Vector<Entity>& es,
+JobFuture<void> longmarch::GameWorld::BackEach(const LongMarch_Vector<Entity>& es,
                                                  const std::type_identity_t<std::function<void
                                                      (const EntityDecorator& e)>>&
                                                  func) const
 {
-    return StealThreadPool::GetInstance()->enqueue_task(
+    return JobSystem::Async(
         [this, es, func]()
         {
             ENGINE_TRY_CATCH(this->ForEach(es, func););
@@ -585,12 +855,12 @@ std::future<void> longmarch::GameWorld::BackEach(const LongMarch_Vector<Entity>&
 }
 
 [[nodiscard]]
-std::future<void> longmarch::GameWorld::ParEach(const LongMarch_Vector<Entity>& es,
+JobFuture<void> longmarch::GameWorld::ParEach(const LongMarch_Vector<Entity>& es,
                                                 const std::type_identity_t<std::function<void
                                                     (const EntityDecorator& e)>>&
                                                 func, int min_batch) const
 {
-    return StealThreadPool::GetInstance()->enqueue_task([this, es, min_batch, func]()
+    return JobSystem::Async([this, es, min_batch, func]()
     {
         ENGINE_TRY_CATCH(ParEach_Internal(es, func, min_batch););
     });
@@ -606,67 +876,20 @@ void longmarch::GameWorld::ParEach_Internal(const LongMarch_Vector<Entity>& es,
         return;
     }
 
-    TRY_LOCK_READ();
-    auto& pool = s_parEachJobPool;
-
-    // Init splitting parameters
-    const int num_e = es.size();
-    auto _begin = es.begin();
-    auto _end = es.end();
-    int batch_size = num_e / pool.threads;
-
     // Adjust minimum split size & set actual split size
     min_batch = std::max(s_parEachMinBatch, min_batch);
-    batch_size = std::max(batch_size, min_batch);
-
-    // Even number split size
-    if (batch_size % 2 != 0)
-    {
-        ++batch_size;
-    }
-
-    // Ready for splitting jobs
-    int num_e_left = num_e;
-    LongMarch_Vector<std::future<void>> _jobs;
-
-    // Iterate until the last batch
-    while ((num_e_left -= batch_size) > 0)
-    {
-        LongMarch_Vector<Entity> split_es(_begin, _begin + batch_size);
-        _begin += batch_size;
-        _jobs.emplace_back(pool.enqueue_task([this, &func, split_es = std::move(split_es)]()
-            {
-                ENGINE_TRY_CATCH(
-                    {
-                        this->ForEach(split_es, func);
-                    }
-                );
-            }
-        ));
-    }
-
-    // Check any entities left, subtract from last batch size (the last batch should have size <= normal batch size)
-    if (num_e_left <= 0)
-    {
-        batch_size += num_e_left;
-        LongMarch_Vector<Entity> split_es(_begin, _begin + batch_size);
-        ENGINE_EXCEPT_IF((_begin + batch_size) != _end, L"Reach end condition does not meet!");
-        _jobs.emplace_back(pool.enqueue_task([this, &func, split_es = std::move(split_es)]()
-            {
-                ENGINE_TRY_CATCH(
-                    {
-                        this->ForEach(split_es, func);
-                    }
-                );
-            }
-        ));
-    }
+    const auto batch_size = std::max(es.size() / JobSystem::NumWorkers(), static_cast<size_t>(min_batch));
 
-    // Wait for each job to finish
-    for (auto& job : _jobs)
+    // Fork join, the calling thread helps running batches until all of them are done.
+    // yuhang : do not hold the read lock here, the calling thread could pick up a job that acquires the write lock while helping, each batch locks on its own
+    JobSystem::ParallelFor(0, es.size(), batch_size, [this, &func, &es](size_t first, size_t last)
     {
-        job.wait();
-    }
+        TRY_LOCK_READ();
+        for (auto i = first; i < last; ++i)
+        {
+            func(EntityDecorator(es[i], this));
+        }
+    });
 }
 
 const LongMarch_Vector<EntityChunkContext> GameWorld::EntityChunkView(const BitMaskSignature& mask) const
@@ -675,17 +898,13 @@ const LongMarch_Vector<EntityChunkContext> GameWorld::EntityChunkView(const BitM
 
     ENGINE_EXCEPT_IF(mask == BitMaskSignature(),
                      L"GameWorld::EntityChunkView should not receive a trivial bit mask. Double check EntityChunkView argument.");
+    const auto& query = GetQuery(mask);
     LongMarch_Vector<EntityChunkContext> ret;
-    for (const auto& [comTypes, manager] : m_maskArcheTypeMap)
+    ret.reserve(query.NumOfChunks());
+    query.ForEachChunk([&ret](const EntityChunkContext& e)
     {
-        if (manager && comTypes.IsAMatch(mask))
-        {
-            for (size_t i = 0; i < manager->NumOfChunks(); ++i)
-            {
-                ret.emplace_back(manager.get(), i);
-            }
-        }
-    }
+        ret.emplace_back(e);
+    });
     return ret;
 }
 
@@ -699,11 +918,11 @@ void GameWorld::ForEachChunk(const LongMarch_Vector<EntityChunkContext>& es,
     }
 }
 
-std::future<void> GameWorld::BackEachChunk(const LongMarch_Vector<EntityChunkContext>& es,
+JobFuture<void> GameWorld::BackEachChunk(const LongMarch_Vector<EntityChunkContext>& es,
                                            const std::type_identity_t<std::function<void(const EntityChunkContext& e)>>&
                                            func) const
 {
-    return StealThreadPool::GetInstance()->enqueue_task(
+    return JobSystem::Async(
         [this, es, func]()
         {
             ENGINE_TRY_CATCH(this->ForEachChunk(es, func););
@@ -711,11 +930,11 @@ std::future<void> GameWorld::BackEachChunk(const LongMarch_Vector<EntityChunkCon
     );
 }
 
-std::future<void> GameWorld::ParEachChunk(const LongMarch_Vector<EntityChunkContext>& es,
+JobFuture<void> GameWorld::ParEachChunk(const LongMarch_Vector<EntityChunkContext>& es,
                                           const std::type_identity_t<std::function<void(const EntityChunkContext& e)>>&
                                           func, int min_batch) const
 {
-    return StealThreadPool::GetInstance()->enqueue_task([this, es, min_batch, func]()
+    return JobSystem::Async([this, es, min_batch, func]()
     {
         ENGINE_TRY_CATCH(ParEachChunk_Internal(es, func, min_batch););
     });
@@ -731,21 +950,17 @@ void GameWorld::ParEachChunk_Internal(const LongMarch_Vector<EntityChunkContext>
         return;
     }
 
-    TRY_LOCK_READ();
-    auto& pool = s_parEachJobPool;
-
     // Init splitting parameters
     const int num_e = es.size();
-    const bool should_split = num_e / pool.threads < 1;
-
-    // Ready for splitting jobs
-    LongMarch_Vector<std::future<void>> _jobs;
+    const int num_workers = JobSystem::NumWorkers();
+    const bool should_split = num_e < num_workers;
 
+    LongMarch_Vector<EntityChunkContext> split_es;
     if (should_split)
     [[unlikely]]
     {
-        int splits = pool.threads - num_e;
-        for (auto& e : es)
+        int splits = num_workers - num_e;
+        for (const auto& e : es)
         {
             if (splits > 0)
             [[unlikely]]
@@ -756,63 +971,171 @@ void GameWorld::ParEachChunk_Internal(const LongMarch_Vector<EntityChunkContext>
                 e1.m_iterEndIndex /= 2;
                 if (e1.m_iterBeginIndex <= e1.m_iterEndIndex)
                 {
-                    _jobs.emplace_back(pool.enqueue_task([this, &func, &e1]()
-                        {
-                            ENGINE_TRY_CATCH(
-                                TRY_LOCK_READ();
-                                func(e1);
-                            );
-                        }
-                    ));
+                    split_es.emplace_back(e1);
                 }
 
                 auto e2 = e;
                 e2.m_iterBeginIndex = e1.m_iterEndIndex + 1;
                 if (e2.m_iterBeginIndex <= e2.m_iterEndIndex)
                 {
-                    _jobs.emplace_back(pool.enqueue_task([this, &func, &e2]()
-                        {
-                            ENGINE_TRY_CATCH(
-                                TRY_LOCK_READ();
-                                func(e2);
-                            );
-                        }
-                    ));
+                    split_es.emplace_back(e2);
                 }
             }
             else
             [[likely]]
             {
-                _jobs.emplace_back(pool.enqueue_task([this, &func, &e]()
-                    {
-                        ENGINE_TRY_CATCH(
-                            TRY_LOCK_READ();
-                            func(e);
-                        );
-                    }
-                ));
+                split_es.emplace_back(e);
             }
         }
     }
-    else
-    [[likely]]
+
+    // Fork join with one chunk per job, the calling thread helps running chunks until all of them are done (each chunk locks on its own, see ParEach_Internal)
+    const auto& job_es = should_split ? split_es : es;
+    JobSystem::ParallelFor(0, job_es.size(), 1, [this, &func, &job_es](size_t first, size_t last)
     {
-        for (auto& e : es)
+        TRY_LOCK_READ();
+        for (auto i = first; i < last; ++i)
         {
-            _jobs.emplace_back(pool.enqueue_task([this, &func, &e]()
-                {
-                    ENGINE_TRY_CATCH(
-                        TRY_LOCK_READ();
-                        func(e);
-                    );
-                }
-            ));
+            func(job_es[i]);
+        }
+    });
+}
+
+void longmarch::GameWorld::ForEach(const EntityQuery& query,
+                                   const std::type_identity_t<std::function<void(const EntityDecorator& e)>>& func)
+const
+{
+    TRY_LOCK_READ();
+    query.ForEachEntity([this, &func](const Entity& e)
+    {
+        func(EntityDecorator(e, this));
+    });
+}
+
+JobFuture<void> longmarch::GameWorld::BackEach(const EntityQuery& query,
+                                                 const std::type_identity_t<std::function<void
+                                                     (const EntityDecorator& e)>>&
+                                                 func) const
+{
+    // Queries live as long as this gameworld, so the job could hold on to it
+    return JobSystem::Async(
+        [this, &query, func]()
+        {
+            ENGINE_TRY_CATCH(this->ForEach(query, func););
+        }
+    );
+}
+
+JobFuture<void> longmarch::GameWorld::ParEach(const EntityQuery& query,
+                                                const std::type_identity_t<std::function<void
+                                                    (const EntityDecorator& e)>>&
+                                                func, int min_batch) const
+{
+    return JobSystem::Async([this, &query, min_batch, func]()
+    {
+        ENGINE_TRY_CATCH(ParEach_Internal(query, func, min_batch););
+    });
+}
+
+void longmarch::GameWorld::ParEach_Internal(const EntityQuery& query,
+                                    const std::type_identity_t<std::function<void(const EntityDecorator& e)>>& func,
+                                    int min_batch) const
+{
+    TRY_LOCK_READ();
+    const auto num_e = query.NumOfEntities();
+    if (num_e == 0)
+    {
+        // Early return on empty entities
+        return;
+    }
+
+    // Adjust minimum split size & set actual split size
+    min_batch = std::max(s_parEachMinBatch, min_batch);
+    const auto batch_size = std::max(num_e / static_cast<size_t>(JobSystem::NumWorkers()), static_cast<size_t>(min_batch));
+
+    // Fork join over the entities of each archetype in place.
+    // yuhang : the entity views are iterated in place so the read lock is held throughout, hence the calling thread must not help running other jobs that might acquire the write lock
+    for (const auto archetype : query.GetArcheTypes())
+    {
+        const auto& es = archetype->GetEntityView();
+        JobSystem::ParallelForNoHelp(0, es.size(), batch_size, [this, &func, &es](size_t first, size_t last)
+        {
+            TRY_LOCK_READ();
+            for (auto i = first; i < last; ++i)
+            {
+                func(EntityDecorator(es[i], this));
+            }
+        });
+    }
+}
+
+void GameWorld::ForEachChunk(const EntityQuery& query,
+                             const std::type_identity_t<std::function<void(const EntityChunkContext& e)>>& func) const
+{
+    TRY_LOCK_READ();
+    query.ForEachChunk(func);
+}
+
+JobFuture<void> GameWorld::BackEachChunk(const EntityQuery& query,
+                                           const std::type_identity_t<std::function<void(const EntityChunkContext& e)>>&
+                                           func) const
+{
+    // Queries live as long as this gameworld, so the job could hold on to it
+    return JobSystem::Async(
+        [this, &query, func]()
+        {
+            ENGINE_TRY_CATCH(this->ForEachChunk(query, func););
+        }
+    );
+}
+
+JobFuture<void> GameWorld::ParEachChunk(const EntityQuery& query,
+                                          const std::type_identity_t<std::function<void(const EntityChunkContext& e)>>&
+                                          func, int min_batch) const
+{
+    return JobSystem::Async([this, &query, min_batch, func]()
+    {
+        ENGINE_TRY_CATCH(ParEachChunk_Internal(query, func, min_batch););
+    });
+}
+
+void GameWorld::ParEachChunk_Internal(const EntityQuery& query,
+                              const std::type_identity_t<std::function<void(const EntityChunkContext& e)>>& func,
+                              int min_batch) const
+{
+    LongMarch_Vector<EntityChunkContext> es;
+    {
+        TRY_LOCK_READ();
+        if (const auto num_e = query.NumOfChunks(); num_e < static_cast<size_t>(JobSystem::NumWorkers()))
+        [[unlikely]]
+        {
+            // Too few chunks to keep every worker busy, collect them so that they could be split
+            es.reserve(num_e);
+            query.ForEachChunk([&es](const EntityChunkContext& e)
+            {
+                es.emplace_back(e);
+            });
         }
     }
-    
-    // Wait for each job to finish
-    for (auto& job : _jobs)
+    if (!es.empty())
+    [[unlikely]]
     {
-        job.wait();
+        // Collected chunks are split and run without holding the read lock
+        ParEachChunk_Internal(es, func, min_batch);
+        return;
+    }
+
+    // Fork join with one chunk per job over the chunks of each archetype in place, the read lock is held throughout (see ParEach_Internal)
+    TRY_LOCK_READ();
+    for (const auto archetype : query.GetArcheTypes())
+    {
+        JobSystem::ParallelForNoHelp(0, archetype->NumOfChunks(), 1, [this, &func, archetype](size_t first, size_t last)
+        {
+            TRY_LOCK_READ();
+            for (auto i = first; i < last; ++i)
+            {
+                func(EntityChunkContext(archetype, i));
+            }
+        });
     }
 }
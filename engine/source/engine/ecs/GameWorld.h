@@ -5,20 +5,26 @@
 #include "engine/core/thread/Lock.h"
 #include "engine/core/thread/ThreadPool.h"
 #include "engine/core/thread/StealThreadPool.h"
+#include "engine/core/thread/JobSystem.h"
 #include "engine/core/utility/TypeHelper.h"
 #include "engine/core/thread/RivalLock.h"
 #include "engine/core/smart-pointer/RefPtr.h"
 
 #include "engine/ecs/EntityManager.h"
+#include "engine/ecs/EntitySparseSet.h"
 #include "engine/ecs/BitMaskSignature.h"
 #include "engine/ecs/EntityDecorator.h"
 #include "engine/ecs/ComponentManager.h"
+#include "engine/ecs/EntityQuery.h"
 #include "engine/ecs/ComponentDecorator.h"
 #include "engine/ecs/EntityType.h"
+#include "engine/ecs/EntityCommandBuffer.h"
 
 #include "engine/events/EventQueue.h"
 #include "engine/events/engineEvents/EngineCustomEvent.h"
 
+#define PARALLEL_SYSTEM_UPDATE 1 // Run component systems that do not conflict on component access concurrently in Update and LateUpdate
+
 namespace longmarch
 {
     class BaseComponentSystem;
@@ -57,39 +63,40 @@ namespace longmarch
             READ_ONLY = 1, // Only allow read, will throw an exception on write
         };
 
-        typedef LongMarch_UnorderedMap_flat<ComponentTypeIndex_T, void*> ComponentCacheMap_T;
-        struct EntityMaskValue_T
+        //! Where the components of an entity live
+        struct EntityRecord_T
         {
-            EntityMaskValue_T() = default;
-            EntityMaskValue_T(const EntityMaskValue_T& other)
-            {
-                GetBitMask() = std::get<0>(other.EntityMaskValue);
-            }
-            EntityMaskValue_T& operator=(const EntityMaskValue_T& other)
-            {
-                GetBitMask() = std::get<0>(other.EntityMaskValue);
-                return *this;
-            }
-            EntityMaskValue_T(EntityMaskValue_T&& other) noexcept
-            {
-                GetBitMask() = std::move(std::get<0>(other.EntityMaskValue));
-            }
-            EntityMaskValue_T& operator=(EntityMaskValue_T&& other) noexcept
-            {
-                GetBitMask() = std::move(std::get<0>(other.EntityMaskValue));
-                return *this;
-            }
-            
-            BitMaskSignature& GetBitMask() const
-            {
-                return std::get<0>(EntityMaskValue);
-            }
-            ComponentCacheMap_T& GetComponentCache() const
+            BitMaskSignature m_mask;
+            //! Archetype that stores the components of the entity, nullptr if the entity has no component
+            ArcheTypeManager* m_archetype{nullptr};
+            //! Index of the entity in its archetype
+            size_t m_index{0};
+        };
+
+        //! Dependency graph of component systems, an edge i -> j means system j must run after system i
+        struct SystemGraph_T
+        {
+            struct Node_T
             {
-                return std::get<1>(EntityMaskValue);
-            }
-        private:
-            mutable std::tuple<BitMaskSignature, ComponentCacheMap_T> EntityMaskValue;
+                uint32_t m_numDependencies{0};
+                LongMarch_Vector<uint32_t> m_dependents;
+                //! Exclusive systems run on the thread that runs the graph
+                bool m_exclusive{false};
+            };
+            LongMarch_Vector<Node_T> m_nodes;
+            LongMarch_Vector<uint32_t> m_roots;
+            //! True if no system could run concurrently with another one
+            bool m_sequential{true};
+        };
+
+        //! Per invocation state of running a system graph, shared by all jobs of the invocation
+        struct SystemGraphRun_T
+        {
+            constexpr inline static uint32_t kNoSystem = {~0u};
+            std::unique_ptr<std::atomic_uint32_t[]> m_pending;
+            std::atomic_size_t m_remaining{0};
+            //! Exclusive system that is ready to run on the calling thread, an exclusive system depends on and is depended on by every other system so at most one is ready at a time
+            std::atomic_uint32_t m_readyExclusive{kNoSystem};
         };
         
     private:
@@ -97,6 +104,7 @@ namespace longmarch
         GameWorld() = delete;
         explicit GameWorld(bool setCurrent, const std::string& name, const fs::path& filePath);
         friend TemplateMemoryManager<GameWorld>;
+        friend EntityCommandBuffer;
 
     public:
         /**
@@ -216,6 +224,14 @@ namespace longmarch
             Scene3DCom,
         */
         EntityDecorator GenerateEntity3DNoCollision(EntityType type, bool active, bool add_to_root);
+        /*
+            Generate entities in bulk, the components of each entity are returned by the prototype function
+            and constructed in place, so that each entity is placed into its final archetype only once.
+            The prototype function should not access this gameworld.
+        */
+        template <typename... ComponentTypes>
+        LongMarch_Vector<EntityDecorator> GenerateEntities(EntityType type, size_t count,
+            const std::type_identity_t<std::function<std::tuple<ComponentTypes...>(const EntityDecorator& e)>>& prototype);
 
         //! Remove a specific entity and all its components
         void RemoveEntity(const Entity& entity);
@@ -223,6 +239,15 @@ namespace longmarch
         //! Check if entity is valid and exists in this gameworld
         bool HasEntity(const Entity& entity) const;
 
+        /**************************************************************
+        *	Command buffer
+        **************************************************************/
+        //! Thread safe, return the command buffer owned by the calling thread, use it to defer structural changes from ParEach/ParEachChunk jobs
+        EntityCommandBuffer& GetCommandBuffer() const;
+
+        //! Play back all command buffers in order of their creation, called at sync points between Update, LateUpdate and PreRenderUpdate
+        void PlaybackCommandBuffers();
+
         //! Helper method that links an entity to a new parent, remove older parent as well.
         void AddChild_Helper(Entity parent, Entity child);
 
@@ -267,12 +292,28 @@ namespace longmarch
         template <typename ComponentType>
         void AddComponent(const Entity& entity, const ComponentType& component);
 
+        //! Add multiple components at once, the entity is moved to its final archetype only once and components are constructed in place
+        template <typename... ComponentTypes>
+        void AddComponents(const Entity& entity, ComponentTypes&&... components);
+
         template <typename ComponentType>
         void RemoveComponent(const Entity& entity);
 
+        //! Mutable access, marks the component of the chunk of the entity as changed (see ArcheTypeManager)
         template <typename ComponentType>
         ComponentDecorator<ComponentType> GetComponent(const Entity& entity) const;
 
+        //! Read only access, does not mark the component as changed. Return nullptr if the entity does not have the component
+        template <typename ComponentType>
+        const ComponentType* GetConstComponent(const Entity& entity) const;
+
+        // Persistent queries --------------------------------------------------------------------------------------
+        //! Thread safe, return the persistent query of the signature, the query is created on first use and lives as long as this gameworld
+        const EntityQuery& GetQuery(const BitMaskSignature& bitMask) const;
+
+        template <class... Components>
+        const EntityQuery& GetQuery() const;
+
         // Unity DOTS ECS like for each function ------------------------------------------------------------------
         template <class... Components>
         const LongMarch_Vector<Entity> EntityView() const;
@@ -296,13 +337,27 @@ namespace longmarch
                      const std::type_identity_t<std::function<void(const EntityDecorator& e)>>& func) const;
 
         // Running job in a single backgroud thread
-        [[nodiscard]] std::future<void> BackEach(const LongMarch_Vector<Entity>& es,
+        [[nodiscard]] JobFuture<void> BackEach(const LongMarch_Vector<Entity>& es,
                                                  const std::type_identity_t<std::function<void
                                                      (const EntityDecorator& e)>>&
                                                  func) const;
 
         // Running jobs in a thread pool
-        [[nodiscard]] std::future<void> ParEach(const LongMarch_Vector<Entity>& es,
+        [[nodiscard]] JobFuture<void> ParEach(const LongMarch_Vector<Entity>& es,
+                                                const std::type_identity_t<std::function<void
+                                                    (const EntityDecorator& e)>>&
+                                                func, int min_batch = -1) const;
+
+        //! Same as above but walk the entities of the query w/o copying them, entities are read when the iteration runs
+        void ForEach(const EntityQuery& query,
+                     const std::type_identity_t<std::function<void(const EntityDecorator& e)>>& func) const;
+
+        [[nodiscard]] JobFuture<void> BackEach(const EntityQuery& query,
+                                                 const std::type_identity_t<std::function<void
+                                                     (const EntityDecorator& e)>>&
+                                                 func) const;
+
+        [[nodiscard]] JobFuture<void> ParEach(const EntityQuery& query,
                                                 const std::type_identity_t<std::function<void
                                                     (const EntityDecorator& e)>>&
                                                 func, int min_batch = -1) const;
@@ -317,13 +372,27 @@ namespace longmarch
              const std::type_identity_t<std::function<void(const EntityChunkContext& e)>>& func) const;
 
         // Running job in a single background thread
-        [[nodiscard]] std::future<void> BackEachChunk(const LongMarch_Vector<EntityChunkContext>& es,
+        [[nodiscard]] JobFuture<void> BackEachChunk(const LongMarch_Vector<EntityChunkContext>& es,
                                                  const std::type_identity_t<std::function<void
                                                      (const EntityChunkContext& e)>>&
                                                  func) const;
 
         // Running jobs in a thread pool
-        [[nodiscard]] std::future<void> ParEachChunk(const LongMarch_Vector<EntityChunkContext>& es,
+        [[nodiscard]] JobFuture<void> ParEachChunk(const LongMarch_Vector<EntityChunkContext>& es,
+                                                const std::type_identity_t<std::function<void
+                                                    (const EntityChunkContext& e)>>&
+                                                func, int min_batch = -1) const;
+
+        //! Same as above but walk the chunks of the query w/o copying them, chunks are read when the iteration runs
+        void ForEachChunk(const EntityQuery& query,
+             const std::type_identity_t<std::function<void(const EntityChunkContext& e)>>& func) const;
+
+        [[nodiscard]] JobFuture<void> BackEachChunk(const EntityQuery& query,
+                                                 const std::type_identity_t<std::function<void
+                                                     (const EntityChunkContext& e)>>&
+                                                 func) const;
+
+        [[nodiscard]] JobFuture<void> ParEachChunk(const EntityQuery& query,
                                                 const std::type_identity_t<std::function<void
                                                     (const EntityChunkContext& e)>>&
                                                 func, int min_batch = -1) const;
@@ -352,6 +421,37 @@ namespace longmarch
                        const std::type_identity_t<std::function<void(const EntityChunkContext& e)>>& func,
                        int min_batch = -1) const;
 
+        void ParEach_Internal(const EntityQuery& query,
+                       const std::type_identity_t<std::function<void(const EntityDecorator& e)>>& func,
+                       int min_batch = -1) const;
+
+        void ParEachChunk_Internal(const EntityQuery& query,
+                       const std::type_identity_t<std::function<void(const EntityChunkContext& e)>>& func,
+                       int min_batch = -1) const;
+
+        //! Generate entity from an entity that has been reserved from the entity manager
+        EntityDecorator _GenerateEntity(const Entity& reserved, bool active, bool add_to_root);
+        //! Generate 3D entity from an entity that has been reserved from the entity manager
+        EntityDecorator _GenerateEntity3D(const Entity& reserved, bool active, bool add_to_root, bool collision);
+
+        //! Build the dependency graph of component systems from their component access, systems conflict if one writes components that the other reads or writes
+        void _BuildSystemGraph();
+        //! Invoke all component systems following the dependency graph, non-conflicting systems run concurrently on workers and exclusive systems run on the calling thread
+        void _RunSystemGraph(const std::function<void(BaseComponentSystem*)>& invoke);
+        void _RunSystemNode(const std::shared_ptr<SystemGraphRun_T>& run, uint32_t index,
+                            const std::function<void(BaseComponentSystem*)>& invoke);
+        //! Enqueue a system whose dependencies are done to the job system, or hand it to the calling thread if it is exclusive
+        void _ScheduleSystemNode(const std::shared_ptr<SystemGraphRun_T>& run, uint32_t index,
+                                 const std::function<void(BaseComponentSystem*)>& invoke);
+
+        //! Components of an entity are moved when another entity is swapped out of its archetype, so its recorded index must be updated
+        void _UpdateEntityIndex(const Entity& swapped, size_t index);
+
+        //! Push a newly created archetype to all matching queries
+        void _OnArcheTypeCreated(const BitMaskSignature& mask, ArcheTypeManager* archetype);
+        //! Rebuild all queries from scratch, used when archetypes are replaced (e.g. cloning a gameworld)
+        void _RebuildQueries();
+
         bool ShouldApplyRivalLock() const
         {
             return m_RWMode != GameWorldReadWriteMode::READ_ONLY;
@@ -361,20 +461,25 @@ namespace longmarch
         inline static LongMarch_UnorderedMap_flat<std::string, RefPtr<GameWorld>> s_allManagedWorlds;
         inline static GameWorld* s_currentWorld {nullptr};
 
-        //! Multithreaded pool used in ParEach2 for inner function multithreading to avoid thread overflow stalling the default thread pool and the entire program
-        inline static StealThreadPool s_parEachJobPool;
+        //! Minimum number of entities per ParEach job
         constexpr inline static int s_parEachMinBatch{64};
+        //! Unique id of game worlds, used to validate thread local command buffer caches
+        inline static std::atomic<uint64_t> s_worldUID{0};
         
     private:
         // Entity (E)
         //!< Contains all entities
         std::shared_ptr<EntityManager> m_entityManager;
-        //!< Contains all entities and their component bit masks and component pointer location cache (do not copy this component cache map when cloning a gameworld)
-        LongMarch_UnorderedMap_Par_node<Entity, EntityMaskValue_T> m_entityMaskMap;
+        //!< Contains all entities, their component bit masks and their location in archetypes, indexed by entity index w/o hashing
+        EntitySparseSet<EntityRecord_T> m_entityRecords;
 
         // Component (C)
         //!< Contains all components bit masks and their corresponding entities
         LongMarch_UnorderedMap_node<BitMaskSignature, std::shared_ptr<ArcheTypeManager>> m_maskArcheTypeMap;
+        //!< Persistent queries by signature, maintained incrementally on archetype creation
+        mutable LongMarch_UnorderedMap_flat<BitMaskSignature, std::unique_ptr<EntityQuery>> m_queries;
+        //!< Guards query creation, as queries could be created concurrently by readers
+        mutable std::atomic_flag m_queryFlag;
 
         // System (S)
         //!< In order array of all systems
@@ -383,6 +488,19 @@ namespace longmarch
         LongMarch_Vector<std::string> m_systemsName;
         //!< System LUT based on names, iterating over this container does not gaurantee orderness
         LongMarch_UnorderedMap_node<std::string, std::shared_ptr<BaseComponentSystem>> m_systemsNameMap;
+        //!< Dependency graph of systems, rebuilt when systems are registered or initialized
+        SystemGraph_T m_systemGraph;
+        bool m_systemGraphDirty{true};
+
+        // Command buffer
+        //!< Unique id of this game world
+        const uint64_t m_uid{++s_worldUID};
+        //!< Command buffers of all threads that have recorded to this game world, in order of their creation
+        mutable LongMarch_Vector<std::unique_ptr<EntityCommandBuffer>> m_commandBuffers;
+        //!< Command buffer LUT by thread id
+        mutable LongMarch_UnorderedMap_flat<std::thread::id, EntityCommandBuffer*> m_commandBufferMap;
+        //!< Guards command buffer registration
+        mutable std::atomic_flag m_commandBufferFlag;
 
         // Misc
         //! Read & Write access mode
@@ -410,3 +528,4 @@ do {ASSERT(m_RWMode != GameWorldReadWriteMode::READ_ONLY);} while(0)
 
 #include "GameWorld.inl"
 #include "EntityDecorator.inl"
+#include "EntityCommandBuffer.inl"
@@ -9,10 +9,9 @@ namespace longmarch
     inline bool GameWorld::HasComponent(const Entity& entity) const
     {
         TRY_LOCK_READ();
-        if (const auto it = m_entityMaskMap.find(entity);
-            it != m_entityMaskMap.end())
+        if (const auto record = m_entityRecords.Find(entity))
         {
-            return it->second.GetBitMask().IsAMatch(BitMaskSignature::Create<ComponentType>());
+            return record->m_mask.IsAMatch(BitMaskSignature::Create<ComponentType>());
         }
         else
         {
@@ -20,59 +19,106 @@ namespace longmarch
         }
     }
 
-    // TODO @yuhang : implement Move component
     template <typename ComponentType>
     inline void GameWorld::AddComponent(const Entity& entity, const ComponentType& component)
     {
+        AddComponents(entity, component);
+    }
+
+    template <typename... ComponentTypes>
+    inline void GameWorld::AddComponents(const Entity& entity, ComponentTypes&&... components)
+    {
+        static_assert(sizeof...(ComponentTypes) > 0, "AddComponents requires at least one component");
         TRY_LOCK_WRITE();
-        auto& EntityMaskValue = m_entityMaskMap[entity];
-        auto& newMask = EntityMaskValue.GetBitMask();
-        auto& ComponentCache = EntityMaskValue.GetComponentCache();
+        auto& record = m_entityRecords[entity];
+        auto& newMask = record.m_mask;
         const auto oldMask = newMask;
-        newMask.AddComponent<ComponentType>();
 
-        if (oldMask == newMask)
+        if ((oldMask.IsAMatch(BitMaskSignature::Create<std::remove_cvref_t<ComponentTypes>>()) || ...))
         {
             ENGINE_EXCEPT(
-                wStr(Str("Entity %s already has component type %s", Str(entity), typeid(ComponentType).name())));
+                wStr(Str("Entity %s already has one of component types %s", Str(entity),
+                    typeid(std::tuple<std::remove_cvref_t<ComponentTypes>...>).name())));
             return;
         }
+        (newMask.AddComponent<std::remove_cvref_t<ComponentTypes>>(), ...);
 
-        const auto& oldManager = m_maskArcheTypeMap[oldMask];
+        const auto oldManager = record.m_archetype;
         auto& newManager = m_maskArcheTypeMap[newMask];
-        if (oldManager)
+        if (!newManager)
         {
-            if (!newManager)
+            newManager = MemoryManager::Make_shared<ArcheTypeManager>();
+            if (oldManager)
             {
-                newManager = MemoryManager::Make_shared<ArcheTypeManager>();
                 newManager->CopyComponentManagerFrom(*oldManager);
-                newManager->AddComponentManger<ComponentType>();
             }
-            // Transfer entity from old manager to new manager
-            oldManager->MoveOutEntity(entity, *newManager);
+            newManager->AddComponentManger<std::remove_cvref_t<ComponentTypes>...>();
+            _OnArcheTypeCreated(newMask, newManager.get());
+        }
+        (components.SetWorld(this), ...);
+        if (oldManager)
+        {
+            // Transfer entity from old manager to new manager, constructing new components in place
+            _UpdateEntityIndex(oldManager->MoveOutEntity(record.m_index, *newManager, std::forward<ComponentTypes>(components)...), record.m_index);
+            record.m_index = newManager->Size() - 1;
         }
         else
         {
             ASSERT(oldMask == BitMaskSignature(),
                    "Fails to retrive proper bist mask for entity. OldManager is nullptr only if mask is empty.");
-            if (!newManager)
+            record.m_index = newManager->EmplaceEntity(entity, std::forward<ComponentTypes>(components)...);
+        }
+        record.m_archetype = newManager.get();
+    }
+
+    template <typename... ComponentTypes>
+    inline LongMarch_Vector<EntityDecorator> GameWorld::GenerateEntities(EntityType type, size_t count,
+        const std::type_identity_t<std::function<std::tuple<ComponentTypes...>(const EntityDecorator& e)>>& prototype)
+    {
+        static_assert(sizeof...(ComponentTypes) > 0, "GenerateEntities requires at least one component");
+        LongMarch_Vector<EntityDecorator> ret;
+        ret.reserve(count);
+        const auto mask = BitMaskSignature::Create<ComponentTypes...>();
+
+        TRY_LOCK_WRITE();
+        auto& manager = m_maskArcheTypeMap[mask];
+        if (!manager)
+        {
+            manager = MemoryManager::Make_shared<ArcheTypeManager>();
+            manager->AddComponentManger<ComponentTypes...>();
+            _OnArcheTypeCreated(mask, manager.get());
+        }
+        manager->Reserve(manager->Size() + count);
+        m_entityRecords.Reserve(m_entityRecords.Size() + count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto entity = m_entityManager->Create(type);
+            auto& record = m_entityRecords[entity];
+            record.m_mask = mask;
+            record.m_archetype = manager.get();
+            const EntityDecorator e{entity, this};
+            std::apply([&](auto&&... components)
             {
-                newManager = MemoryManager::Make_shared<ArcheTypeManager>();
-                newManager->AddComponentManger<ComponentType>();
-            }
+                (components.SetWorld(this), ...);
+                record.m_index = manager->EmplaceEntity(entity, std::move(components)...);
+            }, prototype(e));
+            ret.emplace_back(e);
         }
-        component.SetWorld(this);
-        newManager->AddComponentToEntity(entity, component);
-        ComponentCache.clear();
+        return ret;
     }
 
     template <typename ComponentType>
     inline void GameWorld::RemoveComponent(const Entity& entity)
     {
         TRY_LOCK_WRITE();
-        auto& EntityMaskValue = m_entityMaskMap[entity];
-        auto& newMask = EntityMaskValue.GetBitMask();
-        auto& ComponentCache = EntityMaskValue.GetComponentCache();
+        const auto record = m_entityRecords.Find(entity);
+        if (!record)
+        {
+            ENGINE_EXCEPT(
+                wStr(Str("Entity %s does not exist when removing component type %s", Str(entity), typeid(ComponentType).name())));
+            return;
+        }
+        auto& newMask = record->m_mask;
         const auto oldMask = newMask;
         newMask.RemoveComponent<ComponentType>();
 
@@ -83,12 +129,29 @@ namespace longmarch
             return;
         }
 
-        const auto& oldManager = m_maskArcheTypeMap[oldMask];
-        auto& newManager = m_maskArcheTypeMap[newMask];
-        ASSERT(oldManager && newManager);
-        // Transfer entity from old manager to new manager
-        oldManager->MoveOutEntity(entity, *newManager);
-        ComponentCache.clear();
+        const auto oldManager = record->m_archetype;
+        ASSERT(oldManager);
+        if (newMask == BitMaskSignature())
+        {
+            // Removing the last component, simply remove entity from old manager
+            _UpdateEntityIndex(oldManager->RemoveEntity(record->m_index), record->m_index);
+            record->m_archetype = nullptr;
+            record->m_index = 0;
+        }
+        else
+        {
+            auto& newManager = m_maskArcheTypeMap[newMask];
+            if (!newManager)
+            {
+                newManager = MemoryManager::Make_shared<ArcheTypeManager>();
+                newManager->CopyComponentManagerFrom(*oldManager, GetComponentTypeIndex<ComponentType>());
+                _OnArcheTypeCreated(newMask, newManager.get());
+            }
+            // Transfer entity from old manager to new manager
+            _UpdateEntityIndex(oldManager->MoveOutEntity(record->m_index, *newManager), record->m_index);
+            record->m_archetype = newManager.get();
+            record->m_index = newManager->Size() - 1;
+        }
     }
 
     template <typename ComponentType>
@@ -96,33 +159,12 @@ namespace longmarch
     {
         TRY_LOCK_READ();
         ComponentType* com = nullptr;
-        if (const auto it = m_entityMaskMap.find(entity);
-            it != m_entityMaskMap.end())
+        if (const auto record = m_entityRecords.Find(entity))
+        [[likely]]
         {
-            if (const auto& mask = it->second.GetBitMask();
-                mask.IsAMatch(BitMaskSignature::Create<ComponentType>()))
+            if (record->m_mask.IsAMatch(BitMaskSignature::Create<ComponentType>()))
             {
-                auto& ComponentCache = it->second.GetComponentCache();
-                auto ComTypeIndex = GetComponentTypeIndex<ComponentType>();
-                if (const auto iter_com = ComponentCache.find(ComTypeIndex);
-                    iter_com != ComponentCache.end())
-                {
-                    com = reinterpret_cast<ComponentType*>(iter_com->second);
-                }
-                else if (const auto iter_manager = m_maskArcheTypeMap.find(mask);
-                    iter_manager != m_maskArcheTypeMap.end())
-                {
-                    if (const auto& manager = iter_manager->second;
-                        manager)
-                    {
-                        com = manager->GetComponentByEntity<ComponentType>(entity);
-                        ComponentCache[ComTypeIndex] = com;
-                    }
-                    else
-                    {
-                        ASSERT(mask == BitMaskSignature());
-                    }
-                }
+                com = record->m_archetype->template GetComponentByIndex<ComponentType>(record->m_index);
             }
         }
         else
@@ -133,6 +175,33 @@ namespace longmarch
         return ComponentDecorator<ComponentType>(EntityDecorator{entity, this}, com);
     }
 
+    template <typename ComponentType>
+    inline const ComponentType* GameWorld::GetConstComponent(const Entity& entity) const
+    {
+        TRY_LOCK_READ();
+        if (const auto record = m_entityRecords.Find(entity))
+        [[likely]]
+        {
+            if (record->m_mask.IsAMatch(BitMaskSignature::Create<ComponentType>()))
+            {
+                return record->m_archetype->template GetConstComponentByIndex<ComponentType>(record->m_index);
+            }
+        }
+        else
+        {
+            WARN_PRINT(
+                Str("GameWorld::GetConstComponent: Fail to find Entity '%s' in world '%s'", Str(entity), this->GetName()));
+        }
+        return nullptr;
+    }
+
+    template <class ...Components>
+    inline const EntityQuery& GameWorld::GetQuery() const
+    {
+        static_assert(sizeof...(Components) > 0, "GetQuery requires at least one component");
+        return GetQuery(BitMaskSignature::Create<Components...>());
+    }
+
     template <class ...Components>
     inline const LongMarch_Vector<Entity> GameWorld::EntityView() const
     {
@@ -184,7 +253,7 @@ namespace longmarch
     inline auto GameWorld::BackEach(
         const std::type_identity_t<std::function<void(const EntityDecorator& e, Components&...)>>& func) const
     {
-        return StealThreadPool::GetInstance()->enqueue_task(
+        return JobSystem::Async(
             [this, func]()
             {
                 ENGINE_TRY_CATCH(this->ForEach<Components...>(func););
@@ -198,7 +267,7 @@ namespace longmarch
         const std::type_identity_t<std::function<void(const EntityDecorator& e, Components&...)>>& func,
         int min_batch) const
     {
-        return StealThreadPool::GetInstance()->enqueue_task([this, min_batch, func]()
+        return JobSystem::Async([this, min_batch, func]()
         {
             ENGINE_TRY_CATCH(ParEach_Internal<Components...>(func, min_batch););
         });
@@ -217,70 +286,19 @@ namespace longmarch
             return;
         }
         
-        TRY_LOCK_READ();
-        auto& pool = s_parEachJobPool;
-
-        const int num_e = es.size();
-        auto _begin = es.begin();
-        auto _end = es.end();
-        int batch_size = num_e / pool.threads;
-        
         // Minimum split size
         min_batch = std::max(s_parEachMinBatch, min_batch);
-        batch_size = std::max(batch_size, min_batch);
-        
-        // Even number split size
-        if (batch_size % 2 != 0)
-        {
-            ++batch_size;
-        }
-        
-        int num_e_left = num_e;
-        LongMarch_Vector<std::future<void>> _jobs;
+        const auto batch_size = std::max(es.size() / JobSystem::NumWorkers(), static_cast<size_t>(min_batch));
 
-        // Iterate until the last batch
-        while ((num_e_left -= batch_size) > 0)
-        {
-            LongMarch_Vector<Entity> split_es(_begin, _begin + batch_size);
-            _begin += batch_size;
-            _jobs.emplace_back(pool.enqueue_task([this, &func, split_es = std::move(split_es)]()
-            {
-                ENGINE_TRY_CATCH(
-                    {
-                        TRY_LOCK_READ();
-                        for (const auto& e : split_es)
-                        {
-                            auto ed = EntityDecorator(e, this);
-                            func(ed, *(ed.template GetComponent<Components>().GetPtr())...);
-                        }
-                    });
-            }));
-        }
-        
-        // Check any entities left, subtract from last batch size (the last batch should have size <= normal batch size)
-        if (num_e_left <= 0)
+        // Fork join, the calling thread helps running batches until all of them are done (do not hold the read lock here, each batch locks on its own)
+        JobSystem::ParallelFor(0, es.size(), batch_size, [this, &func, &es](size_t first, size_t last)
         {
-            batch_size += num_e_left;
-            LongMarch_Vector<Entity> split_es(_begin, _begin + batch_size);
-            ENGINE_EXCEPT_IF((_begin + batch_size) != _end, L"Reach end condition does not meet!");
-            _jobs.emplace_back(pool.enqueue_task([this, &func, split_es = std::move(split_es)]()
+            TRY_LOCK_READ();
+            for (auto i = first; i < last; ++i)
             {
-                ENGINE_TRY_CATCH(
-                    {
-                        TRY_LOCK_READ();
-                        for (const auto& e : split_es)
-                        {
-                            auto ed = EntityDecorator(e, this);
-                            func(ed, *(ed.template GetComponent<Components>().GetPtr())...);
-                        }
-                    });
-            }));
-        }
-
-        // Wait on jobs to finish
-        for (auto& job : _jobs)
-        {
-            job.wait();
-        }
+                auto ed = EntityDecorator(es[i], this);
+                func(ed, *(ed.template GetComponent<Components>().GetPtr())...);
+            }
+        });
     }
 }
@@ -34,6 +34,21 @@ void longmarch::Body3DComSys::Init()
 		{
 			m_scene->SetGravity(Vec3f(0, 0, -9.8));
 		}
+		if (auto& broadPhase = engineConfiguration["physics"]["broadphase"]; !broadPhase.isNull())
+		{
+			if (const auto type = broadPhase.asString(); type == "sweep-and-prune")
+			{
+				m_scene->SetBroadPhaseType(BroadPhaseType::SWEEP_AND_PRUNE);
+			}
+			else if (type == "aabb-tree")
+			{
+				m_scene->SetBroadPhaseType(BroadPhaseType::AABB_TREE);
+			}
+			else
+			{
+				ENGINE_EXCEPT(L"Unknown physics broadphase : " + wStr(type));
+			}
+		}
 	}
 	else
 	{
@@ -56,75 +71,105 @@ void longmarch::Body3DComSys::PreRenderUpdate(double dt)
 	has been transfered to the GPU. So we need to initialze the bounding volume before it is rendered.
 	*/
 
-	ParEach(
-		[this](EntityDecorator e)
+	/*
+	Transforms and bodies of static entities are rarely written, so only chunks that have changed since the last update
+	update their bounding volumes and rigid bodies. Every chunk is still visited to finish pending initialization.
+	*/
+	const auto since = BeginChangeTracking();
+	ParEachChunk(
+		[this, since](const EntityChunkContext& e)
 	{
-		// Generate view frustum culling BV if possible
-		auto scene = e.GetComponent<Scene3DCom>();
-		auto body = e.GetComponent<Body3DCom>();
-		auto trans = e.GetComponent<Transform3DCom>();
-		if (auto bv = body->GetBoundingVolume(); !bv)
+		const bool changed = e.HasChangedSince<Transform3DCom>(since) || e.HasChangedSince<Body3DCom>(since);
+		const auto entities = e.GetEntityPtr();
+		const auto transform3DComs = e.GetConstComponentPtr<Transform3DCom>();
+		const auto constBody3DComs = e.GetConstComponentPtr<Body3DCom>();
+		// Only take mutable access to bodies that are actually written, so that bodies waiting for their scene data do not mark the chunk as changed every frame
+		Body3DCom* body3DComs = nullptr;
+
+		for (auto i = e.BeginIndex(); i <= e.EndIndex(); ++i)
 		{
-			if (scene.Valid())
+			const auto& constBody = constBody3DComs[i];
+			const bool pending = !constBody.GetBoundingVolume() || (!constBody.HasRigidBody() && constBody.m_rigidBodyInfo.type != RBType::noCollision);
+			if (!changed && !pending)
 			{
-				if (const auto& data = scene->GetSceneData(false); data)
-				{
-					auto& meshes = data->GetAllMesh();
-					body->CreateBoundingVolume<AABB>(meshes);
-					body->GetBoundingVolume()->SetOwnerEntity(e);
-				}
+				continue;
 			}
-		}
-		if (auto bv = body->GetBoundingVolume(); bv)
-		{
-			// Update view frustum culling BV
-			bv->SetModelTrAndUpdate(trans->GetModelTr());
-		}
-		// check to see if there is a corresponding rigid body in the scene, if not then assign one and update with body info
-		if (!body->HasRigidBody() && body->m_rigidBodyInfo.type != RBType::noCollision)
-		{
-			// Generate rigid body BV if possible
-			auto body = e.GetComponent<Body3DCom>();
-			if (auto aabbPtr = std::dynamic_pointer_cast<AABB>(body->GetBoundingVolume()); aabbPtr)
+			auto ed = EntityDecorator(entities[i], m_parentWorld);
+			const auto trans = transform3DComs + i;
+			auto mutableBody = [&e, &body3DComs, i]()
 			{
-				std::shared_ptr<RigidBody> newRB = m_scene->CreateRigidBody();
-				switch (body->m_rigidBodyInfo.type)
-				{
-				case RBType::dynamicBody:
+				if (!body3DComs)
 				{
-					newRB->SetAwake();
-					newRB->SetRBType(RBType::dynamicBody);
-					newRB->SetMass(body->m_rigidBodyInfo.mass);
+					body3DComs = e.GetComponentPtr<Body3DCom>();
 				}
-				break;
-				case RBType::staticBody:
+				return body3DComs + i;
+			};
+			// Generate view frustum culling BV if possible
+			if (auto bv = constBody.GetBoundingVolume(); !bv)
+			{
+				if (auto scene = ed.GetComponent<Scene3DCom>(); scene.Valid())
 				{
-					newRB->SetRBType(RBType::staticBody);
-					newRB->SetMass(1e8);
+					if (const auto& data = scene->GetSceneData(false); data)
+					{
+						auto& meshes = data->GetAllMesh();
+						const auto body = mutableBody();
+						body->CreateBoundingVolume<AABB>(meshes);
+						body->GetBoundingVolume()->SetOwnerEntity(ed);
+					}
 				}
-				break;
-				default:
-					ENGINE_EXCEPT(L"Logic error!");
+			}
+			if (auto bv = constBody.GetBoundingVolume(); bv)
+			{
+				// Update view frustum culling BV
+				bv->SetModelTrAndUpdate(trans->GetModelTr());
+			}
+			// check to see if there is a corresponding rigid body in the scene, if not then assign one and update with body info
+			if (!constBody.HasRigidBody() && constBody.m_rigidBodyInfo.type != RBType::noCollision)
+			{
+				// Generate rigid body BV if possible
+				if (auto aabbPtr = dynamic_cast<AABB*>(constBody.GetBoundingVolume()); aabbPtr)
+				{
+					const auto& info = constBody.m_rigidBodyInfo;
+					RefPtr<RigidBody> newRB = m_scene->CreateRigidBody();
+					switch (info.type)
+					{
+					case RBType::dynamicBody:
+					{
+						newRB->SetAwake();
+						newRB->SetRBType(RBType::dynamicBody);
+						newRB->SetMass(info.mass);
+					}
 					break;
+					case RBType::staticBody:
+					{
+						newRB->SetRBType(RBType::staticBody);
+						newRB->SetMass(1e8);
+					}
+					break;
+					default:
+						ENGINE_EXCEPT(L"Logic error!");
+						break;
+					}
+					newRB->SetFriction(info.friction);
+					newRB->SetRestitution(info.restitution);
+					newRB->SetLinearDamping(info.linearDamping);
+					const float scale = info.colliderDimensionExtent;
+					newRB->SetAABBShape(aabbPtr->GetOriginalMin() * scale, aabbPtr->GetOriginalMax() * scale);
+					newRB->SetEntity(ed.GetEntity());
+					newRB->m_entityTypeIngoreSet.AddIndex(info.entityTypeIngoreSet);
+					mutableBody()->AssignRigidBody(newRB);
 				}
-				newRB->SetFriction(body->m_rigidBodyInfo.friction);
-				newRB->SetRestitution(body->m_rigidBodyInfo.restitution);
-				newRB->SetLinearDamping(body->m_rigidBodyInfo.linearDamping);
-				const float scale = body->m_rigidBodyInfo.colliderDimensionExtent;
-				newRB->SetAABBShape(aabbPtr->GetOriginalMin() * scale, aabbPtr->GetOriginalMax() * scale);
-				newRB->SetEntity(e.GetEntity());
-				newRB->m_entityTypeIngoreSet.AddIndex(body->m_rigidBodyInfo.entityTypeIngoreSet);
-				body->AssignRigidBody(newRB);
 			}
-		}
-		if (body->HasRigidBody())
-		{
-			// Update rigid body BV
-			// Assign transformCom to rigid body
-			body->m_rigidBody->SetRBTrans(trans->GetModelTr());
-			body->m_rigidBody->SetLinearVelocity(trans->GetGlobalVel());
-			body->UpdateBody3DCom();
-			body->UpdateRigidBody();
+			if (constBody.HasRigidBody())
+			{
+				// Update rigid body BV
+				// Assign transformCom to rigid body
+				const auto body = mutableBody();
+				body->m_rigidBody->SetRBTrans(trans->GetModelTr());
+				body->m_rigidBody->SetLinearVelocity(trans->GetGlobalVel());
+				body->UpdateBody3DCom();
+				body->UpdateRigidBody();
+			}
 		}
 	}
 	).wait();
@@ -138,19 +183,32 @@ void longmarch::Body3DComSys::Update(double dt)
 	{
 		m_scene->Step(dt);
 	}
-	ParEach(
-		[this](EntityDecorator e)
+	ParEachChunk(
+		[](const EntityChunkContext& e)
 		{
-			auto body = e.GetComponent<Body3DCom>();
-			auto trans = e.GetComponent<Transform3DCom>();
+			const auto body3DComs = e.GetConstComponentPtr<Body3DCom>();
+			// Only take mutable access to transforms of chunks that have awake bodies, so that static chunks are not marked as changed
+			Transform3DCom* transform3DComs = nullptr;
 
-			if (body->HasRigidBody())
+			for (auto i = e.BeginIndex(); i <= e.EndIndex(); ++i)
 			{
-				// Assign simulated rigid body back to transformCom
-				const RBTransform& rbTrans = body->GetRBTrans();
-				trans->SetGlobalPos(rbTrans.m_pos);
-				//trans->SetGlobalRot(rbTrans.m_rot); // Rotation is not implemented in the physics engine
-				trans->SetGlobalVel(body->m_rigidBody->GetLinearVelocity());
+				const auto body = body3DComs + i;
+				// A body that has just fallen asleep has its velocity cleared, but the transform still holds the velocity of the last step.
+				// Write the final state back once, otherwise the transform keeps drifting and pushes the drift back into the sleeping body.
+				const bool fellAsleep = body->m_rigidBody && body->m_rigidBody->ConsumeFellAsleep();
+				if (body->IsRBAwake() || fellAsleep)
+				{
+					if (!transform3DComs)
+					{
+						transform3DComs = e.GetComponentPtr<Transform3DCom>();
+					}
+					const auto trans = transform3DComs + i;
+					// Assign simulated rigid body back to transformCom
+					const RBTransform& rbTrans = body->GetRBTrans();
+					trans->SetGlobalPos(rbTrans.m_pos);
+					//trans->SetGlobalRot(rbTrans.m_rot); // Rotation is not implemented in the physics engine
+					trans->SetGlobalVel(body->m_rigidBody->GetLinearVelocity());
+				}
 			}
 		}
 	).wait();
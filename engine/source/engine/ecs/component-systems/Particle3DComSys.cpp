@@ -61,4 +61,10 @@ void Particle3DComSys::LateUpdate(double dt)
 	}
 }
 
-
+BitMaskSignature Particle3DComSys::GetReadSignature() const
+{
+	// Particles follow their transform and face the active camera
+	auto ret = m_systemSignature;
+	ret.AddComponent<Transform3DCom, PerspectiveCameraCom>();
+	return ret;
+}
@@ -19,5 +19,6 @@ namespace longmarch
 		Particle3DComSys();
 		virtual void Update(double dt) override;
 		virtual void LateUpdate(double dt) override;
+		virtual BitMaskSignature GetReadSignature() const override;
 	};
 }
@@ -25,7 +25,7 @@ namespace longmarch
 			ForEach(
 				[dt](EntityDecorator e)
 			{
-				auto trans = e.GetComponent<Transform3DCom>();
+				auto trans = e.GetConstComponent<Transform3DCom>();
 				auto pos = trans->GetGlobalPos();
 				auto rot = trans->GetGlobalRot();
 				auto cam = e.GetComponent<PerspectiveCameraCom>()->GetCamera();
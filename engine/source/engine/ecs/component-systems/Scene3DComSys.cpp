@@ -1,7 +1,7 @@
 #include "engine-precompiled-header.h"
 #include "Scene3DComSys.h"
 #include "engine/ecs/header/header.h"
-#include "engine/core/thread/StealThreadPool.h"
+#include "engine/core/thread/JobSystem.h"
 
 longmarch::Scene3DComSys::Scene3DComSys()
 {
@@ -27,11 +27,11 @@ void longmarch::Scene3DComSys::PreRenderUpdate(double dt)
         {
             auto light = lights[i];
 
-            auto trans = GetComponent<Transform3DCom>(light);
+            auto trans = GetConstComponent<Transform3DCom>(light);
             auto scene = GetComponent<Scene3DCom>(light);
             auto lightCom = GetComponent<LightCom>(light);
 
-            if (trans.Valid() && scene.Valid() && lightCom.Valid())
+            if (trans && scene.Valid() && lightCom.Valid())
             {
                 bool emissive = false;
                 auto sceneDataRef = scene->GetSceneData(false);
@@ -118,7 +118,7 @@ void longmarch::Scene3DComSys::PreRenderUpdate(double dt)
         Mat4 pv = camera_ptr->GetViewProjectionMatrix();
         for (auto& renderObj : Renderer3D::s_Data.cpuBuffer.RENDERABLE_OBJ_TRANSPARENT)
         {
-            auto pos = renderObj.entity.GetComponent<Transform3DCom>()->GetGlobalPos();
+            auto pos = renderObj.entity.GetConstComponent<Transform3DCom>()->GetGlobalPos();
             auto ndc_pos = pv * Vec4f(pos, 1.0f);
             depth_sorted_translucent_obj.emplace(renderObj, ndc_pos.z);
         }
@@ -140,8 +140,8 @@ void longmarch::Scene3DComSys::PreRenderPass()
         LongMarch_ForEach(
             [](const Renderer3D::RenderObj_CPU& renderObj)
             {
-                auto body = renderObj.entity.GetComponent<Body3DCom>();
-                if (body.Valid())
+                auto body = renderObj.entity.GetConstComponent<Body3DCom>();
+                if (body)
                 {
                     if (auto bv = body->GetBoundingVolume(); bv)
                     {
@@ -192,12 +192,11 @@ void longmarch::Scene3DComSys::PrepareScene(double dt)
         parentTrCom->Reset();
         for (const auto child : GetComponent<ChildrenCom>(root)->GetChildren())
         {
-            auto trans = GetComponent<Transform3DCom>(child);
-            trans->SetParentModelTr(parentTrCom->GetSuccessionModelTr(trans));
+            const auto trans = UpdateParentModelTr(child, parentTrCom);
 
             if (auto childrenCom = GetComponent<ChildrenCom>(child).GetPtr(); !childrenCom->IsLeaf())
             {
-                m_threadJobs.push(StealThreadPool::GetInstance()->enqueue_task(
+                m_threadJobs.push(JobSystem::Async(
                         [this, child, trans, childrenCom]()
                         {
                             RecursivePrepareScene(child, trans, childrenCom);
@@ -208,22 +207,33 @@ void longmarch::Scene3DComSys::PrepareScene(double dt)
 
     while (!m_threadJobs.empty())
     {
-        m_threadJobs.pop_front().wait();
+        // Help running the recursive jobs instead of blocking
+        JobSystem::Wait(m_threadJobs.pop_front());
     }
     job.wait();
 }
 
-void longmarch::Scene3DComSys::RecursivePrepareScene(const Entity& parent, Transform3DCom* parentTrCom,
+const longmarch::Transform3DCom* longmarch::Scene3DComSys::UpdateParentModelTr(const Entity& child, const Transform3DCom* parentTrCom)
+{
+    const auto trans = GetConstComponent<Transform3DCom>(child);
+    // Only take mutable access when the parent has moved, so that resting transforms are not marked as changed
+    if (const auto parentTr = parentTrCom->GetSuccessionModelTr(*trans); parentTr != trans->GetParentModelTr())
+    {
+        GetComponent<Transform3DCom>(child)->SetParentModelTr(parentTr);
+    }
+    return trans;
+}
+
+void longmarch::Scene3DComSys::RecursivePrepareScene(const Entity& parent, const Transform3DCom* parentTrCom,
                                                      ChildrenCom* parentChildrenCom)
 {
     for (const auto child : parentChildrenCom->GetChildren())
     {
-        auto trans = GetComponent<Transform3DCom>(child);
-        trans->SetParentModelTr(parentTrCom->GetSuccessionModelTr(trans));
+        const auto trans = UpdateParentModelTr(child, parentTrCom);
 
         if (auto childrenCom = GetComponent<ChildrenCom>(child).GetPtr(); !childrenCom->IsLeaf())
         {
-            m_threadJobs.push(StealThreadPool::GetInstance()->enqueue_task(
+            m_threadJobs.push(JobSystem::Async(
                     [this, child, trans, childrenCom]()
                     {
                         RecursivePrepareScene(child, trans, childrenCom);
@@ -272,10 +282,10 @@ void longmarch::Scene3DComSys::SetRenderShaderName(const std::string& shaderName
 void longmarch::Scene3DComSys::RenderWithModeOpaque(Renderer3D::RenderObj_CPU& renderObj)
 {
     auto scene = renderObj.entity.GetComponent<Scene3DCom>();
-    auto body = renderObj.entity.GetComponent<Body3DCom>();
+    auto body = renderObj.entity.GetConstComponent<Body3DCom>();
 
     scene->SetShaderName(m_RenderShaderName);
-    bool hasBody = body.Valid();
+    bool hasBody = body != nullptr;
 
     if (hasBody)
     {
@@ -320,12 +330,12 @@ void longmarch::Scene3DComSys::RenderWithModeTransparent(Renderer3D::RenderObj_C
 {
     auto particle = renderObj.entity.GetComponent<Particle3DCom>();
     auto scene = renderObj.entity.GetComponent<Scene3DCom>();
-    auto body = renderObj.entity.GetComponent<Body3DCom>();
+    auto body = renderObj.entity.GetConstComponent<Body3DCom>();
 
     scene->SetShaderName(m_RenderShaderName);
     bool isParticle = particle.Valid() && scene->IsParticleRenderType();
 
-    bool hasBody = body.Valid();
+    bool hasBody = body != nullptr;
     if (hasBody)
     {
         if (const auto& bv = body->GetBoundingVolume(); bv)
@@ -388,7 +398,7 @@ void longmarch::Scene3DComSys::RenderWithModeParticle(Renderer3D::RenderObj_CPU&
 {
 }
 
-bool longmarch::Scene3DComSys::ViewFustrumCullingTest(const std::shared_ptr<Shape>& BoudingVolume)
+bool longmarch::Scene3DComSys::ViewFustrumCullingTest(Shape* BoudingVolume)
 {
     if (!m_vfcParam.enableVFCulling)
     {
@@ -400,7 +410,7 @@ bool longmarch::Scene3DComSys::ViewFustrumCullingTest(const std::shared_ptr<Shap
     }
 }
 
-bool longmarch::Scene3DComSys::DistanceCullingTest(const std::shared_ptr<Shape>& BoudingVolume)
+bool longmarch::Scene3DComSys::DistanceCullingTest(Shape* BoudingVolume)
 {
     if (!m_distanceCParam.enableDistanceCulling)
     [[unlikely]]
@@ -28,13 +28,15 @@ namespace longmarch
 
 	private:
 		void PrepareScene(double dt);
-		void RecursivePrepareScene(const Entity& parent, Transform3DCom* parentTrCom, ChildrenCom* parentChildrenCom);
+		void RecursivePrepareScene(const Entity& parent, const Transform3DCom* parentTrCom, ChildrenCom* parentChildrenCom);
+		//! Set the parent transform of the child if it has changed, return the child's transform
+		const Transform3DCom* UpdateParentModelTr(const Entity& child, const Transform3DCom* parentTrCom);
 		void RenderWithModeOpaque(Renderer3D::RenderObj_CPU& renderObj);
 		void RenderWithModeTransparent(Renderer3D::RenderObj_CPU& renderObj);
 		void RenderWithModeParticle(Renderer3D::RenderObj_CPU& renderObj);
 
-		bool ViewFustrumCullingTest(const std::shared_ptr<Shape>& BoudingVolume);
-		bool DistanceCullingTest(const std::shared_ptr<Shape>& BoudingVolume);
+		bool ViewFustrumCullingTest(Shape* BoudingVolume);
+		bool DistanceCullingTest(Shape* BoudingVolume);
 
 	private:
 		struct VFCParam
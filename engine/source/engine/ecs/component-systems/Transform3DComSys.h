@@ -33,10 +33,23 @@ namespace longmarch
         virtual void Update(double dt) override
         {
             EARLY_RETURN(dt);
-            ParEach(
-                [dt](EntityDecorator e)
+            ParEachChunk(
+                [dt](const EntityChunkContext& e)
                 {
-                    e.GetComponent<Transform3DCom>()->Update(dt);
+                    const auto constTransform3DComs = e.GetConstComponentPtr<Transform3DCom>();
+                    // Only take mutable access to chunks that have moving transforms, so that resting chunks are not marked as changed
+                    Transform3DCom* transform3DComs = nullptr;
+                    for (auto i = e.BeginIndex(); i <= e.EndIndex(); ++i)
+                    {
+                        if (!(constTransform3DComs + i)->IsStationary())
+                        {
+                            if (!transform3DComs)
+                            {
+                                transform3DComs = e.GetComponentPtr<Transform3DCom>();
+                            }
+                            (transform3DComs + i)->Update(dt);
+                        }
+                    }
                 }
             ).wait();
         }
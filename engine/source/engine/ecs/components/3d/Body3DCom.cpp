@@ -8,10 +8,10 @@ longmarch::Body3DCom::Body3DCom(const Entity& e)
 {
 }
 
-const std::shared_ptr<Shape>& longmarch::Body3DCom::GetBoundingVolume() const
+longmarch::Shape* longmarch::Body3DCom::GetBoundingVolume() const
 {
 	LOCK_GUARD();
-	return m_boundingVolume;
+	return m_boundingVolume.get();
 }
 
 bool longmarch::Body3DCom::HasRigidBody() const
@@ -30,7 +30,7 @@ RBType longmarch::Body3DCom::GetRigidBodyType() const
 	return RBType::EMPTY;
 }
 
-void longmarch::Body3DCom::AssignRigidBody(const std::shared_ptr<RigidBody>& rb)
+void longmarch::Body3DCom::AssignRigidBody(const RefPtr<RigidBody>& rb)
 {
 	LOCK_GUARD();
 	m_rigidBody = rb;
@@ -37,13 +37,13 @@ namespace longmarch
 			m_boundingVolume = MemoryManager::Make_shared<Shape>(args...);
 		}
 
-		const std::shared_ptr<Shape>& GetBoundingVolume() const;
+		Shape* GetBoundingVolume() const;
 
 		//void Integrate(float dt);
 		bool HasRigidBody() const;
 		RBType GetRigidBodyType() const;
 
-		void AssignRigidBody(const std::shared_ptr<RigidBody>& rb);
+		void AssignRigidBody(const RefPtr<RigidBody>& rb);
 		void UnassignRigidBody();
 
 		// function to update the corresponding rigid body using Body3DCom data
@@ -70,7 +70,7 @@ namespace longmarch
 		std::shared_ptr<Shape> m_boundingVolume{ nullptr }; //!< For view frustum culling
 
 		// Physics body variable
-		std::shared_ptr<RigidBody> m_rigidBody{ nullptr };
+		RefPtr<RigidBody> m_rigidBody{ nullptr };
 		RigidBodyInfo m_rigidBodyInfo;
 	};
 }
@@ -170,7 +170,7 @@ void longmarch::Scene3DCom::Draw()
 		LOCK_GUARD();
 		if (m_shoudlDraw && m_objDatasRef)
 		{
-			const auto trans = EntityDecorator{ m_this , m_world }.GetComponent<Transform3DCom>();
+			const auto trans = EntityDecorator{ m_this , m_world }.GetConstComponent<Transform3DCom>();
 			const auto& shaderName = m_shaderName;
 			Renderer3D::Draw(m_this, m_objDatasRef, trans->GetModelTr(), trans->GetPrevModelTr(), shaderName);
 		}
@@ -186,7 +186,7 @@ void longmarch::Scene3DCom::Draw(const std::function<void(const Renderer3D::Rend
 		LOCK_GUARD();
 		if (m_shoudlDraw && m_objDatasRef)
 		{
-			auto trans = EntityDecorator{ m_this , m_world }.GetComponent<Transform3DCom>();
+			const auto trans = EntityDecorator{ m_this , m_world }.GetConstComponent<Transform3DCom>();
 			const auto& _sceneData = *m_objDatasRef;
 			for (const auto& [level, data] : _sceneData)
 			{
@@ -33,6 +33,15 @@ void longmarch::Transform3DCom::Update(double ts)
 	}
 }
 
+bool longmarch::Transform3DCom::IsStationary() const
+{
+	LOCK_GUARD();
+	const auto zero = Vec3f(0.0f);
+	return rtp_velocity == zero && l_velocity == zero && rtp_rotational_velocity == zero && l_rotational_velocity == zero &&
+		g_total_velocity == zero && g_rotational_velocity == zero &&
+		parentTr == prev_parentTr && rtp_pos == prev_rtp_pos && rtp_rotation == prev_rtp_rotation;
+}
+
 void longmarch::Transform3DCom::SetModelTr(const Mat4& m)
 {
 	const auto rtp_trans = Geommath::SmartInverse(parentTr) * m;
@@ -91,6 +100,12 @@ void longmarch::Transform3DCom::SetParentModelTr(const Mat4& m)
 	parentTr = m;
 }
 
+Mat4 longmarch::Transform3DCom::GetParentModelTr() const
+{
+	LOCK_GUARD();
+	return parentTr;
+}
+
 void longmarch::Transform3DCom::ResetParentModelTr()
 {
 	LOCK_GUARD();
@@ -164,7 +179,7 @@ void longmarch::Transform3DCom::SetGlobalPos(const Vec3f& v)
 	rtp_pos = Geommath::GetRotation(parentTr) * Geommath::GetScale(parentTr) * (v - Geommath::GetTranslation(parentTr));
 }
 
-Vec3f longmarch::Transform3DCom::GetGlobalPos()
+Vec3f longmarch::Transform3DCom::GetGlobalPos() const
 {
 	LOCK_GUARD();
 	return Geommath::GetTranslation(parentTr) + Geommath::GetRotation(parentTr) * Geommath::GetScale(parentTr) * rtp_pos;
@@ -218,7 +233,7 @@ void longmarch::Transform3DCom::SetGlobalVel(const Vec3f& v)
 	rtp_velocity = (v - g_total_velocity) * Geommath::GetRotation(parentTr);
 }
 
-Vec3f longmarch::Transform3DCom::GetGlobalVel()
+Vec3f longmarch::Transform3DCom::GetGlobalVel() const
 {
 	LOCK_GUARD();
 	return g_total_velocity + Geommath::GetRotation(parentTr) * rtp_velocity;
@@ -272,7 +287,7 @@ void longmarch::Transform3DCom::SetGlobalRot(const Quaternion& r)
 	rtp_rotation = Geommath::QuatProd(Geommath::Conjugate(Geommath::GetRotation(parentTr)), r);
 }
 
-Quaternion longmarch::Transform3DCom::GetGlobalRot()
+Quaternion longmarch::Transform3DCom::GetGlobalRot() const
 {
 	LOCK_GUARD();
 	return Geommath::QuatProd(Geommath::GetRotation(parentTr), rtp_rotation);
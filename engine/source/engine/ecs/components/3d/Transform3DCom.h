@@ -12,6 +12,8 @@ namespace longmarch
         explicit Transform3DCom(const EntityDecorator& _this);
 
         void Update(double ts);
+        //! True if Update() would not change anything, i.e. the transform has no velocity and its parent has not moved
+        bool IsStationary() const;
 
         //! Set Global Transformation
         void SetModelTr(const Mat4& m);
@@ -31,6 +33,8 @@ namespace longmarch
 
         //! Set parent
         void SetParentModelTr(const Mat4& m);
+        //! Get parent
+        Mat4 GetParentModelTr() const;
         //! Remember to reset parent model transformation on removing a parent entity
         void ResetParentModelTr();
 
@@ -66,7 +70,7 @@ namespace longmarch
         //! Set position relative to origin (root) 's frame
         void SetGlobalPos(const Vec3f& v);
         //! Get position relative to origin (root) 's frame
-        Vec3f GetGlobalPos();
+        Vec3f GetGlobalPos() const;
         //! Get position relative to origin in the previous frame
         Vec3f GetPrevGlobalPos();
 
@@ -86,7 +90,7 @@ namespace longmarch
         //! Set velocity relative to origin (root) 's frame
         void SetGlobalVel(const Vec3f& v);
         //! Get velocity relative to origin (root) 's frame
-        Vec3f GetGlobalVel();
+        Vec3f GetGlobalVel() const;
         //! Add velocity relative to parent entity parent 's frame
         void AddRelativeToParentVel(const Vec3f& v);
         //! Set velocity relative to parent entity parent 's frame
@@ -111,7 +115,7 @@ namespace longmarch
         //! Set rotation local coordinate
         void SetGlobalRot(const Quaternion& r);
         //! Get rotation local coordinate
-        Quaternion GetGlobalRot();
+        Quaternion GetGlobalRot() const;
         //! Get rotation local coordinate of the previous frame
         Quaternion GetPrevGlobalRot();
 
@@ -21,13 +21,13 @@ void longmarch::IDNameCom::SetName(const std::string& name)
 std::string longmarch::IDNameCom::GetName()
 {
 	LOCK_GUARD();
-	return m_name;
+	return std::string(m_name);
 }
 
 std::string longmarch::IDNameCom::GetUniqueName()
 {
 	LOCK_GUARD();
-	return Str(m_this) + "_" + m_name;
+	return Str(m_this).append("_").append(m_name);
 }
 
 Entity longmarch::IDNameCom::GetEntity()
@@ -47,7 +47,7 @@ void longmarch::IDNameCom::JsonSerialize(Json::Value& value) const
 
 		if (m_name != _default.m_name)
 		{
-			val["name"] = m_name;
+			val["name"] = m_name.c_str();
 		}
 		{
 			value.append(std::move(output));
@@ -22,6 +22,6 @@ namespace longmarch
 		
 	private:
 		Entity m_this;
-		std::string m_name{ "" };
+		LongMarch_String m_name{ "" };
 	};
 }
@@ -8,20 +8,24 @@ namespace longmarch
 	/**
 	 * @brief Base class event callback
 	 *
+	 * @details Typed by the event type of the queue so that publishing does not cast the event pointer for every handler,
+	 *			each handler costs exactly one reference count for the by value argument of the callback.
+	 *
 	 * @author Dushyant Shukla (dushyant.shukla@digipen.edu | 60000519), Hang Yu (yohan680919@gmail.com)
 	 */
+	template<typename EventType>
 	class BaseEventHandler
 	{
 	public:
 		NONCOPYABLE(BaseEventHandler);
 		BaseEventHandler() = default;
 		virtual ~BaseEventHandler() = default;
-		void Execute(const std::shared_ptr<BaseEvent>& event)
+		void Execute(const std::shared_ptr<Event<EventType>>& event)
 		{
 			return HandleEvent(event);
 		}
 	protected:
-		virtual void HandleEvent(const std::shared_ptr<BaseEvent>& event) = 0;
+		virtual void HandleEvent(const std::shared_ptr<Event<EventType>>& event) = 0;
 	};
 
 	/**
@@ -30,7 +34,7 @@ namespace longmarch
 	 * @author Dushyant Shukla (dushyant.shukla@digipen.edu | 60000519), Hang Yu (yohan680919@gmail.com)
 	 */
 	template<typename T, typename EventType>
-	class InstanceEventHandler final : public BaseEventHandler
+	class InstanceEventHandler final : public BaseEventHandler<EventType>
 	{
 	public:
 		typedef void (T::* InstanceHandlerFunction) (std::shared_ptr<Event<EventType>>);
@@ -42,20 +46,9 @@ namespace longmarch
 			m_handler(function)
 		{}
 
-		virtual void HandleEvent(const std::shared_ptr<BaseEvent>& event)
+		virtual void HandleEvent(const std::shared_ptr<Event<EventType>>& event) override
 		{
-#ifndef _SHIPPING
-			if (auto ptr = std::dynamic_pointer_cast<Event<EventType>>(event); ptr)
-			{
-				(m_handlerOwner->*m_handler)(ptr);
-			}
-			else
-			{
-				ENGINE_EXCEPT(L"Can not cast event to : " + wStr(typeid(Event<EventType>).name()));
-			}
-#else
-			(m_handlerOwner->*m_handler)(std::static_pointer_cast<Event<EventType>>(event));
-#endif // _SHIPPING
+			(m_handlerOwner->*m_handler)(event);
 		}
 
 	private:
@@ -69,7 +62,7 @@ namespace longmarch
 	 * @author Dushyant Shukla (dushyant.shukla@digipen.edu | 60000519), Hang Yu (yohan680919@gmail.com)
 	 */
 	template<typename EventType>
-	class GlobalEventHandler final : public BaseEventHandler
+	class GlobalEventHandler final : public BaseEventHandler<EventType>
 	{
 	public:
 		typedef void (*GlobalHandlerFunction) (std::shared_ptr<Event<EventType>>);
@@ -80,20 +73,9 @@ namespace longmarch
 			m_handler(function)
 		{}
 
-		virtual void HandleEvent(const std::shared_ptr<BaseEvent>& event)
+		virtual void HandleEvent(const std::shared_ptr<Event<EventType>>& event) override
 		{
-#ifndef _SHIPPING
-			if (auto ptr = std::dynamic_pointer_cast<Event<EventType>>(event); ptr)
-			{
-				(*m_handler)(ptr);
-			}
-			else
-			{
-				ENGINE_EXCEPT(L"Can not cast event to : " + wStr(typeid(Event<EventType>).name()));
-			}
-#else
-			(*m_handler)(std::static_pointer_cast<Event<EventType>>(event));
-#endif // DEBUG
+			(*m_handler)(event);
 		}
 
 	private:
@@ -3,8 +3,11 @@
 #include "engine/EngineEssential.h"
 #include "engine/core/thread/Scheduler.h"
 #include "engine/core/thread/StealThreadPool.h"
+#include "engine/core/thread/Queue.h"
 #include "EventHandler.h"
 
+#include <span>
+
 namespace longmarch
 {
 #define THROW_ON_DUPLICATED_EVENT_CALLBACk 1
@@ -24,6 +27,11 @@ namespace longmarch
 	/**
 	 * @brief Base class event queue
 	 *
+	 * @details Publish delivers right away, PublishBatch delivers many events with one subscriber lookup per event type,
+	 *			PublishDeferred and Publish with a delay of zero queue the event into a lock-free ring buffer that is drained by Update() once per frame,
+	 *			and async events are delivered by jobs of the job system. Prefer PublishBatch or PublishDeferred for events that are published by the thousands,
+	 *			and create them with TemplateMemoryManager<E>::Make_shared_pooled so that each event and its control block take one block of the pool of its type.
+	 *
 	 * @author Dushyant Shukla (dushyant.shukla@digipen.edu | 60000519), Hang Yu (yohan680919@gmail.com)
 	 */
 	template <typename EventType>
@@ -49,7 +57,7 @@ namespace longmarch
 			m_eventsAsyncUpdateHandle->signal();
 		}
 
-		using BaseEventPtr = std::shared_ptr<BaseEventHandler>;
+		using BaseEventPtr = std::shared_ptr<BaseEventHandler<EventType>>;
 		using EventHandlersMap = LongMarch_UnorderedMap<size_t, BaseEventPtr>;
 		struct EventHandlers final : public BaseAtomicClass
 		{
@@ -57,26 +65,22 @@ namespace longmarch
 			auto end() const { return handlersMap.end(); }
 			EventHandlersMap handlersMap;
 		};
-		using EventSubsriberLUT = LongMarch_UnorderedMap_Par_node<EventType, EventHandlers>;
+		//! Handlers are shared so that a delivery in flight keeps them alive even if Clear() erases them in the meantime
+		using EventHandlersPtr = std::shared_ptr<EventHandlers>;
+		using EventSubsriberLUT = LongMarch_UnorderedMap_Par_node<EventType, EventHandlersPtr>;
 
-		//! Internal type that convert a regular event into a delayed event
-		struct DelayedEvent : Event<EventType> {
-			DelayedEvent() = default;
-			explicit DelayedEvent(EventPtr e, double delayTime)
-				:
-				m_event(e), m_triggerTime(delayTime)
-			{}
+		//! Delayed event, the delay counts down by the frame time of Update() or UpdateAsync()
+		struct DelayedEvent_T
+		{
 			EventPtr m_event;
 			double m_triggerTime;
+			//! Publishing order that breaks ties of trigger time
+			uint64_t m_order;
 		};
+		using DelayedEvents = LongMarch_Vector<DelayedEvent_T>;
 
-		using DelayedEventPtr = std::shared_ptr<DelayedEvent>;	// Define delayed event smart pointer type
-		struct DelayedEventComparator {
-			bool operator() (const DelayedEventPtr& event1, const DelayedEventPtr& event2) {
-				return event1->m_triggerTime > event2->m_triggerTime;
-			}
-		};
-		using delayed_queue = std::priority_queue<DelayedEventPtr, std::vector<DelayedEventPtr>, DelayedEventComparator>;
+		//! Slots of the ring buffer of deferred events
+		constexpr inline static size_t kDeferredEventCapacity = {1u << 12};
 
 	public:
 		struct EventSubHandle final : public BaseEventSubHandle
@@ -95,9 +99,9 @@ namespace longmarch
 				m_ptr->LockNC();
 				if (auto it = m_ptr->m_subscribers.find(m_type); it != m_ptr->m_subscribers.end())
 				{
-					it->second.Lock();
-					it->second.handlersMap.erase(m_mask);
-					it->second.UnLock();
+					it->second->Lock();
+					it->second->handlersMap.erase(m_mask);
+					it->second->UnLock();
 				}
 				m_ptr->UnLockNC();
 			}
@@ -116,7 +120,7 @@ namespace longmarch
 			size_t mask = 0;
 			LongMarch_HashCombine(mask, reinterpret_cast<uintptr_t>(&Function));
 			LongMarch_HashCombine(mask, reinterpret_cast<uintptr_t>(instance));
-			auto& subs = m_subscribers[eventType];
+			auto& subs = _GetOrCreateSubscribers(eventType);
 			subs.Lock();
 			if (!LongMarch_contains(subs.handlersMap, mask))
 			{
@@ -140,7 +144,7 @@ namespace longmarch
 		{
 			LOCK_GUARD_NC();
 			size_t mask = reinterpret_cast<size_t>(&Function);
-			auto& subs = m_subscribers[eventType];
+			auto& subs = _GetOrCreateSubscribers(eventType);
 			subs.Lock();
 			if (!LongMarch_contains(subs.handlersMap, mask))
 			{
@@ -160,79 +164,69 @@ namespace longmarch
 		}
 
 		//! Intantieous execution of a synchronous event
-		inline void Publish(EventPtr e)
+		inline void Publish(const EventPtr& e)
 		{
-			auto _e = std::static_pointer_cast<BaseEvent>(e);
-			LockNC();
-			auto it = m_subscribers.find(e->m_type);
-			if (it == m_subscribers.end())
+			if (auto subs = _GetSubscribers(e->m_type); subs)
 			{
-				UnLockNC();
-#if THROW_ON_UNREGISTERED_EVENT_CALLBACk == 0			
-				ENGINE_WARN("Event with type " + (Str(e->m_type)) + " is not registered in the event queue of type: " + (typeid(EventType).name()));
-				return;
-#else
-				ENGINE_EXCEPT(L"Event with type " + wStr(Str(e->m_type)) + L" is not registered in the event queue of type: " + wStr(typeid(EventType).name()));
-				return;
-#endif
+				subs->Lock();
+				_Deliver(*subs, e);
+				subs->UnLock();
 			}
-			auto& subs = it->second;
-			UnLockNC();
-			subs.Lock();
-			for (auto& [_, handler] : subs)
+		}
+
+		//! Intantieous execution of a batch of synchronous events, subscribers are looked up and locked once per run of events of the same type
+		inline void PublishBatch(std::span<const EventPtr> events)
+		{
+			_PublishBatch(events, false);
+		}
+
+		//! Execution of a synchronous event in a batch by the next Update(), publishing only takes a slot of a lock-free ring buffer
+		inline void PublishDeferred(EventPtr e)
+		{
+			if (!m_deferredEvents.try_push(std::move(e)))
+			[[unlikely]]
 			{
-				if (handler != nullptr)
-				{
-					handler->Execute(_e);
-				}
+				LOCK_GUARD_NC();
+				m_deferredOverflow.emplace_back(std::move(e));
 			}
-			subs.UnLock();
 		}
 
-		//! Instanct execution of an async event in a background thread
+		//! Instanct execution of an async event by a job of the job system
 		inline void PublishAsync(EventPtr e)
 		{
-			LongMarch_UseDeamonThreadWaitAsyncJob(std::async(std::launch::async, [this, e]()
+			StealThreadPool::GetInstance()->enqueue_work([this, e = std::move(e)]()
 			{
-				auto& _e = std::static_pointer_cast<BaseEvent>(e);
-				LockNC();
-				auto& it = m_subscribers.find(e->m_type);
-				ENGINE_EXCEPT_IF(it == m_subscribers.end(), L"Event with type " + wStr(Str(e->m_type)) + L" is not registered in the event queue of type: " + wStr(typeid(EventType).name()));
-				auto& subs = it->second;
-				UnLockNC();
-				subs.Lock();
-				for (auto& [_, handler] : subs)
-				{
-					if (handler)
-					{
-						handler->Execute(_e);
-					}
-				}
-				subs.UnLock();
-			}));
+				Publish(e);
+			});
 		}
 
-		//! Delayed execution of a synchronous event
+		//! Delayed execution of a synchronous event, an event without delay is executed by the next Update() like PublishDeferred
 		inline void Publish(EventPtr event, const double delay) {
+			if (delay <= 0.0)
+			{
+				PublishDeferred(std::move(event));
+				return;
+			}
 			LOCK_GUARD_NC();
-			DelayedEventPtr delayedEvent = MemoryManager::Make_shared<DelayedEvent>(event, delay);
-			m_events.emplace(std::move(delayedEvent));
+			m_events.emplace_back(DelayedEvent_T{ std::move(event), delay, m_delayedEventOrder++ });
 		}
 
-		//! Delayed execution of an delayed async event in a background thread
+		//! Delayed execution of an delayed async event by a job of the job system
 		inline void PublishAsync(EventPtr event, const double delay) {
 			LOCK_GUARD_NC();
-			DelayedEventPtr delayedEvent = MemoryManager::Make_shared<DelayedEvent>(event, delay);
-			m_eventsAsync.emplace(std::move(delayedEvent));
+			m_eventsAsync.emplace_back(DelayedEvent_T{ std::move(event), delay, m_delayedEventOrder++ });
 		}
 
-		//! Clear all delayed events and subscribers
+		//! Clear all delayed events and subscribers, deliveries in flight (e.g. by PublishAsync) finish with the handlers they have started with
 		inline void Clear()
 		{
 			LOCK_GUARD_NC();
-			// Reset with empty queue
-			m_events = std::move(delayed_queue());
-			m_eventsAsync = std::move(delayed_queue());
+			m_events.clear();
+			m_eventsAsync.clear();
+			for (EventPtr e; m_deferredEvents.try_pop(e);)
+			{
+			}
+			m_deferredOverflow.clear();
 			m_subscribers.clear();
 			m_bDelayedEventShouldBeCleared = true;
 		}
@@ -241,56 +235,44 @@ namespace longmarch
 		inline void RemoveDelayedEvent(EventType type)
 		{
 			LOCK_GUARD_NC();
+			std::erase_if(m_events, [type](const DelayedEvent_T& d) { return d.m_event->m_type == type; });
+			std::erase_if(m_eventsAsync, [type](const DelayedEvent_T& d) { return d.m_event->m_type == type; });
+			// Deferred events are delayed events without delay, keep the others in order
+			LongMarch_Vector<EventPtr> kept;
+			for (EventPtr e; m_deferredEvents.try_pop(e);)
 			{
-				std::vector<DelayedEventPtr> temp_events;
-				temp_events.reserve(m_events.size());
-				while (!m_events.empty())
+				if (!(e->m_type == type))
 				{
-					if (DelayedEventPtr delayedEvent = m_events.top();
-						!(delayedEvent->m_event->m_type == type))
-					{
-						temp_events.emplace_back(delayedEvent);
-					}
-					m_events.pop();
-				}
-				for (auto event : temp_events)
-				{
-					m_events.emplace(event);
+					kept.emplace_back(std::move(e));
 				}
 			}
+			for (auto& e : kept)
 			{
-				std::vector<DelayedEventPtr> temp_events;
-				temp_events.reserve(m_eventsAsync.size());
-				while (!m_eventsAsync.empty())
+				if (!m_deferredEvents.try_push(std::move(e)))
 				{
-					if (DelayedEventPtr delayedEvent = m_eventsAsync.top();
-						!(delayedEvent->m_event->m_type == type))
-					{
-						temp_events.emplace_back(delayedEvent);
-					}
-					m_eventsAsync.pop();
-				}
-				for (auto event : temp_events)
-				{
-					m_eventsAsync.emplace(event);
+					m_deferredOverflow.emplace_back(std::move(e));
 				}
 			}
+			std::erase_if(m_deferredOverflow, [type](const EventPtr& e) { return e->m_type == type; });
 		}
 
-		//! Update synchronous delayed event
+		//! Deliver deferred events and delayed events that are due in one batch, called once per frame by the main thread
 		inline void Update(double frameTime)
 		{
-			delayed_queue events_temp;
+			auto& batch = m_batch;
 			{
 				LOCK_GUARD_NC();
-				if (m_events.empty())
+				for (EventPtr e; m_deferredEvents.try_pop(e);)
 				{
-					return;
+					batch.emplace_back(std::move(e));
 				}
-				// Make a deep copy
-				events_temp = m_events;
-				// Clear the original queue
-				m_events = std::move(delayed_queue());
+				std::move(m_deferredOverflow.begin(), m_deferredOverflow.end(), std::back_inserter(batch));
+				m_deferredOverflow.clear();
+				_CollectDueEvents(m_events, frameTime, batch);
+			}
+			if (batch.empty())
+			{
+				return;
 			}
 			/*
 				A few delayed event might call Clear() function such that all remaining delayed event
@@ -298,78 +280,146 @@ namespace longmarch
 				been set.
 			*/
 			m_bDelayedEventShouldBeCleared = false;
-			while (!events_temp.empty() && !m_bDelayedEventShouldBeCleared)
-			{
-				DelayedEventPtr delayedEvent = events_temp.top();
-				events_temp.pop();
-				/*
-					Since the priority queue mimic min-heap, event at the top has the lowest trigger-time.
-					If the current system-time is not greater than the trigger-time of element at the top,
-					program counter will come out of the loop. Otherwise, the system will keep publishing
-					events.
-				*/
-				if ((delayedEvent->m_triggerTime -= frameTime) <= 0)
-				{
-					Publish(delayedEvent->m_event);
-				}
-				else
-				{
-					LOCK_GUARD_NC();
-					m_events.emplace(delayedEvent);
-				}
-			}
+			_PublishBatch(batch, true);
+			// Release the events but keep the capacity for the next frame
+			batch.clear();
 		}
 
 	private:
-		//! Update async delayed event
+		//! Update async delayed event, the scheduler already runs it as a job so events that are due are delivered in place
 		inline void UpdateAsync(double frameTime)
 		{
-			delayed_queue events_temp;
+			LongMarch_Vector<EventPtr> batch;
 			{
 				LOCK_GUARD_NC();
 				if (m_eventsAsync.empty())
 				{
 					return;
 				}
-				// Make a deep copy
-				events_temp = m_eventsAsync;
-				// Clear the original queue
-				m_eventsAsync = std::move(delayed_queue());
+				_CollectDueEvents(m_eventsAsync, frameTime, batch);
 			}
-			/*
-				A few delayed event might call Clear() function such that all remaining delayed event
-				should not be called. We will need to check if m_bDelayedEventShouldBeCleared has
-				been set.
-			*/
-			m_bDelayedEventShouldBeCleared = false;
-			while (!events_temp.empty() && !m_bDelayedEventShouldBeCleared)
+			if (!batch.empty())
+			{
+				PublishBatch(batch);
+			}
+		}
+
+		//! Count down delayed events, move those that are due to out in order of trigger time. Lock before calling.
+		inline void _CollectDueEvents(DelayedEvents& events, double frameTime, LongMarch_Vector<EventPtr>& out)
+		{
+			auto& due = m_dueEvents;
+			due.clear();
+			size_t kept = 0;
+			for (auto& d : events)
 			{
-				DelayedEventPtr delayedEvent = events_temp.top();
-				events_temp.pop();
-				/*
-					Since the priority queue mimic min-heap, event at the top has the lowest trigger-time.
-					If the current system-time is not greater than the trigger-time of element at the top,
-					program counter will come out of the loop. Otherwise, the system will keep publishing
-					events.
-				*/
-				if ((delayedEvent->m_triggerTime -= frameTime) <= 0)
+				if ((d.m_triggerTime -= frameTime) <= 0)
 				{
-					LongMarch_UseDeamonThreadWaitAsyncJob(std::async(std::launch::async, [this, delayedEvent]() { Publish(delayedEvent->m_event); }));
+					due.emplace_back(std::move(d));
 				}
 				else
 				{
-					LOCK_GUARD_NC();
-					m_eventsAsync.emplace(delayedEvent);
+					if (&events[kept] != &d)
+					{
+						events[kept] = std::move(d);
+					}
+					++kept;
+				}
+			}
+			events.erase(events.begin() + kept, events.end());
+			// The lowest trigger time comes first, ties are broken by publishing order
+			std::sort(due.begin(), due.end(), [](const DelayedEvent_T& a, const DelayedEvent_T& b)
+			{
+				return (a.m_triggerTime < b.m_triggerTime) || (a.m_triggerTime == b.m_triggerTime && a.m_order < b.m_order);
+			});
+			for (auto& d : due)
+			{
+				out.emplace_back(std::move(d.m_event));
+			}
+			due.clear();
+		}
+
+		inline void _PublishBatch(std::span<const EventPtr> events, bool stopOnClear)
+		{
+			for (size_t first = 0; first < events.size();)
+			{
+				const auto type = events[first]->m_type;
+				auto last = first + 1;
+				while (last < events.size() && events[last]->m_type == type)
+				{
+					++last;
+				}
+				if (auto subs = _GetSubscribers(type); subs)
+				{
+					subs->Lock();
+					for (auto i = first; i < last; ++i)
+					{
+						if (stopOnClear && m_bDelayedEventShouldBeCleared)
+						[[unlikely]]
+						{
+							subs->UnLock();
+							return;
+						}
+						_Deliver(*subs, events[i]);
+					}
+					subs->UnLock();
+				}
+				first = last;
+			}
+		}
+
+		//! Lock before calling
+		inline EventHandlers& _GetOrCreateSubscribers(EventType type)
+		{
+			auto& subs = m_subscribers[type];
+			if (!subs)
+			{
+				subs = MemoryManager::Make_shared<EventHandlers>();
+			}
+			return *subs;
+		}
+
+		//! Return nullptr if the event type has never been subscribed, the caller shares ownership of the handlers while delivering
+		inline EventHandlersPtr _GetSubscribers(EventType type)
+		{
+			LOCK_GUARD_NC();
+			auto it = m_subscribers.find(type);
+			if (it == m_subscribers.end())
+			{
+#if THROW_ON_UNREGISTERED_EVENT_CALLBACk == 0			
+				ENGINE_WARN("Event with type " + (Str(type)) + " is not registered in the event queue of type: " + (typeid(EventType).name()));
+				return nullptr;
+#else
+				ENGINE_EXCEPT(L"Event with type " + wStr(Str(type)) + L" is not registered in the event queue of type: " + wStr(typeid(EventType).name()));
+				return nullptr;
+#endif
+			}
+			return it->second;
+		}
+
+		inline static void _Deliver(const EventHandlers& subs, const EventPtr& e)
+		{
+			for (auto& [_, handler] : subs)
+			{
+				if (handler != nullptr)
+				{
+					handler->Execute(e);
 				}
 			}
 		}
 
 	private:
 		EventSubsriberLUT m_subscribers;
-		delayed_queue m_events;
-		delayed_queue m_eventsAsync;
+		//! Deferred events, a producer that finds the ring buffer full appends to the overflow list under the lock
+		MpscRingBuffer<EventPtr> m_deferredEvents{ kDeferredEventCapacity };
+		LongMarch_Vector<EventPtr> m_deferredOverflow;
+		DelayedEvents m_events;
+		DelayedEvents m_eventsAsync;
+		//! Scratch buffers that keep their capacity so that a steady state frame does not allocate, m_batch is only used by Update()
+		DelayedEvents m_dueEvents;
+		LongMarch_Vector<EventPtr> m_batch;
+		uint64_t m_delayedEventOrder{ 0 };
 		Scheduler::SchedulerHandle m_eventsAsyncUpdateHandle { nullptr };
-		bool m_bDelayedEventShouldBeCleared { false };
+		std::atomic_bool m_bDelayedEventShouldBeCleared { false };
 	};
 	/**
 	 * @brief Base class event subscriber helper class
@@ -83,7 +83,7 @@ namespace longmarch
 			m_gameworld(world)
 		{
 		}
-		std::string m_filepath;
+		LongMarch_String m_filepath;
 		void* m_gameworld;
 	};
 
@@ -95,7 +95,7 @@ namespace longmarch
 			m_gameworld(world)
 		{
 		}
-		std::string m_filepath;
+		LongMarch_String m_filepath;
 		void* m_gameworld;
 	};
 
@@ -107,7 +107,7 @@ namespace longmarch
 			m_gameworld(world)
 		{
 		}
-		std::string m_filepath;
+		LongMarch_String m_filepath;
 		void* m_gameworld;
 	};
 
@@ -119,7 +119,7 @@ namespace longmarch
 			m_makeCurrent(makeCurrent)
 		{
 		}
-		std::string m_filepath;
+		LongMarch_String m_filepath;
 		bool m_makeCurrent;
 	};
 
@@ -131,7 +131,7 @@ namespace longmarch
 			m_makeCurrent(makeCurrent)
 		{
 		}
-		std::string m_filepath;
+		LongMarch_String m_filepath;
 		bool m_makeCurrent;
 	};
 
@@ -143,7 +143,7 @@ namespace longmarch
 			m_makeCurrent(makeCurrent)
 		{
 		}
-		std::string m_filepath;
+		LongMarch_String m_filepath;
 		bool m_makeCurrent;
 	};
 
@@ -187,7 +187,7 @@ namespace longmarch
 		{
 		}
 		bool m_enable;
-		std::string m_currentEnvMap;
+		LongMarch_String m_currentEnvMap;
 	};
 
 	struct ToggleShadowEvent : public Event<EngineGraphicsDebugEventType> {
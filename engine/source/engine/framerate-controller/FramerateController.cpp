@@ -2,6 +2,7 @@
 #include "FramerateController.h"
 #include "engine/core/profiling/InstrumentorCore.h"
 #include "engine/core/utility/Timer.h"
+#include "engine/core/allocator/FrameArena.h"
 
 #if defined(WIN32) || defined(WINDOWS_APP)
 #include <timeapi.h>
@@ -34,6 +35,8 @@ namespace longmarch
     void FramerateController::FrameStart()
     {
         m_timer.Reset();
+        // Release frame memory of two frames ago
+        FrameArena::FrameStart();
     }
 
     void FramerateController::FrameEnd()
@@ -75,6 +78,7 @@ namespace longmarch
         Instrumentor::GetEngineInstance()->AddInstrumentorResult({"FPS", 1.0 / m_frameTimeSec, "  "});
         Instrumentor::GetApplicationInstance()->AddInstrumentorResult({"Frame Time", m_tickEnd, "ms"});
         Instrumentor::GetApplicationInstance()->AddInstrumentorResult({"FPS", 1.0 / m_frameTimeSec, "  "});
+        PROFILE_COUNTER("Frame Time", m_tickEnd);
 #endif
 
         // 3. busy wait
@@ -343,7 +343,7 @@ namespace longmarch
 		return false;
 	}
 
-	bool longmarch::StaticCirclevsCircle(const std::shared_ptr<Circle>& circle1, const std::shared_ptr<Circle>& circle2)
+	bool longmarch::StaticCirclevsCircle(Circle* circle1, Circle* circle2)
 	{
 		// if squared distance between both circles is less than the squared combined radius of both circles, there is collision
 		if (glm::length2(circle2->GetCenter() - circle1->GetCenter()) <
@@ -353,8 +353,8 @@ namespace longmarch
 		return false;
 	}
 
-	bool longmarch::DynamicCirclevsCircle(const std::shared_ptr<Circle>& circle1, const Vec3f& Vel1,
-		const std::shared_ptr<Circle>& circle2, const Vec3f& Vel2,
+	bool longmarch::DynamicCirclevsCircle(Circle* circle1, const Vec3f& Vel1,
+		Circle* circle2, const Vec3f& Vel2,
 		float dt, Manifold& manifold)
 	{
 		// exit early if both are already overlapping
@@ -367,6 +367,7 @@ namespace longmarch
 
 			manifold.m_normal = glm::normalize(circle2->GetCenter() - circle1->GetCenter());
 			manifold.m_contact.m_penetration = circle1->GetRadius() + circle2->GetRadius() - glm::length(circle2->GetCenter() - circle1->GetCenter());
+			manifold.m_staticCollision = true;
 
 			return true;
 		}
@@ -421,11 +422,14 @@ namespace longmarch
 		manifold.m_intersectTime = timeToIntersect;
 
 		manifold.m_normal = glm::normalize(circle1->GetCenter() - circle2->GetCenter() + rayVel * timeToIntersect);
+		// negative penetration is the gap the bodies close within dt
+		manifold.m_contact.m_penetration = circRad - glm::length(rayToSphere);
+		manifold.m_staticCollision = false;
 
 		return true;
 	}
 
-	bool longmarch::StaticAABBvsAABB(const std::shared_ptr<AABB>& AABB1, const std::shared_ptr<AABB>& AABB2)
+	bool longmarch::StaticAABBvsAABB(AABB* AABB1, AABB* AABB2)
 	{
 		Vec3f min1 = AABB1->GetMin(), min2 = AABB2->GetMin();
 		Vec3f max1 = AABB1->GetMax(), max2 = AABB2->GetMax();
@@ -440,8 +444,8 @@ namespace longmarch
 		return true;
 	}
 
-	bool longmarch::DynamicAABBvsAABB(const std::shared_ptr<AABB>& AABB1, const Vec3f& Vel1,
-		const std::shared_ptr<AABB>& AABB2, const Vec3f& Vel2,
+	bool longmarch::DynamicAABBvsAABB(AABB* AABB1, const Vec3f& Vel1,
+		AABB* AABB2, const Vec3f& Vel2,
 		float dt, Manifold& manifold)
 	{
 		// exit early if both are already overlapping
@@ -464,7 +468,8 @@ namespace longmarch
 			{
 				float axisPenetration = combinedHalfExtents[i] - fabsf(relativeVec[i]);
 
-				if (axisPenetration > 0 && axisPenetration < penetrationDepth)
+				// bodies that only touch have no penetration along the axis they touch on
+				if (axisPenetration >= 0 && axisPenetration < penetrationDepth)
 				{
 					intersectAxis = i;
 					penetrationDepth = axisPenetration;
@@ -492,10 +497,6 @@ namespace longmarch
 		Vec3f min1 = AABB1->GetMin(), min2 = AABB2->GetMin();
 		Vec3f max1 = AABB1->GetMax(), max2 = AABB2->GetMax();
 
-		float firstIntersect = dt;	// time of first intersection
-		int intersectAxis = 0;		// axis of intersection
-		float penetrationDepth = 0.0f;
-
 		for (int i = 0; i < 3; ++i)
 		{
 			if (relativeVel[i] <= 0.0f)
@@ -524,12 +525,22 @@ namespace longmarch
 
 			if (tFirst > tLast)
 				return false;
+		}
 
-			else if (tFirst < firstIntersect && tFirst > 0)
+		// the bodies touch on the axis they reach last, bodies that already touch have a gap of 0 on it
+		int intersectAxis = 0;		// axis of intersection
+		float separation = 0.0f;	// gap along the axis of intersection
+		float lastEntry = -std::numeric_limits<float>::max();
+		for (int i = 0; i < 3; ++i)
+		{
+			float gap = std::max(min2[i] - max1[i], min1[i] - max2[i]);
+			float entry = (gap > 0.0f) ? gap / fabsf(relativeVel[i]) : gap;
+
+			if (entry > lastEntry)
 			{
-				firstIntersect = tFirst;
+				lastEntry = entry;
 				intersectAxis = i;
-				penetrationDepth = relativeVel[i] * (tLast - tFirst);
+				separation = gap;
 			}
 		}
 
@@ -541,7 +552,8 @@ namespace longmarch
 		manifold.m_normal = Vec3f(0.0f, 0.0f, 0.0f);
 		manifold.m_normal[intersectAxis] = -1.0f;
 
-		manifold.m_contact.m_penetration = penetrationDepth;
+		// negative penetration is the gap the bodies close within dt
+		manifold.m_contact.m_penetration = -separation;
 		manifold.m_staticCollision = false;
 
 		//std::cout << "tfirst: " << tFirst << std::endl;
@@ -566,11 +578,11 @@ namespace longmarch
 	{
 		Vec3f rb1AdjustVec, rb2AdjustVec;
 
-		// cases where 1 of the RBs is static
-		if (manifold.m_A->GetRBType() == RBType::staticBody)
+		// cases where 1 of the RBs is static, kinematic bodies are not pushed either since islands solved in parallel share them
+		if (manifold.m_A->GetRBType() != RBType::dynamicBody)
 		{
 			// if for some reason both are static, exit just in case
-			if (manifold.m_B->GetRBType() == RBType::staticBody)
+			if (manifold.m_B->GetRBType() != RBType::dynamicBody)
 				return;
 
 			// rb2 needs to be adjusted, so push it out by the penetration value in the direction of the collision normal
@@ -582,7 +594,7 @@ namespace longmarch
 			manifold.m_B->SetWorldPosition(manifold.m_B->GetWorldPosition() + collNormal * manifold.m_contact.m_penetration);
 		}
 
-		else if (manifold.m_B->GetRBType() == RBType::staticBody)
+		else if (manifold.m_B->GetRBType() != RBType::dynamicBody)
 		{
 			// rb2 needs to be adjusted, so push it out by the penetration value in the direction of the collision normal
 			Vec3f collNormal = manifold.m_normal;
@@ -633,9 +645,15 @@ namespace longmarch
 			Vec3f rb1_vel = rb1->GetRBType() == RBType::staticBody ? Vec3f() : rb1->GetLinearVelocity();
 			Vec3f rb2_vel = rb2->GetRBType() == RBType::staticBody ? Vec3f() : rb2->GetLinearVelocity();
 
-			// advance rb1 and rb2 until time of impact
-			rb1->SetWorldPosition(rb1->GetWorldPosition() + rb1_vel * manifold.m_intersectTime);
-			rb2->SetWorldPosition(rb2->GetWorldPosition() + rb2_vel * manifold.m_intersectTime);
+			// advance rb1 and rb2 until time of impact, only dynamic bodies are written since islands solved in parallel share the others
+			if (rb1->GetRBType() == RBType::dynamicBody)
+			{
+				rb1->SetWorldPosition(rb1->GetWorldPosition() + rb1_vel * manifold.m_intersectTime);
+			}
+			if (rb2->GetRBType() == RBType::dynamicBody)
+			{
+				rb2->SetWorldPosition(rb2->GetWorldPosition() + rb2_vel * manifold.m_intersectTime);
+			}
 
 			// compute the resulting velocity for rb1
 			//rb1->SetLinearVelocity(rb1_vel - 2.0f * rb2Mass / (rb1Mass + rb2Mass) * glm::dot(rb1_vel - rb2_vel, rb2_1) / glm::length2(rb2_1) * rb2_1);
@@ -727,8 +745,8 @@ namespace longmarch
 		}
 	}
 
-	bool DynamicShapevsShape(const std::shared_ptr<Shape>& shape1, const Vec3f& Vel1,
-		const std::shared_ptr<Shape>& shape2, const Vec3f& Vel2,
+	bool DynamicShapevsShape(Shape* shape1, const Vec3f& Vel1,
+		Shape* shape2, const Vec3f& Vel2,
 		float dt, Manifold& manifold)
 	{
 		// apply the appropriate collision check based on the given shapes
@@ -737,7 +755,7 @@ namespace longmarch
 
 		if (shape1Type == Shape::SHAPE_TYPE::AABB && shape2Type == Shape::SHAPE_TYPE::AABB)
 		{
-			return DynamicAABBvsAABB(dynamic_pointer_cast<AABB>(shape1), Vel1, dynamic_pointer_cast<AABB>(shape2), Vel2, dt, manifold);
+			return DynamicAABBvsAABB(static_cast<AABB*>(shape1), Vel1, static_cast<AABB*>(shape2), Vel2, dt, manifold);
 		}
 
 		return false;
@@ -24,20 +24,20 @@ namespace longmarch
 	bool ResolveCollision(Shape* AABB1, float PosX1, float PosY1,
 		Shape* AABB2, float PosX2, float PosY2);
 
-	bool StaticCirclevsCircle(const std::shared_ptr<Circle>& circle1, const std::shared_ptr<Circle>& circle2);
+	bool StaticCirclevsCircle(Circle* circle1, Circle* circle2);
 
-	bool DynamicCirclevsCircle(const std::shared_ptr<Circle>& circle1, const Vec3f& Vel1,
-		const std::shared_ptr<Circle>& circle2, const Vec3f& Vel2,
+	bool DynamicCirclevsCircle(Circle* circle1, const Vec3f& Vel1,
+		Circle* circle2, const Vec3f& Vel2,
 		float dt, Manifold& manifold);
 
-	bool StaticAABBvsAABB(const std::shared_ptr<AABB>& AABB1, const std::shared_ptr<AABB>& AABB2);
+	bool StaticAABBvsAABB(AABB* AABB1, AABB* AABB2);
 
-	bool DynamicAABBvsAABB(const std::shared_ptr<AABB>& AABB1, const Vec3f& Vel1,
-						   const std::shared_ptr<AABB>& AABB2, const Vec3f& Vel2,
+	bool DynamicAABBvsAABB(AABB* AABB1, const Vec3f& Vel1,
+						   AABB* AABB2, const Vec3f& Vel2,
 						   float dt, Manifold& manifold);
 
-	bool DynamicShapevsShape(const std::shared_ptr<Shape>& shape1, const Vec3f& Vel1,
-							 const std::shared_ptr<Shape>& shape2, const Vec3f& Vel2,
+	bool DynamicShapevsShape(Shape* shape1, const Vec3f& Vel1,
+							 Shape* shape2, const Vec3f& Vel2,
 							 float dt, Manifold& manifold);
 
 	/*
@@ -2,8 +2,7 @@
 #include "Scene.h"
 #include "engine/physics/CollisionsManager.h"
 #include "engine/events/engineEvents/EngineCustomEvent.h"
-
-#define MAX_ITERATIONS 3
+#include "engine/core/thread/JobSystem.h"
 
 namespace longmarch
 {
@@ -20,261 +19,347 @@ namespace longmarch
         RemoveAllBodies();
     }
 
-    LongMarch_Vector<LongMarch_Vector<RigidBody*>> Scene::BroadPhase(const LongMarch_Vector<RigidBody*>& rbs)
+    const LongMarch_Vector<BroadPhasePair>& Scene::BroadPhase(float dt)
     {
-        // Convert custom vector to std vector
-        std::vector<RigidBody*> _rbs;
-        _rbs.reserve(rbs.size());
-        for (auto& rb : rbs) { _rbs.push_back(rb); }
-
-        // Build BVH
-        FastBVH_RigidBodyConverter<float> _bvhAABBConverter; //!< Convert our AABB to fastBVH's BBox
-        FastBVH::DefaultBuilder<float> _bvhBuilder; //!< FashBVH deafult BVH builder
-        m_bvh = _bvhBuilder(_rbs, _bvhAABBConverter);
-        const auto nodes = m_bvh.getNodes();
-        auto build_prims = m_bvh.getPrimitives();
-
-        // Iterate over all leaves and treat them as islands
-        LongMarch_Vector<LongMarch_Vector<RigidBody*>> ret;
-        for (const auto& node : nodes)
+        // both broadphases take the same calls, see DynamicAABBTree and SweepAndPrune
+        auto refit = [this, dt](auto& broadPhase) -> const LongMarch_Vector<BroadPhasePair>&
         {
-            if (node.isLeaf())
+            for (const auto& rb : m_rbList)
             {
-                LongMarch_Vector<RigidBody*> island;
-                for (uint32_t o = 0; o < node.primitive_count; ++o) 
+                if (rb->GetShape() == nullptr)
                 {
-                    const auto& obj = build_prims[node.start + o];
-                    island.push_back(obj);
+                    continue;
+                }
+                // bodies get their shape after being created, insert them on their first step
+                if (!broadPhase.HasObject(rb.get()))
+                {
+                    broadPhase.InsertObject(rb.get(), rb->GetLinearVelocity() * dt);
+                }
+                else
+                {
+                    // the bounds cover the displacement of this step, so that the pairs are still valid after Solve() moves the bodies
+                    broadPhase.UpdateObject(rb.get(), rb->GetLinearVelocity() * dt);
                 }
-                ret.push_back(island);
             }
+            return broadPhase.UpdatePairs();
+        };
+
+        switch (m_broadPhaseType)
+        {
+        case BroadPhaseType::SWEEP_AND_PRUNE:
+            return refit(m_sap);
+        default:
+            return refit(m_aabbTree);
         }
+    }
 
-        return ret;
+    const ContactManifolds& Scene::NarrowPhase(const LongMarch_Vector<BroadPhasePair>& pairs, float dt, NarrowPhaseBatch& batch)
+    {
+        return batch.Collide(pairs, m_gravity, dt);
     }
 
-    LongMarch_Vector<Manifold> Scene::NarrowPhase(const LongMarch_Vector<RigidBody*>& island, float dt)
+    bool Scene::canCollide(RigidBody* rb1, RigidBody* rb2)
     {
-        LongMarch_Vector<Manifold> manifold;
+        // Skip two static bodies
+        if (rb1->GetRBType() == RBType::staticBody && rb2->GetRBType() == RBType::staticBody)
+        {
+            return false;
+        }
 
-        for (auto iter = island.begin(); iter != island.end(); ++iter)
+        if (rb1->m_entityTypeIngoreSet.Contains(rb2->GetEntity().m_type)
+            || rb2->m_entityTypeIngoreSet.Contains(rb1->GetEntity().m_type))
         {
-            for (auto iter2 = iter + 1; iter2 != island.end(); ++iter2)
+            return false;
+        }
+        return true;
+    }
+
+    void Scene::BuildIslands(const LongMarch_Vector<BroadPhasePair>& pairs)
+    {
+        // union-find over the dynamic bodies, a body starts as the root of its own set
+        m_islandParents.clear();
+        for (const auto& rb : m_rbList)
+        {
+            if (rb->GetRBType() == RBType::dynamicBody)
+            {
+                const auto index = static_cast<uint32_t>(m_islandParents.size());
+                rb->SetIslandIndex(index);
+                m_islandParents.push_back(index);
+            }
+            else
             {
-                // get the type of body
-                auto& rb1 = *iter;
-                auto& rb2 = *iter2;
+                rb->SetIslandIndex(Island::NO_ISLAND);
+            }
+        }
 
-                RBType rb1Type = rb1->GetRBType();
-                RBType rb2Type = rb2->GetRBType();
+        auto find = [this](uint32_t i)
+        {
+            // path halving
+            while (m_islandParents[i] != i)
+            {
+                m_islandParents[i] = m_islandParents[m_islandParents[i]];
+                i = m_islandParents[i];
+            }
+            return i;
+        };
 
-                // Skip two static bodies
-                if (rb1Type == RBType::staticBody && rb2Type == RBType::staticBody)
-                {
-                    continue;
-                }
+        // static and kinematic bodies do not connect islands
+        for (const auto& pair : pairs)
+        {
+            const auto a = pair.m_A->GetIslandIndex();
+            const auto b = pair.m_B->GetIslandIndex();
+            if (a == Island::NO_ISLAND || b == Island::NO_ISLAND || !canCollide(pair.m_A, pair.m_B))
+            {
+                continue;
+            }
+            const auto rootA = find(a);
+            const auto rootB = find(b);
+            if (rootA != rootB)
+            {
+                // the smaller root wins so that the islands do not depend on the order of the pairs
+                m_islandParents[std::max(rootA, rootB)] = std::min(rootA, rootB);
+            }
+        }
 
-                if (rb1->m_entityTypeIngoreSet.Contains(rb2->GetEntity().m_type)
-                    || rb2->m_entityTypeIngoreSet.Contains(rb1->GetEntity().m_type))
+        // number the islands in the order of their first body, islands keep the memory of the last steps
+        m_islandOfRoot.assign(m_islandParents.size(), Island::NO_ISLAND);
+        m_numIslands = 0;
+        for (const auto& rb : m_rbList)
+        {
+            if (rb->GetIslandIndex() == Island::NO_ISLAND)
+            {
+                continue;
+            }
+            auto& island = m_islandOfRoot[find(rb->GetIslandIndex())];
+            if (island == Island::NO_ISLAND)
+            {
+                island = m_numIslands++;
+                if (m_islands.size() < m_numIslands)
                 {
-                    continue;
+                    m_islands.emplace_back();
                 }
-                
-                Manifold contactManifold;
-
-                // if there is collision, store the manifold and move on to the next pair
-                if (DynamicShapevsShape(rb1->GetShape(), rb1->GetLinearVelocity(), rb2->GetShape(), rb2->GetLinearVelocity(), dt, contactManifold))
-                {
-                    contactManifold.m_A = rb1;
-                    contactManifold.m_B = rb2;
-
-                    contactManifold.m_gravity = m_gravity;
-                    contactManifold.m_friction = (rb1->GetFriction() + rb2->GetFriction()) * 0.5f;
+                m_islands[island].Clear();
+            }
+            rb->SetIslandIndex(island);
+            m_islands[island].AddRigidBody(rb.get());
+        }
 
-                    manifold.push_back(contactManifold);
-                }
+        for (const auto& pair : pairs)
+        {
+            const auto island = (pair.m_A->GetIslandIndex() != Island::NO_ISLAND) ? pair.m_A->GetIslandIndex() : pair.m_B->GetIslandIndex();
+            if (island != Island::NO_ISLAND && canCollide(pair.m_A, pair.m_B))
+            {
+                m_islands[island].AddPair(pair);
             }
         }
 
-        return manifold;
+        // a sleeping island is woken up as a whole by any of its bodies
+        for (uint32_t i = 0; i < m_numIslands; ++i)
+        {
+            m_islands[i].WakeUp(!m_enableSleep);
+        }
     }
 
-    void Scene::Solve(float dt)
+    void Scene::integrateVelocity(RigidBody* rb, float dt)
     {
-        std::shared_ptr<Shape> shapePtr = nullptr;
-
-        // update all rigid bodies using euler
-        for (auto& rb : m_rbList)
-        {
-            // no need to update static objects
-            if (rb->GetRBType() == RBType::dynamicBody)
-            {
+        // apply gravity
+        rb->ApplyLinearForce(m_gravity * rb->GetGravityScale());
 
-                rb->SetPrevWorldPosition(rb->GetWorldPosition());
+        rb->SetLinearVelocity(rb->GetLinearVelocity() + rb->GetLinearAcceleration() * dt);
 
-                if (rb->IsCollided())
-                {
-                    // apply gravity
+        // apply damping to the velocities
+        rb->SetLinearVelocity(rb->GetLinearVelocity() * 1.0f / (1.0f + dt * rb->GetLinearDamping()));
 
-                    rb->ApplyLinearForce(m_gravity * rb->GetGravityScale());
+        rb->ClearAllForces();
+    }
 
-                    rb->SetPrevWorldPosition(rb->GetWorldPosition());
+    void Scene::integratePosition(RigidBody* rb, float dt)
+    {
+        rb->SetPrevWorldPosition(rb->GetWorldPosition());
+        rb->SetWorldPosition(rb->GetWorldPosition() + rb->GetLinearVelocity() * dt);
 
-                    rb->SetLinearVelocity((rb->GetLinearVelocity() + rb->GetLinearAcceleration() * rb->GetSolveTimeLeft()));
-                    rb->SetWorldPosition(rb->GetWorldPosition() + rb->GetLinearVelocity() * rb->GetSolveTimeLeft());
+        //////////////////////////////////////////////
+        // update the shape associated with the object
+        //////////////////////////////////////////////
+        Shape* shapePtr = rb->GetShape();
 
+        if (shapePtr != nullptr)
+        {
+            // for now just check for AABB shapes
+            if (shapePtr->GetType() == Shape::SHAPE_TYPE::AABB)
+            {
+                AABB* aabbPtr = static_cast<AABB*>(shapePtr);
+                aabbPtr->SetCenter(rb->GetWorldPosition() + rb->GetColliderDisplacement());
+            }
 
-                    //rb->SetLinearVelocity(Vec3f(0.0f, 0.0f, 0.0f));
-                }
+            // the broadphase is refitted by the next BroadPhase()
+        }
+    }
 
-                else
-                {
-                    // apply gravity
-                    rb->ApplyLinearForce(m_gravity * rb->GetGravityScale());
+    void Scene::solveIsland(Island& island, float dt)
+    {
+        // reset collision status of the rigid bodies, and apply gravity and forces before the contacts see the velocities
+        for (auto& rb : island.m_bodies)
+        {
+            rb->SetCollisionStatus(false, dt);
+            integrateVelocity(rb, dt);
+        }
 
-                    rb->SetPrevWorldPosition(rb->GetWorldPosition());
+        // contacts are found once per step, gaps that the bodies close within the step are speculative contacts
+        const auto& manifolds = NarrowPhase(island.m_pairs, dt, island.m_narrowPhase);
 
-                    rb->SetLinearVelocity((rb->GetLinearVelocity() + rb->GetLinearAcceleration() * dt));
-                    rb->SetWorldPosition(rb->GetWorldPosition() + rb->GetLinearVelocity() * dt);
-                }
+        auto& solver = island.m_solver;
+        solver.Prepare(island.m_bodies, manifolds, m_contactCache, dt, m_enableFriction);
+        solver.WarmStart();
+        for (int i = 0; i < ContactSolver::kVelocityIterations; ++i)
+        {
+            solver.SolveVelocities();
+        }
+        solver.StoreVelocities();
+        solver.StoreImpulses(island.m_impulses);
 
-                // apply damping to the velocities
-                rb->SetLinearVelocity(rb->GetLinearVelocity() * 1.0f / (1.0f + dt * rb->GetLinearDamping()));
-            }
+        // update all rigid bodies using euler
+        for (auto& rb : island.m_bodies)
+        {
+            integratePosition(rb, dt);
+        }
 
-            //////////////////////////////////////////////
-            // update the shape associated with the object
-            //////////////////////////////////////////////
-            shapePtr = rb->GetShape();
-            
-            if (shapePtr.get() != nullptr)
+        for (size_t j = 0; j < manifolds.Size(); ++j)
+        {
+            const auto elem = manifolds.Get(j);
+            // only dynamic bodies are written since islands solved in parallel share the others
+            for (auto rb : { elem.m_A, elem.m_B })
             {
-                // for now just check for AABB shapes
-                if (shapePtr->GetType() == Shape::SHAPE_TYPE::AABB)
+                if (rb->GetRBType() == RBType::dynamicBody)
                 {
-                    //AABB* aabbPtr = dynamic_cast<AABB*>(shapePtr.get());
-                    std::shared_ptr<AABB> aabbPtr = std::dynamic_pointer_cast<AABB>(shapePtr);
-
-                    //aabbPtr->SetMin(aabbPtr->GetMin() + posDiff);
-                    //aabbPtr->SetMax(aabbPtr->GetMax() + posDiff);
-                    aabbPtr->SetCenter(rb->GetWorldPosition() + rb->GetColliderDisplacement());
+                    rb->SetCollisionStatus(true, dt);
                 }
-
-                //switch (shapePtr->GetType())
-                //{
-                //case Shape::SHAPE_TYPE::AABB:
-                //    std::dynamic_pointer_cast<AABB>(shapePtr)->
-                //}
-
-                // update the AABB in the AABB tree
-                //m_aabbTree.UpdateObject(rb);
             }
+            island.AddContact(elem);
         }
 
-        for (auto& elem : m_rbList)
-            elem->ClearAllForces();
+        if (m_enableSleep)
+        {
+            island.UpdateSleep(dt);
+        }
     }
 
-    // move simulation of Scene forward by given timestep
-    void Scene::Step(float dt)
+    void Scene::Solve(float dt)
     {
-        LOCK_GUARD();
-        m_contactPairs.clear();
-
-        // reset collision status of all rigid bodies
-        for (auto& elem : m_rbList)
+        m_awakeIslands.clear();
+        for (uint32_t i = 0; i < m_numIslands; ++i)
         {
-            elem->SetCollisionStatus(false, dt);
+            if (!m_islands[i].m_isSleeping)
+            {
+                m_awakeIslands.push_back(i);
+            }
         }
 
-        // TODO : do broadphase collision check
-        LongMarch_Vector<RigidBody*> rbs;
-        std::transform(m_rbList.begin(), m_rbList.end(), std::back_inserter(rbs), [](const auto& rb) {return rb.get(); });
-
-        LongMarch_Vector<LongMarch_Vector<RigidBody*>> islands = BroadPhase(rbs);
+        // contacts of sleeping islands keep their impulses until the islands wake up
+        m_contactCache.Retain([this](const ContactImpulse& impulse)
+        {
+            const auto rb = (impulse.m_A->GetRBType() == RBType::dynamicBody) ? impulse.m_A : impulse.m_B;
+            const auto island = rb->GetIslandIndex();
+            return island != Island::NO_ISLAND && m_islands[island].m_isSleeping;
+        });
 
-        // loop collision check and resolution until either max. iterations achieved or no collisions detected
-        for (unsigned int i = 0; i < MAX_ITERATIONS; ++i)
+        // islands do not share any dynamic body, the calling thread holds the lock of the scene so it must not help other jobs
+        JobSystem::ParallelForNoHelp(0, m_awakeIslands.size(), 0, [this, dt](size_t first, size_t last)
         {
-            for (auto& island : islands)
+            // memory tags are per thread
+            MemoryTagScope _tag(MemoryTag::PHYSICS);
+            for (auto i = first; i < last; ++i)
             {
-                // NarrowPhase
-                LongMarch_Vector<Manifold> manifold = NarrowPhase(island, dt);
-
-                if (manifold.empty())
-                {
-                    continue;
-                }
-
-                // temporary solution
-                // solve contacts first, then update positions etc.
-                for (auto& elem : manifold)
-                {
-                    // resolve each contact in the list
-                    ResolveCollision(elem, dt, m_enableFriction);
-                    m_contactPairs.emplace(elem);
-                }
+                solveIsland(m_islands[m_awakeIslands[i]], dt);
             }
+        });
+
+        // in the order of the islands, the cache is sorted anyway
+        for (auto i : m_awakeIslands)
+        {
+            m_contactCache.Add(m_islands[i].m_impulses);
         }
+        m_contactCache.Commit();
+    }
+
+    // move simulation of Scene forward by given timestep
+    void Scene::Step(float dt)
+    {
+        LOCK_GUARD();
+        MemoryTagScope _tag(MemoryTag::PHYSICS);
+        m_contactPairs.clear();
+
+        const auto& pairs = BroadPhase(dt);
 
         // construct islands, then call Solve() in islands
-        // for now just do regular integration (euler) since islands aren't implemented yet
+        BuildIslands(pairs);
         Solve(dt);
-        
-        // addition collision check to push out anything with static collision so that objects don't "sink" into the ground
+
+        // gather contacts in the order of the islands so that events do not depend on the scheduling of the islands
+        for (auto i : m_awakeIslands)
         {
-            for (auto& island : islands)
+            for (const auto& elem : m_islands[i].m_contacts)
             {
-                LongMarch_Vector<Manifold> manifold = NarrowPhase(island, dt);
-
-                for (auto& elem : manifold)
-                {
-                    // resolve each contact in the list
-                    ResolveCollision(elem, dt, m_enableFriction);
-                    m_contactPairs.emplace(elem);
-                }
+                m_contactPairs.emplace(elem);
             }
         }
 
         // add code for collision event here using pairs in m_contactPairs
         {
             auto queue = EventQueue<EngineEventType>::GetInstance();
+            FrameVector<EventQueue<EngineEventType>::EventPtr> events;
+            events.reserve(m_contactPairs.size());
             for (const auto& elem : m_contactPairs)
             {
                 auto e1 = EntityDecorator{ elem.m_A->GetEntity(), m_parentWorld };
                 auto e2 = EntityDecorator{ elem.m_B->GetEntity(), m_parentWorld };
-                auto e = MemoryManager::Make_shared<EngineCollisionEvent>(e1, e2, (void*)(&elem));
-                queue->Publish(e);
+                events.emplace_back(TemplateMemoryManager<EngineCollisionEvent>::Make_shared_pooled(e1, e2, (void*)(&elem)));
             }
+            // Subscribers of collision events are looked up and locked once for all contacts of the step
+            queue->PublishBatch(events);
         }
     }
 
     // by default give a AABB
-    std::shared_ptr<RigidBody> Scene::CreateRigidBody()
+    RefPtr<RigidBody> Scene::CreateRigidBody()
     {
         LOCK_GUARD();
         //mutex mtxTest;
 
-        auto rb = MemoryManager::Make_shared<RigidBody>();
+        RefPtr<RigidBody> rb(RefPtr<RigidBody>::Allocator::New());
+        rb->SetID(m_nextBodyID++);
         //rb->SetShape(Shape::SHAPE_TYPE::AABB);
 
         m_rbList.push_back(rb);
-        //m_aabbTree.InsertObject(rb);
+        // the AABB tree takes the body on the first BroadPhase() after it has a shape
 
         return rb;
     }
 
     // note: need to make sure that after calling the remove functions, the relevant rigid bodies also have the pointers removed
-    void Scene::RemoveRigidBody(const std::shared_ptr<RigidBody>& rb)
+    void Scene::RemoveRigidBody(const RefPtr<RigidBody>& rb)
     {
         LOCK_GUARD();
+        if (m_aabbTree.HasObject(rb.get()))
+        {
+            m_aabbTree.RemoveObject(rb.get());
+        }
+        if (m_sap.HasObject(rb.get()))
+        {
+            m_sap.RemoveObject(rb.get());
+        }
+        m_contactCache.RemoveBody(rb.get());
         std::erase(m_rbList, rb);
     }
 
     void Scene::RemoveAllBodies()
     {
         LOCK_GUARD();
+        m_aabbTree.RemoveAllObjects();
+        m_sap.RemoveAllObjects();
+        m_contactCache.Clear();
         m_rbList.clear();
+        m_nextBodyID = 1;
     }
 
     void Scene::SetGameWorld(GameWorld* world)
@@ -289,6 +374,24 @@ namespace longmarch
         m_gravity = g;
     }
 
+    void Scene::SetBroadPhaseType(BroadPhaseType type)
+    {
+        LOCK_GUARD();
+        if (m_broadPhaseType != type)
+        {
+            // the next BroadPhase() inserts every body into the new broadphase
+            m_aabbTree.RemoveAllObjects();
+            m_sap.RemoveAllObjects();
+            m_broadPhaseType = type;
+        }
+    }
+
+    BroadPhaseType Scene::GetBroadPhaseType() const
+    {
+        LOCK_GUARD();
+        return m_broadPhaseType;
+    }
+
     void Scene::EnableSleep(bool enabled)
     {
         LOCK_GUARD();
@@ -316,7 +419,7 @@ namespace longmarch
     void Scene::RenderDebug()
     {
         LOCK_GUARD();
-        // render the BVH tree
+        // render the AABB tree
         //m_aabbTree.Render();
 
         // render all the rigid body shapes
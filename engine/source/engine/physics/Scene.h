@@ -3,14 +3,22 @@
 #include "engine/core/EngineCore.h"
 #include "engine/math/Geommath.h"
 #include "engine/core/allocator/MemoryManager.h"
+#include "engine/core/allocator/FrameArena.h"
 #include "engine/core/thread/Lock.h"
 #include "engine/core/utility/TypeHelper.h"
 
 #include "dynamics/Island.h"
 #include "collision/DynamicTree.h"
+#include "collision/SweepAndPrune.h"
 
 namespace longmarch
 {
+    enum class BroadPhaseType : uint8_t
+    {
+        AABB_TREE = 0, //!< Persistent dynamic AABB tree, cheap for scenes that are mostly static or sleeping
+        SWEEP_AND_PRUNE, //!< Sort and sweep, cheap for many similar sized moving bodies
+    };
+
     class Scene : BaseAtomicClass
     {
     public:
@@ -18,18 +26,27 @@ namespace longmarch
         explicit Scene(const Vec3f& gravity);
         ~Scene();
 
-        LongMarch_Vector<LongMarch_Vector<RigidBody*>> BroadPhase(const LongMarch_Vector<RigidBody*>& rbs);
-        LongMarch_Vector<Manifold> NarrowPhase(const LongMarch_Vector<RigidBody*>& island, float dt);
+        //! Refit the broadphase with the moved bodies and return the overlapping pairs, the result lives until the next step
+        const LongMarch_Vector<BroadPhasePair>& BroadPhase(float dt);
+        //! Collide pairs that passed the collision filter (e.g. the pairs of an island), the result lives in the batch until its next use
+        const ContactManifolds& NarrowPhase(const LongMarch_Vector<BroadPhasePair>& pairs, float dt, NarrowPhaseBatch& batch);
 
+        //! Build islands of the dynamic bodies from the broadphase pairs with union-find, wake up or keep asleep each island as a whole
+        void BuildIslands(const LongMarch_Vector<BroadPhasePair>& pairs);
+        //! Solve the awake islands of the last BuildIslands() in parallel on the job system, contacts are warm started from the last step
         void Solve(float dt);
         void Step(float dt); //!< move simulation of Scene forward by given timestep
 
         void SetGameWorld(GameWorld* world);
         void SetGravity(const Vec3f& g);
-        std::shared_ptr<RigidBody> CreateRigidBody();
-        void RemoveRigidBody(const std::shared_ptr<RigidBody>& rb);
+        RefPtr<RigidBody> CreateRigidBody();
+        void RemoveRigidBody(const RefPtr<RigidBody>& rb);
         void RemoveAllBodies();
 
+        //! Bodies are moved to the new broadphase on the next step
+        void SetBroadPhaseType(BroadPhaseType type);
+        BroadPhaseType GetBroadPhaseType() const;
+
         void EnableSleep(bool enabled);
         void EnableFriction(bool enabled);
         void EnableUpdate(bool update);
@@ -38,16 +55,33 @@ namespace longmarch
 		void RenderDebug();
 
     private:
-        LongMarch_Vector<std::shared_ptr<RigidBody>> m_rbList;
+        static bool canCollide(RigidBody* rb1, RigidBody* rb2);
+        void solveIsland(Island& island, float dt);
+        void integrateVelocity(RigidBody* rb, float dt);
+        void integratePosition(RigidBody* rb, float dt);
+
+    private:
+        LongMarch_Vector<RefPtr<RigidBody>> m_rbList;
+        uint32_t m_nextBodyID{ 1 };
         LongMarch_UnorderedSet<Manifold> m_contactPairs;
-        //DynamicAABBTree m_aabbTree;
+        DynamicAABBTree m_aabbTree;
+        SweepAndPrune m_sap;
+        BroadPhaseType m_broadPhaseType{ BroadPhaseType::AABB_TREE };
+
+        // islands are kept between steps so that their memory is reused, only the first m_numIslands are valid
+        LongMarch_Vector<Island> m_islands;
+        uint32_t m_numIslands{ 0 };
+        LongMarch_Vector<uint32_t> m_awakeIslands;
+        LongMarch_Vector<uint32_t> m_islandParents;
+        LongMarch_Vector<uint32_t> m_islandOfRoot;
+
+        // contact impulses of the last step, only read while the islands are solved
+        ContactCache m_contactCache;
 
         GameWorld* m_parentWorld{ nullptr };
         Vec3f m_gravity{ Vec3f(0,0,-9.8) };
         bool m_enableSleep{ true };
         bool m_enableFriction{ true };
         bool m_enableUpdate{ true };
-
-        FastBVH::BVH<float, RigidBody*> m_bvh;
     };
 }
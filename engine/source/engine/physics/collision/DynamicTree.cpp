@@ -4,6 +4,29 @@
 
 namespace longmarch
 {
+    namespace
+    {
+        // Fat AABBs grow by this many predicted displacements so that an object moving at constant velocity stays in its leaf for a few steps
+        constexpr float kDisplacementMultiplier = 2.0f;
+
+        // A fat AABB that is this many skins larger than needed (e.g. after the object slowed down) is shrunk by reinserting its leaf
+        constexpr float kHugeSkinMultiplier = 4.0f;
+
+        inline bool Overlaps(const Vec3f& minA, const Vec3f& maxA, const Vec3f& minB, const Vec3f& maxB)
+        {
+            return !(maxA.x < minB.x || minA.x > maxB.x
+                || maxA.y < minB.y || minA.y > maxB.y
+                || maxA.z < minB.z || minA.z > maxB.z);
+        }
+
+        // True if A contains B
+        inline bool Contains(const Vec3f& minA, const Vec3f& maxA, const Vec3f& minB, const Vec3f& maxB)
+        {
+            return minA.x <= minB.x && minA.y <= minB.y && minA.z <= minB.z
+                && maxA.x >= maxB.x && maxA.y >= maxB.y && maxA.z >= maxB.z;
+        }
+    }
+
     DynamicTreeNode::DynamicTreeNode()
         : m_parent(NULL_NODE),
         m_next(NULL_NODE),
@@ -28,13 +51,15 @@ namespace longmarch
     }
 
     DynamicAABBTreeNode::DynamicAABBTreeNode()
-        : DynamicTreeNode()
+        : DynamicTreeNode(),
+        m_moved(false)
     {
 
     }
 
     DynamicAABBTreeNode::DynamicAABBTreeNode(const DynamicAABBTreeNode& node)
-        : DynamicTreeNode(node)
+        : DynamicTreeNode(node),
+        m_moved(node.m_moved)
     {
         m_aabb.SetMin(node.m_aabb.GetMin());
         m_aabb.SetMax(node.m_aabb.GetMax());
@@ -50,6 +75,7 @@ namespace longmarch
         m_root(NULL_NODE),
         m_nodeCount(0),
         m_nodeCapacity(numObjects),
+        m_freeList(NULL_NODE),
         m_skinThickness(skinThickness)
     {
         
@@ -88,6 +114,8 @@ namespace longmarch
         m_nodes[nodeIndex].m_left = NULL_NODE;
         m_nodes[nodeIndex].m_right = NULL_NODE;
         m_nodes[nodeIndex].m_height = 0;
+        m_nodes[nodeIndex].m_obj = nullptr;
+        m_nodes[nodeIndex].m_moved = false;
 
         ++m_nodeCount;
 
@@ -126,62 +154,47 @@ namespace longmarch
         m_freeList = 0;
     }
 
-    void DynamicAABBTree::InsertObject(const std::shared_ptr<RigidBody>& ptr)
+    void DynamicAABBTree::InsertObject(RigidBody* ptr, const Vec3f& displacement)
     {
         // make sure object exists
         ENGINE_EXCEPT_IF(ptr == nullptr, L"Rigid Body to insert doesn't exist!");
 
         // make sure object has a shape
-        ENGINE_EXCEPT_IF(ptr->GetShape().get() == nullptr, L"Rigid Body to insert doesn't have a shape!");
+        ENGINE_EXCEPT_IF(ptr->GetShape() == nullptr, L"Rigid Body to insert doesn't have a shape!");
 
         // make sure object is new to the tree
         ENGINE_EXCEPT_IF(m_objectMap.find(ptr) != m_objectMap.end(), L"Object is already in the dynamic AABB tree!");
 
-        Vec3f aabbHalfWidths = ptr->GetAABBWidths() * 0.5f;
-        Vec3f lowerBound = ptr->GetWorldPosition() - aabbHalfWidths;
-        Vec3f upperBound = ptr->GetWorldPosition() + aabbHalfWidths;
+        Vec3f fatMin, fatMax;
+        computeFatAABB(ptr, displacement, fatMin, fatMax);
 
         // allocate node for the object
         int nodeIndex = allocateNode();
 
-        // make sure bounds are valid
-        for (unsigned int i = 0; i < 3; ++i)
-            ENGINE_EXCEPT_IF(lowerBound[i] > upperBound[i], L"AABB upper bound is smaller than lower bound!");
-
-        Vec3f aabbDimensions = upperBound - lowerBound;
-
-        // if it's not a leaf node, "fatten" the AABB size w.r.t. its original size as well
-        if (m_nodes[nodeIndex].IsLeaf())
-        {
-            m_nodes[nodeIndex].m_aabb.SetMin(lowerBound);
-            m_nodes[nodeIndex].m_aabb.SetMax(upperBound);
-        }
-
-        else
-        {
-            Vec3f skinThickness = aabbDimensions;
-            skinThickness *= m_skinThickness;
-
-            m_nodes[nodeIndex].m_aabb.SetMin(lowerBound - skinThickness);
-            m_nodes[nodeIndex].m_aabb.SetMax(upperBound + skinThickness);
-        }
-
-        // update surface area and center of AABB
+        // leaf nodes store the fattened AABB so that small movements do not touch the tree
+        m_nodes[nodeIndex].m_aabb.SetMin(fatMin);
+        m_nodes[nodeIndex].m_aabb.SetMax(fatMax);
 
         // height is 0 because it new objects are always in leaf nodes
         m_nodes[nodeIndex].m_height = 0;
+        m_nodes[nodeIndex].m_obj = ptr;
 
         // insert leaf node
         insertLeaf(nodeIndex);
 
-        m_objectMap.insert(std::unordered_map<std::shared_ptr<RigidBody>, int>::value_type(ptr, nodeIndex));
+        m_objectMap.insert(std::unordered_map<RigidBody*, int>::value_type(ptr, nodeIndex));
 
-        m_nodes[nodeIndex].m_obj = ptr;
+        bufferMove(nodeIndex);
+    }
+
+    bool DynamicAABBTree::HasObject(RigidBody* ptr) const
+    {
+        return m_objectMap.find(ptr) != m_objectMap.end();
     }
 
-    void DynamicAABBTree::RemoveObject(const std::shared_ptr<RigidBody>& ptr)
+    void DynamicAABBTree::RemoveObject(RigidBody* ptr)
     {
-        std::unordered_map <std::shared_ptr<RigidBody>, int>::iterator iter;
+        std::unordered_map<RigidBody*, int>::iterator iter;
 
         iter = m_objectMap.find(ptr);
 
@@ -192,6 +205,13 @@ namespace longmarch
         // remove object from the map
         m_objectMap.erase(iter);
 
+        // forget its pairs, the node index might be reused by the next inserted object
+        std::erase_if(m_pairs, [nodeIndex](const BroadPhasePair& pair) { return pair.m_proxyA == nodeIndex || pair.m_proxyB == nodeIndex; });
+        if (m_nodes[nodeIndex].m_moved)
+        {
+            std::erase(m_moveBuffer, nodeIndex);
+        }
+
         // remove the corresponding leaf node
         removeLeaf(nodeIndex);
         freeNode(nodeIndex);
@@ -204,36 +224,40 @@ namespace longmarch
     
     void DynamicAABBTree::RemoveAllObjects()
     {
-        // Iterator pointing to the start of the particle map.
-        std::unordered_map<std::shared_ptr<RigidBody>, int>::iterator iter = m_objectMap.begin();
-
-        // Iterate over the map.
-        while (iter != m_objectMap.end())
+        // Release every node at once instead of removing leaves one by one, which would rebalance the tree for nothing
+        for (int i = 0; i < m_nodeCapacity - 1; ++i)
         {
-            // Extract the node index.
-            int nodeIndex = iter->second;
-
-            ENGINE_EXCEPT_IF(nodeIndex >= m_nodeCapacity || !m_nodes[nodeIndex].IsLeaf(), L"Attempted to remove invalid leaf node!");
+            m_nodes[i].m_next = i + 1;
+            m_nodes[i].m_height = -1;
+            m_nodes[i].m_moved = false;
+        }
 
-            removeLeaf(nodeIndex);
-            freeNode(nodeIndex);
+        m_nodes[m_nodeCapacity - 1].m_next = NULL_NODE;
+        m_nodes[m_nodeCapacity - 1].m_height = -1;
+        m_nodes[m_nodeCapacity - 1].m_moved = false;
 
-            ++iter;
-        }
+        m_freeList = 0;
+        m_nodeCount = 0;
+        m_root = NULL_NODE;
 
         // Clear the particle map.
         m_objectMap.clear();
+        m_moveBuffer.clear();
+        m_pairs.clear();
     }
 
-    bool DynamicAABBTree::UpdateObject(const std::shared_ptr<RigidBody>& ptr, bool alwaysReInsert)
+    bool DynamicAABBTree::UpdateObject(RigidBody* ptr, bool alwaysReInsert)
+    {
+        return UpdateObject(ptr, Vec3f(0.0f), alwaysReInsert);
+    }
+
+    bool DynamicAABBTree::UpdateObject(RigidBody* ptr, const Vec3f& displacement, bool alwaysReInsert)
     {
         // make sure object exists
         ENGINE_EXCEPT_IF(ptr == nullptr, L"Rigid Body to update doesn't exist!");
 
         // update the AABB of the corresponding object
-        std::unordered_map<std::shared_ptr<RigidBody>, int>::iterator iter = m_objectMap.begin();
-
-        iter = m_objectMap.find(ptr);
+        auto iter = m_objectMap.find(ptr);
 
         ENGINE_EXCEPT_IF(iter == m_objectMap.end(), L"Attempted to update non-existent object in dynamic tree!");
 
@@ -241,62 +265,165 @@ namespace longmarch
 
         ENGINE_EXCEPT_IF(nodeIndex >= m_nodeCapacity || !m_nodes[nodeIndex].IsLeaf(), L"Attempted to access invalid leaf node!");
 
-        Vec3f newHalfWidths = ptr->GetAABBWidths() * 0.5f;
-        Vec3f newMin = ptr->GetWorldPosition() - newHalfWidths;
-        Vec3f newMax = ptr->GetWorldPosition() + newHalfWidths;
+        Vec3f tightMin, tightMax;
+        ptr->GetShape()->GetBoundingBoxMinMax(tightMin, tightMax);
 
-        // compute AABB limits and make sure bounds are valid
         // make sure bounds are valid
         for (unsigned int i = 0; i < 3; ++i)
-            ENGINE_EXCEPT_IF(newMax[i] > newMin[i], L"AABB upper bound is smaller than lower bound!");
+            ENGINE_EXCEPT_IF(tightMin[i] > tightMax[i], L"AABB upper bound is smaller than lower bound!");
 
-        Vec3f aabbDimensions = newMax - newMin;
+        // swept AABB of the coming step
+        Vec3f sweptMin = tightMin + glm::min(displacement, Vec3f(0.0f));
+        Vec3f sweptMax = tightMax + glm::max(displacement, Vec3f(0.0f));
 
-        AABB newAABB(newMin, newMax);
+        const Vec3f nodeMin = m_nodes[nodeIndex].m_aabb.GetMin();
+        const Vec3f nodeMax = m_nodes[nodeIndex].m_aabb.GetMax();
 
-        // remove current leaf node
-        removeLeaf(nodeIndex);
+        Vec3f fatMin, fatMax;
+        computeFatAABB(ptr, displacement, fatMin, fatMax);
 
-        // if it's not a leaf node, "fatten" the AABB size w.r.t. its original size as well
-        if (!m_nodes[nodeIndex].IsLeaf())
+        if (!alwaysReInsert && Contains(nodeMin, nodeMax, sweptMin, sweptMax))
         {
-            Vec3f skinThickness = aabbDimensions;
-            skinThickness *= m_skinThickness;
-
-            m_nodes[nodeIndex].m_aabb.SetMin(newMin - skinThickness);
-            m_nodes[nodeIndex].m_aabb.SetMax(newMax + skinThickness);
+            // still inside its fat AABB, unless the fat AABB has become much larger than needed there is nothing to do
+            Vec3f hugeSkin = (tightMax - tightMin) * static_cast<float>(m_skinThickness * kHugeSkinMultiplier);
+            if (Contains(fatMin - hugeSkin, fatMax + hugeSkin, nodeMin, nodeMax))
+            {
+                return false;
+            }
         }
 
-        // assign the new AABB
-        m_nodes[nodeIndex].m_aabb.SetMin(newAABB.GetMin());
-        m_nodes[nodeIndex].m_aabb.SetMax(newAABB.GetMax());
+        // remove current leaf node
+        removeLeaf(nodeIndex);
 
-        // recompute surface area and center (if necessary)
+        // assign the new fat AABB
+        m_nodes[nodeIndex].m_aabb.SetMin(fatMin);
+        m_nodes[nodeIndex].m_aabb.SetMax(fatMax);
 
         // insert new leaf node
         insertLeaf(nodeIndex);
 
+        bufferMove(nodeIndex);
+
         return true;
     }
 
-    std::vector<std::shared_ptr<RigidBody>> DynamicAABBTree::Query(const std::shared_ptr<RigidBody>& ptr)
+    const LongMarch_Vector<BroadPhasePair>& DynamicAABBTree::UpdatePairs()
+    {
+        // drop pairs that stopped overlapping, only a pair with a reinserted leaf could have changed
+        std::erase_if(m_pairs, [this](const BroadPhasePair& pair)
+        {
+            const auto& a = m_nodes[pair.m_proxyA];
+            const auto& b = m_nodes[pair.m_proxyB];
+            return (a.m_moved || b.m_moved) && !Overlaps(a.m_aabb.GetMin(), a.m_aabb.GetMax(), b.m_aabb.GetMin(), b.m_aabb.GetMax());
+        });
+
+        // query the tree for every reinserted leaf
+        m_newPairs.clear();
+        for (int proxy : m_moveBuffer)
+        {
+            const auto& node = m_nodes[proxy];
+            const Vec3f queryMin = node.m_aabb.GetMin();
+            const Vec3f queryMax = node.m_aabb.GetMax();
+
+            m_queryStack.clear();
+            m_queryStack.push_back(m_root);
+            while (!m_queryStack.empty())
+            {
+                int nodeIndex = m_queryStack.back();
+                m_queryStack.pop_back();
+
+                if (nodeIndex == NULL_NODE)
+                    continue;
+
+                const auto& other = m_nodes[nodeIndex];
+                if (!Overlaps(queryMin, queryMax, other.m_aabb.GetMin(), other.m_aabb.GetMax()))
+                    continue;
+
+                if (other.IsLeaf())
+                {
+                    // a pair of two reinserted leaves is found from both sides, keep the one from the leaf of the lower index
+                    if (nodeIndex == proxy || (other.m_moved && nodeIndex < proxy))
+                        continue;
+
+                    if (proxy < nodeIndex)
+                        m_newPairs.push_back(BroadPhasePair{ node.m_obj, other.m_obj, proxy, nodeIndex });
+                    else
+                        m_newPairs.push_back(BroadPhasePair{ other.m_obj, node.m_obj, nodeIndex, proxy });
+                }
+
+                else
+                {
+                    m_queryStack.push_back(other.m_left);
+                    m_queryStack.push_back(other.m_right);
+                }
+            }
+        }
+
+        for (int proxy : m_moveBuffer)
+        {
+            m_nodes[proxy].m_moved = false;
+        }
+        m_moveBuffer.clear();
+
+        // new pairs of a leaf that was already overlapping before it moved are in both lists, merge the sorted lists and drop the duplicates
+        if (!m_newPairs.empty())
+        {
+            std::sort(m_newPairs.begin(), m_newPairs.end());
+            m_mergedPairs.clear();
+            m_mergedPairs.reserve(m_pairs.size() + m_newPairs.size());
+            std::merge(m_pairs.begin(), m_pairs.end(), m_newPairs.begin(), m_newPairs.end(), std::back_inserter(m_mergedPairs));
+            m_mergedPairs.erase(std::unique(m_mergedPairs.begin(), m_mergedPairs.end()), m_mergedPairs.end());
+            m_pairs.swap(m_mergedPairs);
+        }
+
+        return m_pairs;
+    }
+
+    const LongMarch_Vector<BroadPhasePair>& DynamicAABBTree::GetPairs() const
+    {
+        return m_pairs;
+    }
+
+    void DynamicAABBTree::computeFatAABB(RigidBody* ptr, const Vec3f& displacement, Vec3f& fatMin, Vec3f& fatMax) const
+    {
+        Vec3f tightMin, tightMax;
+        ptr->GetShape()->GetBoundingBoxMinMax(tightMin, tightMax);
+
+        // skin thickness is proportional to the size of the object
+        Vec3f skinThickness = (tightMax - tightMin) * static_cast<float>(m_skinThickness);
+        Vec3f predicted = displacement * kDisplacementMultiplier;
+
+        fatMin = tightMin - skinThickness + glm::min(predicted, Vec3f(0.0f));
+        fatMax = tightMax + skinThickness + glm::max(predicted, Vec3f(0.0f));
+    }
+
+    void DynamicAABBTree::bufferMove(int nodeIndex)
+    {
+        if (!m_nodes[nodeIndex].m_moved)
+        {
+            m_nodes[nodeIndex].m_moved = true;
+            m_moveBuffer.push_back(nodeIndex);
+        }
+    }
+
+    FrameVector<RigidBody*> DynamicAABBTree::Query(RigidBody* ptr)
     {
         ENGINE_EXCEPT_IF(m_objectMap.count(ptr) == 0, L"Attempted to query but invalid ptr provided!");
 
         return Query(ptr, m_nodes[m_objectMap.find(ptr)->second].m_aabb);
     }
 
-    std::vector<std::shared_ptr<RigidBody>> DynamicAABBTree::Query(const std::shared_ptr<RigidBody>& ptr, const AABB& aabb)
+    FrameVector<RigidBody*> DynamicAABBTree::Query(RigidBody* ptr, const AABB& aabb)
     {
-        std::stack<size_t> nodeStack;
-        nodeStack.push(m_root);
+        FrameVector<int> nodeStack;
+        nodeStack.push_back(m_root);
 
-        std::vector<std::shared_ptr<RigidBody>> objList;
+        FrameVector<RigidBody*> objList;
 
-        while (nodeStack.size() > 0)
+        while (!nodeStack.empty())
         {
-            size_t nodeIndex = nodeStack.top();
-            nodeStack.pop();
+            int nodeIndex = nodeStack.back();
+            nodeStack.pop_back();
 
             // if null node, skip to next node
             if (nodeIndex == NULL_NODE)
@@ -322,8 +449,8 @@ namespace longmarch
                 // if not leaf node, add children nodes to stack
                 else
                 {
-                    nodeStack.push(m_nodes[nodeIndex].m_left);
-                    nodeStack.push(m_nodes[nodeIndex].m_right);
+                    nodeStack.push_back(m_nodes[nodeIndex].m_left);
+                    nodeStack.push_back(m_nodes[nodeIndex].m_right);
                 }
             }
         }
@@ -331,17 +458,17 @@ namespace longmarch
         return objList;
     }
 
-    std::vector<std::shared_ptr<RigidBody>> DynamicAABBTree::Query(const AABB& aabb)
+    FrameVector<RigidBody*> DynamicAABBTree::Query(const AABB& aabb)
     {
         // if tree is empty, return empty vector
         if (m_objectMap.size() == 0)
-            return std::vector<std::shared_ptr<RigidBody>>();
+            return FrameVector<RigidBody*>();
 
         // otherwise test overlap with all objects and return results
         return Query(nullptr, aabb);
     }
 
-    const AABB& DynamicAABBTree::GetAABB(const std::shared_ptr<RigidBody>& ptr)
+    const AABB& DynamicAABBTree::GetAABB(RigidBody* ptr)
     {
         // throw exception if AABB can't be obtained
         ENGINE_EXCEPT_IF(m_objectMap.count(ptr) == 0, L"Attempted to get AABB from tree but RB does not exist!");
@@ -704,7 +831,8 @@ namespace longmarch
     {
         ENGINE_EXCEPT_IF(nodeIndex >= m_nodeCapacity, L"Node index provided is out of bounds!");
 
-        if (m_nodes[nodeIndex].IsLeaf())
+        // an empty tree has no root
+        if (nodeIndex == NULL_NODE || m_nodes[nodeIndex].IsLeaf())
             return 0;
 
         unsigned int height1 = computeHeight(m_nodes[nodeIndex].m_left);
@@ -6,6 +6,8 @@
 #include <FastBVH.h>
 
 #include "engine/math/Geommath.h"
+#include "engine/core/allocator/FrameArena.h"
+#include "engine/core/utility/TypeHelper.h"
 
 #include "engine/physics/AABB.h"
 #include "engine/physics/dynamics/RigidBody.h"
@@ -44,8 +46,8 @@ namespace longmarch
         // height is 0 for leaf nodes and -1 for free nodes
         int m_height;
 
-        // index of object contained in the node (only for leaf nodes)
-        std::shared_ptr<RigidBody> m_obj;
+        // object contained in the node (only for leaf nodes), the tree does not own the rigid body
+        RigidBody* m_obj;
     };
 
     struct DynamicAABBTreeNode : DynamicTreeNode
@@ -55,6 +57,27 @@ namespace longmarch
 
         // AABB of the node (not the same as the AABB of the object contained in the node (if it's a leaf node)
         AABB m_aabb;
+
+        // leaf has been inserted or reinserted since the last UpdatePairs()
+        bool m_moved;
+    };
+
+    //! Pair of objects whose fat AABBs overlap, ordered by proxy so that each pair is listed once
+    struct BroadPhasePair
+    {
+        RigidBody* m_A;
+        RigidBody* m_B;
+        int m_proxyA;
+        int m_proxyB;
+
+        inline bool operator<(const BroadPhasePair& other) const
+        {
+            return (m_proxyA != other.m_proxyA) ? (m_proxyA < other.m_proxyA) : (m_proxyB < other.m_proxyB);
+        }
+        inline bool operator==(const BroadPhasePair& other) const
+        {
+            return m_proxyA == other.m_proxyA && m_proxyB == other.m_proxyB;
+        }
     };
 
     class DynamicTree
@@ -62,7 +85,7 @@ namespace longmarch
     public:
         DynamicTree(unsigned int numObjects = 16, double skinThickness = 0.05);
 
-        //virtual void InsertObject(const std::shared_ptr<RigidBody>& ptr) = 0;
+        //virtual void InsertObject(RigidBody* ptr) = 0;
 
         //void InsertObject(std::shared_ptr<RigidBody>, Vec3f& pos, double radius);
 
@@ -70,19 +93,19 @@ namespace longmarch
 
         virtual int GetNumObjects() = 0;
 
-        virtual void RemoveObject(const std::shared_ptr<RigidBody>& ptr) = 0;
+        virtual void RemoveObject(RigidBody* ptr) = 0;
 
         virtual void RemoveAllObjects() = 0;
 
         // Update object if it moves outside its enclosing shape
-        //virtual bool UpdateObject(const std::shared_ptr<RigidBody>& ptr) = 0;
+        //virtual bool UpdateObject(RigidBody* ptr) = 0;
 
         //bool UpdateObject(size_t id, Vec3f& pos, double radius, bool alwaysReinsert = false);
 
         //bool UpdateObject(size_t id, Vec3f& lowerBound, Vec3f& upperBound, bool alwaysReinsert = false);
 
         // Query the tree to find intersecting objects
-        virtual std::vector<std::shared_ptr<RigidBody>> Query(const std::shared_ptr<RigidBody>& ptr) = 0;
+        virtual FrameVector<RigidBody*> Query(RigidBody* ptr) = 0;
 
         //virtual unsigned int GetHeight() const;
         //virtual unsigned int GetNodeCount() const;
@@ -109,7 +132,7 @@ namespace longmarch
         double m_skinThickness;
 
         // A map between object and node indices.
-        std::unordered_map<std::shared_ptr<RigidBody>, int> m_objectMap;
+        std::unordered_map<RigidBody*, int> m_objectMap;
 
         virtual int allocateNode() = 0;
 
@@ -131,37 +154,58 @@ namespace longmarch
         
     };
 
-    // specialization for spheres
+    /**
+     *  @brief Persistent broadphase, leaves keep fattened AABBs so that only objects that leave their fat AABB are reinserted
+     *
+     *  Use it like : tree.InsertObject(rb); // Once per object
+     *                ...
+     *                tree.UpdateObject(rb, rb->GetLinearVelocity() * dt); // Every step, cheap when the object stays inside its fat AABB
+     *                for (const auto& pair : tree.UpdatePairs()) { ... }
+     *
+     *  @details Fat AABBs are the tight AABB grown by the skin thickness (relative to the size of the object) and stretched along the predicted
+     *           displacement. The overlapping pair list persists between steps, UpdatePairs() only queries the tree for objects that have been
+     *           reinserted and only drops pairs of those objects, because the fat AABBs of two objects that stayed put can not have changed.
+     *           Pairs are sorted by proxy so that the list is deduplicated and its order does not depend on the traversal.
+     */
     class DynamicAABBTree : DynamicTree
     {
     public:
         //! Constructor
         DynamicAABBTree(unsigned int numObjects = 16, double skinThickness = 0.05);
 
-        void InsertObject(const std::shared_ptr<RigidBody>& ptr);
+        void InsertObject(RigidBody* ptr, const Vec3f& displacement = Vec3f(0.0f));
+
+        bool HasObject(RigidBody* ptr) const;
 
         int GetNumObjects();
 
-        void RemoveObject(const std::shared_ptr<RigidBody>& ptr);
+        void RemoveObject(RigidBody* ptr);
 
         void RemoveAllObjects();
 
-        // Update object if it moves outside its fattened AABB
-        //bool UpdateObject(size_t id, Vec3f& pos, double radius, bool alwaysReinsert = false);
+        // Update object if it moves outside its fattened AABB, return true if the object has been reinserted
+        bool UpdateObject(RigidBody* ptr, bool alwaysReInsert = false);
+
+        // Update object with its predicted displacement of the coming step, return true if the object has been reinserted
+        bool UpdateObject(RigidBody* ptr, const Vec3f& displacement, bool alwaysReInsert = false);
 
-        bool UpdateObject(const std::shared_ptr<RigidBody>& ptr, bool alwaysReInsert = false);
+        // Find the pairs of objects that started overlapping and drop the ones that stopped since the last call, the result lives until the next call
+        const LongMarch_Vector<BroadPhasePair>& UpdatePairs();
 
-        // Query the tree to find candidate interactions for an object.
-        std::vector<std::shared_ptr<RigidBody>> Query(const std::shared_ptr<RigidBody>& ptr);
+        // Overlapping pairs found by the last UpdatePairs()
+        const LongMarch_Vector<BroadPhasePair>& GetPairs() const;
+
+        // Query the tree to find candidate interactions for an object, the result lives until the end of the frame.
+        FrameVector<RigidBody*> Query(RigidBody* ptr);
 
         // Query the tree to find candidate interactions for a AABB.
-        std::vector<std::shared_ptr<RigidBody>> Query(const std::shared_ptr<RigidBody>& ptr, const AABB& aabb);
+        FrameVector<RigidBody*> Query(RigidBody* ptr, const AABB& aabb);
 
         // Query the tree to find candidate interactions for an AABB.
-        std::vector<std::shared_ptr<RigidBody>> Query(const AABB& aabb);
+        FrameVector<RigidBody*> Query(const AABB& aabb);
 
         // Get AABB of an object given its rigid body ptr
-        const AABB& GetAABB(const std::shared_ptr<RigidBody>& ptr);
+        const AABB& GetAABB(RigidBody* ptr);
 
         // Get the height of the tree.
         unsigned int GetHeight() const;
@@ -205,7 +249,24 @@ namespace longmarch
         // Check if metrics are valid from specified index onwards
         void validateMetrics(int nodeIndex) const;
 
+        // Compute the fat AABB of an object from its shape and its predicted displacement
+        void computeFatAABB(RigidBody* ptr, const Vec3f& displacement, Vec3f& fatMin, Vec3f& fatMax) const;
+
+        // Queue a leaf for the next UpdatePairs()
+        void bufferMove(int nodeIndex);
+
         // The radius of the system
         double m_radius;
+
+        // Leaves that have been inserted or reinserted since the last UpdatePairs()
+        LongMarch_Vector<int> m_moveBuffer;
+
+        // Sorted and unique overlapping pairs
+        LongMarch_Vector<BroadPhasePair> m_pairs;
+
+        // Scratch buffers of UpdatePairs()
+        LongMarch_Vector<BroadPhasePair> m_newPairs;
+        LongMarch_Vector<BroadPhasePair> m_mergedPairs;
+        LongMarch_Vector<int> m_queryStack;
     };
 }
@@ -0,0 +1,181 @@
+#include "engine-precompiled-header.h"
+
+#include "NarrowPhase.h"
+#include "engine/physics/CollisionsManager.h"
+#include "engine/core/thread/JobSystem.h"
+
+namespace longmarch
+{
+    namespace
+    {
+        using ContactTest = bool (*)(Shape* shape1, const Vec3f& vel1, Shape* shape2, const Vec3f& vel2, float dt, Manifold& manifold);
+
+        bool AABBvsAABB(Shape* shape1, const Vec3f& vel1, Shape* shape2, const Vec3f& vel2, float dt, Manifold& manifold)
+        {
+            return DynamicAABBvsAABB(static_cast<AABB*>(shape1), vel1, static_cast<AABB*>(shape2), vel2, dt, manifold);
+        }
+
+        bool CirclevsCircle(Shape* shape1, const Vec3f& vel1, Shape* shape2, const Vec3f& vel2, float dt, Manifold& manifold)
+        {
+            return DynamicCirclevsCircle(static_cast<Circle*>(shape1), vel1, static_cast<Circle*>(shape2), vel2, dt, manifold);
+        }
+
+        // Contact test of each bucket, nullptr for shape pairs that do not generate contacts
+        constexpr ContactTest kContactTests[static_cast<size_t>(NarrowPhaseBatch::SHAPE_PAIR::NUM)] =
+        {
+            &AABBvsAABB,
+            &CirclevsCircle,
+            nullptr,
+            nullptr,
+        };
+    }
+
+    void ContactManifolds::Resize(size_t size)
+    {
+        m_A.resize(size);
+        m_B.resize(size);
+        m_intersectTime.resize(size);
+        m_normal.resize(size);
+        m_penetration.resize(size);
+        m_friction.resize(size);
+        m_staticCollision.resize(size);
+    }
+
+    void ContactManifolds::Set(size_t i, const Manifold& manifold)
+    {
+        m_A[i] = manifold.m_A;
+        m_B[i] = manifold.m_B;
+        m_intersectTime[i] = manifold.m_intersectTime;
+        m_normal[i] = manifold.m_normal;
+        m_penetration[i] = manifold.m_contact.m_penetration;
+        m_friction[i] = manifold.m_friction;
+        m_staticCollision[i] = manifold.m_staticCollision;
+    }
+
+    void ContactManifolds::Move(size_t from, size_t to)
+    {
+        m_A[to] = m_A[from];
+        m_B[to] = m_B[from];
+        m_intersectTime[to] = m_intersectTime[from];
+        m_normal[to] = m_normal[from];
+        m_penetration[to] = m_penetration[from];
+        m_friction[to] = m_friction[from];
+        m_staticCollision[to] = m_staticCollision[from];
+    }
+
+    Manifold ContactManifolds::Get(size_t i) const
+    {
+        Manifold manifold;
+        manifold.m_A = m_A[i];
+        manifold.m_B = m_B[i];
+        manifold.m_intersectTime = m_intersectTime[i];
+        manifold.m_normal = m_normal[i];
+        manifold.m_gravity = m_gravity;
+        manifold.m_contact.m_pos = Vec3f(0.0f);
+        manifold.m_contact.m_penetration = m_penetration[i];
+        manifold.m_friction = m_friction[i];
+        manifold.m_staticCollision = (m_staticCollision[i] != 0);
+        return manifold;
+    }
+
+    NarrowPhaseBatch::SHAPE_PAIR NarrowPhaseBatch::GetShapePair(Shape::SHAPE_TYPE type1, Shape::SHAPE_TYPE type2)
+    {
+        using SHAPE_TYPE = Shape::SHAPE_TYPE;
+        if (type1 == SHAPE_TYPE::AABB && type2 == SHAPE_TYPE::AABB)
+        {
+            return SHAPE_PAIR::AABB_AABB;
+        }
+        if (type1 == SHAPE_TYPE::CIRCLE && type2 == SHAPE_TYPE::CIRCLE)
+        {
+            return SHAPE_PAIR::CIRCLE_CIRCLE;
+        }
+        if ((type1 == SHAPE_TYPE::AABB && type2 == SHAPE_TYPE::CIRCLE) || (type1 == SHAPE_TYPE::CIRCLE && type2 == SHAPE_TYPE::AABB))
+        {
+            return SHAPE_PAIR::AABB_CIRCLE;
+        }
+        return SHAPE_PAIR::OTHER;
+    }
+
+    const ContactManifolds& NarrowPhaseBatch::Collide(const LongMarch_Vector<BroadPhasePair>& pairs, const Vec3f& gravity, float dt)
+    {
+        const auto numPairs = pairs.size();
+        m_manifolds.Resize(numPairs);
+        m_manifolds.m_gravity = gravity;
+        m_hits.assign(numPairs, 0);
+
+        for (auto& bucket : m_buckets)
+        {
+            bucket.clear();
+        }
+        for (size_t i = 0; i < numPairs; ++i)
+        {
+            const auto shapePair = GetShapePair(pairs[i].m_A->GetShape()->GetType(), pairs[i].m_B->GetShape()->GetType());
+            m_buckets[static_cast<size_t>(shapePair)].push_back(static_cast<uint32_t>(i));
+        }
+
+        for (size_t b = 0; b < static_cast<size_t>(SHAPE_PAIR::NUM); ++b)
+        {
+            const auto test = kContactTests[b];
+            const auto& bucket = m_buckets[b];
+            if (!test || bucket.empty())
+            {
+                continue;
+            }
+
+            // every pair writes to its own slot, so chunks never share memory
+            auto collide = [this, test, &bucket, &pairs, &gravity, dt](size_t first, size_t last)
+            {
+                for (auto k = first; k < last; ++k)
+                {
+                    const auto i = bucket[k];
+                    auto rb1 = pairs[i].m_A;
+                    auto rb2 = pairs[i].m_B;
+
+                    Manifold contactManifold;
+                    if (test(rb1->GetShape(), rb1->GetLinearVelocity(), rb2->GetShape(), rb2->GetLinearVelocity(), dt, contactManifold))
+                    {
+                        contactManifold.m_A = rb1;
+                        contactManifold.m_B = rb2;
+
+                        contactManifold.m_gravity = gravity;
+                        contactManifold.m_friction = (rb1->GetFriction() + rb2->GetFriction()) * 0.5f;
+
+                        m_manifolds.Set(i, contactManifold);
+                        m_hits[i] = 1;
+                    }
+                }
+            };
+
+            if (bucket.size() >= 2 * kPairsPerChunk)
+            {
+                // the calling thread might hold the lock of the scene, see JobSystem::ParallelForNoHelp
+                JobSystem::ParallelForNoHelp(0, bucket.size(), kPairsPerChunk, collide);
+            }
+            else
+            {
+                collide(0, bucket.size());
+            }
+        }
+
+        // compact in the order of the pairs
+        size_t numContacts = 0;
+        for (size_t i = 0; i < numPairs; ++i)
+        {
+            if (m_hits[i])
+            {
+                if (numContacts != i)
+                {
+                    m_manifolds.Move(i, numContacts);
+                }
+                ++numContacts;
+            }
+        }
+        m_manifolds.Resize(numContacts);
+        return m_manifolds;
+    }
+
+    const ContactManifolds& NarrowPhaseBatch::GetManifolds() const
+    {
+        return m_manifolds;
+    }
+}
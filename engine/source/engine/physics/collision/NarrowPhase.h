@@ -0,0 +1,99 @@
+#pragma once
+
+#include "engine/math/Geommath.h"
+#include "engine/core/utility/TypeHelper.h"
+
+#include "engine/physics/Shape.h"
+#include "engine/physics/dynamics/Contact.h"
+#include "DynamicTree.h"
+
+namespace longmarch
+{
+    /**
+     *  @brief Contact manifolds stored as structure of arrays, the buffers are reused between steps
+     *
+     *  @details Get() builds a Manifold for the code that still takes one (e.g. collision events).
+     *
+     *  @author Hang Yu (yohan680919@gmail.com)
+     */
+    struct ContactManifolds
+    {
+        void Resize(size_t size);
+
+        inline size_t Size() const
+        {
+            return m_A.size();
+        }
+
+        inline bool Empty() const
+        {
+            return m_A.empty();
+        }
+
+        //! Write a manifold to slot i
+        void Set(size_t i, const Manifold& manifold);
+
+        //! Copy slot from to slot to
+        void Move(size_t from, size_t to);
+
+        //! Read slot i as a manifold
+        Manifold Get(size_t i) const;
+
+        LongMarch_Vector<RigidBody*> m_A;
+        LongMarch_Vector<RigidBody*> m_B;
+        LongMarch_Vector<float> m_intersectTime;
+        LongMarch_Vector<Vec3f> m_normal;
+        LongMarch_Vector<float> m_penetration;
+        LongMarch_Vector<float> m_friction;
+        LongMarch_Vector<uint8_t> m_staticCollision;
+
+        //! Gravity of the scene is the same for every manifold
+        Vec3f m_gravity{ Vec3f(0.0f) };
+    };
+
+    /**
+     *  @brief Narrowphase over a broadphase pair list, pairs are bucketed by the types of their shapes so that each bucket calls its contact
+     *         test directly, and large buckets are split in chunks that run in parallel on the job system
+     *
+     *  Use it like : const auto& manifolds = batch.Collide(pairs, gravity, dt);
+     *                solver.Prepare(island.m_bodies, manifolds, cache, dt, enableFriction); // See ContactSolver
+     *
+     *  @details Every pair writes to the slot of its index and the slots are compacted in the order of the pairs afterwards,
+     *           so the manifolds are the same whatever the number of threads and the way the pairs are chunked, and replays stay valid.
+     *           Only AABB vs AABB and circle vs circle have contact tests, the other shape pairs do not generate contacts yet.
+     *
+     *  @author Hang Yu (yohan680919@gmail.com)
+     */
+    class NarrowPhaseBatch
+    {
+    public:
+        enum class SHAPE_PAIR : uint8_t
+        {
+            AABB_AABB = 0,
+            CIRCLE_CIRCLE,
+            AABB_CIRCLE,
+            OTHER, //!< OOBB and empty shapes
+            NUM
+        };
+
+        //! Pairs per parallel chunk, smaller buckets run on the calling thread
+        constexpr inline static size_t kPairsPerChunk = { 64 };
+
+        static SHAPE_PAIR GetShapePair(Shape::SHAPE_TYPE type1, Shape::SHAPE_TYPE type2);
+
+        //! Collide the pairs, the result lives until the next call
+        const ContactManifolds& Collide(const LongMarch_Vector<BroadPhasePair>& pairs, const Vec3f& gravity, float dt);
+
+        //! Manifolds of the last Collide()
+        const ContactManifolds& GetManifolds() const;
+
+    private:
+        ContactManifolds m_manifolds;
+
+        // Indices of the pairs of each bucket
+        LongMarch_Vector<uint32_t> m_buckets[static_cast<size_t>(SHAPE_PAIR::NUM)];
+
+        // Whether the pair at the same index generated a contact
+        LongMarch_Vector<uint8_t> m_hits;
+    };
+}
@@ -0,0 +1,326 @@
+#include "engine-precompiled-header.h"
+
+#include "SweepAndPrune.h"
+
+#include <bit>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace longmarch
+{
+    namespace
+    {
+        // Number of candidates tested at once by the sweep, the gathered bounds are padded by as many empty bounds
+        constexpr int kLanes = 8;
+
+        // Switch the sweep axis only when another axis is clearly better, so that objects spread evenly do not resort every step
+        constexpr double kAxisSwitchRatio = 1.5;
+    }
+
+    SweepAndPrune::SweepAndPrune(double skinThickness)
+        : m_numSorted(0),
+        m_skinThickness(skinThickness),
+        m_axis(0)
+    {
+    }
+
+    void SweepAndPrune::InsertObject(RigidBody* ptr, const Vec3f& displacement)
+    {
+        // make sure object exists
+        ENGINE_EXCEPT_IF(ptr == nullptr, L"Rigid Body to insert doesn't exist!");
+
+        // make sure object has a shape
+        ENGINE_EXCEPT_IF(ptr->GetShape() == nullptr, L"Rigid Body to insert doesn't have a shape!");
+
+        // make sure object is new to the broadphase
+        ENGINE_EXCEPT_IF(m_objectMap.contains(ptr), L"Object is already in the sweep and prune!");
+
+        int proxy;
+        if (!m_freeProxies.empty())
+        {
+            proxy = m_freeProxies.back();
+            m_freeProxies.pop_back();
+        }
+        else
+        {
+            proxy = static_cast<int>(m_objects.size());
+            m_objects.push_back(nullptr);
+            for (int i = 0; i < 3; ++i)
+            {
+                m_min[i].push_back(0.0f);
+                m_max[i].push_back(0.0f);
+            }
+        }
+        m_objects[proxy] = ptr;
+        setBounds(proxy, ptr, displacement);
+        m_objectMap.emplace(ptr, proxy);
+
+        // new proxies are sorted in a batch by the next UpdatePairs()
+        m_sorted.push_back(SortKey{ m_min[m_axis][proxy], proxy });
+    }
+
+    bool SweepAndPrune::HasObject(RigidBody* ptr) const
+    {
+        return m_objectMap.contains(ptr);
+    }
+
+    int SweepAndPrune::GetNumObjects() const
+    {
+        return static_cast<int>(m_objectMap.size());
+    }
+
+    void SweepAndPrune::RemoveObject(RigidBody* ptr)
+    {
+        auto iter = m_objectMap.find(ptr);
+        ENGINE_EXCEPT_IF(iter == m_objectMap.end(), L"Attempted to remove object but invalid ptr provided!");
+
+        const int proxy = iter->second;
+        m_objectMap.erase(iter);
+        m_objects[proxy] = nullptr;
+        m_freeProxies.push_back(proxy);
+
+        // keep the order of the remaining proxies so that the next sort stays cheap
+        const auto sortedIter = std::find_if(m_sorted.begin(), m_sorted.end(), [proxy](const SortKey& key) { return key.m_proxy == proxy; });
+        if (static_cast<size_t>(sortedIter - m_sorted.begin()) < m_numSorted)
+        {
+            --m_numSorted;
+        }
+        m_sorted.erase(sortedIter);
+
+        std::erase_if(m_pairs, [proxy](const BroadPhasePair& pair) { return pair.m_proxyA == proxy || pair.m_proxyB == proxy; });
+    }
+
+    void SweepAndPrune::RemoveAllObjects()
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            m_min[i].clear();
+            m_max[i].clear();
+        }
+        m_objects.clear();
+        m_freeProxies.clear();
+        m_objectMap.clear();
+        m_sorted.clear();
+        m_numSorted = 0;
+        m_pairs.clear();
+    }
+
+    void SweepAndPrune::UpdateObject(RigidBody* ptr, const Vec3f& displacement)
+    {
+        auto iter = m_objectMap.find(ptr);
+        ENGINE_EXCEPT_IF(iter == m_objectMap.end(), L"Attempted to update object but invalid ptr provided!");
+
+        setBounds(iter->second, ptr, displacement);
+    }
+
+    const LongMarch_Vector<BroadPhasePair>& SweepAndPrune::UpdatePairs()
+    {
+        const bool axisChanged = chooseSweepAxis();
+        sortProxies(axisChanged);
+        gatherBounds();
+        sweep();
+        return m_pairs;
+    }
+
+    const LongMarch_Vector<BroadPhasePair>& SweepAndPrune::GetPairs() const
+    {
+        return m_pairs;
+    }
+
+    int SweepAndPrune::GetSweepAxis() const
+    {
+        return m_axis;
+    }
+
+    void SweepAndPrune::setBounds(int proxy, RigidBody* ptr, const Vec3f& displacement)
+    {
+        Vec3f tightMin, tightMax;
+        ptr->GetShape()->GetBoundingBoxMinMax(tightMin, tightMax);
+
+        // bounds are rebuilt every step, so they only need to cover the displacement of the coming step
+        Vec3f skinThickness = (tightMax - tightMin) * static_cast<float>(m_skinThickness);
+        Vec3f boundsMin = tightMin - skinThickness + glm::min(displacement, Vec3f(0.0f));
+        Vec3f boundsMax = tightMax + skinThickness + glm::max(displacement, Vec3f(0.0f));
+
+        for (int i = 0; i < 3; ++i)
+        {
+            m_min[i][proxy] = boundsMin[i];
+            m_max[i][proxy] = boundsMax[i];
+        }
+    }
+
+    bool SweepAndPrune::chooseSweepAxis()
+    {
+        if (m_sorted.empty())
+        {
+            return false;
+        }
+
+        double sum[3] = { 0.0, 0.0, 0.0 };
+        double sumSquared[3] = { 0.0, 0.0, 0.0 };
+        for (const auto& key : m_sorted)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                const double center = 0.5 * (static_cast<double>(m_min[i][key.m_proxy]) + m_max[i][key.m_proxy]);
+                sum[i] += center;
+                sumSquared[i] += center * center;
+            }
+        }
+
+        const double count = static_cast<double>(m_sorted.size());
+        double variance[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            variance[i] = sumSquared[i] - sum[i] * sum[i] / count;
+        }
+
+        int best = m_axis;
+        for (int i = 0; i < 3; ++i)
+        {
+            if (variance[i] > variance[best])
+            {
+                best = i;
+            }
+        }
+        if (best != m_axis && variance[best] > variance[m_axis] * kAxisSwitchRatio)
+        {
+            m_axis = best;
+            return true;
+        }
+        return false;
+    }
+
+    void SweepAndPrune::sortProxies(bool fullSort)
+    {
+        const auto& keys = m_min[m_axis];
+        for (auto& key : m_sorted)
+        {
+            key.m_min = keys[key.m_proxy];
+        }
+
+        if (fullSort)
+        {
+            std::sort(m_sorted.begin(), m_sorted.end());
+            m_numSorted = m_sorted.size();
+            return;
+        }
+
+        // objects barely move between steps, insertion sort of the previous order only does a few swaps
+        for (size_t i = 1; i < m_numSorted; ++i)
+        {
+            const SortKey key = m_sorted[i];
+            size_t j = i;
+            for (; j > 0 && key < m_sorted[j - 1]; --j)
+            {
+                m_sorted[j] = m_sorted[j - 1];
+            }
+            m_sorted[j] = key;
+        }
+
+        // objects inserted since the last step are in no particular order, sort and merge them at once
+        if (m_numSorted < m_sorted.size())
+        {
+            const auto middle = m_sorted.begin() + m_numSorted;
+            std::sort(middle, m_sorted.end());
+            std::inplace_merge(m_sorted.begin(), middle, m_sorted.end());
+            m_numSorted = m_sorted.size();
+        }
+    }
+
+    void SweepAndPrune::gatherBounds()
+    {
+        const size_t count = m_sorted.size();
+        for (int i = 0; i < 3; ++i)
+        {
+            // index 0 is the sweep axis, 1 and 2 are the other two axes
+            const int axis = (m_axis + i) % 3;
+            const auto& mins = m_min[axis];
+            const auto& maxs = m_max[axis];
+            auto& sweepMin = m_sweepMin[i];
+            auto& sweepMax = m_sweepMax[i];
+            sweepMin.resize(count + kLanes);
+            sweepMax.resize(count + kLanes);
+            for (size_t j = 0; j < count; ++j)
+            {
+                const int proxy = m_sorted[j].m_proxy;
+                sweepMin[j] = mins[proxy];
+                sweepMax[j] = maxs[proxy];
+            }
+            // empty bounds end the sweep
+            std::fill(sweepMin.begin() + count, sweepMin.end(), std::numeric_limits<float>::infinity());
+            std::fill(sweepMax.begin() + count, sweepMax.end(), -std::numeric_limits<float>::infinity());
+        }
+    }
+
+    void SweepAndPrune::sweep()
+    {
+        m_pairs.clear();
+
+        const int count = static_cast<int>(m_sorted.size());
+        const float* min0 = m_sweepMin[0].data();
+        const float* max0 = m_sweepMax[0].data();
+        const float* min1 = m_sweepMin[1].data();
+        const float* max1 = m_sweepMax[1].data();
+        const float* min2 = m_sweepMin[2].data();
+        const float* max2 = m_sweepMax[2].data();
+
+        auto addPair = [this](int i, int j)
+        {
+            int proxyA = m_sorted[i].m_proxy;
+            int proxyB = m_sorted[j].m_proxy;
+            if (proxyA > proxyB)
+            {
+                std::swap(proxyA, proxyB);
+            }
+            m_pairs.emplace_back(BroadPhasePair{ m_objects[proxyA], m_objects[proxyB], proxyA, proxyB });
+        };
+
+        for (int i = 0; i < count; ++i)
+        {
+            // candidates are the following proxies whose lower bound on the sweep axis is within the bounds of this one
+#if defined(__AVX2__)
+            const __m256 upper0 = _mm256_set1_ps(max0[i]);
+            const __m256 lower1 = _mm256_set1_ps(min1[i]);
+            const __m256 upper1 = _mm256_set1_ps(max1[i]);
+            const __m256 lower2 = _mm256_set1_ps(min2[i]);
+            const __m256 upper2 = _mm256_set1_ps(max2[i]);
+            for (int j = i + 1; ; j += kLanes)
+            {
+                const __m256 inRange = _mm256_cmp_ps(_mm256_loadu_ps(min0 + j), upper0, _CMP_LE_OQ);
+                const __m256 overlap1 = _mm256_and_ps(
+                    _mm256_cmp_ps(_mm256_loadu_ps(min1 + j), upper1, _CMP_LE_OQ),
+                    _mm256_cmp_ps(_mm256_loadu_ps(max1 + j), lower1, _CMP_GE_OQ));
+                const __m256 overlap2 = _mm256_and_ps(
+                    _mm256_cmp_ps(_mm256_loadu_ps(min2 + j), upper2, _CMP_LE_OQ),
+                    _mm256_cmp_ps(_mm256_loadu_ps(max2 + j), lower2, _CMP_GE_OQ));
+
+                auto hits = static_cast<unsigned int>(_mm256_movemask_ps(_mm256_and_ps(inRange, _mm256_and_ps(overlap1, overlap2))));
+                while (hits != 0)
+                {
+                    addPair(i, j + std::countr_zero(hits));
+                    hits &= hits - 1;
+                }
+                // lower bounds are sorted, the first lane out of range ends the sweep of this proxy
+                if (_mm256_movemask_ps(inRange) != 0xFF)
+                {
+                    break;
+                }
+            }
+#else
+            for (int j = i + 1; min0[j] <= max0[i]; ++j)
+            {
+                if (min1[j] <= max1[i] && max1[j] >= min1[i]
+                    && min2[j] <= max2[i] && max2[j] >= min2[i])
+                {
+                    addPair(i, j);
+                }
+            }
+#endif
+        }
+
+        // same order as DynamicAABBTree, independent of the sweep axis
+        std::sort(m_pairs.begin(), m_pairs.end());
+    }
+}
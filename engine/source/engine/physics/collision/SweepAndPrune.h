@@ -0,0 +1,103 @@
+#pragma once
+
+#include "engine/math/Geommath.h"
+#include "engine/core/utility/TypeHelper.h"
+
+#include "engine/physics/dynamics/RigidBody.h"
+#include "DynamicTree.h"
+
+namespace longmarch
+{
+    /**
+     *  @brief Sort and sweep broadphase, an alternative to DynamicAABBTree for many similar sized moving objects
+     *
+     *  Use it like : sap.InsertObject(rb); // Once per object
+     *                ...
+     *                sap.UpdateObject(rb, rb->GetLinearVelocity() * dt); // Every step
+     *                for (const auto& pair : sap.UpdatePairs()) { ... }
+     *
+     *  @details Bounds are stored as structure of arrays indexed by proxy. Proxies are kept sorted by their lower bound on the sweep axis between
+     *           steps, objects move little from one step to the next so that re-sorting is a nearly linear insertion sort. The sweep axis is the
+     *           one along which the objects are spread the most, it is re-evaluated every step. The sweep tests the two other axes of eight
+     *           candidates at once with AVX2 when it is available.
+     *           Pairs are sorted by proxy the same as DynamicAABBTree, so that both broadphases can be swapped in a Scene.
+     *
+     *  @author Hang Yu (yohan680919@gmail.com)
+     */
+    class SweepAndPrune
+    {
+    public:
+        NONCOPYABLE(SweepAndPrune);
+        explicit SweepAndPrune(double skinThickness = 0.05);
+
+        void InsertObject(RigidBody* ptr, const Vec3f& displacement = Vec3f(0.0f));
+
+        bool HasObject(RigidBody* ptr) const;
+
+        int GetNumObjects() const;
+
+        void RemoveObject(RigidBody* ptr);
+
+        void RemoveAllObjects();
+
+        // Update the bounds of an object with its predicted displacement of the coming step
+        void UpdateObject(RigidBody* ptr, const Vec3f& displacement);
+
+        // Sort and sweep all objects, the result lives until the next call
+        const LongMarch_Vector<BroadPhasePair>& UpdatePairs();
+
+        // Overlapping pairs found by the last UpdatePairs()
+        const LongMarch_Vector<BroadPhasePair>& GetPairs() const;
+
+        // Axis (0, 1 or 2) that the last UpdatePairs() swept along
+        int GetSweepAxis() const;
+
+    private:
+        struct SortKey
+        {
+            float m_min;
+            int m_proxy;
+
+            inline bool operator<(const SortKey& other) const
+            {
+                return (m_min != other.m_min) ? (m_min < other.m_min) : (m_proxy < other.m_proxy);
+            }
+        };
+
+        // Write the bounds of an object to its proxy
+        void setBounds(int proxy, RigidBody* ptr, const Vec3f& displacement);
+
+        // Pick the axis with the largest variance of the centers, return true if it changed
+        bool chooseSweepAxis();
+
+        // Sort proxies by their lower bound on the sweep axis
+        void sortProxies(bool fullSort);
+
+        // Gather the bounds in sweep order, the sweep axis first
+        void gatherBounds();
+
+        void sweep();
+
+    private:
+        // Bounds indexed by proxy, one array per axis
+        LongMarch_Vector<float> m_min[3];
+        LongMarch_Vector<float> m_max[3];
+        LongMarch_Vector<RigidBody*> m_objects;
+        LongMarch_Vector<int> m_freeProxies;
+        LongMarch_UnorderedMap<RigidBody*, int> m_objectMap;
+
+        // Proxies sorted along the sweep axis, the first m_numSorted entries are kept sorted between steps and new proxies are appended
+        LongMarch_Vector<SortKey> m_sorted;
+        size_t m_numSorted;
+
+        // Bounds in sweep order, index 0 is the sweep axis, padded with empty bounds so that the sweep can always load eight lanes
+        LongMarch_Vector<float> m_sweepMin[3];
+        LongMarch_Vector<float> m_sweepMax[3];
+
+        // Sorted and unique overlapping pairs
+        LongMarch_Vector<BroadPhasePair> m_pairs;
+
+        double m_skinThickness;
+        int m_axis;
+    };
+}
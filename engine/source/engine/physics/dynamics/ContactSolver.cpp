@@ -0,0 +1,495 @@
+#include "engine-precompiled-header.h"
+
+#include "ContactSolver.h"
+
+#include <bit>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace longmarch
+{
+    namespace
+    {
+        // Rows solved at once, a batch is kLanes rows of the same color
+#if defined(__AVX2__)
+        constexpr int kLanes = 8;
+        using FloatV = __m256;
+
+        inline FloatV Set1(float f) { return _mm256_set1_ps(f); }
+        inline FloatV Load(const float* p) { return _mm256_loadu_ps(p); }
+        inline void Store(float* p, FloatV v) { _mm256_storeu_ps(p, v); }
+        inline FloatV Add(FloatV a, FloatV b) { return _mm256_add_ps(a, b); }
+        inline FloatV Sub(FloatV a, FloatV b) { return _mm256_sub_ps(a, b); }
+        inline FloatV Mul(FloatV a, FloatV b) { return _mm256_mul_ps(a, b); }
+        inline FloatV Min(FloatV a, FloatV b) { return _mm256_min_ps(a, b); }
+        inline FloatV Max(FloatV a, FloatV b) { return _mm256_max_ps(a, b); }
+
+        inline FloatV Gather(const float* base, const int32_t* index)
+        {
+            return _mm256_i32gather_ps(base, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index)), 4);
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        constexpr int kLanes = 4;
+        using FloatV = __m128;
+
+        inline FloatV Set1(float f) { return _mm_set1_ps(f); }
+        inline FloatV Load(const float* p) { return _mm_loadu_ps(p); }
+        inline void Store(float* p, FloatV v) { _mm_storeu_ps(p, v); }
+        inline FloatV Add(FloatV a, FloatV b) { return _mm_add_ps(a, b); }
+        inline FloatV Sub(FloatV a, FloatV b) { return _mm_sub_ps(a, b); }
+        inline FloatV Mul(FloatV a, FloatV b) { return _mm_mul_ps(a, b); }
+        inline FloatV Min(FloatV a, FloatV b) { return _mm_min_ps(a, b); }
+        inline FloatV Max(FloatV a, FloatV b) { return _mm_max_ps(a, b); }
+
+        inline FloatV Gather(const float* base, const int32_t* index)
+        {
+            return _mm_setr_ps(base[index[0]], base[index[1]], base[index[2]], base[index[3]]);
+        }
+#else
+        constexpr int kLanes = 1;
+        using FloatV = float;
+
+        inline FloatV Set1(float f) { return f; }
+        inline FloatV Load(const float* p) { return *p; }
+        inline void Store(float* p, FloatV v) { *p = v; }
+        inline FloatV Add(FloatV a, FloatV b) { return a + b; }
+        inline FloatV Sub(FloatV a, FloatV b) { return a - b; }
+        inline FloatV Mul(FloatV a, FloatV b) { return a * b; }
+        inline FloatV Min(FloatV a, FloatV b) { return std::min(a, b); }
+        inline FloatV Max(FloatV a, FloatV b) { return std::max(a, b); }
+
+        inline FloatV Gather(const float* base, const int32_t* index)
+        {
+            return base[index[0]];
+        }
+#endif
+
+        // Rows of a batch never share a dynamic body, lanes that share a static or kinematic body write back the same unchanged velocity
+        inline void Scatter(float* base, const int32_t* index, FloatV v)
+        {
+            float lanes[kLanes];
+            Store(lanes, v);
+            for (int i = 0; i < kLanes; ++i)
+            {
+                base[index[i]] = lanes[i];
+            }
+        }
+
+        inline FloatV Dot(const FloatV a[3], const FloatV b[3])
+        {
+            return Add(Add(Mul(a[0], b[0]), Mul(a[1], b[1])), Mul(a[2], b[2]));
+        }
+    }
+
+    const ContactImpulse* ContactCache::Find(const RigidBody* A, const RigidBody* B, uint32_t feature) const
+    {
+        ContactImpulse key;
+        key.m_idA = A->GetID();
+        key.m_idB = B->GetID();
+        key.m_feature = feature;
+
+        const auto iter = std::lower_bound(m_entries.begin(), m_entries.end(), key);
+        return (iter != m_entries.end() && !(key < *iter)) ? &*iter : nullptr;
+    }
+
+    void ContactCache::Add(const LongMarch_Vector<ContactImpulse>& impulses)
+    {
+        m_next.insert(m_next.end(), impulses.begin(), impulses.end());
+    }
+
+    void ContactCache::Commit()
+    {
+        std::sort(m_next.begin(), m_next.end());
+        std::swap(m_entries, m_next);
+        m_next.clear();
+    }
+
+    void ContactCache::RemoveBody(RigidBody* rb)
+    {
+        std::erase_if(m_entries, [rb](const ContactImpulse& impulse) { return impulse.m_A == rb || impulse.m_B == rb; });
+    }
+
+    void ContactCache::Clear()
+    {
+        m_entries.clear();
+        m_next.clear();
+    }
+
+    size_t ContactCache::Size() const
+    {
+        return m_entries.size();
+    }
+
+    int32_t ContactSolver::solverBody(RigidBody* rb)
+    {
+        switch (rb->GetRBType())
+        {
+        case RBType::dynamicBody:
+            return static_cast<int32_t>(rb->GetSolverIndex());
+        case RBType::kinematicBody:
+        {
+            const auto [iter, inserted] = m_kinematicSlots.try_emplace(rb, static_cast<int32_t>(m_solverBodies.size()));
+            if (!inserted)
+            {
+                return iter->second;
+            }
+            const auto& velocity = rb->GetLinearVelocity();
+            for (int k = 0; k < 3; ++k)
+            {
+                m_velocity[k].push_back(velocity[k]);
+            }
+            m_solverBodies.push_back(rb);
+            m_colorMasks.push_back(0);
+            return iter->second;
+        }
+        default:
+            return 0;
+        }
+    }
+
+    void ContactSolver::Prepare(const LongMarch_Vector<RigidBody*>& bodies, const ContactManifolds& manifolds, const ContactCache& cache, float dt, bool enableFriction)
+    {
+        m_solverBodies.clear();
+        m_solverBodies.push_back(nullptr);
+        m_kinematicSlots.clear();
+        for (int k = 0; k < 3; ++k)
+        {
+            m_velocity[k].clear();
+            m_velocity[k].push_back(0.0f);
+        }
+        for (auto& rb : bodies)
+        {
+            rb->SetSolverIndex(static_cast<uint32_t>(m_solverBodies.size()));
+            m_solverBodies.push_back(rb);
+            const auto& velocity = rb->GetLinearVelocity();
+            for (int k = 0; k < 3; ++k)
+            {
+                m_velocity[k].push_back(velocity[k]);
+            }
+        }
+        m_numDynamic = bodies.size();
+        m_colorMasks.assign(m_solverBodies.size(), 0);
+
+        auto isDynamic = [this](int32_t slot)
+        {
+            return slot > 0 && static_cast<size_t>(slot) <= m_numDynamic;
+        };
+
+        const auto numContacts = manifolds.Size();
+        m_contacts.resize(numContacts);
+        m_contactNormals.resize(numContacts);
+        m_contactBodies.resize(2 * numContacts);
+        m_contactColors.resize(numContacts);
+
+        // the last count is for the contacts that do not fit in kMaxColors colors
+        size_t colorCounts[kMaxColors + 1] = {};
+
+        for (size_t i = 0; i < numContacts; ++i)
+        {
+            auto A = manifolds.m_A[i];
+            auto B = manifolds.m_B[i];
+            if (B->GetID() < A->GetID())
+            {
+                std::swap(A, B);
+            }
+
+            // the normal points from A to B
+            auto normal = glm::normalize(manifolds.m_normal[i]);
+            if (glm::dot(B->GetWorldPosition() - A->GetWorldPosition(), normal) < 0.0f)
+            {
+                normal = -normal;
+            }
+
+            // the face the normal points out of tells the contacts of a pair apart
+            int axis = 0;
+            for (int k = 1; k < 3; ++k)
+            {
+                if (fabsf(normal[k]) > fabsf(normal[axis]))
+                {
+                    axis = k;
+                }
+            }
+            const auto feature = static_cast<uint32_t>(axis * 2 + ((normal[axis] < 0.0f) ? 1 : 0));
+
+            m_contacts[i] = ContactImpulse{ A, B, A->GetID(), B->GetID(), feature, 0.0f, { 0.0f, 0.0f }, Vec3f(0.0f), false };
+            m_contactNormals[i] = normal;
+
+            const auto slotA = solverBody(A);
+            const auto slotB = solverBody(B);
+            m_contactBodies[2 * i] = slotA;
+            m_contactBodies[2 * i + 1] = slotB;
+
+            // greedy coloring, take the lowest color that none of the dynamic bodies of the contact has yet
+            uint64_t used = 0;
+            if (isDynamic(slotA))
+            {
+                used |= m_colorMasks[slotA];
+            }
+            if (isDynamic(slotB))
+            {
+                used |= m_colorMasks[slotB];
+            }
+            uint32_t color = kMaxColors;
+            if (used != ~uint64_t(0))
+            {
+                color = static_cast<uint32_t>(std::countr_zero(~used));
+                const uint64_t bit = uint64_t(1) << color;
+                if (isDynamic(slotA))
+                {
+                    m_colorMasks[slotA] |= bit;
+                }
+                if (isDynamic(slotB))
+                {
+                    m_colorMasks[slotB] |= bit;
+                }
+            }
+            m_contactColors[i] = color;
+            ++colorCounts[color];
+        }
+
+        // rows of a color start on a whole batch, contacts beyond kMaxColors colors get a batch each and are solved one after another
+        size_t rowOffsets[kMaxColors + 1];
+        m_numRows = 0;
+        m_numColors = 0;
+        for (uint32_t c = 0; c < kMaxColors; ++c)
+        {
+            rowOffsets[c] = m_numRows;
+            m_numRows += (colorCounts[c] + kLanes - 1) / kLanes * kLanes;
+            if (colorCounts[c] > 0)
+            {
+                m_numColors = c + 1;
+            }
+        }
+        rowOffsets[kMaxColors] = m_numRows;
+        m_numRows += colorCounts[kMaxColors] * kLanes;
+
+        m_bodyA.assign(m_numRows, 0);
+        m_bodyB.assign(m_numRows, 0);
+        m_invMassA.assign(m_numRows, 0.0f);
+        m_invMassB.assign(m_numRows, 0.0f);
+        for (int k = 0; k < 3; ++k)
+        {
+            m_normal[k].assign(m_numRows, 0.0f);
+            m_tangent[0][k].assign(m_numRows, 0.0f);
+            m_tangent[1][k].assign(m_numRows, 0.0f);
+        }
+        m_mass.assign(m_numRows, 0.0f);
+        m_friction.assign(m_numRows, 0.0f);
+        m_normalTarget.assign(m_numRows, 0.0f);
+        m_normalImpulse.assign(m_numRows, 0.0f);
+        for (int t = 0; t < 2; ++t)
+        {
+            m_tangentTarget[t].assign(m_numRows, 0.0f);
+            m_tangentImpulse[t].assign(m_numRows, 0.0f);
+        }
+        m_rowContact.assign(m_numRows, -1);
+
+        for (size_t i = 0; i < numContacts; ++i)
+        {
+            const auto color = m_contactColors[i];
+            const auto row = rowOffsets[color];
+            rowOffsets[color] += (color == kMaxColors) ? kLanes : 1;
+
+            auto& contact = m_contacts[i];
+            const auto A = contact.m_A;
+            const auto B = contact.m_B;
+            const auto slotA = m_contactBodies[2 * i];
+            const auto slotB = m_contactBodies[2 * i + 1];
+            const float invMassA = isDynamic(slotA) ? A->GetInvMass() : 0.0f;
+            const float invMassB = isDynamic(slotB) ? B->GetInvMass() : 0.0f;
+
+            const auto& normal = m_contactNormals[i];
+            Vec3f tangents[2];
+            tangents[0] = glm::normalize(glm::cross(normal, (fabsf(normal.x) < 0.57735f) ? Vec3f(1.0f, 0.0f, 0.0f) : Vec3f(0.0f, 1.0f, 0.0f)));
+            tangents[1] = glm::cross(normal, tangents[0]);
+
+            m_bodyA[row] = slotA;
+            m_bodyB[row] = slotB;
+            m_invMassA[row] = invMassA;
+            m_invMassB[row] = invMassB;
+            for (int k = 0; k < 3; ++k)
+            {
+                m_normal[k][row] = normal[k];
+                m_tangent[0][k][row] = tangents[0][k];
+                m_tangent[1][k][row] = tangents[1][k];
+            }
+            // no angular terms, so the normal and tangent rows have the same effective mass
+            m_mass[row] = (invMassA + invMassB > 0.0f) ? 1.0f / (invMassA + invMassB) : 0.0f;
+            m_friction[row] = enableFriction ? manifolds.m_friction[i] : 0.0f;
+
+            const Vec3f velocityA(m_velocity[0][slotA], m_velocity[1][slotA], m_velocity[2][slotA]);
+            const Vec3f velocityB(m_velocity[0][slotB], m_velocity[1][slotB], m_velocity[2][slotB]);
+            const float normalSpeed = glm::dot(velocityB - velocityA, normal);
+
+            // a gap can be closed but not crossed within the step, penetration beyond the slop is pushed out over a few steps
+            const float separation = -manifolds.m_penetration[i];
+            float target = (separation > 0.0f) ? -separation / dt : kBaumgarte * std::max(-separation - kLinearSlop, 0.0f) / dt;
+
+            // bodies that meet within the step bounce if they approach fast enough
+            if (normalSpeed < -kRestitutionThreshold && normalSpeed * dt <= -separation)
+            {
+                const float restitution = (A->GetRestitution() + B->GetRestitution()) * 0.5f;
+                target = std::max(target, -restitution * normalSpeed);
+            }
+            m_normalTarget[row] = target;
+
+            // warm start from the last step, friction that held keeps its anchor
+            const Vec3f relativePos = B->GetWorldPosition() - A->GetWorldPosition();
+            Vec3f anchor = relativePos;
+            if (const auto cached = cache.Find(A, B, contact.m_feature))
+            {
+                m_normalImpulse[row] = cached->m_normalImpulse;
+                if (m_friction[row] > 0.0f)
+                {
+                    m_tangentImpulse[0][row] = cached->m_tangentImpulse[0];
+                    m_tangentImpulse[1][row] = cached->m_tangentImpulse[1];
+                    if (cached->m_sticking)
+                    {
+                        anchor = cached->m_anchor;
+                    }
+                }
+            }
+            for (int t = 0; t < 2; ++t)
+            {
+                m_tangentTarget[t][row] = -kBaumgarte * glm::dot(relativePos - anchor, tangents[t]) / dt;
+            }
+            contact.m_anchor = anchor;
+            m_rowContact[row] = static_cast<int32_t>(i);
+        }
+    }
+
+    void ContactSolver::WarmStart()
+    {
+        for (size_t row = 0; row < m_numRows; ++row)
+        {
+            const float normalImpulse = m_normalImpulse[row];
+            const float tangentImpulse0 = m_tangentImpulse[0][row];
+            const float tangentImpulse1 = m_tangentImpulse[1][row];
+            const auto a = m_bodyA[row];
+            const auto b = m_bodyB[row];
+            for (int k = 0; k < 3; ++k)
+            {
+                const float impulse = m_normal[k][row] * normalImpulse + m_tangent[0][k][row] * tangentImpulse0 + m_tangent[1][k][row] * tangentImpulse1;
+                m_velocity[k][a] -= impulse * m_invMassA[row];
+                m_velocity[k][b] += impulse * m_invMassB[row];
+            }
+        }
+    }
+
+    void ContactSolver::SolveVelocities()
+    {
+        for (size_t row = 0; row < m_numRows; row += kLanes)
+        {
+            solveBatch(row);
+        }
+    }
+
+    void ContactSolver::solveBatch(size_t row)
+    {
+        const int32_t* indexA = m_bodyA.data() + row;
+        const int32_t* indexB = m_bodyB.data() + row;
+
+        FloatV velocityA[3];
+        FloatV velocityB[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            velocityA[k] = Gather(m_velocity[k].data(), indexA);
+            velocityB[k] = Gather(m_velocity[k].data(), indexB);
+        }
+        const FloatV invMassA = Load(m_invMassA.data() + row);
+        const FloatV invMassB = Load(m_invMassB.data() + row);
+        const FloatV mass = Load(m_mass.data() + row);
+        const FloatV zero = Set1(0.0f);
+
+        auto applyImpulse = [&](const FloatV dir[3], FloatV impulse)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                const FloatV p = Mul(dir[k], impulse);
+                velocityA[k] = Sub(velocityA[k], Mul(p, invMassA));
+                velocityB[k] = Add(velocityB[k], Mul(p, invMassB));
+            }
+        };
+
+        // friction first, so that the normal row has the last word on penetration
+        const FloatV maxFriction = Mul(Load(m_friction.data() + row), Load(m_normalImpulse.data() + row));
+        const FloatV minFriction = Sub(zero, maxFriction);
+        for (int t = 0; t < 2; ++t)
+        {
+            FloatV dir[3];
+            FloatV relativeVel[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                dir[k] = Load(m_tangent[t][k].data() + row);
+                relativeVel[k] = Sub(velocityB[k], velocityA[k]);
+            }
+            const FloatV lambda = Mul(mass, Sub(Load(m_tangentTarget[t].data() + row), Dot(relativeVel, dir)));
+
+            float* accumulated = m_tangentImpulse[t].data() + row;
+            const FloatV oldImpulse = Load(accumulated);
+            const FloatV newImpulse = Max(minFriction, Min(Add(oldImpulse, lambda), maxFriction));
+            Store(accumulated, newImpulse);
+            applyImpulse(dir, Sub(newImpulse, oldImpulse));
+        }
+
+        {
+            FloatV dir[3];
+            FloatV relativeVel[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                dir[k] = Load(m_normal[k].data() + row);
+                relativeVel[k] = Sub(velocityB[k], velocityA[k]);
+            }
+            const FloatV lambda = Mul(mass, Sub(Load(m_normalTarget.data() + row), Dot(relativeVel, dir)));
+
+            float* accumulated = m_normalImpulse.data() + row;
+            const FloatV oldImpulse = Load(accumulated);
+            const FloatV newImpulse = Max(Add(oldImpulse, lambda), zero);
+            Store(accumulated, newImpulse);
+            applyImpulse(dir, Sub(newImpulse, oldImpulse));
+        }
+
+        for (int k = 0; k < 3; ++k)
+        {
+            Scatter(m_velocity[k].data(), indexA, velocityA[k]);
+            Scatter(m_velocity[k].data(), indexB, velocityB[k]);
+        }
+    }
+
+    void ContactSolver::StoreVelocities() const
+    {
+        for (size_t slot = 1; slot <= m_numDynamic; ++slot)
+        {
+            m_solverBodies[slot]->SetLinearVelocity(Vec3f(m_velocity[0][slot], m_velocity[1][slot], m_velocity[2][slot]));
+        }
+    }
+
+    void ContactSolver::StoreImpulses(LongMarch_Vector<ContactImpulse>& impulses) const
+    {
+        for (size_t row = 0; row < m_numRows; ++row)
+        {
+            const auto i = m_rowContact[row];
+            if (i < 0)
+            {
+                continue;
+            }
+            auto impulse = m_contacts[i];
+            impulse.m_normalImpulse = m_normalImpulse[row];
+            impulse.m_tangentImpulse[0] = m_tangentImpulse[0][row];
+            impulse.m_tangentImpulse[1] = m_tangentImpulse[1][row];
+
+            // friction that stayed inside the cone held the contact, it keeps its anchor
+            const float maxFriction = m_friction[row] * impulse.m_normalImpulse;
+            impulse.m_sticking = maxFriction > 0.0f && fabsf(impulse.m_tangentImpulse[0]) < maxFriction && fabsf(impulse.m_tangentImpulse[1]) < maxFriction;
+            impulses.push_back(impulse);
+        }
+    }
+
+    size_t ContactSolver::GetNumColors() const
+    {
+        return m_numColors;
+    }
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "engine/math/Geommath.h"
+#include "engine/core/utility/TypeHelper.h"
+
+#include "engine/physics/dynamics/RigidBody.h"
+#include "engine/physics/collision/NarrowPhase.h"
+
+namespace longmarch
+{
+    /**
+     *  @brief Accumulated impulses of a contact, kept from one step to the next to warm start the solver
+     *
+     *  @details A contact is identified by its two bodies and the face its normal points out of (axis and sign). The bodies are ordered by
+     *           their ids, so that the identity and the order of the cache depend neither on the order the broadphase reports them in nor on
+     *           heap addresses.
+     *
+     *  @author Hang Yu (yohan680919@gmail.com)
+     */
+    struct ContactImpulse
+    {
+        RigidBody* m_A;
+        RigidBody* m_B;
+        uint32_t m_idA;
+        uint32_t m_idB;
+        uint32_t m_feature;
+
+        float m_normalImpulse;
+        float m_tangentImpulse[2];
+
+        //! Position of B relative to A where static friction holds the contact, only valid while m_sticking
+        Vec3f m_anchor;
+        bool m_sticking;
+
+        inline bool operator<(const ContactImpulse& other) const
+        {
+            if (m_idA != other.m_idA)
+            {
+                return m_idA < other.m_idA;
+            }
+            if (m_idB != other.m_idB)
+            {
+                return m_idB < other.m_idB;
+            }
+            return m_feature < other.m_feature;
+        }
+    };
+
+    /**
+     *  @brief Contact impulses of the last step sorted by contact, read by the islands solved in parallel and rebuilt after they are done
+     *
+     *  Use it like : cache.Retain([](const ContactImpulse& impulse) { ... }); // Keep the contacts that are not solved this step
+     *                ... // Solve islands with cache.Find()
+     *                cache.Add(island.m_impulses); // For each solved island
+     *                cache.Commit();
+     *
+     *  @author Hang Yu (yohan680919@gmail.com)
+     */
+    class ContactCache
+    {
+    public:
+        //! Impulses of the contact in the last step, nullptr for a new contact, A must have the lower id
+        const ContactImpulse* Find(const RigidBody* A, const RigidBody* B, uint32_t feature) const;
+
+        //! Carry over the contacts of the last step that satisfy the predicate (e.g. contacts of sleeping islands)
+        template<typename Predicate>
+        void Retain(Predicate pred)
+        {
+            m_next.clear();
+            for (const auto& impulse : m_entries)
+            {
+                if (pred(impulse))
+                {
+                    m_next.push_back(impulse);
+                }
+            }
+        }
+
+        //! Add the contacts solved in this step
+        void Add(const LongMarch_Vector<ContactImpulse>& impulses);
+
+        //! Replace the contacts of the last step with the retained and added ones
+        void Commit();
+
+        //! Forget the contacts of a body that is removed from the scene
+        void RemoveBody(RigidBody* rb);
+
+        void Clear();
+
+        size_t Size() const;
+
+    private:
+        LongMarch_Vector<ContactImpulse> m_entries;
+        LongMarch_Vector<ContactImpulse> m_next;
+    };
+
+    /**
+     *  @brief Sequential impulse solver of the contacts of an island
+     *
+     *  Use it like : solver.Prepare(island.m_bodies, manifolds, cache, dt, enableFriction);
+     *                solver.WarmStart();
+     *                for (int i = 0; i < ContactSolver::kVelocityIterations; ++i) { solver.SolveVelocities(); }
+     *                solver.StoreVelocities();
+     *                solver.StoreImpulses(island.m_impulses);
+     *
+     *  @details Every contact is a normal row and two friction rows. Accumulated impulses are clamped (the normal impulse stays positive and
+     *           friction stays within the friction cone) and carried over to the next step through ContactCache, so that resting stacks
+     *           converge in a few iterations. A contact whose friction held keeps its anchor, friction rows then pull the bodies back to it
+     *           instead of letting them creep.
+     *           Contacts are colored so that two contacts of the same color never share a dynamic body, rows of the same color are solved in
+     *           batches of eight (AVX2) or four (SSE2) lanes with the velocities of the bodies gathered and scattered per batch. Contacts
+     *           that do not fit in kMaxColors colors get a batch of their own.
+     *           Rows only carry linear terms since rigid bodies do not rotate in the solver, the effective mass of a row is the inverse of
+     *           the sum of the inverse masses. Gaps reported by the narrowphase are speculative contacts, bodies close the gap but do not
+     *           go through, penetration is pushed out with Baumgarte stabilization.
+     *
+     *  @author Hang Yu (yohan680919@gmail.com)
+     */
+    class ContactSolver
+    {
+    public:
+        constexpr inline static int kVelocityIterations = { 8 };
+
+        //! Fraction of the penetration and friction drift corrected per step
+        constexpr inline static float kBaumgarte = { 0.2f };
+
+        //! Penetration that is allowed so that resting contacts stay in contact
+        constexpr inline static float kLinearSlop = { 0.005f };
+
+        //! Bodies that approach slower than this do not bounce
+        constexpr inline static float kRestitutionThreshold = { 1.0f };
+
+        //! Colors tracked per body, one bit each
+        constexpr inline static uint32_t kMaxColors = { 64 };
+
+        // Build, color and batch the rows of the contacts, read their impulses of the last step from the cache
+        void Prepare(const LongMarch_Vector<RigidBody*>& bodies, const ContactManifolds& manifolds, const ContactCache& cache, float dt, bool enableFriction);
+
+        // Apply the impulses of the last step
+        void WarmStart();
+
+        // One iteration over all rows, color by color
+        void SolveVelocities();
+
+        // Write the solved velocities to the dynamic bodies
+        void StoreVelocities() const;
+
+        // Append the impulses of the contacts for the cache of the next step
+        void StoreImpulses(LongMarch_Vector<ContactImpulse>& impulses) const;
+
+        size_t GetNumColors() const;
+
+    private:
+        // Slot of a body, static bodies share slot 0
+        int32_t solverBody(RigidBody* rb);
+
+        // Solve the rows of the batch starting at row
+        void solveBatch(size_t row);
+
+    private:
+        // Velocities of the solver bodies, slot 0 stands for every static body and is never moved
+        LongMarch_Vector<float> m_velocity[3];
+        LongMarch_Vector<RigidBody*> m_solverBodies;
+        size_t m_numDynamic{ 0 };
+        // Slots of the kinematic bodies, they are shared by the islands solved in parallel so their slot can not be written to the body
+        LongMarch_UnorderedMap<RigidBody*, int32_t> m_kinematicSlots;
+
+        // Rows grouped by color and padded to whole batches, padding rows have no mass and never change a velocity
+        LongMarch_Vector<int32_t> m_bodyA;
+        LongMarch_Vector<int32_t> m_bodyB;
+        LongMarch_Vector<float> m_invMassA;
+        LongMarch_Vector<float> m_invMassB;
+        LongMarch_Vector<float> m_normal[3];
+        LongMarch_Vector<float> m_tangent[2][3];
+        LongMarch_Vector<float> m_mass;
+        LongMarch_Vector<float> m_friction;
+        LongMarch_Vector<float> m_normalTarget;
+        LongMarch_Vector<float> m_tangentTarget[2];
+        LongMarch_Vector<float> m_normalImpulse;
+        LongMarch_Vector<float> m_tangentImpulse[2];
+        LongMarch_Vector<int32_t> m_rowContact; //!< Contact of each row, -1 for padding
+
+        // Contacts in the order of the manifolds
+        LongMarch_Vector<ContactImpulse> m_contacts;
+        LongMarch_Vector<Vec3f> m_contactNormals;
+        LongMarch_Vector<int32_t> m_contactBodies;
+        LongMarch_Vector<uint32_t> m_contactColors;
+
+        // Colors used by each solver body
+        LongMarch_Vector<uint64_t> m_colorMasks;
+        size_t m_numColors{ 0 };
+        size_t m_numRows{ 0 };
+    };
+}
@@ -3,18 +3,74 @@
 
 namespace longmarch
 {
-    void Island::Solve()
+    void Island::Clear()
     {
-
+        m_bodies.clear();
+        m_pairs.clear();
+        m_contacts.clear();
+        m_impulses.clear();
+        m_isSleeping = false;
     }
 
     void Island::AddRigidBody(RigidBody* rb)
     {
+        m_bodies.push_back(rb);
+    }
+
+    void Island::AddPair(const BroadPhasePair& pair)
+    {
+        m_pairs.push_back(pair);
+    }
+
+    void Island::AddContact(const Manifold& manifold)
+    {
+        m_contacts.push_back(manifold);
+    }
+
+    bool Island::WakeUp(bool force)
+    {
+        bool awake = force;
+        for (auto it = m_bodies.begin(); !awake && it != m_bodies.end(); ++it)
+        {
+            const auto rb = *it;
+            awake = rb->IsAwake() || glm::length2(rb->GetLinearVelocity()) > kLinearSleepTolerance * kLinearSleepTolerance;
+        }
 
+        if (awake)
+        {
+            for (auto& rb : m_bodies)
+            {
+                rb->SetAwake();
+            }
+        }
+        m_isSleeping = !awake;
+        return awake;
     }
 
-    void Island::AddContact(Contact* c)
+    void Island::UpdateSleep(float dt)
     {
+        float minSleepTime = std::numeric_limits<float>::max();
+        for (auto& rb : m_bodies)
+        {
+            if (glm::length2(rb->GetLinearVelocity()) > kLinearSleepTolerance * kLinearSleepTolerance)
+            {
+                rb->SetSleepTime(0.0f);
+            }
+            else
+            {
+                rb->SetSleepTime(rb->GetSleepTime() + dt);
+            }
+            minSleepTime = std::min(minSleepTime, rb->GetSleepTime());
+        }
 
+        if (minSleepTime >= kTimeToSleep)
+        {
+            for (auto& rb : m_bodies)
+            {
+                rb->Sleep();
+                rb->SetFellAsleep();
+            }
+            m_isSleeping = true;
+        }
     }
-}
\ No newline at end of file
+}
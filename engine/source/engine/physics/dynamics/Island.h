@@ -1,25 +1,64 @@
 #pragma once
 
-#include <vector>
+#include "engine/core/utility/TypeHelper.h"
 #include "engine/physics/dynamics/RigidBody.h"
 #include "engine/physics/dynamics/Contact.inl"
+#include "engine/physics/collision/DynamicTree.h"
+#include "engine/physics/collision/NarrowPhase.h"
+#include "engine/physics/dynamics/ContactSolver.h"
 
 namespace longmarch
 {
+    /**
+     *  @brief Dynamic bodies connected by broadphase pairs, built by Scene with union-find every step
+     *
+     *  @details Bodies of different islands can not touch within a step because the broadphase bounds cover the displacement of the step,
+     *           so islands are solved in parallel. Static and kinematic bodies do not connect islands, they are shared by the islands that
+     *           touch them and are never written by the solver.
+     *           An island sleeps as a whole once all of its bodies have rested for kTimeToSleep, and wakes as a whole when any of its bodies
+     *           is woken (e.g. by a force) or touched by an awake body, so that sleeping stacks cost nothing but the broadphase.
+     *
+     *  @author Hang Yu (yohan680919@gmail.com)
+     */
     struct Island
     {
-        // Solve the constraints in the island
-        void Solve();
+        constexpr inline static uint32_t NO_ISLAND = { ~0u };
+
+        //! Bodies slower than this are resting
+        constexpr inline static float kLinearSleepTolerance = { 0.05f };
+
+        //! Seconds all bodies of an island have to rest before the island sleeps
+        constexpr inline static float kTimeToSleep = { 0.5f };
+
+        // Clear the island while keeping its memory for the next step
+        void Clear();
 
         // Add rigid body to the island
         void AddRigidBody(RigidBody* rb);
 
-        // Add contact constraint to the island
-        void AddContact(Contact* c);
+        // Add broadphase pair of a body of the island
+        void AddPair(const BroadPhasePair& pair);
+
+        // Add contact solved in the island
+        void AddContact(const Manifold& manifold);
+
+        // Wake the island up if any of its bodies is awake or has been given a velocity (or if forced), return true if the island is awake
+        bool WakeUp(bool force);
+
+        // Accumulate the resting time of the bodies and put the island to sleep once all of them rested long enough
+        void UpdateSleep(float dt);
+
+        LongMarch_Vector<RigidBody*> m_bodies;
+        LongMarch_Vector<BroadPhasePair> m_pairs;
+        LongMarch_Vector<Manifold> m_contacts;
+
+        // Narrowphase and solver buffers of the island, kept between steps
+        NarrowPhaseBatch m_narrowPhase;
+        ContactSolver m_solver;
 
-        std::vector<std::shared_ptr<RigidBody>> m_bodies;
-        std::vector<std::shared_ptr<Contact>> m_contacts;
+        // Impulses of the contacts solved in this step, gathered into the contact cache of the scene
+        LongMarch_Vector<ContactImpulse> m_impulses;
 
-        bool m_isSleeping;
+        bool m_isSleeping = { false };
     };
 }
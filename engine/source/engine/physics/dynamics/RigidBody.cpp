@@ -9,6 +9,9 @@ namespace longmarch
 {
     RigidBody::RigidBody()
         : m_rbType(RBType::staticBody),
+          m_id(0),
+          m_islandIndex(~0u),
+          m_solverIndex(0),
           m_restitution(1.0f),
           m_mass(1.0f),
           m_invMass(1.0f),
@@ -18,7 +21,8 @@ namespace longmarch
           m_gravityScale(1.0f),
           m_friction(0.0f),
           m_shape(nullptr),
-          m_awake(false)
+          m_awake(false),
+          m_fellAsleep(false)
     {
     }
 
@@ -62,12 +66,21 @@ namespace longmarch
 
     void RigidBody::SetAwake()
     {
-        m_awake = true;
+        if (!m_awake)
+        {
+            m_awake = true;
+            m_fellAsleep = false;
+            m_sleepTime = 0.0f;
+        }
     }
 
     void RigidBody::Sleep()
     {
         m_awake = false;
+        m_sleepTime = 0.0f;
+        m_linearVelocity = Vec3f(0.0f);
+        m_angularVelocity = Vec3f(0.0f);
+        ClearAllForces();
     }
 
     bool RigidBody::IsAwake() const
@@ -75,6 +88,58 @@ namespace longmarch
         return m_awake;
     }
 
+    void RigidBody::SetFellAsleep()
+    {
+        m_fellAsleep = true;
+    }
+
+    bool RigidBody::ConsumeFellAsleep()
+    {
+        const bool fellAsleep = m_fellAsleep;
+        m_fellAsleep = false;
+        return fellAsleep;
+    }
+
+    float RigidBody::GetSleepTime() const
+    {
+        return m_sleepTime;
+    }
+
+    void RigidBody::SetSleepTime(float time)
+    {
+        m_sleepTime = time;
+    }
+
+    uint32_t RigidBody::GetID() const
+    {
+        return m_id;
+    }
+
+    void RigidBody::SetID(uint32_t id)
+    {
+        m_id = id;
+    }
+
+    uint32_t RigidBody::GetIslandIndex() const
+    {
+        return m_islandIndex;
+    }
+
+    void RigidBody::SetIslandIndex(uint32_t index)
+    {
+        m_islandIndex = index;
+    }
+
+    uint32_t RigidBody::GetSolverIndex() const
+    {
+        return m_solverIndex;
+    }
+
+    void RigidBody::SetSolverIndex(uint32_t index)
+    {
+        m_solverIndex = index;
+    }
+
     float RigidBody::GetMass() const
     {
         return m_mass;
@@ -257,9 +322,9 @@ namespace longmarch
         m_shape = tempPtr;
     }
 
-    const std::shared_ptr<Shape> RigidBody::GetShape() const
+    Shape* RigidBody::GetShape() const
     {
-        return m_shape;
+        return m_shape.get();
     }
 
     void RigidBody::SetColliderDisplacement(const Vec3f& displacement)
@@ -320,5 +385,10 @@ namespace longmarch
     void RigidBody::SetRBType(RBType type)
     {
         m_rbType = type;
+        // new dynamic bodies start awake so that they are simulated without a push
+        if (m_rbType == RBType::dynamicBody)
+        {
+            SetAwake();
+        }
     }
 }
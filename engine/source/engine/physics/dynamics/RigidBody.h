@@ -1,6 +1,7 @@
 #pragma once
 
 #include "engine/core/utility/TypeHelper.h"
+#include "engine/core/smart-pointer/RefPtr.h"
 #include "engine/physics/Shape.h"
 #include "engine/physics/RBTransform.h"
 #include "engine/ecs/components/3d/Transform3DCom.h"
@@ -18,7 +19,10 @@ namespace longmarch
         NUM
     };
 
-    class RigidBody
+    /**
+     *  @brief Rigid body owned by Scene through RefPtr<RigidBody>, broadphase, narrowphase and islands only borrow RigidBody*
+     */
+    class RigidBody final : public BaseRefCountClassNC
     {
     public:
         RigidBody();
@@ -31,11 +35,34 @@ namespace longmarch
 
         void ApplyTorque(const Vec3f& torque);
 
+        //! Waking a body resets its sleep time
         void SetAwake();
+        //! Sleeping bodies are skipped by the solver, their velocities and forces are cleared
         void Sleep();
 
         bool IsAwake() const;
 
+        //! Set by Island::UpdateSleep on the step the body falls asleep, cleared once it is consumed or the body wakes up
+        void SetFellAsleep();
+        //! Return whether the body has fallen asleep since the last call, and clear the flag
+        bool ConsumeFellAsleep();
+
+        //! Time the body has been resting, see Island::UpdateSleep
+        float GetSleepTime() const;
+        void SetSleepTime(float time);
+
+        //! Id assigned by Scene::CreateRigidBody in the order bodies are created, it orders contacts independently of heap addresses
+        uint32_t GetID() const;
+        void SetID(uint32_t id);
+
+        //! Index of the island of the body in the last Scene::Step, Island::NO_ISLAND if it is not in any island (e.g. static bodies)
+        uint32_t GetIslandIndex() const;
+        void SetIslandIndex(uint32_t index);
+
+        //! Slot of the body in the ContactSolver of its island, only valid for dynamic bodies while their island is solved
+        uint32_t GetSolverIndex() const;
+        void SetSolverIndex(uint32_t index);
+
         float GetMass() const;
         float GetInvMass() const;
 
@@ -77,7 +104,7 @@ namespace longmarch
 
         void UpdateAABBShape();
         void SetAABBShape(const Vec3f& aabbMin, const Vec3f& aabbMax);
-        const std::shared_ptr<Shape> GetShape() const;
+        Shape* GetShape() const;
 
         Vec3f GetAABBWidths() const;
 
@@ -108,8 +135,9 @@ namespace longmarch
 
         Entity m_entity;
 
-        // usage to be decided
+        uint32_t m_id;
         uint32_t m_islandIndex;
+        uint32_t m_solverIndex;
 
         float m_restitution;
 
@@ -145,6 +173,7 @@ namespace longmarch
         float m_solveTimeLeft;
 
         bool m_awake;
+        bool m_fellAsleep;
 
         bool m_collidable = true;
     };
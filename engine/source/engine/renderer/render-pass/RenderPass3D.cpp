@@ -4,7 +4,7 @@
 #include "engine/ecs/components/3d/Particle3DCom.h"
 #include "engine/ecs/components/3d/Scene3DCom.h"
 
-bool longmarch::RenderPass3D::ViewFustrumCullingTest(const std::shared_ptr<Shape>& BoudingVolume)
+bool longmarch::RenderPass3D::ViewFustrumCullingTest(Shape* BoudingVolume)
 {
 	if (!m_vfcParam.enableVFCulling)
 	{
@@ -16,7 +16,7 @@ bool longmarch::RenderPass3D::ViewFustrumCullingTest(const std::shared_ptr<Shape
 	}
 }
 
-bool longmarch::RenderPass3D::DistanceCullingTest(const std::shared_ptr<Shape>& BoudingVolume)
+bool longmarch::RenderPass3D::DistanceCullingTest(Shape* BoudingVolume)
 {
 	if (!m_distanceCParam.enableDistanceCulling)
 	{
@@ -47,8 +47,8 @@ namespace longmarch
 
 		virtual void SetVFCullingParam(bool enable, const ViewFrustum& VFinViewSpace, const Mat4& WorldSpaceToViewSpace);
 		virtual void SetDistanceCullingParam(bool enable, const Vec3f& center, float Near, float Far);
-		virtual bool ViewFustrumCullingTest(const std::shared_ptr<Shape>& BoudingVolume);
-		virtual bool DistanceCullingTest(const std::shared_ptr<Shape>& BoudingVolume);
+		virtual bool ViewFustrumCullingTest(Shape* BoudingVolume);
+		virtual bool DistanceCullingTest(Shape* BoudingVolume);
 
 	protected:
 		VFCParam m_vfcParam;
@@ -128,40 +128,45 @@ void longmarch::Prototype2PlayerArsenalComSys::_ON_GEN_PROJECTILE(EventQueue<Pro
 				break;
 			}
 
+			// Projectiles are spawned in bursts, record them into the command buffer so that they are created in one batch at the next sync point
+			auto& commandBuffer = m_parentWorld->GetCommandBuffer();
 			for (int i = 0; i < m_MaxNumProjectile; ++i)
 			{
 				auto e_type = (EntityType)GameEntityType::PROJECTILE;
-				auto entity = m_parentWorld->GenerateEntity3D(e_type, true, true);
 				auto onwer = m_parentWorld->GetTheOnlyEntityWithType((EntityType)GameEntityType::PLAYER);
-				m_projectileDatas.emplace_back(ProjectileData{ .m_this = entity, .owner = onwer, .lifeTime = 5.0f });
+				auto entity = commandBuffer.CreateEntity3D(e_type, true, true,
+					[onwer, position = event->m_player_position, orientation = projectile_orientation[i]](const EntityDecorator& projectile)
 				{
-					auto rm = ResourceManager<Scene3DNode>::GetInstance();
-					auto meshName = "projectile_0";
-					auto mesh = rm->TryGet(meshName)->Get()->Copy();
-					auto scene = m_parentWorld->GetComponent<Scene3DCom>(entity);
-					scene->SetVisiable(true);
-					mesh->ModifyAllMaterial([&](Material* material)
 					{
-						material->Kd = Vec3f(0.54, 1.0, 0.);
-					});
-					scene->SetSceneData(mesh);
-				}
-				{
-					auto body_owner = m_parentWorld->GetComponent<Body3DCom>(onwer);
-					auto player_radius = body_owner->m_body->GetShape()->GetRadius();
-					auto velocity_vector = projectile_orientation[i] * Geommath::WorldFront;
-					auto trans = m_parentWorld->GetComponent<Transform3DCom>(entity);
-					trans->SetLocalScale(Vec3f(0.5));
-					trans->SetGlobalPos(event->m_player_position + velocity_vector * player_radius);
-					trans->SetGlobalRot(projectile_orientation[i]);
-					trans->SetGlobalVel(velocity_vector * 10.0f);
-				}
-				{
-					auto body = m_parentWorld->GetComponent<Body3DCom>(entity);
-					body->m_bodyInfo.type = RBType::dynamicBody;
-					body->m_bodyInfo.colliderDimensionExtent = 0.5;
-					body->m_bodyInfo.entityTypeIngoreSet.emplace((EntityType)GameEntityType::PLAYER);
-				}
+						auto rm = ResourceManager<Scene3DNode>::GetInstance();
+						auto meshName = "projectile_0";
+						auto mesh = rm->TryGet(meshName)->Get()->Copy();
+						auto scene = projectile.GetComponent<Scene3DCom>();
+						scene->SetVisiable(true);
+						mesh->ModifyAllMaterial([&](Material* material)
+						{
+							material->Kd = Vec3f(0.54, 1.0, 0.);
+						});
+						scene->SetSceneData(mesh);
+					}
+					{
+						auto body_owner = projectile.GetWorld()->GetComponent<Body3DCom>(onwer);
+						auto player_radius = body_owner->m_body->GetShape()->GetRadius();
+						auto velocity_vector = orientation * Geommath::WorldFront;
+						auto trans = projectile.GetComponent<Transform3DCom>();
+						trans->SetLocalScale(Vec3f(0.5));
+						trans->SetGlobalPos(position + velocity_vector * player_radius);
+						trans->SetGlobalRot(orientation);
+						trans->SetGlobalVel(velocity_vector * 10.0f);
+					}
+					{
+						auto body = projectile.GetComponent<Body3DCom>();
+						body->m_bodyInfo.type = RBType::dynamicBody;
+						body->m_bodyInfo.colliderDimensionExtent = 0.5;
+						body->m_bodyInfo.entityTypeIngoreSet.emplace((EntityType)GameEntityType::PLAYER);
+					}
+				});
+				m_projectileDatas.emplace_back(ProjectileData{ .m_this = entity, .owner = onwer, .lifeTime = 5.0f });
 				{
 					auto camera = m_parentWorld->GetTheOnlyEntityWithType((EntityType)EngineEntityType::PLAYER_CAMERA);
 					auto trans = GetComponent<Transform3DCom>(camera);
@@ -174,38 +179,40 @@ void longmarch::Prototype2PlayerArsenalComSys::_ON_GEN_PROJECTILE(EventQueue<Pro
 			if (event->m_entity.GetWorld() == m_parentWorld)
 			{
 				auto e_type = (EntityType)GameEntityType::PROJECTILE;
-				auto entity = m_parentWorld->GenerateEntity3D(e_type, true, true);
 				auto onwer = event->m_entity;
-				m_projectileDatas.emplace_back(ProjectileData{ .m_this = entity, .owner = onwer, .lifeTime = 2.0f });
+				auto entity = m_parentWorld->GetCommandBuffer().CreateEntity3D(e_type, true, true,
+					[position = event->m_player_position, orientation = event->m_player_orientation](const EntityDecorator& projectile)
 				{
-					auto rm = ResourceManager<Scene3DNode>::GetInstance();
-					auto meshName = "projectile_0";
-					auto mesh = rm->TryGet(meshName)->Get()->Copy();
-					auto scene = m_parentWorld->GetComponent<Scene3DCom>(entity);
-					scene->SetVisiable(true);
-					mesh->ModifyAllMaterial([&](Material* material)
 					{
-						material->Kd = Vec3f(0.0, 0.96, 1.);
-					});
-					scene->SetSceneData(mesh);
-				}
-				{
-					auto body_owner = m_parentWorld->GetComponent<Body3DCom>(onwer);
-					//auto player_radius = body_owner->m_body->GetShape()->GetRadius(); // The spaceship currently does not have collision
-					auto player_radius = 1.0f;
-					auto velocity_vector = event->m_player_orientation * Geommath::WorldFront;
-					auto trans = m_parentWorld->GetComponent<Transform3DCom>(entity);
-					trans->SetLocalScale(Vec3f(0.5));
-					trans->SetGlobalPos(event->m_player_position + velocity_vector * player_radius);
-					trans->SetGlobalRot(event->m_player_orientation);
-					trans->SetGlobalVel(velocity_vector * 10.0f);
-				}
-				{
-					auto body = m_parentWorld->GetComponent<Body3DCom>(entity);
-					body->m_bodyInfo.type = RBType::dynamicBody;
-					body->m_bodyInfo.colliderDimensionExtent = 0.5;
-					body->m_bodyInfo.entityTypeIngoreSet.emplace((EntityType)GameEntityType::PLAYER);
-				}
+						auto rm = ResourceManager<Scene3DNode>::GetInstance();
+						auto meshName = "projectile_0";
+						auto mesh = rm->TryGet(meshName)->Get()->Copy();
+						auto scene = projectile.GetComponent<Scene3DCom>();
+						scene->SetVisiable(true);
+						mesh->ModifyAllMaterial([&](Material* material)
+						{
+							material->Kd = Vec3f(0.0, 0.96, 1.);
+						});
+						scene->SetSceneData(mesh);
+					}
+					{
+						//auto player_radius = body_owner->m_body->GetShape()->GetRadius(); // The spaceship currently does not have collision
+						auto player_radius = 1.0f;
+						auto velocity_vector = orientation * Geommath::WorldFront;
+						auto trans = projectile.GetComponent<Transform3DCom>();
+						trans->SetLocalScale(Vec3f(0.5));
+						trans->SetGlobalPos(position + velocity_vector * player_radius);
+						trans->SetGlobalRot(orientation);
+						trans->SetGlobalVel(velocity_vector * 10.0f);
+					}
+					{
+						auto body = projectile.GetComponent<Body3DCom>();
+						body->m_bodyInfo.type = RBType::dynamicBody;
+						body->m_bodyInfo.colliderDimensionExtent = 0.5;
+						body->m_bodyInfo.entityTypeIngoreSet.emplace((EntityType)GameEntityType::PLAYER);
+					}
+				});
+				m_projectileDatas.emplace_back(ProjectileData{ .m_this = entity, .owner = onwer, .lifeTime = 2.0f });
 			}
 		}
 		else
@@ -226,8 +233,8 @@ void longmarch::Prototype2PlayerArsenalComSys::_ON_PROJECTILE_COLLISION(EventQue
 		if (e1.GetType() == (EntityType)(GameEntityType::PROJECTILE) && e2.GetType() == (EntityType)(GameEntityType::ENEMY_ASTERIOD) ||
 			e2.GetType() == (EntityType)(GameEntityType::PROJECTILE) && e1.GetType() == (EntityType)(GameEntityType::ENEMY_ASTERIOD))
 		{
-			auto event1 = MemoryManager::Make_shared<EngineGCEvent>(EntityDecorator{ e1, m_parentWorld });
-			auto event2 = MemoryManager::Make_shared<EngineGCEvent>(EntityDecorator{ e2, m_parentWorld });
+			auto event1 = TemplateMemoryManager<EngineGCEvent>::Make_shared_pooled(EntityDecorator{ e1, m_parentWorld });
+			auto event2 = TemplateMemoryManager<EngineGCEvent>::Make_shared_pooled(EntityDecorator{ e2, m_parentWorld });
 			m_GC.push_back(event1);
 			m_GC.push_back(event2);
 		}
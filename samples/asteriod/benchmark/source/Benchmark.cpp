@@ -0,0 +1,151 @@
+#include "benchmark-precompiled-header.h"
+#include "Benchmark.h"
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+
+longmarch::benchmark::State::State(uint64_t seed, uint32_t warmups, uint32_t samples)
+	:
+	m_rng(seed),
+	m_warmups(warmups),
+	m_numSamples(std::max(samples, 1u))
+{
+	m_samples.reserve(m_numSamples);
+}
+
+void longmarch::benchmark::State::Measure(const std::function<void()>& f)
+{
+	for (uint32_t i = 0; i < m_warmups; ++i)
+	{
+		FrameArena::FrameStart();
+		f();
+	}
+	m_samples.clear();
+	for (uint32_t i = 0; i < m_numSamples; ++i)
+	{
+		FrameArena::FrameStart();
+		const auto start = std::chrono::steady_clock::now();
+		f();
+		const auto end = std::chrono::steady_clock::now();
+		m_samples.emplace_back(std::chrono::duration<double>(end - start).count());
+	}
+}
+
+bool longmarch::benchmark::Runner::Register(const std::string& name, const Benchmark& benchmark)
+{
+	_Benchmarks().emplace_back(name, benchmark);
+	return true;
+}
+
+int longmarch::benchmark::Runner::Run(const Options& options)
+{
+	auto benchmarks = _Benchmarks();
+	// Registration order depends on the link order, run by name so that results of two builds line up
+	std::sort(benchmarks.begin(), benchmarks.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+	Json::Value results;
+	results["Seed"] = Json::UInt64(options.m_seed);
+	results["Warmups"] = options.m_warmups;
+	results["Samples"] = options.m_samples;
+	results["Threads"] = StealThreadPool::GetInstance()->threads;
+#ifdef _DEBUG
+	results["Config"] = "Debug";
+#else
+	results["Config"] = "Release";
+#endif
+	auto& values = results["Benchmarks"] = Json::Value(Json::arrayValue);
+
+	int ret = 0;
+	std::cout << std::left << std::setw(32) << "Benchmark" << std::right << std::setw(14) << "median ms" << std::setw(14) << "stddev ms"
+		<< std::setw(16) << "items/s" << std::setw(20) << "checksum" << '\n';
+	for (const auto& [name, benchmark] : benchmarks)
+	{
+		if (!options.m_filter.empty() && name.find(options.m_filter) == std::string::npos)
+		{
+			continue;
+		}
+		State state(options.m_seed, options.m_warmups, options.m_samples);
+		try
+		{
+			benchmark(state);
+		}
+		catch (const EngineException& e)
+		{
+			std::wcerr << L"Benchmark " << wStr(name) << L" failed : " << e.GetFullMessage() << L'\n';
+			ret = 1;
+			continue;
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << "Benchmark " << name << " failed : " << e.what() << '\n';
+			ret = 1;
+			continue;
+		}
+		if (state.Samples().empty())
+		{
+			std::cerr << "Benchmark " << name << " did not call Measure()\n";
+			ret = 1;
+			continue;
+		}
+		auto value = _ToJson(name, state);
+		std::cout << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(4)
+			<< std::setw(14) << value["Median-ms"].asDouble() << std::setw(14) << value["Stddev-ms"].asDouble()
+			<< std::setprecision(0) << std::setw(16) << value["Items-per-second"].asDouble()
+			<< std::setw(20) << value["Checksum"].asString() << '\n';
+		values.append(value);
+	}
+	_WriteJson(options.m_out, results);
+	std::cout << "Results are written to " << options.m_out << '\n';
+	return ret;
+}
+
+std::vector<std::pair<std::string, longmarch::benchmark::Runner::Benchmark>>& longmarch::benchmark::Runner::_Benchmarks()
+{
+	// yuhang : function local so that registration during static initialization is safe
+	static std::vector<std::pair<std::string, Benchmark>> benchmarks;
+	return benchmarks;
+}
+
+Json::Value longmarch::benchmark::Runner::_ToJson(const std::string& name, const State& state)
+{
+	auto samples = state.Samples();
+	std::sort(samples.begin(), samples.end());
+	const auto n = samples.size();
+	const auto median = (n % 2) ? samples[n / 2] : 0.5 * (samples[n / 2 - 1] + samples[n / 2]);
+	const auto mean = std::accumulate(samples.begin(), samples.end(), 0.0) / n;
+	const auto variance = std::accumulate(samples.begin(), samples.end(), 0.0, [mean](double sum, double x) { return sum + (x - mean) * (x - mean); }) / n;
+
+	Json::Value value;
+	value["Name"] = name;
+	value["Min-ms"] = samples.front() * 1e3;
+	value["Median-ms"] = median * 1e3;
+	value["Mean-ms"] = mean * 1e3;
+	value["Max-ms"] = samples.back() * 1e3;
+	value["Stddev-ms"] = std::sqrt(variance) * 1e3;
+	value["Items-per-sample"] = Json::UInt64(state.ItemsPerSample());
+	// Median is robust against the odd sample that is preempted by the OS
+	value["Items-per-second"] = (median > 0.0) ? state.ItemsPerSample() / median : 0.0;
+	// Hex string, json readers would lose the low bits of a 64 bit number stored as a double
+	value["Checksum"] = Str("%016llx", static_cast<unsigned long long>(state.GetChecksum()));
+	auto& values = value["Samples-ms"] = Json::Value(Json::arrayValue);
+	for (auto sample : state.Samples())
+	{
+		values.append(sample * 1e3);
+	}
+	return value;
+}
+
+void longmarch::benchmark::Runner::_WriteJson(const std::string& file, const Json::Value& value)
+{
+	Json::StreamWriterBuilder builder;
+	builder["commentStyle"] = "None";
+	builder["indentation"] = "\t";
+	builder["precision"] = 6;
+	builder["precisionType"] = "significant";
+	std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+	auto& output = FileSystem::OpenOfstream(file, FileSystem::FileType::OPEN_TEXT);
+	writer->write(value, &output);
+	FileSystem::CloseOfstream(file);
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+#include <json/json.h>
+
+namespace longmarch
+{
+	namespace benchmark
+	{
+		/**
+		 * @brief Per benchmark context, owns the fixed seed random engine and the timed loop
+		 *
+		 * Use it like : LONGMARCH_BENCHMARK(Foo)
+		 *				 {
+		 *					 auto data = MakeData(state); // Setup is not timed, draw its data from state.Uniform() and state.Below()
+		 *					 state.SetItemsPerSample(data.size());
+		 *					 state.Measure([&]() { state.Checksum(Process(data)); });
+		 *				 }
+		 *
+		 * @author Hang Yu (yohan680919@gmail.com)
+		 */
+		class State
+		{
+		public:
+			NONCOPYABLE(State);
+			explicit State(uint64_t seed, uint32_t warmups, uint32_t samples);
+
+			//! Deterministic random engine, reseeded for every benchmark so that a filter does not change the data of the others
+			inline std::mt19937_64& Rng() { return m_rng; }
+
+			// yuhang : std distributions are implementation defined and give different data on different standard libraries, the engine itself is specified
+
+			//! Uniform in [lo, hi)
+			inline float Uniform(float lo, float hi) { return lo + (hi - lo) * static_cast<float>((m_rng() >> 40) * 0x1.0p-24); }
+			//! Uniform in [0, n)
+			inline uint64_t Below(uint64_t n) { return m_rng() % n; }
+
+			//! Work items processed by one call of the measured function, used to report items per second
+			inline void SetItemsPerSample(uint64_t items) { m_itemsPerSample = items; }
+
+			//! Fold a result into the checksum, so that the work is not optimized away and a behavior change shows up in the results
+			inline void Checksum(uint64_t value) { m_checksum = (m_checksum ^ value) * 0x100000001b3ull; }
+			inline void Checksum(double value) { Checksum(static_cast<uint64_t>(static_cast<int64_t>(value * 1e3))); }
+
+			/**
+			 * @brief	Run f for the warmup samples, then time it for the measured samples
+			 * @details	Frame memory is released before every sample the way a frame would, f should leave the data in a state that the next sample can reuse
+			 */
+			void Measure(const std::function<void()>& f);
+
+			//! Seconds of each measured sample
+			inline const std::vector<double>& Samples() const { return m_samples; }
+			inline uint64_t ItemsPerSample() const { return m_itemsPerSample; }
+			inline uint64_t GetChecksum() const { return m_checksum; }
+
+		private:
+			std::mt19937_64 m_rng;
+			std::vector<double> m_samples;
+			uint64_t m_itemsPerSample = { 1 };
+			uint64_t m_checksum = { 0xcbf29ce484222325ull };
+			uint32_t m_warmups;
+			uint32_t m_numSamples;
+		};
+
+		/**
+		 * @brief Registry and runner of the headless benchmarks
+		 *
+		 * @details Benchmarks run one after another on the main thread in the order of their names, jobs of the benchmarks use the StealThreadPool.
+		 * Results are written as json with the statistics of the samples so that runs of two builds could be diffed for regression tracking.
+		 *
+		 * @author Hang Yu (yohan680919@gmail.com)
+		 */
+		class Runner
+		{
+		public:
+			NONINSTANTIABLE(Runner);
+			using Benchmark = std::function<void(State&)>;
+
+			struct Options
+			{
+				//! Only run benchmarks whose name contains it
+				std::string m_filter;
+				std::string m_out = { "benchmark-results.json" };
+				uint64_t m_seed = { 20200513 };
+				uint32_t m_warmups = { 3 };
+				uint32_t m_samples = { 15 };
+			};
+
+			//! Called by LONGMARCH_BENCHMARK during static initialization
+			static bool Register(const std::string& name, const Benchmark& benchmark);
+
+			//! Return the process exit code
+			static int Run(const Options& options);
+
+		private:
+			static std::vector<std::pair<std::string, Benchmark>>& _Benchmarks();
+			static Json::Value _ToJson(const std::string& name, const State& state);
+			static void _WriteJson(const std::string& file, const Json::Value& value);
+		};
+	}
+}
+
+#define LONGMARCH_BENCHMARK(NAME) \
+	static void Benchmark_##NAME(longmarch::benchmark::State& state); \
+	static const bool s_benchmark_##NAME = longmarch::benchmark::Runner::Register(#NAME, Benchmark_##NAME); \
+	static void Benchmark_##NAME(longmarch::benchmark::State& state)
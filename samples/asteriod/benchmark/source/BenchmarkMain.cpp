@@ -0,0 +1,49 @@
+#include "benchmark-precompiled-header.h"
+#include "Benchmark.h"
+
+#include <iostream>
+
+/*
+	Headless benchmarks of engine subsystems, no window, GPU nor asset is needed.
+
+	Usage : benchmark [--filter <substring>] [--samples <n>] [--warmups <n>] [--seed <n>] [--out <file.json>]
+*/
+int main(int argc, char** argv)
+{
+	using namespace longmarch::benchmark;
+	Runner::Options options;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg(argv[i]);
+		const bool hasValue = (i + 1 < argc);
+		if (arg == "--filter" && hasValue)
+		{
+			options.m_filter = argv[++i];
+		}
+		else if (arg == "--samples" && hasValue)
+		{
+			options.m_samples = static_cast<uint32_t>(std::stoul(argv[++i]));
+		}
+		else if (arg == "--warmups" && hasValue)
+		{
+			options.m_warmups = static_cast<uint32_t>(std::stoul(argv[++i]));
+		}
+		else if (arg == "--seed" && hasValue)
+		{
+			options.m_seed = std::stoull(argv[++i]);
+		}
+		else if (arg == "--out" && hasValue)
+		{
+			options.m_out = argv[++i];
+		}
+		else
+		{
+			std::cerr << "Usage : " << argv[0] << " [--filter <substring>] [--samples <n>] [--warmups <n>] [--seed <n>] [--out <file.json>]\n";
+			return 2;
+		}
+	}
+	const auto ret = Runner::Run(options);
+	// Stop the scheduler threads while the thread pool is still alive, the same as the engine does on exit
+	longmarch::Scheduler::ShutDown();
+	return ret;
+}
@@ -0,0 +1 @@
+#include "benchmark-precompiled-header.h"
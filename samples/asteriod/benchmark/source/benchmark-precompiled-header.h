@@ -0,0 +1,4 @@
+#pragma once
+
+#include "engine-precompiled-header.h"
+#include "EngineExport.h"
@@ -0,0 +1,67 @@
+#include "benchmark-precompiled-header.h"
+#include "../Benchmark.h"
+
+namespace longmarch
+{
+	namespace benchmark
+	{
+		namespace
+		{
+			constexpr int kGridSize = { 256 };
+			constexpr size_t kNumQueries = { 32 };
+			//! One of kBlockedOneIn cells is blocked
+			constexpr uint64_t kBlockedOneIn = { 4 };
+		}
+	}
+}
+
+LONGMARCH_BENCHMARK(AI_PathFinder2DGrid)
+{
+	using namespace longmarch;
+	using PathFinder = pathfinding::PathFinder2DGrid<int16_t, float>;
+	using benchmark::kGridSize;
+
+	std::vector<uint8_t> blocked(kGridSize * kGridSize);
+	for (auto& cell : blocked)
+	{
+		cell = (state.Below(benchmark::kBlockedOneIn) == 0);
+	}
+	std::vector<std::pair<PathFinder::pair, PathFinder::pair>> queries;
+	queries.reserve(benchmark::kNumQueries);
+	while (queries.size() < benchmark::kNumQueries)
+	{
+		const auto start = static_cast<int>(state.Below(kGridSize * kGridSize));
+		const auto target = static_cast<int>(state.Below(kGridSize * kGridSize));
+		if (start != target && !blocked[start] && !blocked[target])
+		{
+			queries.emplace_back(PathFinder::pair(start / kGridSize, start % kGridSize), PathFinder::pair(target / kGridSize, target % kGridSize));
+		}
+	}
+
+	PathFinder finder;
+	finder.IsBlocked = [&blocked](int16_t i, int16_t j) { return blocked[i * kGridSize + j] != 0; };
+	// The search reports the open and closed cells for debug drawing, nothing to draw in a headless run
+	finder.SetOpenListColor = [](int16_t, int16_t) {};
+	finder.SetClosedListColor = [](int16_t, int16_t) {};
+	finder.Init(kGridSize, kGridSize);
+
+	state.SetItemsPerSample(benchmark::kNumQueries);
+	uint64_t pathCells = 0;
+	state.Measure([&]()
+	{
+		pathCells = 0;
+		for (const auto& [start, target] : queries)
+		{
+			if (finder.PrepareForSeacrh(start, target))
+			{
+				finder.Search();
+				if (finder.Status == pathfinding::PathResult::COMPLETE)
+				{
+					finder.CollectRawPathFindingReuslt();
+					pathCells += finder.Result.size();
+				}
+			}
+		}
+	});
+	state.Checksum(pathCells);
+}
@@ -0,0 +1,112 @@
+#include "benchmark-precompiled-header.h"
+#include "../Benchmark.h"
+#include "engine/renderer/animation/3D/Animation3D.h"
+
+namespace longmarch
+{
+	namespace benchmark
+	{
+		namespace
+		{
+			constexpr uint32_t kNumBones = { 64 };
+			//! Bones per limb, every limb hangs off the first bone like a spine with arms, legs and fingers
+			constexpr uint32_t kBonesPerLimb = { 8 };
+			constexpr uint32_t kNumKeys = { 32 };
+			constexpr float kDuration = { 60.0f };
+			constexpr uint32_t kNumEvaluations = { 1000 };
+			const std::string kAnimationName = { "benchmark" };
+
+			std::string BoneName(uint32_t i)
+			{
+				return Str("Bone_%u", i);
+			}
+
+			Skeleton::Node* FindNode(Skeleton::Node& node, const std::string& name)
+			{
+				if (node.name == name)
+				{
+					return &node;
+				}
+				for (auto& child : node.children)
+				{
+					if (auto ret = FindNode(child, name); ret)
+					{
+						return ret;
+					}
+				}
+				return nullptr;
+			}
+
+			/*
+				Skeleton and animation built in memory, model files are not loaded so that it runs without assets.
+				Bone count, key count and hierarchy depth are in the range of the characters of the samples.
+			*/
+			Animation3D MakeAnimation(State& state)
+			{
+				auto skeleton = MemoryManager::Make_shared<Skeleton>();
+				skeleton->id = kAnimationName;
+				skeleton->rootNode.name = "Scene_Root";
+				skeleton->rootNode.nodeTransform = Mat4(1.0f);
+				for (uint32_t i = 0; i < kNumBones; ++i)
+				{
+					const auto parentName = (i == 0) ? skeleton->rootNode.name : BoneName((i % kBonesPerLimb == 1) ? 0 : i - 1);
+					Skeleton::Node node;
+					node.name = BoneName(i);
+					node.parent_name = parentName;
+					node.nodeTransform = Geommath::ToTranslateMatrix(Vec3f(0.0f, 0.0f, 0.1f));
+					FindNode(skeleton->rootNode, parentName)->children.emplace_back(std::move(node));
+					skeleton->boneIndexLUT[BoneName(i)] = i;
+					skeleton->bone_inverseBindTransform_LUT.emplace_back(Geommath::ToTranslateMatrix(Vec3f(0.0f, 0.0f, -0.1f * i)));
+				}
+
+				Animation3D ret(skeleton);
+				auto& animation = ret.animationCollection[kAnimationName];
+				animation.Duration = kDuration;
+				for (uint32_t i = 0; i < kNumBones; ++i)
+				{
+					auto& channel = animation.Channels[BoneName(i)];
+					for (uint32_t k = 0; k < kNumKeys; ++k)
+					{
+						const auto time = kDuration * k / (kNumKeys - 1);
+						Vec3f v, axis;
+						for (int j = 0; j < 3; ++j)
+						{
+							v[j] = state.Uniform(-0.1f, 0.1f);
+							axis[j] = state.Uniform(-1.0f, 1.0f);
+						}
+						const auto angle = state.Uniform(-1.0f, 1.0f);
+						channel.VKeys.emplace_back(Animation3D::VKeyValue{ v, time });
+						channel.QKeys.emplace_back(Animation3D::QKeyValue{ Geommath::FromAxisRot(angle, Geommath::Normalize(axis + Vec3f(0.0f, 0.0f, 1e-3f))), time });
+						channel.SKeys.emplace_back(Animation3D::SKeyValue{ Vec3f(1.0f), time });
+					}
+				}
+				return ret;
+			}
+		}
+	}
+}
+
+LONGMARCH_BENCHMARK(Animation_CalculateBoneTransform)
+{
+	using namespace longmarch;
+	const auto animation = benchmark::MakeAnimation(state);
+	std::vector<float> ticks(benchmark::kNumEvaluations);
+	for (auto& tick : ticks)
+	{
+		tick = state.Uniform(0.0f, benchmark::kDuration);
+	}
+	Skeleton::Bone_Transform_LUT local, global, inverseFinal;
+
+	state.SetItemsPerSample(benchmark::kNumEvaluations * benchmark::kNumBones);
+	double sum = 0.0;
+	state.Measure([&]()
+	{
+		sum = 0.0;
+		for (auto tick : ticks)
+		{
+			animation.CalculateBoneTransform(benchmark::kAnimationName, tick, Mat4(1.0f), &local, &global, &inverseFinal);
+			sum += inverseFinal.back()[3][2];
+		}
+	});
+	state.Checksum(sum);
+}
@@ -0,0 +1,306 @@
+#include "benchmark-precompiled-header.h"
+#include "../Benchmark.h"
+#include "engine/core/allocator/Allocator.h"
+
+#include <thread>
+
+namespace longmarch
+{
+	namespace benchmark
+	{
+		namespace
+		{
+			constexpr size_t kNumAllocations = { 200000 };
+			constexpr size_t kNumLiveSlots = { 4096 };
+			constexpr size_t kNumJobs = { 100000 };
+			constexpr size_t kNumEvents = { 100000 };
+			constexpr size_t kNumAllocatorThreads = { 8 };
+			constexpr size_t kNumAllocatorRounds = { 20000 };
+			constexpr size_t kAllocatorBatch = { 16 };
+
+			//! Allocation sizes and slots of a random alloc/free trace, half of the sizes are small and the rest spread up to 4KB
+			struct AllocationTrace
+			{
+				explicit AllocationTrace(State& state)
+				{
+					m_sizes.reserve(kNumAllocations);
+					m_slots.reserve(kNumAllocations);
+					for (size_t i = 0; i < kNumAllocations; ++i)
+					{
+						m_sizes.emplace_back((state.Below(2) == 0) ? 8 + state.Below(120) : 8 + state.Below(4088));
+						m_slots.emplace_back(static_cast<uint32_t>(state.Below(kNumLiveSlots)));
+					}
+				}
+
+				//! Replay the trace, every allocation frees the block that is live in its slot first
+				template <typename Alloc, typename Free>
+				uint64_t Replay(Alloc&& alloc, Free&& free) const
+				{
+					std::vector<std::pair<void*, size_t>> live(kNumLiveSlots, { nullptr, 0 });
+					uint64_t touched = 0;
+					for (size_t i = 0; i < kNumAllocations; ++i)
+					{
+						auto& [p, size] = live[m_slots[i]];
+						if (p)
+						{
+							free(p, size);
+						}
+						size = m_sizes[i];
+						p = alloc(size);
+						// Touch the block so that lazily committed pages are paid for like a real user would
+						static_cast<uint8_t*>(p)[0] = static_cast<uint8_t>(i);
+						touched += size;
+					}
+					for (auto& [p, size] : live)
+					{
+						if (p)
+						{
+							free(p, size);
+						}
+					}
+					return touched;
+				}
+
+				std::vector<size_t> m_sizes;
+				std::vector<uint32_t> m_slots;
+			};
+
+			/**
+			 * @brief Threads hammer one allocator with single and batched alloc/free, every block is stamped by its owner and checked before it is freed
+			 * @details A block handed out twice (e.g. a pop of the lock free list that lost an ABA race) shows up as a wrong stamp, a lost block as a used block left over
+			 */
+			uint64_t StressAllocator(Allocator& allocator)
+			{
+				std::atomic_uint64_t errors = { 0 };
+				std::vector<std::thread> threads;
+				threads.reserve(kNumAllocatorThreads);
+				for (size_t t = 0; t < kNumAllocatorThreads; ++t)
+				{
+					threads.emplace_back([&allocator, &errors, t]()
+					{
+						void* blocks[kAllocatorBatch];
+						for (size_t round = 0; round < kNumAllocatorRounds; ++round)
+						{
+							const uint64_t stamp = (static_cast<uint64_t>(t) << 32) | (round * kAllocatorBatch);
+							if (round % 2 == 0)
+							{
+								for (size_t i = 0; i < kAllocatorBatch; ++i)
+								{
+									blocks[i] = allocator.Allocate();
+									*static_cast<uint64_t*>(blocks[i]) = stamp + i;
+								}
+								for (size_t i = 0; i < kAllocatorBatch; ++i)
+								{
+									if (*static_cast<uint64_t*>(blocks[i]) != stamp + i)
+									{
+										errors.fetch_add(1, std::memory_order_relaxed);
+									}
+									allocator.Free(blocks[i]);
+								}
+							}
+							else
+							{
+								// batches are linked by their next pointers the way thread caches use them
+								BlockHeader* head = allocator.AllocateBatch(kAllocatorBatch);
+								BlockHeader* tail = head;
+								uint64_t i = 0;
+								for (BlockHeader* block = head; block != nullptr; block = block->pNext, ++i)
+								{
+									*static_cast<uint64_t*>(BlockHeader::GetPtr(block)) = stamp + i;
+									tail = block;
+								}
+								i = 0;
+								for (BlockHeader* block = head; block != nullptr; block = block->pNext, ++i)
+								{
+									if (*static_cast<uint64_t*>(BlockHeader::GetPtr(block)) != stamp + i)
+									{
+										errors.fetch_add(1, std::memory_order_relaxed);
+									}
+								}
+								if (i != kAllocatorBatch)
+								{
+									errors.fetch_add(1, std::memory_order_relaxed);
+								}
+								allocator.FreeBatch(head, tail, kAllocatorBatch);
+							}
+						}
+					});
+				}
+				for (auto& thread : threads)
+				{
+					thread.join();
+				}
+				ENGINE_EXCEPT_IF(errors.load() != 0, L"Allocator handed out a block that is owned by another thread!");
+				ENGINE_EXCEPT_IF(allocator.GetStats().m_usedBlocks != 0, L"Allocator lost blocks!");
+				return kNumAllocatorThreads * kNumAllocatorRounds * kAllocatorBatch;
+			}
+
+			enum class BenchmarkEventType : uint8_t
+			{
+				PING = 0,
+			};
+
+			struct PingEvent final : public Event<BenchmarkEventType>
+			{
+				explicit PingEvent(uint64_t value)
+					:
+					Event(BenchmarkEventType::PING),
+					m_value(value)
+				{
+				}
+				uint64_t m_value;
+			};
+
+			struct PingCounter
+			{
+				void OnPing(EventQueue<BenchmarkEventType>::EventPtr e)
+				{
+					m_sum += std::static_pointer_cast<PingEvent>(e)->m_value;
+				}
+				uint64_t m_sum = { 0 };
+			};
+
+			using PingQueue = EventQueue<BenchmarkEventType>;
+
+			LongMarch_Vector<PingQueue::EventPtr> MakePings(State& state)
+			{
+				LongMarch_Vector<PingQueue::EventPtr> ret;
+				ret.reserve(kNumEvents);
+				for (size_t i = 0; i < kNumEvents; ++i)
+				{
+					ret.emplace_back(MemoryManager::Make_shared<PingEvent>(state.Below(1000)));
+				}
+				return ret;
+			}
+		}
+	}
+}
+
+LONGMARCH_BENCHMARK(Memory_MemoryManager)
+{
+	using namespace longmarch;
+	const benchmark::AllocationTrace trace(state);
+	state.SetItemsPerSample(benchmark::kNumAllocations);
+	state.Measure([&]()
+	{
+		state.Checksum(trace.Replay(
+			[](size_t size) { return MemoryManager::Allocate(size); },
+			[](void* p, size_t size) { MemoryManager::Free(p, size); }));
+	});
+}
+
+LONGMARCH_BENCHMARK(Memory_Malloc)
+{
+	using namespace longmarch;
+	const benchmark::AllocationTrace trace(state);
+	state.SetItemsPerSample(benchmark::kNumAllocations);
+	state.Measure([&]()
+	{
+		state.Checksum(trace.Replay(
+			[](size_t size) { return std::malloc(size); },
+			[](void* p, size_t) { std::free(p); }));
+	});
+}
+
+LONGMARCH_BENCHMARK(Memory_Allocator_Threads)
+{
+	using namespace longmarch;
+	Allocator allocator;
+	allocator.Reset(64, 4096, 8, false);
+	state.SetItemsPerSample(benchmark::kNumAllocatorThreads * benchmark::kNumAllocatorRounds * benchmark::kAllocatorBatch);
+	state.Measure([&]()
+	{
+		state.Checksum(benchmark::StressAllocator(allocator));
+	});
+}
+
+LONGMARCH_BENCHMARK(Memory_LockFreeAllocator_Threads)
+{
+	using namespace longmarch;
+	Allocator allocator;
+	allocator.Reset(64, 4096, 8, true);
+	state.SetItemsPerSample(benchmark::kNumAllocatorThreads * benchmark::kNumAllocatorRounds * benchmark::kAllocatorBatch);
+	state.Measure([&]()
+	{
+		state.Checksum(benchmark::StressAllocator(allocator));
+	});
+}
+
+LONGMARCH_BENCHMARK(Thread_StealThreadPool)
+{
+	using namespace longmarch;
+	auto pool = StealThreadPool::GetInstance();
+	state.SetItemsPerSample(benchmark::kNumJobs);
+	state.Measure([&]()
+	{
+		std::atomic_uint64_t done = { 0 };
+		for (size_t i = 0; i < benchmark::kNumJobs; ++i)
+		{
+			pool->enqueue_work([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+		}
+		// The calling thread helps like a fork join of the engine does
+		while (done.load(std::memory_order_acquire) < benchmark::kNumJobs)
+		{
+			if (!pool->try_run_one())
+			{
+				std::this_thread::yield();
+			}
+		}
+		state.Checksum(done.load());
+	});
+}
+
+LONGMARCH_BENCHMARK(Event_Publish)
+{
+	using namespace longmarch;
+	benchmark::PingCounter counter;
+	auto queue = benchmark::PingQueue::GetInstance();
+	auto handle = queue->Subscribe<benchmark::PingCounter>(&counter, benchmark::BenchmarkEventType::PING, &benchmark::PingCounter::OnPing);
+	const auto events = benchmark::MakePings(state);
+	state.SetItemsPerSample(benchmark::kNumEvents);
+	state.Measure([&]()
+	{
+		for (const auto& e : events)
+		{
+			queue->Publish(e);
+		}
+	});
+	state.Checksum(counter.m_sum);
+	handle->RemoveEventSub();
+}
+
+LONGMARCH_BENCHMARK(Event_PublishBatch)
+{
+	using namespace longmarch;
+	benchmark::PingCounter counter;
+	auto queue = benchmark::PingQueue::GetInstance();
+	auto handle = queue->Subscribe<benchmark::PingCounter>(&counter, benchmark::BenchmarkEventType::PING, &benchmark::PingCounter::OnPing);
+	const auto events = benchmark::MakePings(state);
+	state.SetItemsPerSample(benchmark::kNumEvents);
+	state.Measure([&]()
+	{
+		queue->PublishBatch(events);
+	});
+	state.Checksum(counter.m_sum);
+	handle->RemoveEventSub();
+}
+
+LONGMARCH_BENCHMARK(Event_PublishDeferred_Pooled)
+{
+	using namespace longmarch;
+	benchmark::PingCounter counter;
+	auto queue = benchmark::PingQueue::GetInstance();
+	auto handle = queue->Subscribe<benchmark::PingCounter>(&counter, benchmark::BenchmarkEventType::PING, &benchmark::PingCounter::OnPing);
+	state.SetItemsPerSample(benchmark::kNumEvents);
+	state.Measure([&]()
+	{
+		// Events are created in the loop like gameplay does, each one takes a single block of the pool of its type
+		for (size_t i = 0; i < benchmark::kNumEvents; ++i)
+		{
+			queue->PublishDeferred(TemplateMemoryManager<benchmark::PingEvent>::Make_shared_pooled(i % 1000));
+		}
+		queue->Update(0.0);
+	});
+	state.Checksum(counter.m_sum);
+	handle->RemoveEventSub();
+}
@@ -0,0 +1,123 @@
+#include "benchmark-precompiled-header.h"
+#include "../Benchmark.h"
+
+namespace longmarch
+{
+	namespace benchmark
+	{
+		namespace
+		{
+			constexpr size_t kNumEntities = { 100000 };
+			constexpr float kDt = { 1.0f / 60.0f };
+
+			GameWorld* CreateWorld(const std::string& name)
+			{
+				// An empty file path skips deserialization, the world has no system and is never updated
+				return GameWorld::GetInstance(false, name, "");
+			}
+
+			LongMarch_Vector<EntityDecorator> Populate(GameWorld* world, State& state)
+			{
+				return world->GenerateEntities<Transform3DCom>(LongMarch_ToUnderlying(EngineEntityType::DYNAMIC_OBJ), kNumEntities,
+					[&](const EntityDecorator&)
+				{
+					// yuhang : one draw per statement, the evaluation order of function arguments is unspecified and would differ between compilers
+					Vec3f p, v;
+					for (int i = 0; i < 3; ++i)
+					{
+						p[i] = state.Uniform(-1000.0f, 1000.0f);
+						v[i] = state.Uniform(-10.0f, 10.0f);
+					}
+					Transform3DCom trans;
+					trans.SetGlobalPos(p);
+					trans.SetGlobalVel(v);
+					return std::make_tuple(trans);
+				});
+			}
+
+			//! Summed sequentially after the timed loop, so that sequential and parallel iteration give the same checksum
+			void ChecksumPositions(State& state, GameWorld* world)
+			{
+				double sum = 0.0;
+				world->ForEach<Transform3DCom>([&sum](const EntityDecorator&, Transform3DCom& trans)
+				{
+					const auto p = trans.GetGlobalPos();
+					sum += p.x + p.y + p.z;
+				});
+				state.Checksum(sum);
+			}
+		}
+	}
+}
+
+LONGMARCH_BENCHMARK(ECS_CreateDestroy)
+{
+	using namespace longmarch;
+	auto world = benchmark::CreateWorld("benchmark-ecs-create");
+	state.SetItemsPerSample(benchmark::kNumEntities);
+	state.Measure([&]()
+	{
+		auto es = benchmark::Populate(world, state);
+		state.Checksum(static_cast<uint64_t>(es.size()));
+		for (const auto& e : es)
+		{
+			world->RemoveEntity(e.GetEntity());
+		}
+	});
+	GameWorld::RemoveWorld(world);
+}
+
+LONGMARCH_BENCHMARK(ECS_ForEach)
+{
+	using namespace longmarch;
+	auto world = benchmark::CreateWorld("benchmark-ecs-foreach");
+	benchmark::Populate(world, state);
+	state.SetItemsPerSample(benchmark::kNumEntities);
+	state.Measure([&]()
+	{
+		world->ForEach<Transform3DCom>([](const EntityDecorator&, Transform3DCom& trans)
+		{
+			trans.AddGlobalPos(trans.GetGlobalVel() * benchmark::kDt);
+		});
+	});
+	benchmark::ChecksumPositions(state, world);
+	GameWorld::RemoveWorld(world);
+}
+
+LONGMARCH_BENCHMARK(ECS_ParEach)
+{
+	using namespace longmarch;
+	auto world = benchmark::CreateWorld("benchmark-ecs-pareach");
+	benchmark::Populate(world, state);
+	state.SetItemsPerSample(benchmark::kNumEntities);
+	state.Measure([&]()
+	{
+		world->ParEach<Transform3DCom>([](const EntityDecorator&, Transform3DCom& trans)
+		{
+			trans.AddGlobalPos(trans.GetGlobalVel() * benchmark::kDt);
+		}).wait();
+	});
+	benchmark::ChecksumPositions(state, world);
+	GameWorld::RemoveWorld(world);
+}
+
+LONGMARCH_BENCHMARK(ECS_ParEachChunk)
+{
+	using namespace longmarch;
+	auto world = benchmark::CreateWorld("benchmark-ecs-pareachchunk");
+	benchmark::Populate(world, state);
+	state.SetItemsPerSample(benchmark::kNumEntities);
+	state.Measure([&]()
+	{
+		world->ParEachChunk(world->EntityChunkView<Transform3DCom>(), [](const EntityChunkContext& chunk)
+		{
+			auto trans = chunk.GetComponentPtr<Transform3DCom>();
+			for (auto i = chunk.BeginIndex(); i <= chunk.EndIndex(); ++i)
+			{
+				trans[i].AddGlobalPos(trans[i].GetGlobalVel() * benchmark::kDt);
+			}
+		}).wait();
+	});
+	benchmark::ChecksumPositions(state, world);
+	GameWorld::RemoveWorld(world);
+}
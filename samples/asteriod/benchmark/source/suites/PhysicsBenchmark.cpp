@@ -0,0 +1,250 @@
+#include "benchmark-precompiled-header.h"
+#include "../Benchmark.h"
+#include "engine/physics/Scene.h"
+
+namespace longmarch
+{
+	namespace benchmark
+	{
+		namespace
+		{
+			constexpr size_t kNumBodies = { 2000 };
+			constexpr size_t kNumAsteroids = { 8000 };
+			constexpr int kStepsPerSample = { 4 };
+			constexpr float kDt = { 1.0f / 60.0f };
+
+			struct BodyInit_T
+			{
+				RefPtr<RigidBody> m_rb;
+				Vec3f m_pos;
+				Vec3f m_vel;
+			};
+
+			//! Unit boxes dropped in a pile above a static ground slab, with gravity along -z as the engine default
+			std::vector<BodyInit_T> PopulateScene(Scene& scene, State& state)
+			{
+				auto ground = scene.CreateRigidBody();
+				ground->SetRBType(RBType::staticBody);
+				// Shapes take local extents and are moved to the world by UpdateAABBShape(), the same as Body3DComSys does
+				ground->SetAABBShape(Vec3f(-100.0f, -100.0f, -1.0f), Vec3f(100.0f, 100.0f, 1.0f));
+				ground->SetWorldPosition(Vec3f(0.0f, 0.0f, -1.0f));
+				ground->UpdateAABBShape();
+
+				std::vector<BodyInit_T> ret;
+				ret.reserve(kNumBodies);
+				for (size_t i = 0; i < kNumBodies; ++i)
+				{
+					Vec3f pos, vel;
+					for (int j = 0; j < 3; ++j)
+					{
+						pos[j] = state.Uniform(-30.0f, 30.0f);
+						vel[j] = state.Uniform(-2.0f, 2.0f);
+					}
+					pos.z = state.Uniform(0.5f, 30.0f);
+					auto rb = scene.CreateRigidBody();
+					rb->SetRBType(RBType::dynamicBody);
+					rb->SetMass(1.0f);
+					rb->SetAABBShape(Vec3f(-0.5f), Vec3f(0.5f));
+					rb->SetWorldPosition(pos);
+					rb->UpdateAABBShape();
+					ret.emplace_back(BodyInit_T{ rb, pos, vel });
+				}
+				return ret;
+			}
+
+			//! Similar sized asteroids drifting in a flat field without gravity, the same as the asteroid sample
+			std::vector<BodyInit_T> PopulateAsteroidField(Scene& scene, State& state)
+			{
+				std::vector<BodyInit_T> ret;
+				ret.reserve(kNumAsteroids);
+				for (size_t i = 0; i < kNumAsteroids; ++i)
+				{
+					Vec3f pos, vel;
+					for (int j = 0; j < 2; ++j)
+					{
+						pos[j] = state.Uniform(-200.0f, 200.0f);
+						vel[j] = state.Uniform(-5.0f, 5.0f);
+					}
+					pos.z = state.Uniform(-2.0f, 2.0f);
+					vel.z = 0.0f;
+					const float halfSize = state.Uniform(0.5f, 1.5f);
+					auto rb = scene.CreateRigidBody();
+					rb->SetRBType(RBType::dynamicBody);
+					rb->SetMass(1.0f);
+					rb->SetAABBShape(Vec3f(-halfSize), Vec3f(halfSize));
+					rb->SetWorldPosition(pos);
+					rb->SetLinearVelocity(vel);
+					rb->UpdateAABBShape();
+					ret.emplace_back(BodyInit_T{ rb, pos, vel });
+				}
+				return ret;
+			}
+
+			void SceneStep(State& state, BroadPhaseType type)
+			{
+				Scene scene;
+				scene.SetBroadPhaseType(type);
+				const auto bodies = PopulateScene(scene, state);
+				state.SetItemsPerSample(kNumBodies * kStepsPerSample);
+				state.Measure([&]()
+				{
+					// Every sample simulates the same pile from the start, so that samples are comparable
+					for (const auto& body : bodies)
+					{
+						body.m_rb->SetWorldPosition(body.m_pos);
+						body.m_rb->SetPrevWorldPosition(body.m_pos);
+						body.m_rb->SetLinearVelocity(body.m_vel);
+						body.m_rb->UpdateAABBShape();
+						body.m_rb->ClearAllForces();
+						body.m_rb->SetAwake();
+						body.m_rb->SetSleepTime(0.0f);
+					}
+					for (int i = 0; i < kStepsPerSample; ++i)
+					{
+						scene.Step(kDt);
+					}
+				});
+				double sum = 0.0;
+				for (const auto& body : bodies)
+				{
+					const auto& p = body.m_rb->GetWorldPosition();
+					sum += p.x + p.y + p.z;
+				}
+				state.Checksum(sum);
+			}
+
+			//! Resting boxes in stacks without gravity, every island falls asleep before the measurement so that only the broadphase runs
+			void SleepingStacks(State& state)
+			{
+				Scene scene(Vec3f(0.0f));
+				std::vector<RefPtr<RigidBody>> bodies;
+				bodies.reserve(kNumBodies);
+				for (size_t i = 0; i < kNumBodies; ++i)
+				{
+					// stacks of 10 touching boxes on a grid
+					const Vec3f pos(static_cast<float>(i / 10 % 50) * 2.0f, static_cast<float>(i / 500) * 2.0f, static_cast<float>(i % 10));
+					auto rb = scene.CreateRigidBody();
+					rb->SetRBType(RBType::dynamicBody);
+					rb->SetMass(1.0f);
+					rb->SetAABBShape(Vec3f(-0.5f), Vec3f(0.5f));
+					rb->SetWorldPosition(pos);
+					rb->UpdateAABBShape();
+					bodies.emplace_back(rb);
+				}
+				for (float t = 0.0f; t <= Island::kTimeToSleep + kDt; t += kDt)
+				{
+					scene.Step(kDt);
+				}
+				state.SetItemsPerSample(kNumBodies * kStepsPerSample);
+				state.Measure([&]()
+				{
+					for (int i = 0; i < kStepsPerSample; ++i)
+					{
+						scene.Step(kDt);
+					}
+				});
+				state.Checksum(static_cast<uint64_t>(std::count_if(bodies.begin(), bodies.end(), [](const auto& rb) { return rb->IsAwake(); })));
+			}
+
+			//! Stacks of boxes resting on a static ground with sleeping disabled, so that every step runs the contact solver on all of them
+			void RestingStacks(State& state)
+			{
+				Scene scene;
+				scene.EnableSleep(false);
+				auto ground = scene.CreateRigidBody();
+				ground->SetRBType(RBType::staticBody);
+				ground->SetAABBShape(Vec3f(-100.0f, -100.0f, -1.0f), Vec3f(100.0f, 100.0f, 1.0f));
+				ground->SetWorldPosition(Vec3f(0.0f, 0.0f, -1.0f));
+				ground->UpdateAABBShape();
+
+				std::vector<RefPtr<RigidBody>> bodies;
+				bodies.reserve(kNumBodies);
+				for (size_t i = 0; i < kNumBodies; ++i)
+				{
+					// stacks of 10 touching boxes on a grid
+					const Vec3f pos(static_cast<float>(i / 10 % 20) * 2.0f, static_cast<float>(i / 200) * 2.0f, static_cast<float>(i % 10) + 0.5f);
+					auto rb = scene.CreateRigidBody();
+					rb->SetRBType(RBType::dynamicBody);
+					rb->SetMass(1.0f);
+					rb->SetAABBShape(Vec3f(-0.5f), Vec3f(0.5f));
+					rb->SetWorldPosition(pos);
+					rb->UpdateAABBShape();
+					bodies.emplace_back(rb);
+				}
+				// let the stacks settle so that the solver is warm started from resting contacts
+				for (float t = 0.0f; t <= 1.0f; t += kDt)
+				{
+					scene.Step(kDt);
+				}
+				state.SetItemsPerSample(kNumBodies * kStepsPerSample);
+				state.Measure([&]()
+				{
+					for (int i = 0; i < kStepsPerSample; ++i)
+					{
+						scene.Step(kDt);
+					}
+				});
+				double sum = 0.0;
+				for (const auto& rb : bodies)
+				{
+					sum += rb->GetWorldPosition().z;
+				}
+				state.Checksum(sum);
+			}
+
+			//! Broadphase alone, bodies are moved by hand so that the pair lists of both broadphases are comparable
+			void AsteroidFieldBroadPhase(State& state, BroadPhaseType type)
+			{
+				Scene scene(Vec3f(0.0f));
+				scene.SetBroadPhaseType(type);
+				const auto bodies = PopulateAsteroidField(scene, state);
+				state.SetItemsPerSample(kNumAsteroids * kStepsPerSample);
+				uint64_t numPairs = 0;
+				state.Measure([&]()
+				{
+					numPairs = 0;
+					for (int i = 0; i < kStepsPerSample; ++i)
+					{
+						for (const auto& body : bodies)
+						{
+							body.m_rb->SetWorldPosition(body.m_pos + body.m_vel * (kDt * i));
+							body.m_rb->UpdateAABBShape();
+						}
+						numPairs += scene.BroadPhase(kDt).size();
+					}
+				});
+				state.Checksum(numPairs);
+			}
+		}
+	}
+}
+
+LONGMARCH_BENCHMARK(Physics_SceneStep)
+{
+	longmarch::benchmark::SceneStep(state, longmarch::BroadPhaseType::AABB_TREE);
+}
+
+LONGMARCH_BENCHMARK(Physics_SceneStep_SweepAndPrune)
+{
+	longmarch::benchmark::SceneStep(state, longmarch::BroadPhaseType::SWEEP_AND_PRUNE);
+}
+
+LONGMARCH_BENCHMARK(Physics_SceneStep_SleepingStacks)
+{
+	longmarch::benchmark::SleepingStacks(state);
+}
+
+LONGMARCH_BENCHMARK(Physics_SceneStep_RestingStacks)
+{
+	longmarch::benchmark::RestingStacks(state);
+}
+
+LONGMARCH_BENCHMARK(Physics_BroadPhase_AABBTree)
+{
+	longmarch::benchmark::AsteroidFieldBroadPhase(state, longmarch::BroadPhaseType::AABB_TREE);
+}
+
+LONGMARCH_BENCHMARK(Physics_BroadPhase_SweepAndPrune)
+{
+	longmarch::benchmark::AsteroidFieldBroadPhase(state, longmarch::BroadPhaseType::SWEEP_AND_PRUNE);
+}
@@ -27,6 +27,11 @@ ApplicationDir = {}
 ApplicationDir["root"]     		= (applicationdir)
 ApplicationDir["source"]     	= (applicationdir .. "/source")
 
+benchmarkdir = compact_path(cwd .. "/benchmark")
+BenchmarkDir = {}
+BenchmarkDir["root"]     		= (benchmarkdir)
+BenchmarkDir["source"]     		= (benchmarkdir .. "/source")
+
 IncludeDir = {}
 IncludeDir["glad"]     		= "%{EngineDir.external}/glad/include"
 IncludeDir["glfw"]     		= "%{EngineDir.external}/glfw/include"
@@ -301,6 +306,94 @@ project "application"
 		symbols "On"
 		optimize "Debug"
 
+	filter "configurations:Release"
+		buildoptions "/MD /Zi /utf-8 /EHsc /Ob2"
+		flags "MultiProcessorCompile"
+		vectorextensions "AVX2"
+		floatingpoint "Fast"
+		optimize "Speed"
+		flags "LinkTimeOptimization"
+
+-- Headless benchmarks of engine subsystems, run it from a console and keep the json results for regression tracking
+project "benchmark"
+	location (benchmarkdir)
+	kind "ConsoleApp"
+	language "C++"
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-intermediate/" .. outputdir .. "/%{prj.name}")
+	debugdir ("bin/" .. outputdir .. "/%{prj.name}")
+
+	pchheader "benchmark-precompiled-header.h"
+	pchsource "%{BenchmarkDir.source}/benchmark-precompiled-header.cpp"
+
+	files
+	{
+		"%{BenchmarkDir.source}/**.h",
+		"%{BenchmarkDir.source}/**.inl",
+		"%{BenchmarkDir.source}/**.cpp",
+	}
+
+	includedirs
+	{
+		"%{BenchmarkDir.source}",
+		"%{EngineDir.source}",
+		"%{EngineDir.vendors}",
+		"%{IncludeDir.assimp}",
+		"%{IncludeDir.blaze}",
+		"%{IncludeDir.phmap}",
+		"%{IncludeDir.glfw}",
+		"%{IncludeDir.glad}",
+		"%{IncludeDir.SOIL2}",
+		"%{IncludeDir.glm}",
+		"%{IncludeDir.jsoncpp}",
+		"%{IncludeDir.fmod_core}",
+		"%{IncludeDir.fmod_bank}",
+		"%{IncludeDir.fmod_studio}",
+		"%{IncludeDir.spdlog}",
+		"%{IncludeDir.ImGui}",
+		"%{IncludeDir.tileson}",
+		"%{IncludeDir.lua}",
+		"%{IncludeDir.sol2}",
+		"%{IncludeDir.FastBVH}",
+		"%{IncludeDir.miniz_cpp}",
+		"%{IncludeDir.Remotery}",
+	}
+
+	links
+	{
+		"engine"
+	}
+
+	filter "system:windows"
+		cppdialect "C++20"
+		staticruntime "On"
+		systemversion "latest"
+
+		defines
+		{
+			"DEBUG_DRAW",
+			"WINDOWS_APP",
+			"MULTITHREAD_UPDATE",
+		}
+
+		-- The engine links against the fmod and assimp dlls even though no benchmark loads audio or models
+		postbuildcommands
+		{
+			("{COPY} %{LibDir.fmod_core}/%{DllName.fmod_core} \"$(SolutionDir)bin/" .. outputdir .. "/benchmark/\""),
+			("{COPY} %{LibDir.fmod_bank}/%{DllName.fmod_bank} \"$(SolutionDir)bin/" .. outputdir .. "/benchmark/\""),
+			("{COPY} %{LibDir.fmod_bank}/%{DllName.fmod_bank2} \"$(SolutionDir)bin/" .. outputdir .. "/benchmark/\""),
+			("{COPY} %{LibDir.fmod_studio}/%{DllName.fmod_studio} \"$(SolutionDir)bin/" .. outputdir .. "/benchmark/\""),
+			("{COPY} %{LibDir.assimp}/%{DllName.assimp} \"$(SolutionDir)bin/" .. outputdir .. "/benchmark/\""),
+		}
+
+	filter "configurations:Debug"
+		buildoptions "/MDd /Zi /utf-8 /EHsc /Ob1"
+		flags "MultiProcessorCompile"
+		vectorextensions "AVX2"
+		floatingpoint "Fast"
+		symbols "On"
+		optimize "Debug"
+
 	filter "configurations:Release"
 		buildoptions "/MD /Zi /utf-8 /EHsc /Ob2"
 		flags "MultiProcessorCompile"